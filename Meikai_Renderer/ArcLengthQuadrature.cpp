@@ -0,0 +1,139 @@
+#include "ArcLengthQuadrature.h"
+#include "BezierSpline.h"
+#include <algorithm>
+
+namespace
+{
+	//5-point Gauss-Legendre nodes and weights on [-1, 1].
+	constexpr int GaussOrder = 5;
+	constexpr float GaussNodes[GaussOrder] = { -0.9061798459386640f, -0.5384693101056831f, 0.f, 0.5384693101056831f, 0.9061798459386640f };
+	constexpr float GaussWeights[GaussOrder] = { 0.2369268850561891f, 0.4786286704993665f, 0.5688888888888889f, 0.4786286704993665f, 0.2369268850561891f };
+}
+
+ArcLengthQuadrature::ArcLengthQuadrature(int knotsPerSegment, int newtonIterations)
+	:mKnotsPerSegment(knotsPerSegment), mNewtonIterations(newtonIterations)
+{
+}
+
+void ArcLengthQuadrature::Build(const BezierSpline& spline)
+{
+	mKnotArcLengths.clear();
+	mSegmentStartArcLengths.assign(1, 0.f);
+	mSegmentCount = 0;
+
+	Splice(spline, 0, 0, spline.GetSegmentCount());
+}
+
+void ArcLengthQuadrature::Splice(const BezierSpline& spline, int firstSegment, int oldSegmentCount, int newSegmentCount)
+{
+	mSpline = &spline;
+	int stride = mKnotsPerSegment + 1;
+
+	auto knotItor = mKnotArcLengths.begin() + firstSegment * stride;
+	knotItor = mKnotArcLengths.erase(knotItor, knotItor + oldSegmentCount * stride);
+	mKnotArcLengths.insert(knotItor, newSegmentCount * stride, 0.f);
+
+	auto startItor = mSegmentStartArcLengths.begin() + firstSegment + 1;
+	startItor = mSegmentStartArcLengths.erase(startItor, startItor + oldSegmentCount);
+	mSegmentStartArcLengths.insert(startItor, newSegmentCount, 0.f);
+	mSegmentCount += newSegmentCount - oldSegmentCount;
+
+	for (int i = 0; i < newSegmentCount; ++i)
+	{
+		BuildSegment(firstSegment + i);
+	}
+	for (int segment = firstSegment; segment < mSegmentCount; ++segment)
+	{
+		mSegmentStartArcLengths[segment + 1] = mSegmentStartArcLengths[segment] + mKnotArcLengths[segment * stride + mKnotsPerSegment];
+	}
+	mWorldArcLength = mSegmentStartArcLengths[mSegmentCount];
+}
+
+void ArcLengthQuadrature::BuildSegment(int segment)
+{
+	float* knots = &mKnotArcLengths[segment * (mKnotsPerSegment + 1)];
+	float knotSlice = 1.f / mKnotsPerSegment;
+
+	knots[0] = 0.f;
+	for (int i = 0; i < mKnotsPerSegment; ++i)
+	{
+		knots[i + 1] = knots[i] + IntegrateSpeed(segment, i * knotSlice, (i + 1) * knotSlice);
+	}
+}
+
+float ArcLengthQuadrature::ArcLengthToParam(float normalizedArcLength) const
+{
+	float localArcLength;
+	int segment = FindSegment(std::clamp(normalizedArcLength, 0.f, 1.f), localArcLength);
+	return (segment + LocalArcLengthToParam(segment, localArcLength)) / mSegmentCount;
+}
+
+int ArcLengthQuadrature::FindSegment(float normalizedArcLength, float& localArcLength) const
+{
+	float worldArcLength = normalizedArcLength * mWorldArcLength;
+	auto segmentItor = std::upper_bound(mSegmentStartArcLengths.begin(), mSegmentStartArcLengths.end() - 1, worldArcLength);
+	int segment = std::clamp(static_cast<int>(segmentItor - mSegmentStartArcLengths.begin()) - 1, 0, mSegmentCount - 1);
+	localArcLength = worldArcLength - mSegmentStartArcLengths[segment];
+	return segment;
+}
+
+float ArcLengthQuadrature::LocalArcLengthToParam(int segment, float localArcLength) const
+{
+	//Find the knot bracket.
+	const float* knots = &mKnotArcLengths[segment * (mKnotsPerSegment + 1)];
+	int high = static_cast<int>(std::lower_bound(knots + 1, knots + mKnotsPerSegment, localArcLength) - knots);
+	int low = high - 1;
+
+	float knotSlice = 1.f / mKnotsPerSegment;
+	float lowU = low * knotSlice;
+	float highU = high * knotSlice;
+	float lowS = knots[low];
+	float highS = knots[high];
+
+	//Linear guess inside the bracket, then Newton on f(u) = s(u) - s.
+	float u = highS > lowS ? lowU + (localArcLength - lowS) / (highS - lowS) * knotSlice : lowU;
+	for (int i = 0; i < mNewtonIterations; ++i)
+	{
+		float speed = GetSpeed(segment, u);
+		if (speed <= 0.f)
+		{
+			break;
+		}
+		float error = lowS + IntegrateSpeed(segment, lowU, u) - localArcLength;
+		u = std::clamp(u - error / speed, lowU, highU);
+	}
+
+	return u;
+}
+
+float ArcLengthQuadrature::LocalParamToArcLength(int segment, float localParam) const
+{
+	//Knots sit at even parameter steps, so the bracket is found directly.
+	const float* knots = &mKnotArcLengths[segment * (mKnotsPerSegment + 1)];
+	float u = std::clamp(localParam, 0.f, 1.f);
+	int low = std::min(static_cast<int>(u * mKnotsPerSegment), mKnotsPerSegment - 1);
+	return knots[low] + IntegrateSpeed(segment, static_cast<float>(low) / mKnotsPerSegment, u);
+}
+
+size_t ArcLengthQuadrature::GetMemorySize() const
+{
+	return (mKnotArcLengths.size() + mSegmentStartArcLengths.size()) * sizeof(float);
+}
+
+float ArcLengthQuadrature::IntegrateSpeed(int segment, float u_a, float u_b) const
+{
+	float halfWidth = (u_b - u_a) * 0.5f;
+	float center = (u_a + u_b) * 0.5f;
+
+	float result = 0.f;
+	for (int i = 0; i < GaussOrder; ++i)
+	{
+		result += GaussWeights[i] * GetSpeed(segment, center + halfWidth * GaussNodes[i]);
+	}
+	return result * halfWidth;
+}
+
+float ArcLengthQuadrature::GetSpeed(int segment, float u) const
+{
+	return XMVectorGetX(XMVector3Length(mSpline->EvaluateDerivative(segment, u)));
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+#include "IArcLength.h"
+
+using namespace DirectX;
+class BezierSpline;
+
+/**
+ * @brief Arc length reparameterization by Gauss-Legendre quadrature of |B'(u)|.
+ * @detail Each segment keeps a coarse table of arc lengths at evenly spaced knots.
+ * A query seeds Newton's method from the knot bracket and refines u with a few steps,
+ * integrating only the short interval between the knot and the current guess.
+ * The spline must outlive this object since queries evaluate its derivative.
+ */
+class ArcLengthQuadrature : public IArcLength
+{
+public:
+	ArcLengthQuadrature(int knotsPerSegment = 8, int newtonIterations = 3);
+
+	void Build(const BezierSpline& spline) override;
+	void Splice(const BezierSpline& spline, int firstSegment, int oldSegmentCount, int newSegmentCount) override;
+	float ArcLengthToParam(float normalizedArcLength) const override;
+	int FindSegment(float normalizedArcLength, float& localArcLength) const override;
+	float LocalArcLengthToParam(int segment, float localArcLength) const override;
+	float LocalParamToArcLength(int segment, float localParam) const override;
+	float GetSegmentStartArcLength(int segment) const override { return mSegmentStartArcLengths[segment]; }
+	float GetSegmentArcLength(int segment) const override { return mKnotArcLengths[segment * (mKnotsPerSegment + 1) + mKnotsPerSegment]; }
+	float GetWorldArcLength() const override { return mWorldArcLength; }
+	size_t GetMemorySize() const override;
+
+private:
+	void BuildSegment(int segment);
+	float IntegrateSpeed(int segment, float u_a, float u_b) const;
+	float GetSpeed(int segment, float u) const;
+
+private:
+	const BezierSpline* mSpline = nullptr;
+	int mKnotsPerSegment;
+	int mNewtonIterations;
+
+	//(mKnotsPerSegment + 1) entries per segment, arc length from the segment start.
+	std::vector<float> mKnotArcLengths;
+	std::vector<float> mSegmentStartArcLengths;
+
+	int mSegmentCount = 0;
+	float mWorldArcLength = 0.f;
+};
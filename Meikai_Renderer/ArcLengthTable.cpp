@@ -0,0 +1,252 @@
+#include "ArcLengthTable.h"
+#include "BezierSpline.h"
+#include <algorithm>
+
+namespace
+{
+	//Intervals narrower than this are accepted as is. Float chord lengths stop converging around here.
+	constexpr float MinSubdivisionWidth = 1.f / 65536.f;
+	constexpr int PreSegmentAmount = 4;
+	constexpr int BucketsPerSegment = 2;
+}
+
+ArcLengthTable::ArcLengthTable(float threshHold, int uniformSamplesPerSegment)
+	:mThreshHold(threshHold), mUniformSamplesPerSegment(uniformSamplesPerSegment)
+{
+}
+
+void ArcLengthTable::Build(const BezierSpline& spline)
+{
+	mLocalParams.clear();
+	mLocalArcLengths.clear();
+	mUniformParams.clear();
+	mSegmentOffsets.assign(1, 0);
+	mSegmentStartArcLengths.assign(1, 0.f);
+	mSegmentCount = 0;
+
+	Splice(spline, 0, 0, spline.GetSegmentCount());
+}
+
+void ArcLengthTable::Splice(const BezierSpline& spline, int firstSegment, int oldSegmentCount, int newSegmentCount)
+{
+	//Build the new segments' entries aside, then swap them in place of the old range.
+	mBuildParams.clear();
+	mBuildArcLengths.clear();
+	mBuildOffsets.clear();
+	for (int i = 0; i < newSegmentCount; ++i)
+	{
+		mBuildOffsets.push_back(static_cast<int>(mBuildParams.size()));
+		BuildSegment(spline, firstSegment + i);
+	}
+
+	int entryBegin = mSegmentOffsets[firstSegment];
+	int entryEnd = mSegmentOffsets[firstSegment + oldSegmentCount];
+	int entryDelta = static_cast<int>(mBuildParams.size()) - (entryEnd - entryBegin);
+
+	mLocalParams.erase(mLocalParams.begin() + entryBegin, mLocalParams.begin() + entryEnd);
+	mLocalParams.insert(mLocalParams.begin() + entryBegin, mBuildParams.begin(), mBuildParams.end());
+	mLocalArcLengths.erase(mLocalArcLengths.begin() + entryBegin, mLocalArcLengths.begin() + entryEnd);
+	mLocalArcLengths.insert(mLocalArcLengths.begin() + entryBegin, mBuildArcLengths.begin(), mBuildArcLengths.end());
+
+	//Offsets and prefix sums have a trailing entry. Their entry at firstSegment is unchanged by the splice.
+	auto offsetItor = mSegmentOffsets.begin() + firstSegment;
+	offsetItor = mSegmentOffsets.erase(offsetItor, offsetItor + oldSegmentCount);
+	for (int& offset : mBuildOffsets)
+	{
+		offset += entryBegin;
+	}
+	offsetItor = mSegmentOffsets.insert(offsetItor, mBuildOffsets.begin(), mBuildOffsets.end());
+	for (auto itor = offsetItor + newSegmentCount; itor != mSegmentOffsets.end(); ++itor)
+	{
+		*itor += entryDelta;
+	}
+
+	auto startItor = mSegmentStartArcLengths.begin() + firstSegment + 1;
+	startItor = mSegmentStartArcLengths.erase(startItor, startItor + oldSegmentCount);
+	mSegmentStartArcLengths.insert(startItor, newSegmentCount, 0.f);
+	mSegmentCount += newSegmentCount - oldSegmentCount;
+
+	for (int segment = firstSegment; segment < mSegmentCount; ++segment)
+	{
+		mSegmentStartArcLengths[segment + 1] = mSegmentStartArcLengths[segment] + GetSegmentArcLength(segment);
+	}
+	mWorldArcLength = mSegmentStartArcLengths[mSegmentCount];
+	BuildSegmentBuckets();
+
+	if (mUniformSamplesPerSegment > 0)
+	{
+		int stride = mUniformSamplesPerSegment + 1;
+		auto uniformItor = mUniformParams.begin() + firstSegment * stride;
+		uniformItor = mUniformParams.erase(uniformItor, uniformItor + oldSegmentCount * stride);
+		mUniformParams.insert(uniformItor, newSegmentCount * stride, 0.f);
+		for (int i = 0; i < newSegmentCount; ++i)
+		{
+			int segment = firstSegment + i;
+			BuildUniformSegment(segment, &mUniformParams[segment * stride]);
+		}
+	}
+}
+
+void ArcLengthTable::BuildSegment(const BezierSpline& spline, int segment)
+{
+	mBuildParams.push_back(0.f);
+	mBuildArcLengths.push_back(0.f);
+
+	//Push in reverse so the stack pops intervals from u = 0 upward and entries come out sorted.
+	mSubdivisionStack.clear();
+	float preSegmentSlice = 1.f / PreSegmentAmount;
+	for (int i = PreSegmentAmount - 1; i >= 0; --i)
+	{
+		mSubdivisionStack.push_back({ i * preSegmentSlice, (i + 1) * preSegmentSlice });
+	}
+
+	while (mSubdivisionStack.empty() == false)
+	{
+		auto [u_a, u_b] = mSubdivisionStack.back();
+		mSubdivisionStack.pop_back();
+		float u_m = (u_a + u_b) * 0.5f;
+
+		auto distances = GetPointDistances(spline, segment, u_a, u_b, u_m);//Return order: am -> mb -> ab
+		float am_length = distances.x;
+		float mb_length = distances.y;
+		float ab_length = distances.z;
+
+		if (am_length + mb_length - ab_length < mThreshHold || u_b - u_a < MinSubdivisionWidth)
+		{
+			//Case1: Complete
+			float firstHalfLength = mBuildArcLengths.back() + am_length;
+			mBuildParams.push_back(u_m);
+			mBuildArcLengths.push_back(firstHalfLength);
+			mBuildParams.push_back(u_b);
+			mBuildArcLengths.push_back(firstHalfLength + mb_length);
+		}
+		else
+		{
+			//Case2: Divide and Repeat
+			mSubdivisionStack.push_back({ u_m, u_b });
+			mSubdivisionStack.push_back({ u_a, u_m });
+		}
+	}
+}
+
+void ArcLengthTable::BuildUniformSegment(int segment, float* uniformParams) const
+{
+	float segmentLength = GetSegmentArcLength(segment);
+	for (int i = 0; i <= mUniformSamplesPerSegment; ++i)
+	{
+		uniformParams[i] = SearchLocalParam(segment, segmentLength * i / mUniformSamplesPerSegment);
+	}
+}
+
+void ArcLengthTable::BuildSegmentBuckets()
+{
+	//One sweep over the prefix sums. Cheap enough to redo on every splice.
+	int bucketCount = mSegmentCount * BucketsPerSegment;
+	mSegmentBuckets.resize(bucketCount);
+	int segment = 0;
+	for (int bucket = 0; bucket < bucketCount; ++bucket)
+	{
+		float bucketStart = mWorldArcLength * bucket / bucketCount;
+		while (segment < mSegmentCount - 1 && mSegmentStartArcLengths[segment + 1] <= bucketStart)
+		{
+			++segment;
+		}
+		mSegmentBuckets[bucket] = segment;
+	}
+}
+
+int ArcLengthTable::FindSegment(float normalizedArcLength, float& localArcLength) const
+{
+	float worldArcLength = normalizedArcLength * mWorldArcLength;
+	int bucketCount = static_cast<int>(mSegmentBuckets.size());
+	int bucket = std::min(static_cast<int>(normalizedArcLength * bucketCount), bucketCount - 1);
+	int segment = mSegmentBuckets[bucket];
+
+	//Buckets are half the mean segment length, so this rarely walks more than a step.
+	while (segment > 0 && mSegmentStartArcLengths[segment] > worldArcLength)
+	{
+		--segment;
+	}
+	while (segment < mSegmentCount - 1 && mSegmentStartArcLengths[segment + 1] <= worldArcLength)
+	{
+		++segment;
+	}
+	localArcLength = worldArcLength - mSegmentStartArcLengths[segment];
+	return segment;
+}
+
+float ArcLengthTable::SearchLocalParam(int segment, float localArcLength) const
+{
+	auto begin = mLocalArcLengths.begin() + mSegmentOffsets[segment];
+	auto end = mLocalArcLengths.begin() + mSegmentOffsets[segment + 1];
+	auto highItor = std::lower_bound(begin + 1, end - 1, localArcLength);
+	int high = static_cast<int>(highItor - mLocalArcLengths.begin());
+	int low = high - 1;
+
+	float lowS = mLocalArcLengths[low];
+	float highS = mLocalArcLengths[high];
+	float interpolateArcLength = highS > lowS ? (localArcLength - lowS) / (highS - lowS) : 0.f;
+	return (mLocalParams[high] - mLocalParams[low]) * interpolateArcLength + mLocalParams[low];
+}
+
+float ArcLengthTable::ArcLengthToParam(float normalizedArcLength) const
+{
+	float localArcLength;
+	int segment = FindSegment(std::clamp(normalizedArcLength, 0.f, 1.f), localArcLength);
+	return (segment + LocalArcLengthToParam(segment, localArcLength)) / mSegmentCount;
+}
+
+float ArcLengthTable::LocalArcLengthToParam(int segment, float localArcLength) const
+{
+	if (mUniformParams.empty())
+	{
+		return SearchLocalParam(segment, localArcLength);
+	}
+
+	float segmentLength = GetSegmentArcLength(segment);
+	float scaled = segmentLength > 0.f ? std::clamp(localArcLength / segmentLength, 0.f, 1.f) * mUniformSamplesPerSegment : 0.f;
+	int index = std::min(static_cast<int>(scaled), mUniformSamplesPerSegment - 1);
+	float t = scaled - index;
+
+	const float* uniformParams = &mUniformParams[segment * (mUniformSamplesPerSegment + 1)];
+	return uniformParams[index] + (uniformParams[index + 1] - uniformParams[index]) * t;
+}
+
+float ArcLengthTable::LocalParamToArcLength(int segment, float localParam) const
+{
+	//Entries are sorted by parameter as well, so the same bracket search works the other way round.
+	auto begin = mLocalParams.begin() + mSegmentOffsets[segment];
+	auto end = mLocalParams.begin() + mSegmentOffsets[segment + 1];
+	auto highItor = std::lower_bound(begin + 1, end - 1, localParam);
+	int high = static_cast<int>(highItor - mLocalParams.begin());
+	int low = high - 1;
+
+	float lowU = mLocalParams[low];
+	float highU = mLocalParams[high];
+	float interpolateParam = highU > lowU ? std::clamp((localParam - lowU) / (highU - lowU), 0.f, 1.f) : 0.f;
+	return (mLocalArcLengths[high] - mLocalArcLengths[low]) * interpolateParam + mLocalArcLengths[low];
+}
+
+size_t ArcLengthTable::GetMemorySize() const
+{
+	return (mLocalParams.size() + mLocalArcLengths.size() + mSegmentStartArcLengths.size() + mUniformParams.size()) * sizeof(float)
+		+ (mSegmentOffsets.size() + mSegmentBuckets.size()) * sizeof(int);
+}
+
+XMFLOAT3 ArcLengthTable::GetPointDistances(const BezierSpline& spline, int segment, float u_a, float u_b, float u_m) const
+{
+	int segments[3] = { segment, segment, segment };
+	float localUs[3] = { u_a, u_m, u_b };
+	XMFLOAT3 positions[3];
+	spline.EvaluateBatch(segments, localUs, positions, 3);
+
+	auto a_pos = XMLoadFloat3(&positions[0]);
+	auto m_pos = XMLoadFloat3(&positions[1]);
+	auto b_pos = XMLoadFloat3(&positions[2]);
+
+	float am_length = XMVectorGetX(XMVector3Length(m_pos - a_pos));
+	float mb_length = XMVectorGetX(XMVector3Length(b_pos - m_pos));
+	float ab_length = XMVectorGetX(XMVector3Length(b_pos - a_pos));
+
+	return XMFLOAT3(am_length, mb_length, ab_length);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+#include "IArcLength.h"
+
+using namespace DirectX;
+class BezierSpline;
+
+/**
+ * @brief Arc length reparameterization of a BezierSpline stored in flat sorted arrays.
+ * @detail Each segment is subdivided adaptively until the chord error falls below the threshold.
+ * Entries of segment i live in [mSegmentOffsets[i], mSegmentOffsets[i + 1]) and hold the local
+ * parameter with the arc length measured from the start of that segment.
+ * An optional resampled table per segment with uniform arc length spacing gives O(1) lookups inside a segment.
+ * Every table is local to its segment, so Splice only rebuilds the edited segments.
+ */
+class ArcLengthTable : public IArcLength
+{
+public:
+	ArcLengthTable(float threshHold, int uniformSamplesPerSegment = 128);
+
+	void Build(const BezierSpline& spline) override;
+	void Splice(const BezierSpline& spline, int firstSegment, int oldSegmentCount, int newSegmentCount) override;
+
+	/**
+	 * @brief Map normalized arc length with the uniform table, or binary search when it was not built.
+	 */
+	float ArcLengthToParam(float normalizedArcLength) const override;
+	int FindSegment(float normalizedArcLength, float& localArcLength) const override;
+	float LocalArcLengthToParam(int segment, float localArcLength) const override;
+	float LocalParamToArcLength(int segment, float localParam) const override;
+	float GetSegmentStartArcLength(int segment) const override { return mSegmentStartArcLengths[segment]; }
+	float GetSegmentArcLength(int segment) const override { return mLocalArcLengths[mSegmentOffsets[segment + 1] - 1]; }
+	float GetWorldArcLength() const override { return mWorldArcLength; }
+	size_t GetMemorySize() const override;
+	size_t GetEntryCount() const { return mLocalParams.size(); }
+
+private:
+	void BuildSegmentBuckets();
+	float SearchLocalParam(int segment, float localArcLength) const;
+	void BuildSegment(const BezierSpline& spline, int segment);
+	void BuildUniformSegment(int segment, float* uniformParams) const;
+	XMFLOAT3 GetPointDistances(const BezierSpline& spline, int segment, float u_a, float u_b, float u_m) const;
+
+private:
+	std::vector<float> mLocalParams;
+	std::vector<float> mLocalArcLengths;
+	std::vector<int> mSegmentOffsets;
+	std::vector<float> mSegmentStartArcLengths;
+
+	//Segment holding the start of each equal arc length bucket, so finding a segment needs no search.
+	std::vector<int> mSegmentBuckets;
+
+	//(mUniformSamplesPerSegment + 1) local parameters per segment.
+	std::vector<float> mUniformParams;
+
+	//Scratch storage reused between builds.
+	std::vector<std::pair<float, float>> mSubdivisionStack;
+	std::vector<float> mBuildParams;
+	std::vector<float> mBuildArcLengths;
+	std::vector<int> mBuildOffsets;
+
+	float mThreshHold;
+	int mUniformSamplesPerSegment;
+	int mSegmentCount = 0;
+	float mWorldArcLength = 0.f;
+};
@@ -0,0 +1,177 @@
+#include "AssetRegistry.h"
+#include "CommandList.h"
+#include "CommandQueue.h"
+#include "Model.h"
+#include "SkeletalModel.h"
+#include "Texture.h"
+
+AssetRegistry::AssetRegistry(DXApp* app, ThreadPool& threadPool)
+	:mApp(app), mModelLoader(app, threadPool)
+{
+}
+
+template<typename AssetType, typename LoadFunc>
+std::shared_future<std::shared_ptr<AssetType>> AssetRegistry::FindOrLoad(EntryMap<AssetType>& entries, const std::string& key, LoadFunc&& load)
+{
+	Entry<AssetType>& entry = entries[key];
+	Settle(entry);
+	if (entry.loading.valid())
+	{
+		++mSharedCount;
+		return entry.loading;
+	}
+	if (std::shared_ptr<AssetType> asset = entry.asset.lock())
+	{
+		++mSharedCount;
+		std::promise<std::shared_ptr<AssetType>> loaded;
+		loaded.set_value(std::move(asset));
+		return loaded.get_future().share();
+	}
+
+	entry.loading = load();
+	++mLoadCount;
+	return entry.loading;
+}
+
+template<typename AssetType>
+void AssetRegistry::Settle(Entry<AssetType>& entry)
+{
+	if (entry.loading.valid() == false || entry.loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+	try
+	{
+		entry.asset = entry.loading.get();
+	}
+	catch (...)
+	{
+		//A failed load is left for the holders of its handle to report. The next request tries again.
+		entry.asset.reset();
+	}
+	entry.loading = {};
+}
+
+template<typename AssetType>
+void AssetRegistry::SettleAll(EntryMap<AssetType>& entries)
+{
+	for (auto& [key, entry] : entries)
+	{
+		Settle(entry);
+	}
+}
+
+template<typename AssetType>
+int AssetRegistry::EraseUnreferenced(EntryMap<AssetType>& entries)
+{
+	int erasedCount = 0;
+	for (auto entry = entries.begin(); entry != entries.end();)
+	{
+		Settle(entry->second);
+		if (entry->second.loading.valid() == false && entry->second.asset.expired())
+		{
+			entry = entries.erase(entry);
+			++erasedCount;
+		}
+		else
+		{
+			++entry;
+		}
+	}
+	return erasedCount;
+}
+
+std::shared_future<std::shared_ptr<Model>> AssetRegistry::LoadModel(const std::string& filePath, GeometryRetention retention)
+{
+	std::string key = GetModelKey(filePath, Model::ImportFlags, retention);
+	return FindOrLoad(mModels, key, [this, &filePath, retention]() { return mModelLoader.Load(filePath, retention); });
+}
+
+std::shared_future<std::shared_ptr<SkeletalModel>> AssetRegistry::LoadSkeletalModel(const std::string& filePath, GeometryRetention retention)
+{
+	std::string key = GetModelKey(filePath, SkeletalModel::ImportFlags, retention);
+	return FindOrLoad(mSkeletalModels, key, [this, &filePath, retention]() { return mModelLoader.LoadSkeletal(filePath, retention); });
+}
+
+std::shared_ptr<Texture> AssetRegistry::LoadTexture(CommandList& commandList, const std::wstring& filePath,
+	D3D12_SRV_DIMENSION srvDim, D3D12_UAV_DIMENSION uavDim)
+{
+	std::wstring key = NormalizePath(filePath).generic_wstring() + L'|' + std::to_wstring(srvDim) + L'|' + std::to_wstring(uavDim);
+	auto found = mTextures.find(key);
+	if (found != mTextures.end())
+	{
+		if (std::shared_ptr<Texture> texture = found->second.lock())
+		{
+			++mSharedCount;
+			return texture;
+		}
+	}
+
+	auto texture = std::make_shared<Texture>(mApp);
+	commandList.LoadTextureFromFile(*texture, filePath, srvDim, uavDim);
+	mTextures[key] = texture;
+	++mLoadCount;
+	return texture;
+}
+
+void AssetRegistry::Update(CommandQueue& commandQueue)
+{
+	mModelLoader.Update(commandQueue);
+	SettleAll(mModels);
+	SettleAll(mSkeletalModels);
+}
+
+void AssetRegistry::Finish(CommandQueue& commandQueue)
+{
+	mModelLoader.Finish(commandQueue);
+	SettleAll(mModels);
+	SettleAll(mSkeletalModels);
+}
+
+int AssetRegistry::CollectUnreferenced()
+{
+	int erasedCount = EraseUnreferenced(mModels) + EraseUnreferenced(mSkeletalModels);
+	for (auto texture = mTextures.begin(); texture != mTextures.end();)
+	{
+		if (texture->second.expired())
+		{
+			texture = mTextures.erase(texture);
+			++erasedCount;
+		}
+		else
+		{
+			++texture;
+		}
+	}
+	return erasedCount;
+}
+
+long AssetRegistry::GetReferenceCount(const std::string& filePath) const
+{
+	long referenceCount = 0;
+	for (GeometryRetention retention : { GeometryRetention::Full, GeometryRetention::Positions, GeometryRetention::None })
+	{
+		auto found = mModels.find(GetModelKey(filePath, Model::ImportFlags, retention));
+		if (found != mModels.end())
+		{
+			referenceCount += found->second.asset.use_count();
+		}
+		auto skeletalFound = mSkeletalModels.find(GetModelKey(filePath, SkeletalModel::ImportFlags, retention));
+		if (skeletalFound != mSkeletalModels.end())
+		{
+			referenceCount += skeletalFound->second.asset.use_count();
+		}
+	}
+	return referenceCount;
+}
+
+std::filesystem::path AssetRegistry::NormalizePath(const std::filesystem::path& filePath)
+{
+	//Lexical only, so it costs no file system access. Links to the same file still count as different assets.
+	return std::filesystem::absolute(filePath).lexically_normal();
+}
+
+std::string AssetRegistry::GetModelKey(const std::string& filePath, unsigned int importFlags, GeometryRetention retention)
+{
+	return NormalizePath(filePath).generic_string() + '|' + std::to_string(importFlags) + '|' + std::to_string(static_cast<int>(retention));
+}
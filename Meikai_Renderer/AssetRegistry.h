@@ -0,0 +1,99 @@
+#pragma once
+#include <d3d12.h>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Mesh.h"
+#include "ModelLoader.h"
+
+struct DXApp;
+class CommandList;
+class CommandQueue;
+class ThreadPool;
+class Model;
+class SkeletalModel;
+class Texture;
+
+/**
+ * @brief Owns the mapping from asset files to the loaded assets, so each file is imported once however many users ask for it.
+ * @detail Assets are keyed by their normalized absolute path and the settings they are imported with. The registry only keeps
+ * weak references, the handles given out are the reference counts and an asset unloads with its last handle.
+ * A request for an asset that is still loading joins that load. Only to be used from the thread that owns it.
+ */
+class AssetRegistry
+{
+public:
+	AssetRegistry(DXApp* app, ThreadPool& threadPool);
+
+	AssetRegistry(const AssetRegistry& copy) = delete;
+	AssetRegistry& operator= (const AssetRegistry& other) = delete;
+
+	/**
+	 * @brief Handle of the model at filePath, ready once it is imported and uploaded. See ModelLoader.
+	 * @detail Requests with another retention get their own copy of the model.
+	 */
+	std::shared_future<std::shared_ptr<Model>> LoadModel(const std::string& filePath, GeometryRetention retention = GeometryRetention::Full);
+	std::shared_future<std::shared_ptr<SkeletalModel>> LoadSkeletalModel(const std::string& filePath, GeometryRetention retention = GeometryRetention::Full);
+	/**
+	 * @brief Texture at filePath, whose upload is recorded into commandList when it is not loaded yet.
+	 */
+	std::shared_ptr<Texture> LoadTexture(CommandList& commandList, const std::wstring& filePath,
+		D3D12_SRV_DIMENSION srvDim = D3D12_SRV_DIMENSION_UNKNOWN, D3D12_UAV_DIMENSION uavDim = D3D12_UAV_DIMENSION_UNKNOWN);
+
+	/**
+	 * @brief Execute pending model uploads and make the handles whose uploads finished ready. Does not block.
+	 */
+	void Update(CommandQueue& commandQueue);
+	/**
+	 * @brief Block until every requested model is loaded.
+	 */
+	void Finish(CommandQueue& commandQueue);
+
+	/**
+	 * @brief Forget the entries of assets that were unloaded. Returns how many were dropped.
+	 */
+	int CollectUnreferenced();
+	/**
+	 * @brief Handles held on the models loaded from filePath, 0 when none is loaded.
+	 */
+	long GetReferenceCount(const std::string& filePath) const;
+	int GetLoadCount() const { return mLoadCount; }
+	int GetSharedCount() const { return mSharedCount; }
+
+private:
+	template<typename AssetType>
+	struct Entry
+	{
+		//Only held while loading. Holding it longer would keep the asset alive from inside the registry.
+		std::shared_future<std::shared_ptr<AssetType>> loading;
+		std::weak_ptr<AssetType> asset;
+	};
+	template<typename AssetType>
+	using EntryMap = std::unordered_map<std::string, Entry<AssetType>>;
+
+	template<typename AssetType, typename LoadFunc>
+	std::shared_future<std::shared_ptr<AssetType>> FindOrLoad(EntryMap<AssetType>& entries, const std::string& key, LoadFunc&& load);
+	template<typename AssetType>
+	static void Settle(Entry<AssetType>& entry);
+	template<typename AssetType>
+	static void SettleAll(EntryMap<AssetType>& entries);
+	template<typename AssetType>
+	static int EraseUnreferenced(EntryMap<AssetType>& entries);
+
+	static std::filesystem::path NormalizePath(const std::filesystem::path& filePath);
+	static std::string GetModelKey(const std::string& filePath, unsigned int importFlags, GeometryRetention retention);
+
+private:
+	DXApp* mApp;
+	ModelLoader mModelLoader;
+
+	EntryMap<Model> mModels;
+	EntryMap<SkeletalModel> mSkeletalModels;
+	std::unordered_map<std::wstring, std::weak_ptr<Texture>> mTextures;
+
+	int mLoadCount = 0;
+	int mSharedCount = 0;
+};
@@ -0,0 +1,1425 @@
+#include "Benchmark.h"
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "BezierSpline.h"
+#include "ArcLengthTable.h"
+#include "ArcLengthQuadrature.h"
+#include "Path.h"
+#include "NavMesh.h"
+#include "NavQuery.h"
+#include "PathCrowd.h"
+#include "SpatialHash.h"
+#include "MathHelper.h"
+#include "ThreadPool.h"
+#include "Mesh.h"
+#include "SkeletalMesh.h"
+#include "VertexCompression.h"
+#include "MeshOptimizer.h"
+#include "MeshPartition.h"
+#include "Meshlet.h"
+#include "MeshletCuller.h"
+#include "MeshSimplifier.h"
+#include "LodSelector.h"
+#include "MeshBounds.h"
+#include "RangeAllocator.h"
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Model.h"
+#include "VertexWelder.h"
+
+using namespace DirectX;
+
+namespace
+{
+	BezierSpline BuildRandomSpline(int controlPointCount)
+	{
+		std::vector<XMVECTOR> controlPoints;
+		XMVECTOR position = XMVectorZero();
+		for (int i = 0; i < controlPointCount; ++i)
+		{
+			position += XMVectorSet(MathHelper::RandF(1.f, 4.f), 0.f, MathHelper::RandF(-3.f, 3.f), 0.f);
+			controlPoints.push_back(position);
+		}
+
+		std::vector<XMVECTOR> subPoints;
+		for (int i = 0; i < controlPointCount - 1; ++i)
+		{
+			XMVECTOR prev = controlPoints[std::max(i - 1, 0)];
+			XMVECTOR next = controlPoints[std::min(i + 2, controlPointCount - 1)];
+			subPoints.push_back(controlPoints[i] + (controlPoints[i + 1] - prev) / 6.f);
+			subPoints.push_back(controlPoints[i + 1] - (next - controlPoints[i]) / 6.f);
+		}
+
+		BezierSpline spline;
+		spline.Build(controlPoints, subPoints);
+		return spline;
+	}
+
+	void AddBox(NavMesh& navMesh, XMFLOAT3 boundsMin, XMFLOAT3 boundsMax)
+	{
+		XMFLOAT3 corners[8];
+		for (int i = 0; i < 8; ++i)
+		{
+			corners[i] = XMFLOAT3((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+		}
+		const unsigned int indices[36] = { 0, 1, 3, 0, 3, 2, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 3, 7, 1, 7, 5 };
+		navMesh.AddTriangles(corners, sizeof(XMFLOAT3), 8, indices, 36, XMMatrixIdentity());
+	}
+
+	//UV sphere with clockwise front faces, rings by segments quads.
+	void BuildSphere(int rings, int segments, std::vector<Vertex>& vertices, std::vector<UINT>& indices)
+	{
+		for (int ring = 0; ring <= rings; ++ring)
+		{
+			float phi = XM_PI * ring / rings;
+			for (int segment = 0; segment <= segments; ++segment)
+			{
+				float theta = XM_2PI * segment / segments;
+				Vertex vertex = {};
+				vertex.normal = XMFLOAT3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+				vertex.position = vertex.normal;
+				vertex.UV = XMFLOAT2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings);
+				vertices.push_back(vertex);
+			}
+		}
+		for (int ring = 0; ring < rings; ++ring)
+		{
+			for (int segment = 0; segment < segments; ++segment)
+			{
+				UINT topLeft = ring * (segments + 1) + segment;
+				UINT bottomLeft = topLeft + segments + 1;
+				indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft, bottomLeft, topLeft + 1, bottomLeft + 1 });
+			}
+		}
+	}
+
+	//Furthest any triangle of a LOD of a BuildSphere sphere strays from the unit sphere, sampled at its centroid and edge midpoints.
+	float MeasureSphereError(const std::vector<Vertex>& vertices, const std::vector<UINT>& indices)
+	{
+		float maxError = 0.f;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			XMVECTOR a = XMLoadFloat3(&vertices[indices[i]].position);
+			XMVECTOR b = XMLoadFloat3(&vertices[indices[i + 1]].position);
+			XMVECTOR c = XMLoadFloat3(&vertices[indices[i + 2]].position);
+			const XMVECTOR samples[4] = { XMVectorScale(XMVectorAdd(a, XMVectorAdd(b, c)), 1.f / 3.f), XMVectorScale(XMVectorAdd(a, b), 0.5f),
+				XMVectorScale(XMVectorAdd(b, c), 0.5f), XMVectorScale(XMVectorAdd(c, a), 0.5f) };
+			for (XMVECTOR sample : samples)
+			{
+				maxError = std::max(maxError, fabsf(1.f - XMVectorGetX(XMVector3Length(sample))));
+			}
+		}
+		return maxError;
+	}
+
+	/**
+	 * @brief Level LodSelector should pick, one object at a time.
+	 */
+	int SelectLodScalar(const LodChainStats& stats, int levelCount, int currentLod, float distance, float pixelsPerUnit, float threshold, float hysteresis)
+	{
+		int lod = 0;
+		while (lod + 1 < levelCount)
+		{
+			float limit = lod + 1 > currentLod ? threshold * (1.f - hysteresis) : threshold;
+			if (stats.errors[lod + 1] * pixelsPerUnit / distance > limit)
+			{
+				break;
+			}
+			++lod;
+		}
+		return lod;
+	}
+}
+
+void Benchmark::RunAll()
+{
+	ArcLength();
+	ClosestPoint();
+	NavMeshQuery();
+	CrowdAvoidance();
+	VertexPacking();
+	MeshOptimization();
+	MeshletCulling();
+	MeshSimplification();
+	LodSelection();
+	BoundingVolumes();
+	GeometryPoolAllocation();
+	ObjParsing();
+	VertexWelding();
+}
+
+void Benchmark::ArcLength()
+{
+	const int queryCount = 1000000;
+	const int controlPointCounts[] = { 9, 256 };
+
+	for (int controlPointCount : controlPointCounts)
+	{
+		BezierSpline spline = BuildRandomSpline(controlPointCount);
+
+		ArcLengthQuadrature reference(64, 8);
+		reference.Build(spline);
+
+		struct Candidate
+		{
+			const char* name;
+			std::unique_ptr<IArcLength> engine;
+		};
+		Candidate candidates[] =
+		{
+			{ "AdaptiveTable(1e-6)", std::make_unique<ArcLengthTable>(0.000001f, 0) },
+			{ "AdaptiveTable(1e-6) + Uniform LUT", std::make_unique<ArcLengthTable>(0.000001f, 128) },
+			{ "GaussLegendre(8 knots, 3 newton)", std::make_unique<ArcLengthQuadrature>(8, 3) },
+		};
+
+		Log("[ArcLength] %d control points, reference length %f\n", controlPointCount, reference.GetWorldArcLength());
+		for (auto& candidate : candidates)
+		{
+			double buildMs = MeasureMilliseconds([&]() { candidate.engine->Build(spline); });
+
+			float checksum = 0.f;
+			double queryMs = MeasureMilliseconds([&]()
+				{
+					for (int i = 0; i < queryCount; ++i)
+					{
+						checksum += candidate.engine->ArcLengthToParam(static_cast<float>(i) / queryCount);
+					}
+				});
+
+			float maxError = 0.f;
+			for (int i = 0; i <= 1000; ++i)
+			{
+				float s = i / 1000.f;
+				XMVECTOR expected = spline.EvaluateGlobal(reference.ArcLengthToParam(s));
+				XMVECTOR actual = spline.EvaluateGlobal(candidate.engine->ArcLengthToParam(s));
+				maxError = std::max(maxError, XMVectorGetX(XMVector3Length(expected - actual)));
+			}
+
+			Log("  %-36s build %9.3f ms | %8zu bytes | %7.2f ns/query | max error %g (checksum %f)\n",
+				candidate.name, buildMs, candidate.engine->GetMemorySize(), queryMs * 1000000.0 / queryCount, maxError, checksum);
+		}
+	}
+}
+
+void Benchmark::ClosestPoint()
+{
+	const int queryCount = 100000;
+	//Dense sampling is slow enough that a strided subset of the queries is plenty.
+	const int bruteForceStride = 100;
+	const int bruteForceSamplesPerSegment = 64;
+	const int controlPointCounts[] = { 16, 256 };
+
+	for (int controlPointCount : controlPointCounts)
+	{
+		//Jittered loop, with queries scattered around it in loop order like a crowd walking the path.
+		std::vector<XMVECTOR> controlPoints;
+		float radius = controlPointCount * 0.5f;
+		for (int i = 0; i < controlPointCount; ++i)
+		{
+			float angle = XM_2PI * i / controlPointCount;
+			float jitteredRadius = radius + MathHelper::RandF(-2.f, 2.f);
+			controlPoints.push_back(XMVectorSet(jitteredRadius * cosf(angle), MathHelper::RandF(-1.f, 1.f), jitteredRadius * sinf(angle), 0.f));
+		}
+		controlPoints.push_back(controlPoints.front());
+		Path path(controlPoints);
+
+		std::vector<XMFLOAT3> points(queryCount);
+		for (int i = 0; i < queryCount; ++i)
+		{
+			float angle = XM_2PI * i / queryCount;
+			points[i] = XMFLOAT3(radius * cosf(angle) + MathHelper::RandF(-2.f, 2.f), MathHelper::RandF(-2.f, 2.f), radius * sinf(angle) + MathHelper::RandF(-2.f, 2.f));
+		}
+
+		const BezierSpline& spline = path.GetSpline();
+		std::vector<float> bruteForceDistances(queryCount / bruteForceStride);
+		double bruteForceMs = MeasureMilliseconds([&]()
+			{
+				for (int i = 0; i < queryCount; i += bruteForceStride)
+				{
+					XMVECTOR point = XMLoadFloat3(&points[i]);
+					float best = FLT_MAX;
+					for (int segment = 0; segment < spline.GetSegmentCount(); ++segment)
+					{
+						for (int sample = 0; sample <= bruteForceSamplesPerSegment; ++sample)
+						{
+							XMVECTOR position = spline.Evaluate(segment, static_cast<float>(sample) / bruteForceSamplesPerSegment);
+							best = std::min(best, XMVectorGetX(XMVector3LengthSq(position - point)));
+						}
+					}
+					bruteForceDistances[i / bruteForceStride] = sqrtf(best);
+				}
+			});
+
+		std::vector<PathProjection> projections(queryCount);
+		double singleMs = MeasureMilliseconds([&]()
+			{
+				for (int i = 0; i < queryCount; ++i)
+				{
+					projections[i] = path.Project(XMLoadFloat3(&points[i]));
+				}
+			});
+		double batchMs = MeasureMilliseconds([&]() { path.ProjectBatch(points.data(), projections.data(), queryCount); });
+
+		//Dense sampling only ever overestimates, so a positive gap means the projection was closer.
+		float maxGap = 0.f;
+		for (int i = 0; i < queryCount; i += bruteForceStride)
+		{
+			maxGap = std::max(maxGap, projections[i].distance - bruteForceDistances[i / bruteForceStride]);
+		}
+
+		Log("[ClosestPoint] %d control points, %d queries\n", controlPointCount, queryCount);
+		Log("  %-36s %9.2f ns/query\n", "Dense sampling (64 per segment)", bruteForceMs * 1000000.0 * bruteForceStride / queryCount);
+		Log("  %-36s %9.2f ns/query\n", "BVH + Newton", singleMs * 1000000.0 / queryCount);
+		Log("  %-36s %9.2f ns/query | worst distance over dense sampling %g\n", "BVH + Newton, batch", batchMs * 1000000.0 / queryCount, maxGap);
+	}
+}
+
+void Benchmark::NavMeshQuery()
+{
+	const float mapHalfSize = 100.f;
+	const int queryCount = 1000;
+	const int replanCount = 10000;
+
+	//Flat ground scattered with boxes, about one per 40 square meters.
+	NavMesh navMesh;
+	XMFLOAT3 ground[4] = { { -mapHalfSize, 0.f, -mapHalfSize }, { mapHalfSize, 0.f, -mapHalfSize }, { -mapHalfSize, 0.f, mapHalfSize }, { mapHalfSize, 0.f, mapHalfSize } };
+	const unsigned int groundIndices[6] = { 0, 1, 2, 1, 3, 2 };
+	navMesh.AddTriangles(ground, sizeof(XMFLOAT3), 4, groundIndices, 6, XMMatrixIdentity());
+	int boxCount = static_cast<int>(mapHalfSize * mapHalfSize * 4.f / 40.f);
+	for (int i = 0; i < boxCount; ++i)
+	{
+		float x = MathHelper::RandF(-mapHalfSize, mapHalfSize);
+		float z = MathHelper::RandF(-mapHalfSize, mapHalfSize);
+		AddBox(navMesh, XMFLOAT3(x, 0.f, z), XMFLOAT3(x + MathHelper::RandF(0.5f, 4.f), 2.f, z + MathHelper::RandF(0.5f, 4.f)));
+	}
+
+	NavMeshSettings settings;
+	settings.cellSize = 0.25f;
+	double buildMs = MeasureMilliseconds([&]() { navMesh.Build(settings); });
+	Log("[NavMesh] %.0f m map, %d boxes: build %.1f ms | %d walkable cells, %d polygons, %d clusters, %d entrances\n",
+		mapHalfSize * 2.f, boxCount, buildMs, navMesh.GetWalkableCellCount(), navMesh.GetPolygonCount(), navMesh.GetClusterCount(), navMesh.GetEntranceCount());
+
+	std::vector<std::pair<XMFLOAT3, XMFLOAT3>> queries(replanCount);
+	for (auto& query : queries)
+	{
+		query.first = XMFLOAT3(MathHelper::RandF(-mapHalfSize, mapHalfSize), 0.f, MathHelper::RandF(-mapHalfSize, mapHalfSize));
+		query.second = XMFLOAT3(MathHelper::RandF(-mapHalfSize, mapHalfSize), 0.f, MathHelper::RandF(-mapHalfSize, mapHalfSize));
+	}
+
+	NavQuery navQuery(navMesh);
+	std::vector<XMVECTOR> points;
+	const std::pair<const char*, NavSearchMethod> methods[] = { { "Flat A*", NavSearchMethod::Flat }, { "Hierarchical A*", NavSearchMethod::Hierarchical } };
+	for (auto [name, method] : methods)
+	{
+		double totalMs = 0.0;
+		double maxMs = 0.0;
+		long long expandedNodeCount = 0;
+		float totalLength = 0.f;
+		int foundCount = 0;
+		for (int i = 0; i < queryCount; ++i)
+		{
+			bool found = false;
+			double ms = MeasureMilliseconds([&]() { found = navQuery.FindPath(XMLoadFloat3(&queries[i].first), XMLoadFloat3(&queries[i].second), points, method); });
+			totalMs += ms;
+			maxMs = std::max(maxMs, ms);
+			expandedNodeCount += navQuery.GetExpandedNodeCount();
+			if (found)
+			{
+				++foundCount;
+				for (size_t point = 1; point < points.size(); ++point)
+				{
+					totalLength += XMVectorGetX(XMVector3Length(points[point] - points[point - 1]));
+				}
+			}
+		}
+		Log("  %-36s avg %8.2f us | max %8.2f us | %6lld nodes expanded | %d/%d found, total length %.0f m\n",
+			name, totalMs * 1000.0 / queryCount, maxMs * 1000.0, expandedNodeCount / queryCount, foundCount, queryCount, totalLength);
+	}
+
+	//Each range gets its own NavQuery, as queries share scratch storage.
+	ThreadPool threadPool;
+	const int grainSize = 256;
+	double parallelMs = MeasureMilliseconds([&]()
+		{
+			threadPool.ParallelFor(replanCount, grainSize, [&](int begin, int end)
+				{
+					NavQuery rangeQuery(navMesh);
+					std::vector<XMVECTOR> rangePoints;
+					for (int i = begin; i < end; ++i)
+					{
+						rangeQuery.FindPath(XMLoadFloat3(&queries[i].first), XMLoadFloat3(&queries[i].second), rangePoints);
+					}
+				});
+		});
+	Log("  %-36s %9.0f replans/s on %u workers + caller\n", "Hierarchical A*, ParallelFor", replanCount / (parallelMs * 0.001), threadPool.GetThreadCount());
+}
+
+void Benchmark::CrowdAvoidance()
+{
+	const int agentCount = 10000;
+	const float neighbourRadius = 2.f;
+	const float densities[] = { 0.05f, 0.25f, 1.f, 4.f };
+
+	ThreadPool threadPool;
+	SpatialHash spatialHash;
+	std::vector<XMFLOAT3> positions(agentCount);
+	Log("[CrowdAvoidance] %d agents, %.1f m neighbour radius\n", agentCount, neighbourRadius);
+	for (float density : densities)
+	{
+		float side = sqrtf(agentCount / density);
+		for (auto& position : positions)
+		{
+			position = XMFLOAT3(MathHelper::RandF(0.f, side), 0.f, MathHelper::RandF(0.f, side));
+		}
+
+		const int repeatCount = 20;
+		double serialBuildMs = MeasureMilliseconds([&]()
+			{
+				for (int i = 0; i < repeatCount; ++i)
+				{
+					spatialHash.Build(positions.data(), agentCount, neighbourRadius);
+				}
+			}) / repeatCount;
+		double parallelBuildMs = MeasureMilliseconds([&]()
+			{
+				for (int i = 0; i < repeatCount; ++i)
+				{
+					spatialHash.Build(positions.data(), agentCount, neighbourRadius, &threadPool);
+				}
+			}) / repeatCount;
+
+		long long visitedCount = 0;
+		long long neighbourCount = 0;
+		double queryMs = MeasureMilliseconds([&]()
+			{
+				for (const XMFLOAT3& position : positions)
+				{
+					spatialHash.ForEachNear(position, [&](int other)
+						{
+							float dx = positions[other].x - position.x;
+							float dz = positions[other].z - position.z;
+							++visitedCount;
+							neighbourCount += dx * dx + dz * dz < neighbourRadius * neighbourRadius;
+						});
+				}
+			});
+		Log("  %5.2f agents/m2: build %6.3f ms, %6.3f ms parallel | query %7.1f ns, %6.1f visited, %6.1f in radius\n",
+			density, serialBuildMs, parallelBuildMs, queryMs * 1000000.0 / agentCount,
+			static_cast<double>(visitedCount) / agentCount, static_cast<double>(neighbourCount) / agentCount - 1.0);
+	}
+
+	//A hundred separate 20 m loops with a hundred agents each, at speeds that make them catch up on each other.
+	const int loopCount = 100;
+	const int loopsPerRow = 10;
+	const float loopRadius = 20.f;
+	const float loopSpacing = 45.f;
+	const int frameCount = 240;
+	const float deltaTime = 1.f / 60.f;
+	CrowdAvoidanceSettings settings;
+	settings.neighbourRadius = neighbourRadius;
+
+	auto buildCrowd = [&]()
+	{
+		auto crowd = std::make_unique<PathCrowd>();
+		for (int loop = 0; loop < loopCount; ++loop)
+		{
+			float centerX = (loop % loopsPerRow) * loopSpacing;
+			float centerZ = (loop / loopsPerRow) * loopSpacing;
+			std::vector<XMVECTOR> controlPoints;
+			for (int i = 0; i <= 12; ++i)
+			{
+				float angle = MathHelper::Pi * 2.f * (i % 12) / 12.f;
+				controlPoints.push_back(XMVectorSet(centerX + cosf(angle) * loopRadius, 0.f, centerZ + sinf(angle) * loopRadius, 0.f));
+			}
+			int pathId = crowd->AddPath(std::make_shared<const Path>(controlPoints));
+			for (int i = 0; i < agentCount / loopCount; ++i)
+			{
+				crowd->AddAgent(pathId, MathHelper::RandF(0.f, loopRadius * MathHelper::Pi * 2.f), MathHelper::RandF(1.f, 1.6f));
+			}
+		}
+		return crowd;
+	};
+	auto countOverlaps = [&](const PathCrowd& crowd)
+	{
+		for (int agent = 0; agent < agentCount; ++agent)
+		{
+			XMStoreFloat3(&positions[agent], crowd.GetPosition(agent));
+		}
+		spatialHash.Build(positions.data(), agentCount, neighbourRadius);
+		//Agents pressed together in a queue touch now and then, so only count those sunk in by more than a tenth.
+		float contactDistance = settings.agentRadius * 2.f * 0.9f;
+		int overlapCount = 0;
+		for (int agent = 0; agent < agentCount; ++agent)
+		{
+			spatialHash.ForEachNear(positions[agent], [&](int other)
+				{
+					float dx = positions[other].x - positions[agent].x;
+					float dz = positions[other].z - positions[agent].z;
+					overlapCount += other > agent && dx * dx + dz * dz < contactDistance * contactDistance;
+				});
+		}
+		return overlapCount;
+	};
+
+	struct Variant
+	{
+		const char* name;
+		bool avoidance;
+		ThreadPool* threadPool;
+	};
+	const Variant variants[] =
+	{
+		{ "Path following only", false, nullptr },
+		{ "Path following only, ParallelFor", false, &threadPool },
+		{ "Avoidance", true, nullptr },
+		{ "Avoidance, ParallelFor", true, &threadPool },
+	};
+	for (const Variant& variant : variants)
+	{
+		std::unique_ptr<PathCrowd> crowd = buildCrowd();
+		if (variant.avoidance)
+		{
+			crowd->EnableAvoidance(settings);
+		}
+		double totalMs = MeasureMilliseconds([&]()
+			{
+				for (int frame = 0; frame < frameCount; ++frame)
+				{
+					crowd->Update(deltaTime, variant.threadPool);
+				}
+			});
+		Log("  %-36s %8.3f ms/frame | %5d pairs overlapping after %d frames\n", variant.name, totalMs / frameCount, countOverlaps(*crowd), frameCount);
+	}
+}
+
+void Benchmark::VertexPacking()
+{
+	const int vertexCount = 1000000;
+	//Bounds the decoded attributes have to meet, in degrees for directions.
+	const float maxNormalErrorBound = 0.01f;
+	const float maxTangentErrorBound = 0.3f;
+	//Half a step of rounding, plus the steps the heaviest weight absorbs to keep the sum at 255.
+	const float maxWeightErrorBound = 2.f / 255.f;
+
+	auto randomDirection = []()
+		{
+			XMVECTOR direction;
+			do
+			{
+				direction = XMVectorSet(MathHelper::RandF(-1.f, 1.f), MathHelper::RandF(-1.f, 1.f), MathHelper::RandF(-1.f, 1.f), 0.f);
+			} while (XMVectorGetX(XMVector3LengthSq(direction)) < 1e-4f || XMVectorGetX(XMVector3LengthSq(direction)) > 1.f);
+			return XMVector3Normalize(direction);
+		};
+	auto angleDegrees = [](const XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			//atan2 rather than acos, which has no precision left for angles this small.
+			XMVECTOR first = XMVector3Normalize(XMLoadFloat3(&a));
+			XMVECTOR second = XMVector3Normalize(XMLoadFloat3(&b));
+			return XMConvertToDegrees(atan2f(XMVectorGetX(XMVector3Length(XMVector3Cross(first, second))), XMVectorGetX(XMVector3Dot(first, second))));
+		};
+
+	std::vector<SkeletalVertex> vertices(vertexCount);
+	for (SkeletalVertex& vertex : vertices)
+	{
+		XMVECTOR normal = randomDirection();
+		XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(normal, randomDirection()));
+		float sign = MathHelper::RandF() < 0.5f ? -1.f : 1.f;
+		vertex.position = XMFLOAT3(MathHelper::RandF(-10.f, 10.f), MathHelper::RandF(-10.f, 10.f), MathHelper::RandF(-10.f, 10.f));
+		XMStoreFloat3(&vertex.normal, normal);
+		XMStoreFloat3(&vertex.tangent, tangent);
+		XMStoreFloat3(&vertex.biTangent, XMVectorScale(XMVector3Cross(normal, tangent), sign));
+		//Mostly unit square UVs, with some tiling ones.
+		float uvRange = MathHelper::RandF() < 0.9f ? 1.f : 8.f;
+		vertex.UV = XMFLOAT2(MathHelper::RandF(0.f, uvRange), MathHelper::RandF(0.f, uvRange));
+		vertex.weightNum = 0;
+		int influenceCount = MathHelper::Rand(1, 4);
+		for (int i = 0; i < influenceCount; ++i)
+		{
+			vertex.AddBoneData(MathHelper::Rand(0, VertexCompression::MaxBones - 1), MathHelper::RandF(0.01f, 1.f));
+		}
+	}
+	std::vector<Vertex> staticVertices(vertexCount);
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		staticVertices[i] = { vertices[i].position, vertices[i].normal, vertices[i].UV, vertices[i].tangent, vertices[i].biTangent };
+	}
+
+	std::vector<PackedVertex> packed(vertexCount);
+	std::vector<PackedSkeletalVertex> packedSkeletal(vertexCount);
+	double packMs = MeasureMilliseconds([&]()
+		{
+			for (int i = 0; i < vertexCount; ++i)
+			{
+				packed[i] = VertexCompression::Pack(staticVertices[i]);
+			}
+		});
+	double packSkeletalMs = MeasureMilliseconds([&]()
+		{
+			for (int i = 0; i < vertexCount; ++i)
+			{
+				packedSkeletal[i] = VertexCompression::Pack(vertices[i]);
+			}
+		});
+
+	float maxNormalError = 0.f;
+	float maxTangentError = 0.f;
+	float maxUVError = 0.f;
+	float maxWeightError = 0.f;
+	int signMismatches = 0;
+	int weightSumMismatches = 0;
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		Vertex decoded = VertexCompression::Unpack(packed[i]);
+		const Vertex& source = staticVertices[i];
+		maxNormalError = std::max(maxNormalError, angleDegrees(decoded.normal, source.normal));
+		maxTangentError = std::max(maxTangentError, angleDegrees(decoded.tangent, source.tangent));
+		//Half floats keep 11 significant bits, so the error is relative to the magnitude.
+		maxUVError = std::max(maxUVError, fabsf(decoded.UV.x - source.UV.x) / std::max(fabsf(source.UV.x), 1.f));
+		maxUVError = std::max(maxUVError, fabsf(decoded.UV.y - source.UV.y) / std::max(fabsf(source.UV.y), 1.f));
+		if (XMVectorGetX(XMVector3Dot(XMLoadFloat3(&decoded.biTangent), XMLoadFloat3(&source.biTangent))) <= 0.f)
+		{
+			++signMismatches;
+		}
+
+		SkeletalVertex decodedSkeletal = VertexCompression::Unpack(packedSkeletal[i]);
+		float sourceSum = 0.f;
+		for (UINT influence = 0; influence < vertices[i].weightNum; ++influence)
+		{
+			sourceSum += vertices[i].weights[influence];
+		}
+		int quantizedSum = 0;
+		for (int influence = 0; influence < 4; ++influence)
+		{
+			float sourceWeight = influence < static_cast<int>(vertices[i].weightNum) ? vertices[i].weights[influence] / sourceSum : 0.f;
+			maxWeightError = std::max(maxWeightError, fabsf(decodedSkeletal.weights[influence] - sourceWeight));
+			quantizedSum += packedSkeletal[i].weights[influence];
+		}
+		weightSumMismatches += quantizedSum != 255 ? 1 : 0;
+	}
+
+	Log("[VertexPacking] %d vertices\n", vertexCount);
+	Log("  %-36s %3zu -> %2zu bytes | %6.2f ns/vertex\n", "Static", sizeof(Vertex), sizeof(PackedVertex), packMs * 1000000.0 / vertexCount);
+	Log("  %-36s %3zu -> %2zu bytes | %6.2f ns/vertex\n", "Skinned", sizeof(SkeletalVertex), sizeof(PackedSkeletalVertex), packSkeletalMs * 1000000.0 / vertexCount);
+	bool passed = CheckBound("Normal round trip error, degrees", maxNormalError, maxNormalErrorBound);
+	passed &= CheckBound("Tangent round trip error, degrees", maxTangentError, maxTangentErrorBound);
+	passed &= CheckBound("UV round trip error, relative", maxUVError, 1.0 / 1024.0);
+	passed &= CheckBound("Weight round trip error", maxWeightError, maxWeightErrorBound);
+	passed &= CheckBound("Bitangent sign mismatches", signMismatches, 0.0);
+	passed &= CheckBound("Weight sums other than 255", weightSumMismatches, 0.0);
+	ReportChecks("VertexPacking", passed);
+}
+
+void Benchmark::MeshOptimization()
+{
+	std::vector<Vertex> sphereVertices;
+	std::vector<UINT> sphereIndices;
+	BuildSphere(384, 768, sphereVertices, sphereIndices);
+
+	//Scanned meshes come out of reconstruction with little locality, a random triangle order stands in for them.
+	std::vector<UINT> scrambledIndices;
+	{
+		std::vector<UINT> triangleOrder(sphereIndices.size() / 3);
+		for (size_t i = 0; i < triangleOrder.size(); ++i)
+		{
+			triangleOrder[i] = static_cast<UINT>(i);
+		}
+		for (size_t i = triangleOrder.size() - 1; i > 0; --i)
+		{
+			std::swap(triangleOrder[i], triangleOrder[MathHelper::Rand(0, static_cast<int>(i))]);
+		}
+		for (UINT triangle : triangleOrder)
+		{
+			scrambledIndices.insert(scrambledIndices.end(), sphereIndices.begin() + triangle * 3, sphereIndices.begin() + triangle * 3 + 3);
+		}
+	}
+
+	Log("[MeshOptimization] %zu triangles, %zu vertices, FIFO cache of %d\n", sphereIndices.size() / 3, sphereVertices.size(), MeshOptimizer::CacheSize);
+	const std::pair<const char*, const std::vector<UINT>*> inputs[] = { { "Generated order", &sphereIndices }, { "Scrambled order", &scrambledIndices } };
+	bool passed = true;
+	for (const auto& [name, sourceIndices] : inputs)
+	{
+		std::vector<Vertex> vertices = sphereVertices;
+		std::vector<UINT> indices = *sourceIndices;
+		VertexCacheStats before;
+		VertexCacheStats after;
+		double optimizeMs = MeasureMilliseconds([&]() { MeshOptimizer::Optimize(vertices, indices, before, after); });
+		Log("  %-36s ACMR %.3f -> %.3f | ATVR %.3f -> %.3f | %8.2f ms\n", name, before.GetACMR(), after.GetACMR(), before.GetATVR(), after.GetATVR(), optimizeMs);
+
+		passed &= Check("Vertex transforms", after.transformCount < before.transformCount, "%zu, down from %zu", after.transformCount, before.transformCount);
+		passed &= Check("ACMR after optimizing", after.GetACMR() < 0.8f, "%.3f, bound below 0.8", after.GetACMR());
+	}
+	ReportChecks("MeshOptimization", passed);
+}
+
+void Benchmark::MeshletCulling()
+{
+	const int gridSize = 5;
+	const float spacing = 4.f;
+	const int frameCount = 256;
+
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	BuildSphere(256, 512, vertices, indices);
+	VertexCacheStats before;
+	VertexCacheStats after;
+	MeshOptimizer::Optimize(vertices, indices, before, after);
+	MeshPartition partition = MeshPartition::Build(indices, vertices.size());
+	std::vector<Meshlet> meshlets;
+	double buildMs = MeasureMilliseconds([&]() { meshlets = Meshlet::Build(partition, &vertices[0].position, sizeof(Vertex)); });
+
+	std::vector<XMFLOAT4X4> worlds;
+	for (int x = 0; x < gridSize; ++x)
+	{
+		for (int z = 0; z < gridSize; ++z)
+		{
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, XMMatrixTranslation((x - gridSize / 2) * spacing, 0.f, (z - gridSize / 2) * spacing));
+			worlds.push_back(world);
+		}
+	}
+	Log("[MeshletCulling] %d spheres of %zu triangles, %zu meshlets each, built in %.2f ms\n", gridSize * gridSize, indices.size() / 3, meshlets.size(), buildMs);
+
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.f / 9.f, 1.f, 1000.f);
+	struct CameraPath
+	{
+		const char* name;
+		XMVECTOR(*eye)(float t);
+		XMVECTOR(*target)(float t);
+	};
+	const CameraPath paths[] =
+	{
+		{ "Orbit", [](float t) { return XMVectorSet(30.f * cosf(XM_2PI * t), 8.f, 30.f * sinf(XM_2PI * t), 1.f); }, [](float t) { return XMVectorSet(0.f, 0.f, 0.f, 1.f); } },
+		{ "Fly through", [](float t) { return XMVectorSet(2.f, 1.5f, -15.f + 30.f * t, 1.f); }, [](float t) { return XMVectorSet(2.f, 1.f, -5.f + 30.f * t, 1.f); } },
+		{ "Close up", [](float t) { return XMVectorSet(3.f * cosf(XM_2PI * t), 0.5f, 3.f * sinf(XM_2PI * t), 1.f); }, [](float t) { return XMVectorSet(0.f, 0.f, 0.f, 1.f); } }
+	};
+
+	bool passed = true;
+	for (const CameraPath& path : paths)
+	{
+		MeshletCullStats stats;
+		double cullMs = 0.0;
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			float t = static_cast<float>(frame) / frameCount;
+			XMVECTOR eye = path.eye(t);
+			XMMATRIX viewProj = XMMatrixMultiply(XMMatrixLookAtLH(eye, path.target(t), XMVectorSet(0.f, 1.f, 0.f, 0.f)), proj);
+			MeshletCuller culler(viewProj, eye);
+			cullMs += MeasureMilliseconds([&]()
+				{
+					for (const XMFLOAT4X4& world : worlds)
+					{
+						culler.SetObject(XMLoadFloat4x4(&world));
+						culler.Cull(meshlets);
+					}
+				});
+			const MeshletCullStats& frameStats = culler.GetStats();
+			stats.meshletCount += frameStats.meshletCount;
+			stats.triangleCount += frameStats.triangleCount;
+			stats.frustumCulledTriangles += frameStats.frustumCulledTriangles;
+			stats.backfaceCulledTriangles += frameStats.backfaceCulledTriangles;
+			stats.rangeCount += frameStats.rangeCount;
+			stats.drawnTriangles += frameStats.drawnTriangles;
+		}
+
+		Log("  %-36s %6.2f ns/meshlet | %7.3f ms/frame | culled frustum %5.1f%%, backface %5.1f%% | drawn %5.1f%% in %6.1f ranges/frame\n", path.name,
+			cullMs * 1000000.0 / stats.meshletCount, cullMs / frameCount, 100.0 * stats.frustumCulledTriangles / stats.triangleCount,
+			100.0 * stats.backfaceCulledTriangles / stats.triangleCount, 100.0 * stats.drawnTriangles / stats.triangleCount,
+			static_cast<double>(stats.rangeCount) / frameCount);
+
+		//Spheres seen from outside turn close to half of their surface away, the cones are conservative but not by that much.
+		uint64_t inFrustumTriangles = stats.triangleCount - stats.frustumCulledTriangles;
+		passed &= Check("Backface culled", stats.backfaceCulledTriangles >= inFrustumTriangles / 4, "%llu of %llu triangles in the frustum, at least a quarter",
+			stats.backfaceCulledTriangles, inFrustumTriangles);
+		passed &= Check("Drawn", stats.drawnTriangles < stats.triangleCount, "%llu of %llu triangles", stats.drawnTriangles, stats.triangleCount);
+	}
+	ReportChecks("MeshletCulling", passed);
+}
+
+void Benchmark::MeshSimplification()
+{
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	BuildSphere(256, 512, vertices, indices);
+	VertexCacheStats before;
+	VertexCacheStats after;
+	MeshOptimizer::Optimize(vertices, indices, before, after);
+
+	std::vector<MeshLod> lods;
+	double buildMs = MeasureMilliseconds([&]() { lods = MeshSimplifier::BuildLods(vertices, indices); });
+	Log("[MeshSimplification] %zu triangles, %zu vertices, chain of %zu LODs in %.2f ms, %.2f M triangles/s\n", indices.size() / 3, vertices.size(),
+		lods.size(), buildMs, indices.size() / 3 / (buildMs * 1000.0));
+
+	//3 to 5 levels counting the source.
+	bool passed = Check("LODs below the source", lods.size() >= 2 && lods.size() <= MeshSimplifier::MaxLodCount, "%zu, bound 2 to %d", lods.size(),
+		MeshSimplifier::MaxLodCount);
+	size_t previousTriangleCount = indices.size() / 3;
+	float previousError = 0.f;
+	for (size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		size_t triangleCount = lods[lod].indices.size() / 3;
+		float measuredError = MeasureSphereError(vertices, lods[lod].indices);
+		Log("  LOD %zu %32zu triangles | recorded error %.6f | measured %.6f\n", lod + 1, triangleCount, lods[lod].error, measuredError);
+
+		passed &= CheckBound("Triangles", static_cast<double>(triangleCount), previousTriangleCount * MeshSimplifier::MinLodReduction);
+		passed &= Check("Recorded error", lods[lod].error >= previousError, "%.6f, at least the previous %.6f", lods[lod].error, previousError);
+		//The quadric error is a weighted mean over the planes a vertex gathered, the worst spot of a triangle may be a little off it.
+		passed &= CheckBound("Measured against recorded error", measuredError, 3.f * lods[lod].error + 1e-5f);
+		//Even the sixteenth of the triangles keeps a unit sphere within 1%.
+		passed &= Check("Measured error", measuredError < 0.01f, "%.6f, bound below 0.01", measuredError);
+		previousTriangleCount = triangleCount;
+		previousError = lods[lod].error;
+	}
+
+	//Imports build the chains of their meshes in parallel, as Model does.
+	const int meshCount = 16;
+	std::vector<Vertex> meshVertices;
+	std::vector<UINT> meshIndices;
+	BuildSphere(96, 192, meshVertices, meshIndices);
+	std::vector<std::vector<MeshLod>> chains(meshCount);
+	double serialMs = MeasureMilliseconds([&]()
+		{
+			for (int mesh = 0; mesh < meshCount; ++mesh)
+			{
+				chains[mesh] = MeshSimplifier::BuildLods(meshVertices, meshIndices);
+			}
+		});
+	ThreadPool threadPool;
+	double parallelMs = MeasureMilliseconds([&]()
+		{
+			threadPool.ParallelFor(meshCount, 1, [&](int begin, int end)
+				{
+					for (int mesh = begin; mesh < end; ++mesh)
+					{
+						chains[mesh] = MeshSimplifier::BuildLods(meshVertices, meshIndices);
+					}
+				});
+		});
+	Log("  %d meshes of %zu triangles %14s | serial %8.2f ms | ParallelFor %8.2f ms on %u workers + caller, %.1fx\n", meshCount, meshIndices.size() / 3, "",
+		serialMs, parallelMs, threadPool.GetThreadCount(), serialMs / parallelMs);
+	ReportChecks("MeshSimplification", passed);
+}
+
+void Benchmark::LodSelection()
+{
+	const int gridSize = 128;
+	const float scale = 4.f;
+	const float spacing = 12.f;
+	const int frameCount = 256;
+
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	BuildSphere(24, 48, vertices, indices);
+	VertexCacheStats before;
+	VertexCacheStats after;
+	MeshOptimizer::Optimize(vertices, indices, before, after);
+	std::vector<MeshLod> lods = MeshSimplifier::BuildLods(vertices, indices);
+	LodChainStats stats;
+	stats.Add(indices.size() / 3, lods);
+	int levelCount = static_cast<int>(lods.size()) + 1;
+	MeshBounds bounds = MeshBounds::FromVertices(vertices);
+
+	std::vector<XMFLOAT3> positions;
+	for (int x = 0; x < gridSize; ++x)
+	{
+		for (int z = 0; z < gridSize; ++z)
+		{
+			positions.push_back(XMFLOAT3((x - gridSize / 2) * spacing, 0.f, z * spacing));
+		}
+	}
+	Log("[LodSelection] %zu spheres, %d levels of %zu to %zu triangles, coarsest error %.4f\n", positions.size(), levelCount, stats.triangleCounts[0],
+		stats.triangleCounts[levelCount - 1], stats.errors[levelCount - 1] * scale);
+
+	//1080 rows, as Demo projects with.
+	float pixelsPerUnit = 1.f / tanf(0.125f * XM_PI) * 1080.f * 0.5f;
+	//The camera drifts into the field while swaying back and forth by a metre, as a player idling in place would.
+	auto eyeAt = [](int frame)
+		{
+			float t = static_cast<float>(frame) / frameCount;
+			return XMVectorSet(0.f, 2.f, -10.f + 40.f * t + sinf(0.5f * frame), 1.f);
+		};
+
+	const float hysteresisValues[] = { 0.f, 0.25f };
+	uint64_t switchCounts[2] = {};
+	bool passed = true;
+	for (int run = 0; run < 2; ++run)
+	{
+		LodSelector selector;
+		selector.mHysteresis = hysteresisValues[run];
+		std::vector<int> currentLods(positions.size(), 0);
+		double selectMs = 0.0;
+		uint64_t selectedTriangles = 0;
+		uint64_t fullDetailTriangles = 0;
+		uint64_t scalarMismatches = 0;
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			XMVECTOR eye = eyeAt(frame);
+			selectMs += MeasureMilliseconds([&]()
+				{
+					selector.Clear();
+					for (size_t i = 0; i < positions.size(); ++i)
+					{
+						selector.Add(XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), XMMatrixTranslation(positions[i].x, positions[i].y, positions[i].z)), bounds, stats, levelCount, currentLods[i]);
+					}
+					selector.Select(eye, pixelsPerUnit);
+				});
+			selectedTriangles += selector.GetSelectedTriangles();
+			fullDetailTriangles += selector.GetFullDetailTriangles();
+
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				int slot = static_cast<int>(i);
+				//Rounding may differ at a boundary, so the batch only has to land between a slightly stricter and looser threshold.
+				float distance = std::max(XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&positions[i]), eye))) - bounds.radius * scale, 1e-3f);
+				int lod = selector.GetLod(slot);
+				int coarsestLod = SelectLodScalar(stats, levelCount, currentLods[i], distance, pixelsPerUnit * scale, selector.mPixelThreshold * 1.001f, selector.mHysteresis);
+				int finestLod = SelectLodScalar(stats, levelCount, currentLods[i], distance, pixelsPerUnit * scale, selector.mPixelThreshold * 0.999f, selector.mHysteresis);
+				scalarMismatches += (lod < finestLod || lod > coarsestLod) ? 1 : 0;
+				//The first frame settles every object from LOD 0.
+				switchCounts[run] += (frame > 0 && lod != currentLods[i]) ? 1 : 0;
+				currentLods[i] = lod;
+			}
+		}
+
+		Log("  hysteresis %4.2f %21s | %6.2f ns/object | %8.1f switches/frame | %5.1f%% of the full detail triangles\n", hysteresisValues[run], "",
+			selectMs * 1000000.0 / (static_cast<double>(positions.size()) * frameCount), static_cast<double>(switchCounts[run]) / frameCount,
+			100.0 * selectedTriangles / fullDetailTriangles);
+		passed &= CheckBound("Objects off the scalar selection", static_cast<double>(scalarMismatches), 0.0);
+		passed &= Check("Selected triangles", selectedTriangles < fullDetailTriangles, "%llu of %llu at full detail", selectedTriangles, fullDetailTriangles);
+	}
+	//Without it, every object near a boundary flips with the sway.
+	passed &= Check("Switches with hysteresis", switchCounts[1] * 2 < switchCounts[0], "%llu, bound below half of %llu", switchCounts[1], switchCounts[0]);
+
+	//From a standing camera, a budget a quarter of the way from all objects at their coarsest level to what the pixel error alone selects.
+	LodSelector selector;
+	std::vector<int> currentLods(positions.size(), 0);
+	XMVECTOR eye = eyeAt(0);
+	auto selectFrame = [&]()
+		{
+			selector.Clear();
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				selector.Add(XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), XMMatrixTranslation(positions[i].x, positions[i].y, positions[i].z)), bounds, stats, levelCount, currentLods[i]);
+			}
+			selector.Select(eye, pixelsPerUnit);
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				currentLods[i] = selector.GetLod(static_cast<int>(i));
+			}
+		};
+	selectFrame();
+	uint64_t unbudgetedTriangles = selector.GetSelectedTriangles();
+	uint64_t coarsestTriangles = positions.size() * stats.triangleCounts[levelCount - 1];
+	selector.mTriangleBudget = coarsestTriangles + (unbudgetedTriangles - coarsestTriangles) / 4;
+	int framesToBudget = 0;
+	while (selector.GetSelectedTriangles() > selector.mTriangleBudget && framesToBudget < 64)
+	{
+		selectFrame();
+		++framesToBudget;
+	}
+	for (int frame = 0; frame < 64; ++frame)
+	{
+		selectFrame();
+	}
+	Log("  budget %llu of %llu triangles %8s | met in %d frames at %.2f pixels, %llu triangles 64 frames later\n", selector.mTriangleBudget, unbudgetedTriangles, "",
+		framesToBudget, selector.GetEffectiveThreshold(), selector.GetSelectedTriangles());
+	passed &= Check("Frames to meet the budget", framesToBudget < 64, "%d, bound below 64", framesToBudget);
+	passed &= Check("Triangles 64 frames later", selector.GetSelectedTriangles() <= selector.mTriangleBudget, "%llu, bound %llu",
+		selector.GetSelectedTriangles(), selector.mTriangleBudget);
+	ReportChecks("LodSelection", passed);
+}
+
+void Benchmark::BoundingVolumes()
+{
+	const int repeatCount = 64;
+
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	BuildSphere(256, 512, vertices, indices);
+	//Off center and squashed, so the box and sphere do not come out the same for any axis.
+	for (Vertex& vertex : vertices)
+	{
+		vertex.position = XMFLOAT3(vertex.position.x * 3.f + 5.f, vertex.position.y - 2.f, vertex.position.z * 0.5f);
+	}
+
+	MeshBounds bounds;
+	double reductionMs = MeasureMilliseconds([&]()
+		{
+			for (int repeat = 0; repeat < repeatCount; ++repeat)
+			{
+				bounds = MeshBounds::FromVertices(vertices);
+			}
+		}) / repeatCount;
+	XMFLOAT3 scalarMin;
+	XMFLOAT3 scalarMax;
+	float scalarRadiusSq;
+	double scalarMs = MeasureMilliseconds([&]()
+		{
+			for (int repeat = 0; repeat < repeatCount; ++repeat)
+			{
+				scalarMin = vertices[0].position;
+				scalarMax = vertices[0].position;
+				for (const Vertex& vertex : vertices)
+				{
+					scalarMin = XMFLOAT3(std::min(scalarMin.x, vertex.position.x), std::min(scalarMin.y, vertex.position.y), std::min(scalarMin.z, vertex.position.z));
+					scalarMax = XMFLOAT3(std::max(scalarMax.x, vertex.position.x), std::max(scalarMax.y, vertex.position.y), std::max(scalarMax.z, vertex.position.z));
+				}
+				XMFLOAT3 center((scalarMin.x + scalarMax.x) * 0.5f, (scalarMin.y + scalarMax.y) * 0.5f, (scalarMin.z + scalarMax.z) * 0.5f);
+				scalarRadiusSq = 0.f;
+				for (const Vertex& vertex : vertices)
+				{
+					float dx = vertex.position.x - center.x;
+					float dy = vertex.position.y - center.y;
+					float dz = vertex.position.z - center.z;
+					scalarRadiusSq = std::max(scalarRadiusSq, dx * dx + dy * dy + dz * dz);
+				}
+			}
+		}) / repeatCount;
+	Log("[BoundingVolumes] %zu vertices of %zu bytes\n", vertices.size(), sizeof(Vertex));
+	Log("  %-36s %8.3f ms | %7.1f M vertices/s\n", "XMVECTOR, 4 accumulators", reductionMs, vertices.size() / (reductionMs * 1000.0));
+	Log("  %-36s %8.3f ms | %7.1f M vertices/s\n", "Scalar", scalarMs, vertices.size() / (scalarMs * 1000.0));
+
+	bool passed = Check("Box min against scalar", bounds.boundsMin.x == scalarMin.x && bounds.boundsMin.y == scalarMin.y && bounds.boundsMin.z == scalarMin.z,
+		"%g %g %g, scalar %g %g %g", bounds.boundsMin.x, bounds.boundsMin.y, bounds.boundsMin.z, scalarMin.x, scalarMin.y, scalarMin.z);
+	passed &= Check("Box max against scalar", bounds.boundsMax.x == scalarMax.x && bounds.boundsMax.y == scalarMax.y && bounds.boundsMax.z == scalarMax.z,
+		"%g %g %g, scalar %g %g %g", bounds.boundsMax.x, bounds.boundsMax.y, bounds.boundsMax.z, scalarMax.x, scalarMax.y, scalarMax.z);
+	passed &= CheckBound("Radius off the scalar one", fabsf(bounds.radius - sqrtf(scalarRadiusSq)), 1e-4f);
+
+	//Rotated, non-uniformly scaled and moved, as no Object does yet but the bounds should allow.
+	XMMATRIX world = XMMatrixScaling(2.f, 0.5f, 1.f) * XMMatrixRotationRollPitchYaw(0.3f, 1.1f, -0.7f) * XMMatrixTranslation(10.f, -4.f, 7.f);
+	MeshBounds worldBounds = bounds.Transform(world);
+	MeshBounds merged = MeshBounds::Merge(bounds, worldBounds);
+	const float tolerance = 1e-4f;
+	float farthest = 0.f;
+	//How far the farthest vertex lies outside each volume, negative while all are inside.
+	float sphereExcess = -FLT_MAX;
+	float worldSphereExcess = -FLT_MAX;
+	float worldBoxMinExcess = -FLT_MAX;
+	float worldBoxMaxExcess = -FLT_MAX;
+	float mergedExcess = -FLT_MAX;
+	float mergedWorldExcess = -FLT_MAX;
+	for (const Vertex& vertex : vertices)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertex.position);
+		XMVECTOR worldPosition = XMVector3Transform(position, world);
+		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(position, XMLoadFloat3(&bounds.center))));
+		sphereExcess = std::max(sphereExcess, distance - bounds.radius);
+		worldSphereExcess = std::max(worldSphereExcess, XMVectorGetX(XMVector3Length(XMVectorSubtract(worldPosition, XMLoadFloat3(&worldBounds.center)))) - worldBounds.radius);
+		XMFLOAT3 belowMin;
+		XMFLOAT3 aboveMax;
+		XMStoreFloat3(&belowMin, XMVectorSubtract(XMLoadFloat3(&worldBounds.boundsMin), worldPosition));
+		XMStoreFloat3(&aboveMax, XMVectorSubtract(worldPosition, XMLoadFloat3(&worldBounds.boundsMax)));
+		worldBoxMinExcess = std::max(worldBoxMinExcess, std::max(belowMin.x, std::max(belowMin.y, belowMin.z)));
+		worldBoxMaxExcess = std::max(worldBoxMaxExcess, std::max(aboveMax.x, std::max(aboveMax.y, aboveMax.z)));
+		mergedExcess = std::max(mergedExcess, XMVectorGetX(XMVector3Length(XMVectorSubtract(position, XMLoadFloat3(&merged.center)))) - merged.radius);
+		mergedWorldExcess = std::max(mergedWorldExcess, XMVectorGetX(XMVector3Length(XMVectorSubtract(worldPosition, XMLoadFloat3(&merged.center)))) - merged.radius);
+		farthest = std::max(farthest, distance);
+	}
+	XMFLOAT3 extents;
+	XMStoreFloat3(&extents, XMVectorScale(XMVectorSubtract(XMLoadFloat3(&bounds.boundsMax), XMLoadFloat3(&bounds.boundsMin)), 0.5f));
+	Log("  sphere radius %.3f against half diagonal %.3f, world radius %.3f, merged radius %.3f\n", bounds.radius,
+		sqrtf(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z), worldBounds.radius, merged.radius);
+	passed &= CheckBound("Outside the sphere, by", sphereExcess, tolerance);
+	passed &= CheckBound("Outside the world sphere, by", worldSphereExcess, tolerance);
+	passed &= CheckBound("Below the world box min, by", worldBoxMinExcess, tolerance);
+	passed &= CheckBound("Above the world box max, by", worldBoxMaxExcess, tolerance);
+	passed &= CheckBound("Outside the merged sphere, by", mergedExcess, tolerance);
+	passed &= CheckBound("World outside the merged sphere, by", mergedWorldExcess, tolerance);
+	//Some position sits on the sphere, it is not looser than it has to be around its center.
+	passed &= Check("Farthest vertex from the center", farthest >= bounds.radius - tolerance, "%g, radius %g", farthest, bounds.radius);
+	ReportChecks("BoundingVolumes", passed);
+}
+
+void Benchmark::GeometryPoolAllocation()
+{
+	//A block of GeometryPool, and meshes from a few dozen to a few thousand vertices.
+	const uint64_t capacity = 1 << 20;
+	const int minSize = 64;
+	const int maxSize = 8192;
+	const int churnCount = 200000;
+
+	struct Range
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+	RangeAllocator allocator(capacity);
+	std::vector<Range> live;
+
+	int fillCount = 0;
+	double fillMs = MeasureMilliseconds([&]()
+		{
+			while (true)
+			{
+				uint64_t size = MathHelper::Rand(minSize, maxSize);
+				uint64_t offset = allocator.Allocate(size);
+				if (offset == RangeAllocator::InvalidOffset)
+				{
+					break;
+				}
+				live.push_back({ offset, size });
+				++fillCount;
+			}
+		});
+
+	//Unload a random mesh and load another, as streaming does, until the free list is well shuffled.
+	int failedCount = 0;
+	double churnMs = MeasureMilliseconds([&]()
+		{
+			for (int i = 0; i < churnCount; ++i)
+			{
+				if (live.empty() == false)
+				{
+					size_t victim = MathHelper::Rand(0, static_cast<int>(live.size()) - 1);
+					allocator.Free(live[victim].offset, live[victim].size);
+					live[victim] = live.back();
+					live.pop_back();
+				}
+				uint64_t size = MathHelper::Rand(minSize, maxSize);
+				uint64_t offset = allocator.Allocate(size);
+				if (offset == RangeAllocator::InvalidOffset)
+				{
+					++failedCount;
+					continue;
+				}
+				live.push_back({ offset, size });
+			}
+		});
+
+	std::sort(live.begin(), live.end(), [](const Range& a, const Range& b) { return a.offset < b.offset; });
+	uint64_t liveSize = 0;
+	int outsideCount = 0;
+	int overlapCount = 0;
+	for (size_t i = 0; i < live.size(); ++i)
+	{
+		outsideCount += live[i].offset + live[i].size > capacity ? 1 : 0;
+		overlapCount += (i + 1 < live.size() && live[i].offset + live[i].size > live[i + 1].offset) ? 1 : 0;
+		liveSize += live[i].size;
+	}
+
+	Log("[GeometryPoolAllocation] %llu elements, ranges of %d to %d\n", capacity, minSize, maxSize);
+	Log("  %-36s %8.1f ns/op | %d ranges\n", "Fill", fillMs * 1e6 / (fillCount + 1), fillCount);
+	Log("  %-36s %8.1f ns/op | %zu ranges, %d failed\n", "Churn, free and allocate", churnMs * 1e6 / (churnCount * 2), live.size(), failedCount);
+	Log("  %-36s %7.1f%% used | %zu free ranges, largest %llu, fragmentation %.2f\n", "After churn", 100.0 * liveSize / capacity,
+		allocator.GetFreeRangeCount(), allocator.GetLargestFreeRange(), allocator.GetFragmentation());
+	bool passed = CheckBound("Ranges past the end", outsideCount, 0.0);
+	passed &= CheckBound("Overlapping ranges", overlapCount, 0.0);
+	passed &= Check("Free size", allocator.GetFreeSize() == capacity - liveSize, "%llu, capacity less live %llu", allocator.GetFreeSize(), capacity - liveSize);
+
+	//What Defragment does with the block: the live ranges again, in offset order, from an empty allocator.
+	RangeAllocator packed(capacity);
+	int misplacedCount = 0;
+	double packMs = MeasureMilliseconds([&]()
+		{
+			packed.Reset();
+			uint64_t end = 0;
+			for (const Range& range : live)
+			{
+				uint64_t offset = packed.Allocate(range.size);
+				misplacedCount += offset != end ? 1 : 0;
+				end = offset + range.size;
+			}
+		});
+	Log("  %-36s %8.3f ms | fragmentation %.2f\n", "Repack", packMs, packed.GetFragmentation());
+	passed &= CheckBound("Repacked ranges out of place", misplacedCount, 0.0);
+	passed &= CheckBound("Repacked fragmentation", packed.GetFragmentation(), 0.0);
+	passed &= Check("Repacked largest free range", packed.GetLargestFreeRange() == capacity - liveSize, "%llu, capacity less live %llu",
+		packed.GetLargestFreeRange(), capacity - liveSize);
+
+	//Freed out of order, the ranges still merge into one.
+	for (size_t i = 0; i < live.size(); i += 2)
+	{
+		allocator.Free(live[i].offset, live[i].size);
+	}
+	for (size_t i = 1; i < live.size(); i += 2)
+	{
+		allocator.Free(live[i].offset, live[i].size);
+	}
+	passed &= Check("Free ranges after freeing all", allocator.GetFreeRangeCount() == 1 && allocator.GetLargestFreeRange() == capacity, "%zu, largest %llu",
+		allocator.GetFreeRangeCount(), allocator.GetLargestFreeRange());
+	ReportChecks("GeometryPoolAllocation", passed);
+}
+
+void Benchmark::ObjParsing()
+{
+	//Those of Demo::BuildModels, the ones missing from the checkout are skipped.
+	const char* modelFiles[] =
+	{
+		"../models/Skybox.obj", "../models/Sphere.obj", "../models/Plane.obj", "../models/bunny.obj", "../models/Cube.obj",
+		"../models/Torus.obj", "../models/Monkey.obj", "../models/dragon.obj", "../models/bmw.obj", "../models/buddha.obj"
+	};
+	ThreadPool threadPool;
+
+	Log("[ObjParsing] %u worker threads\n", threadPool.GetThreadCount());
+	bool passed = true;
+	for (const char* modelFile : modelFiles)
+	{
+		MappedFile file;
+		if (file.Open(modelFile) == false)
+		{
+			continue;
+		}
+		//Touch every page, so no run pays for reading the file from disk.
+		size_t lineCount = std::count(file.GetData(), file.GetData() + file.GetSize(), '\n');
+		double megabytes = file.GetSize() / (1024.0 * 1024.0);
+
+		std::vector<ObjMesh> serialMeshes;
+		ObjParseStats serialStats;
+		double serialMs = MeasureMilliseconds([&]() { ObjParser::Load(modelFile, serialMeshes, nullptr, &serialStats); });
+		std::vector<ObjMesh> parallelMeshes;
+		ObjParseStats parallelStats;
+		double parallelMs = MeasureMilliseconds([&]() { ObjParser::Load(modelFile, parallelMeshes, &threadPool, &parallelStats); });
+
+		size_t assimpTriangles = 0;
+		size_t assimpVertices = 0;
+		MeshBounds assimpBounds;
+		//Kept past the timing for the normals compared below.
+		Assimp::Importer importer;
+		const aiScene* scene = nullptr;
+		double assimpMs = MeasureMilliseconds([&]()
+			{
+				scene = importer.ReadFile(modelFile, Model::ImportFlags);
+				for (unsigned int i = 0; scene != nullptr && i < scene->mNumMeshes; ++i)
+				{
+					const aiMesh* mesh = scene->mMeshes[i];
+					for (unsigned int face = 0; face < mesh->mNumFaces; ++face)
+					{
+						assimpTriangles += mesh->mFaces[face].mNumIndices == 3;
+					}
+					assimpVertices += mesh->mNumVertices;
+					static_assert(sizeof(aiVector3D) == sizeof(XMFLOAT3), "aiVector3D is read as XMFLOAT3");
+					assimpBounds = MeshBounds::Merge(assimpBounds,
+						MeshBounds::FromPositions(reinterpret_cast<const XMFLOAT3*>(mesh->mVertices), mesh->mNumVertices, sizeof(aiVector3D)));
+				}
+			});
+
+		Log("  %s, %.2f MB, %zu lines, %zu triangles\n", modelFile, megabytes, lineCount, serialStats.triangleCount);
+		Log("  %-36s %8.2f ms | %7.1f MB/s | %zu vertices\n", "Assimp", assimpMs, megabytes * 1000.0 / assimpMs, assimpVertices);
+		Log("  %-36s %8.2f ms | %7.1f MB/s | %zu vertices, parse %.2f ms, weld %.2f ms\n", "ObjParser", serialMs, megabytes * 1000.0 / serialMs,
+			serialStats.vertexCount, serialStats.parseMilliseconds, serialStats.buildMilliseconds);
+		Log("  %-36s %8.2f ms | %7.1f MB/s | %d chunks\n", "ObjParser, thread pool", parallelMs, megabytes * 1000.0 / parallelMs, parallelStats.chunkCount);
+
+		if (Check("Assimp import", scene != nullptr, "%s", scene != nullptr ? "read with Model::ImportFlags" : importer.GetErrorString()) == false)
+		{
+			passed = false;
+			continue;
+		}
+
+		//Chunking must not change the result.
+		passed &= Check("Meshes on the thread pool", serialMeshes.size() == parallelMeshes.size(), "%zu, serial %zu", parallelMeshes.size(), serialMeshes.size());
+		MeshBounds parsedBounds;
+		int differentCount = 0;
+		for (size_t i = 0; i < serialMeshes.size(); ++i)
+		{
+			bool same = i < parallelMeshes.size() && serialMeshes[i].indices == parallelMeshes[i].indices &&
+				serialMeshes[i].vertices.size() == parallelMeshes[i].vertices.size();
+			differentCount += same ? 0 : 1;
+			parsedBounds = MeshBounds::Merge(parsedBounds, MeshBounds::FromVertices(serialMeshes[i].vertices));
+		}
+		passed &= CheckBound("Meshes changed by the thread pool", differentCount, 0.0);
+		passed &= Check("Triangles against Assimp", serialStats.triangleCount == assimpTriangles, "%zu, Assimp %zu", serialStats.triangleCount, assimpTriangles);
+		passed &= Check("Vertices against Assimp", serialStats.vertexCount <= assimpVertices, "%zu, at most Assimp's %zu", serialStats.vertexCount, assimpVertices);
+		const float tolerance = 1e-4f;
+		passed &= Check("Bounds min against Assimp", XMVector3NearEqual(XMLoadFloat3(&parsedBounds.boundsMin), XMLoadFloat3(&assimpBounds.boundsMin), XMVectorReplicate(tolerance)),
+			"%g %g %g, Assimp %g %g %g", parsedBounds.boundsMin.x, parsedBounds.boundsMin.y, parsedBounds.boundsMin.z,
+			assimpBounds.boundsMin.x, assimpBounds.boundsMin.y, assimpBounds.boundsMin.z);
+		passed &= Check("Bounds max against Assimp", XMVector3NearEqual(XMLoadFloat3(&parsedBounds.boundsMax), XMLoadFloat3(&assimpBounds.boundsMax), XMVectorReplicate(tolerance)),
+			"%g %g %g, Assimp %g %g %g", parsedBounds.boundsMax.x, parsedBounds.boundsMax.y, parsedBounds.boundsMax.z,
+			assimpBounds.boundsMax.x, assimpBounds.boundsMax.y, assimpBounds.boundsMax.z);
+
+		//Each Assimp vertex against the closest normal of the parsed vertices at its position, sorted by x to find them.
+		std::vector<const Vertex*> parsedVertices;
+		for (const ObjMesh& mesh : serialMeshes)
+		{
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				parsedVertices.push_back(&vertex);
+			}
+		}
+		std::sort(parsedVertices.begin(), parsedVertices.end(), [](const Vertex* a, const Vertex* b) { return a->position.x < b->position.x; });
+		//Assimp leaves the normals it generates facing inwards, see ObjParser.
+		const char normalKeyword[] = "\nvn ";
+		bool fileHasNormals = std::search(file.GetData(), file.GetData() + file.GetSize(), normalKeyword, normalKeyword + 4) != file.GetData() + file.GetSize();
+		float normalSign = fileHasNormals ? 1.f : -1.f;
+		auto closeTo = [](float a, float b) { return fabsf(a - b) <= 1e-5f * (1.f + fabsf(b)); };
+		const float maxNormalAngle = 1.f;
+		float worstAngle = 0.f;
+		size_t offCount = 0;
+		size_t unmatchedCount = 0;
+		for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+		{
+			const aiMesh* mesh = scene->mMeshes[i];
+			for (unsigned int vertex = 0; vertex < mesh->mNumVertices; ++vertex)
+			{
+				const aiVector3D& position = mesh->mVertices[vertex];
+				XMVECTOR normal = XMVectorScale(XMVectorSet(mesh->mNormals[vertex].x, mesh->mNormals[vertex].y, mesh->mNormals[vertex].z, 0.f), normalSign);
+				float minX = position.x - 1e-5f * (1.f + fabsf(position.x));
+				auto candidate = std::lower_bound(parsedVertices.begin(), parsedVertices.end(), minX, [](const Vertex* a, float x) { return a->position.x < x; });
+				float angle = FLT_MAX;
+				for (; candidate != parsedVertices.end() && closeTo((*candidate)->position.x, position.x); ++candidate)
+				{
+					if (closeTo((*candidate)->position.y, position.y) && closeTo((*candidate)->position.z, position.z))
+					{
+						angle = std::min(angle, XMConvertToDegrees(XMVectorGetX(XMVector3AngleBetweenVectors(normal, XMLoadFloat3(&(*candidate)->normal)))));
+					}
+				}
+				if (angle == FLT_MAX)
+				{
+					++unmatchedCount;
+					continue;
+				}
+				worstAngle = std::max(worstAngle, angle);
+				offCount += angle > maxNormalAngle;
+			}
+		}
+		//The float parsers may round a coordinate a bit apart, which can move a vertex across the smoothing distance, so a
+		//few vertices are allowed off.
+		passed &= Check("Normals against Assimp", unmatchedCount == 0 && offCount * 1000 <= assimpVertices, "worst %.3f deg, %zu over %.0f deg, %zu without a parsed vertex%s",
+			worstAngle, offCount, maxNormalAngle, unmatchedCount, fileHasNormals ? "" : ", generated");
+	}
+	ReportChecks("ObjParsing", passed);
+}
+
+void Benchmark::VertexWelding()
+{
+	//Every corner a vertex of its own, and every other one moved well within the tolerance, as rounding in an exporter does.
+	auto splitCorners = [](const std::vector<Vertex>& vertices, const std::vector<UINT>& indices, std::vector<Vertex>& corners, std::vector<UINT>& cornerIndices)
+		{
+			corners.clear();
+			cornerIndices.clear();
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				Vertex corner = vertices[indices[i]];
+				if (i % 2 == 1)
+				{
+					corner.position.x += 1e-7f;
+				}
+				corners.push_back(corner);
+				cornerIndices.push_back(static_cast<UINT>(i));
+			}
+		};
+	//Corners that no longer land on their vertex, all of them when the triangles do not line up.
+	auto countChangedCorners = [](const std::vector<Vertex>& vertices, const std::vector<UINT>& indices, const std::vector<Vertex>& welded, const std::vector<UINT>& weldedIndices)
+		{
+			if (indices.size() != weldedIndices.size())
+			{
+				return indices.size();
+			}
+			size_t changedCount = 0;
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				const Vertex& original = vertices[indices[i]];
+				const Vertex& result = welded[weldedIndices[i]];
+				bool samePosition = fabsf(original.position.x - result.position.x) <= 1e-6f && original.position.y == result.position.y && original.position.z == result.position.z;
+				changedCount += (samePosition && original.UV.x == result.UV.x && original.UV.y == result.UV.y) ? 0 : 1;
+			}
+			return changedCount;
+		};
+
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	BuildSphere(256, 512, vertices, indices);
+	std::vector<Vertex> corners;
+	std::vector<UINT> cornerIndices;
+	splitCorners(vertices, indices, corners, cornerIndices);
+	size_t cornerCount = corners.size();
+
+	WeldStats stats;
+	double weldMs = MeasureMilliseconds([&]() { stats = VertexWelder::Weld(corners, cornerIndices); });
+	Log("[VertexWelding] %zu corners of a sphere of %zu vertices\n", cornerCount, vertices.size());
+	Log("  %-36s %8.2f ms | %7.1f M vertices/s | %zu -> %zu vertices, %zu degenerate\n", "Hashed grid", weldMs, cornerCount / (weldMs * 1000.0),
+		stats.vertexCountBefore, stats.vertexCountAfter, stats.degenerateTriangles);
+	//The seam and the poles share positions but not UVs, so exactly the vertices of the indexed sphere come back.
+	bool passed = Check("Welded vertices", stats.vertexCountAfter == vertices.size() && corners.size() == vertices.size(), "%zu, indexed sphere %zu",
+		corners.size(), vertices.size());
+	passed &= CheckBound("Degenerate triangles", static_cast<double>(stats.degenerateTriangles), 0.0);
+	passed &= CheckBound("Corners changed by welding", static_cast<double>(countChangedCorners(vertices, indices, corners, cornerIndices)), 0.0);
+
+	//Small enough for every pair.
+	std::vector<Vertex> smallVertices;
+	std::vector<UINT> smallIndices;
+	BuildSphere(24, 48, smallVertices, smallIndices);
+	splitCorners(smallVertices, smallIndices, corners, cornerIndices);
+	std::vector<WeldVertex> attributes;
+	for (const Vertex& corner : corners)
+	{
+		attributes.push_back(VertexWelder::ToWeldVertex(corner));
+	}
+	WeldTolerance tolerance;
+	MeshBounds bounds = MeshBounds::FromVertices(corners);
+	float positionTolerance = tolerance.position * XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&bounds.boundsMax), XMLoadFloat3(&bounds.boundsMin))));
+	std::vector<uint32_t> bruteKept;
+	double bruteMs = MeasureMilliseconds([&]()
+		{
+			for (size_t i = 0; i < attributes.size(); ++i)
+			{
+				bool welded = false;
+				for (uint32_t kept : bruteKept)
+				{
+					const WeldVertex& a = attributes[kept];
+					const WeldVertex& b = attributes[i];
+					if (fabsf(a.position.x - b.position.x) <= positionTolerance && fabsf(a.position.y - b.position.y) <= positionTolerance &&
+						fabsf(a.position.z - b.position.z) <= positionTolerance && a.UV.x == b.UV.x && a.UV.y == b.UV.y)
+					{
+						welded = true;
+						break;
+					}
+				}
+				if (welded == false)
+				{
+					bruteKept.push_back(static_cast<uint32_t>(i));
+				}
+			}
+		});
+	std::vector<UINT> smallCornerIndices = cornerIndices;
+	std::vector<uint32_t> gridKept;
+	double gridMs = MeasureMilliseconds([&]() { VertexWelder::Weld(attributes, smallCornerIndices, tolerance, gridKept); });
+	Log("  %-36s %8.3f ms | %zu corners\n", "Brute force", bruteMs, attributes.size());
+	Log("  %-36s %8.3f ms | %zu corners\n", "Hashed grid", gridMs, attributes.size());
+	//Both keep the first vertex of each group, so they keep the same ones.
+	passed &= Check("Kept vertices against brute force", bruteKept == gridKept, "%zu, brute force %zu", gridKept.size(), bruteKept.size());
+	ReportChecks("VertexWelding", passed);
+}
+
+void Benchmark::Log(const char* format, ...)
+{
+	char buffer[512];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	OutputDebugStringA(buffer);
+}
+
+bool Benchmark::Check(const char* name, bool passed, const char* format, ...)
+{
+	char details[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(details, sizeof(details), format, args);
+	va_end(args);
+	Log("  %-36s %-4s %s\n", name, passed ? "ok" : "FAIL", details);
+	return passed;
+}
+
+bool Benchmark::CheckBound(const char* name, double value, double bound)
+{
+	return Check(name, value <= bound, "%g, bound %g", value, bound);
+}
+
+void Benchmark::ReportChecks(const char* benchmark, bool passed)
+{
+	if (passed == false)
+	{
+		Log("  [%s] FAILED: see the checks marked FAIL above\n", benchmark);
+	}
+	assert(passed);
+}
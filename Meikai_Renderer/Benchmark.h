@@ -0,0 +1,107 @@
+#pragma once
+#include <chrono>
+
+/**
+ * @brief CPU micro benchmarks for engine subsystems.
+ * @detail Results are written to the debugger output. Define MEIKAI_BENCHMARK to run them after Demo initialization.
+ */
+struct Benchmark
+{
+	static void RunAll();
+
+	/**
+	 * @brief Compare build time, memory and query time of the arc length engines.
+	 */
+	static void ArcLength();
+
+	/**
+	 * @brief Compare closest point queries through the segment BVH against dense sampling of every segment.
+	 */
+	static void ClosestPoint();
+
+	/**
+	 * @brief Navmesh build time, flat against hierarchical A* latency, and replans per second on the thread pool.
+	 */
+	static void NavMeshQuery();
+
+	/**
+	 * @brief Spatial hash build and neighbour query cost against agent density, and crowd update time with and without avoidance.
+	 */
+	static void CrowdAvoidance();
+
+	/**
+	 * @brief Packing throughput and size of the compressed vertex formats, and their worst round trip errors.
+	 * @detail Checks that the errors stay within the bounds the G-buffer can tolerate.
+	 */
+	static void VertexPacking();
+
+	/**
+	 * @brief Simulated ACMR and ATVR of a dense sphere before and after MeshOptimizer, in generated and in scrambled triangle order.
+	 * @detail Checks that the optimizer cuts the vertex transforms and brings the ACMR under 0.8.
+	 */
+	static void MeshOptimization();
+
+	/**
+	 * @brief Meshlet culling throughput, triangles rejected by the frustum and by normal cones, and draw ranges left, along camera paths through a field of spheres.
+	 * @detail Checks that the normal cones reject a fair share of what faces away and that culling leaves triangles out.
+	 */
+	static void MeshletCulling();
+
+	/**
+	 * @brief Speed of building a LOD chain, the triangles and error of each LOD against the true surface, and chains of many meshes on the thread pool.
+	 * @detail Checks the length of the chain, that every LOD cuts enough triangles, and that the true error stays within a few times the recorded one.
+	 */
+	static void MeshSimplification();
+
+	/**
+	 * @brief Cost of LOD selection per object, LOD switches along a jittering camera path with and without hysteresis, and how fast a triangle budget is met.
+	 * @detail Checks that the batched selection matches a scalar one, that hysteresis cuts the switches and that the budget is met.
+	 */
+	static void LodSelection();
+
+	/**
+	 * @brief Speed of the min/max reduction that bounds a mesh, against a scalar loop.
+	 * @detail Checks that the bounds match the scalar ones and that the world space and merged bounds contain every vertex.
+	 */
+	static void BoundingVolumes();
+
+	/**
+	 * @brief Allocate and free cost of the free list behind GeometryPool under mesh load and unload churn, and the fragmentation it leaves.
+	 * @detail Checks that no ranges overlap, that freeing everything merges back into one range, and that repacking the live ranges leaves no fragmentation.
+	 */
+	static void GeometryPoolAllocation();
+
+	/**
+	 * @brief Throughput of ObjParser in MB/s, on one thread and on the thread pool, against Assimp with Model::ImportFlags on the OBJ models of the demo.
+	 * @detail Checks that both imports give the same triangles, bounds and normals, and that the thread pool does not change the result.
+	 */
+	static void ObjParsing();
+
+	/**
+	 * @brief Speed of VertexWelder on a sphere split into a vertex per face corner, as the generic importer leaves meshes, against a brute force search.
+	 * @detail Checks that welding gives back the vertices of the indexed sphere and the same triangles, and that it matches the brute force result.
+	 */
+	static void VertexWelding();
+
+private:
+	static void Log(const char* format, ...);
+	/**
+	 * @brief Log a check as ok or FAIL, followed by its printf style details, and return whether it passed.
+	 * @detail Checks are logged rather than only asserted, so a Release benchmark build still reports them.
+	 */
+	static bool Check(const char* name, bool passed, const char* format, ...);
+	static bool CheckBound(const char* name, double value, double bound);
+	/**
+	 * @brief Log that a benchmark failed unless all of its checks passed, and assert in Debug builds.
+	 */
+	static void ReportChecks(const char* benchmark, bool passed);
+
+	template<typename Func>
+	static double MeasureMilliseconds(Func&& func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+};
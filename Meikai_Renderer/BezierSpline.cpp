@@ -0,0 +1,260 @@
+#include "BezierSpline.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	//Intervals of a closest point search are four lanes per group. The distance to a looping segment can have a minimum and
+	//a maximum within a quarter of it, which a single group would miss.
+	constexpr int ClosestParamLaneGroups = 2;
+	constexpr int ClosestParamIterations = 6;
+}
+
+void BezierSpline::Build(const std::vector<XMVECTOR>& controlPoints, const std::vector<XMVECTOR>& subPoints)
+{
+	int segmentCount = static_cast<int>(controlPoints.size()) - 1;
+	mC0.resize(segmentCount);
+	mC1.resize(segmentCount);
+	mC2.resize(segmentCount);
+	mC3.resize(segmentCount);
+
+	for (int i = 0; i < segmentCount; ++i)
+	{
+		SetSegment(i, controlPoints[i], subPoints[2 * i], subPoints[2 * i + 1], controlPoints[i + 1]);
+	}
+}
+
+void BezierSpline::SetSegment(int segment, XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2, XMVECTOR p_3)
+{
+	//Bernstein basis to power basis.
+	XMVECTOR c0 = p_0;
+	XMVECTOR c1 = 3.f * (p_1 - p_0);
+	XMVECTOR c2 = 3.f * (p_0 - 2.f * p_1 + p_2);
+	XMVECTOR c3 = -p_0 + 3.f * p_1 - 3.f * p_2 + p_3;
+
+	XMStoreFloat4(&mC0[segment], XMVectorSetW(c0, 0.f));
+	XMStoreFloat4(&mC1[segment], XMVectorSetW(c1, 0.f));
+	XMStoreFloat4(&mC2[segment], XMVectorSetW(c2, 0.f));
+	XMStoreFloat4(&mC3[segment], XMVectorSetW(c3, 0.f));
+}
+
+void BezierSpline::Splice(int firstSegment, int oldSegmentCount, int newSegmentCount)
+{
+	for (auto* coefficients : { &mC0, &mC1, &mC2, &mC3 })
+	{
+		auto first = coefficients->begin() + firstSegment;
+		coefficients->erase(first, first + oldSegmentCount);
+		coefficients->insert(coefficients->begin() + firstSegment, newSegmentCount, XMFLOAT4(0.f, 0.f, 0.f, 0.f));
+	}
+}
+
+XMVECTOR BezierSpline::Evaluate(int segment, float u) const
+{
+	XMVECTOR vu = XMVectorReplicate(u);
+	XMVECTOR result = XMLoadFloat4(&mC3[segment]);
+	result = XMVectorMultiplyAdd(result, vu, XMLoadFloat4(&mC2[segment]));
+	result = XMVectorMultiplyAdd(result, vu, XMLoadFloat4(&mC1[segment]));
+	result = XMVectorMultiplyAdd(result, vu, XMLoadFloat4(&mC0[segment]));
+	return result;
+}
+
+XMVECTOR BezierSpline::EvaluateDerivative(int segment, float u) const
+{
+	XMVECTOR vu = XMVectorReplicate(u);
+	XMVECTOR result = XMVectorScale(XMLoadFloat4(&mC3[segment]), 3.f);
+	result = XMVectorMultiplyAdd(result, vu, XMVectorScale(XMLoadFloat4(&mC2[segment]), 2.f));
+	result = XMVectorMultiplyAdd(result, vu, XMLoadFloat4(&mC1[segment]));
+	return result;
+}
+
+XMVECTOR BezierSpline::EvaluateGlobal(float globalU) const
+{
+	int segment = GetSegmentIndex(globalU);
+	return Evaluate(segment, ToLocalU(globalU, segment));
+}
+
+void BezierSpline::EvaluateBatch(const int* segments, const float* us, XMFLOAT3* outPositions, size_t count) const
+{
+	int laneSegments[4];
+	float laneUs[4];
+	for (size_t base = 0; base < count; base += 4)
+	{
+		//Pad the last group by repeating its final valid lane.
+		size_t laneCount = std::min<size_t>(4, count - base);
+		for (size_t lane = 0; lane < 4; ++lane)
+		{
+			size_t src = base + std::min(lane, laneCount - 1);
+			laneSegments[lane] = segments[src];
+			laneUs[lane] = us[src];
+		}
+
+		XMMATRIX c3 = GatherTransposed(mC3, laneSegments);
+		XMMATRIX c2 = GatherTransposed(mC2, laneSegments);
+		XMMATRIX c1 = GatherTransposed(mC1, laneSegments);
+		XMMATRIX c0 = GatherTransposed(mC0, laneSegments);
+		XMVECTOR vu = XMVectorSet(laneUs[0], laneUs[1], laneUs[2], laneUs[3]);
+
+		XMMATRIX result;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			XMVECTOR value = XMVectorMultiplyAdd(c3.r[axis], vu, c2.r[axis]);
+			value = XMVectorMultiplyAdd(value, vu, c1.r[axis]);
+			result.r[axis] = XMVectorMultiplyAdd(value, vu, c0.r[axis]);
+		}
+		result.r[3] = XMVectorZero();
+		result = XMMatrixTranspose(result);
+
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			XMStoreFloat3(&outPositions[base + lane], result.r[lane]);
+		}
+	}
+}
+
+void BezierSpline::EvaluateDerivativeBatch(const int* segments, const float* us, XMFLOAT3* outDerivatives, size_t count) const
+{
+	int laneSegments[4];
+	float laneUs[4];
+	for (size_t base = 0; base < count; base += 4)
+	{
+		size_t laneCount = std::min<size_t>(4, count - base);
+		for (size_t lane = 0; lane < 4; ++lane)
+		{
+			size_t src = base + std::min(lane, laneCount - 1);
+			laneSegments[lane] = segments[src];
+			laneUs[lane] = us[src];
+		}
+
+		XMMATRIX c3 = GatherTransposed(mC3, laneSegments);
+		XMMATRIX c2 = GatherTransposed(mC2, laneSegments);
+		XMMATRIX c1 = GatherTransposed(mC1, laneSegments);
+		XMVECTOR vu = XMVectorSet(laneUs[0], laneUs[1], laneUs[2], laneUs[3]);
+
+		//B'(u) = (3 * c3 * u + 2 * c2) * u + c1
+		XMMATRIX result;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			XMVECTOR value = XMVectorMultiplyAdd(XMVectorScale(c3.r[axis], 3.f), vu, XMVectorScale(c2.r[axis], 2.f));
+			result.r[axis] = XMVectorMultiplyAdd(value, vu, c1.r[axis]);
+		}
+		result.r[3] = XMVectorZero();
+		result = XMMatrixTranspose(result);
+
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			XMStoreFloat3(&outDerivatives[base + lane], result.r[lane]);
+		}
+	}
+}
+
+float BezierSpline::FindClosestParam(int segment, XMVECTOR point, float& outDistanceSquared) const
+{
+	//Lanes hold parameters, so each coefficient is splatted per axis.
+	const XMFLOAT4* coefficients[4] = { &mC0[segment], &mC1[segment], &mC2[segment], &mC3[segment] };
+	XMVECTOR c0[3], c1[3], c2[3], c3[3], target[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		c0[axis] = XMVectorReplicatePtr(&coefficients[0]->x + axis);
+		c1[axis] = XMVectorReplicatePtr(&coefficients[1]->x + axis);
+		c2[axis] = XMVectorReplicatePtr(&coefficients[2]->x + axis);
+		c3[axis] = XMVectorReplicatePtr(&coefficients[3]->x + axis);
+		target[axis] = XMVectorReplicate(XMVectorGetByIndex(point, axis));
+	}
+
+	//|B(u) - p|^2, its half derivative (B - p) . B' and that one's derivative B' . B' + (B - p) . B''.
+	auto evaluate = [&](XMVECTOR u, XMVECTOR& distanceSquared, XMVECTOR& gradient, XMVECTOR& hessian)
+	{
+		distanceSquared = XMVectorZero();
+		gradient = XMVectorZero();
+		hessian = XMVectorZero();
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			XMVECTOR difference = XMVectorMultiplyAdd(XMVectorMultiplyAdd(XMVectorMultiplyAdd(c3[axis], u, c2[axis]), u, c1[axis]), u, c0[axis]) - target[axis];
+			XMVECTOR firstDerivative = XMVectorMultiplyAdd(XMVectorMultiplyAdd(c3[axis] * 3.f, u, c2[axis] * 2.f), u, c1[axis]);
+			XMVECTOR secondDerivative = XMVectorMultiplyAdd(c3[axis] * 6.f, u, c2[axis] * 2.f);
+
+			distanceSquared = XMVectorMultiplyAdd(difference, difference, distanceSquared);
+			gradient = XMVectorMultiplyAdd(difference, firstDerivative, gradient);
+			hessian = XMVectorMultiplyAdd(firstDerivative, firstDerivative, hessian);
+			hessian = XMVectorMultiplyAdd(difference, secondDerivative, hessian);
+		}
+	};
+
+	//Each lane owns an interval of the segment. A minimum inside it shows up as the gradient turning from negative to positive,
+	//and that bracket keeps Newton from jumping to a maximum or into another lane. Lanes without a bracket keep their better end.
+	const XMVECTOR intervalWidth = XMVectorReplicate(1.f / (ClosestParamLaneGroups * 4));
+	const XMVECTOR laneOffsets = XMVectorSet(0.f, 1.f, 2.f, 3.f) * intervalWidth;
+	float bestU = 0.f;
+	outDistanceSquared = FLT_MAX;
+	for (int group = 0; group < ClosestParamLaneGroups; ++group)
+	{
+		const XMVECTOR lowU = XMVectorReplicate(group * 4.f) * intervalWidth + laneOffsets;
+		const XMVECTOR highU = lowU + intervalWidth;
+		XMVECTOR lowDistanceSquared, lowGradient, highDistanceSquared, highGradient, hessian;
+		evaluate(lowU, lowDistanceSquared, lowGradient, hessian);
+		evaluate(highU, highDistanceSquared, highGradient, hessian);
+		XMVECTOR bracketed = XMVectorAndInt(XMVectorLess(lowGradient, XMVectorZero()), XMVectorGreater(highGradient, XMVectorZero()));
+
+		XMVECTOR low = lowU;
+		XMVECTOR high = highU;
+		XMVECTOR u = (low + high) * 0.5f;
+		XMVECTOR distanceSquared, gradient;
+		for (int iteration = 0; iteration < ClosestParamIterations; ++iteration)
+		{
+			evaluate(u, distanceSquared, gradient, hessian);
+			XMVECTOR descending = XMVectorLess(gradient, XMVectorZero());
+			low = XMVectorSelect(low, u, descending);
+			high = XMVectorSelect(u, high, descending);
+
+			//Bisect whenever the Newton step leaves the bracket. A converged lane sits on a bracket end, so the ends count as inside.
+			XMVECTOR newton = u - gradient / hessian;
+			XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(newton, low), XMVectorLessOrEqual(newton, high));
+			u = XMVectorSelect((low + high) * 0.5f, newton, XMVectorAndInt(inside, XMVectorGreater(hessian, XMVectorZero())));
+		}
+		evaluate(u, distanceSquared, gradient, hessian);
+
+		XMVECTOR laneU = XMVectorSelect(lowU, highU, XMVectorLess(highDistanceSquared, lowDistanceSquared));
+		XMVECTOR laneDistanceSquared = XMVectorMin(lowDistanceSquared, highDistanceSquared);
+		XMVECTOR useInterior = XMVectorAndInt(bracketed, XMVectorLess(distanceSquared, laneDistanceSquared));
+		laneU = XMVectorSelect(laneU, u, useInterior);
+		laneDistanceSquared = XMVectorSelect(laneDistanceSquared, distanceSquared, useInterior);
+
+		XMFLOAT4 laneUs;
+		XMFLOAT4 laneDistances;
+		XMStoreFloat4(&laneUs, laneU);
+		XMStoreFloat4(&laneDistances, laneDistanceSquared);
+		const float* us = &laneUs.x;
+		const float* distances = &laneDistances.x;
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			if (distances[lane] < outDistanceSquared)
+			{
+				outDistanceSquared = distances[lane];
+				bestU = us[lane];
+			}
+		}
+	}
+	return bestU;
+}
+
+int BezierSpline::GetSegmentIndex(float globalU) const
+{
+	float segmentCount = static_cast<float>(mC0.size());
+	return static_cast<int>(std::clamp(floorf(segmentCount * globalU), 0.f, segmentCount - 1.f));
+}
+
+float BezierSpline::ToLocalU(float globalU, int segment) const
+{
+	return globalU * mC0.size() - segment;
+}
+
+XMMATRIX BezierSpline::GatherTransposed(const std::vector<XMFLOAT4>& coefficients, const int* segments) const
+{
+	XMMATRIX rows;
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		rows.r[lane] = XMLoadFloat4(&coefficients[segments[lane]]);
+	}
+	return XMMatrixTranspose(rows);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+/**
+ * @brief Piecewise cubic bezier curve stored as power basis coefficients.
+ * @detail Segment i is evaluated as ((c3 * u + c2) * u + c1) * u + c0 with Horner's scheme.
+ * Each coefficient lives in its own contiguous array, so a batch can load four segments at once
+ * and transpose them into x/y/z lanes.
+ */
+class BezierSpline
+{
+public:
+	BezierSpline() = default;
+
+	void Build(const std::vector<XMVECTOR>& controlPoints, const std::vector<XMVECTOR>& subPoints);
+	void SetSegment(int segment, XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2, XMVECTOR p_3);
+
+	/**
+	 * @brief Replace segments [first, first + oldCount) with newCount zeroed segments to be filled by SetSegment.
+	 */
+	void Splice(int firstSegment, int oldSegmentCount, int newSegmentCount);
+
+	XMVECTOR Evaluate(int segment, float u) const;
+	XMVECTOR EvaluateDerivative(int segment, float u) const;
+	XMVECTOR EvaluateGlobal(float globalU) const;
+
+	/**
+	 * @brief Evaluate many (segment, u) pairs four at a time.
+	 */
+	void EvaluateBatch(const int* segments, const float* us, XMFLOAT3* outPositions, size_t count) const;
+	void EvaluateDerivativeBatch(const int* segments, const float* us, XMFLOAT3* outDerivatives, size_t count) const;
+
+	/**
+	 * @brief Local parameter of the point on a segment closest to point.
+	 * @detail The segment is cut into intervals, four per SIMD pass. Each lane solves (B(u) - p) . B'(u) = 0 inside
+	 * its interval with Newton's method, falling back to bisection, and the closest lane or interval end wins.
+	 */
+	float FindClosestParam(int segment, XMVECTOR point, float& outDistanceSquared) const;
+
+	int GetSegmentCount() const { return static_cast<int>(mC0.size()); }
+	int GetSegmentIndex(float globalU) const;
+	float ToLocalU(float globalU, int segment) const;
+
+private:
+	XMMATRIX GatherTransposed(const std::vector<XMFLOAT4>& coefficients, const int* segments) const;
+
+private:
+	std::vector<XMFLOAT4> mC0;
+	std::vector<XMFLOAT4> mC1;
+	std::vector<XMFLOAT4> mC2;
+	std::vector<XMFLOAT4> mC3;
+};
@@ -40,6 +40,14 @@ void CommandList::TransitionBarrier(Microsoft::WRL::ComPtr<ID3D12Resource> resou
 {
 	if (resource)
 	{
+		if (resource.Get() == mBoundVertexBuffer)
+		{
+			mBoundVertexBuffer = nullptr;
+		}
+		if (resource.Get() == mBoundIndexBuffer)
+		{
+			mBoundIndexBuffer = nullptr;
+		}
 		// The "before" state is not important. It will be resolved by the resource state tracker.
 		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COMMON, stateAfter, subresource);
 		mResourceStateTracker->ResourceBarrier(barrier);
@@ -82,6 +90,50 @@ void CommandList::CopyIndexBuffer(IndexBuffer& indexBuffer, size_t numIndicies,
 	CopyBuffer(indexBuffer, numIndicies, indexSizeInBytes, indexBufferData);
 }
 
+void CommandList::CopyBufferRegion(Buffer& dstBuffer, size_t dstOffset, const void* data, size_t sizeInBytes)
+{
+	if (sizeInBytes == 0)
+	{
+		return;
+	}
+
+	ComPtr<ID3D12Resource> uploadResource;
+	ThrowIfFailed(mApp->GetDevice()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(sizeInBytes),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&uploadResource)));
+
+	void* mapped = nullptr;
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(uploadResource->Map(0, &readRange, &mapped));
+	memcpy(mapped, data, sizeInBytes);
+	uploadResource->Unmap(0, nullptr);
+
+	TransitionBarrier(dstBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, true);
+	mCommandList->CopyBufferRegion(dstBuffer.GetResource().Get(), dstOffset, uploadResource.Get(), 0, sizeInBytes);
+
+	TrackResource(uploadResource);
+	TrackResource(dstBuffer);
+}
+
+void CommandList::CopyBufferRegion(Buffer& dstBuffer, size_t dstOffset, const Buffer& srcBuffer, size_t srcOffset, size_t sizeInBytes)
+{
+	if (sizeInBytes == 0)
+	{
+		return;
+	}
+
+	TransitionBarrier(dstBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+	TransitionBarrier(srcBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, true);
+	mCommandList->CopyBufferRegion(dstBuffer.GetResource().Get(), dstOffset, srcBuffer.GetResource().Get(), srcOffset, sizeInBytes);
+
+	TrackResource(dstBuffer);
+	TrackResource(srcBuffer);
+}
+
 void CommandList::SetGraphicsDynamicConstantBuffer(uint32_t rootParameterIndex, size_t sizeInBytes,
 	const void* bufferData)
 {
@@ -370,12 +422,20 @@ void CommandList::Reset()
 
 	mResourceStateTracker->Reset();
 	mUploadBuffer->Reset();
+	mBoundVertexBuffer = nullptr;
+	mBoundIndexBuffer = nullptr;
+	mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
 	
 	ReleaseTrackedObjects();
 }
 
 void CommandList::SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY primitiveTopology)
 {
+	if (primitiveTopology == mPrimitiveTopology)
+	{
+		return;
+	}
+	mPrimitiveTopology = primitiveTopology;
 	mCommandList->IASetPrimitiveTopology(primitiveTopology);
 }
 
@@ -386,20 +446,33 @@ void CommandList::SetRenderTargets(const std::vector<D3D12_CPU_DESCRIPTOR_HANDLE
 
 void CommandList::SetEmptyVertexBuffer()
 {
+	mBoundVertexBuffer = nullptr;
 	mCommandList->IASetVertexBuffers(0, 0, nullptr);
 }
 
 void CommandList::SetEmptyIndexBuffer()
 {
+	mBoundIndexBuffer = nullptr;
 	mCommandList->IASetIndexBuffer(nullptr);
 }
 
 void CommandList::SetVertexBuffer(uint32_t slot, const VertexBuffer& vertexBuffer)
 {
-	TransitionBarrier(vertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 	auto vertexBufferView = vertexBuffer.GetVertexBufferView();
+	if (slot == 0 && vertexBuffer.GetResource().Get() == mBoundVertexBuffer && vertexBufferView.BufferLocation == mBoundVertexBufferView.BufferLocation &&
+		vertexBufferView.SizeInBytes == mBoundVertexBufferView.SizeInBytes && vertexBufferView.StrideInBytes == mBoundVertexBufferView.StrideInBytes)
+	{
+		return;
+	}
+
+	TransitionBarrier(vertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 	mCommandList->IASetVertexBuffers(slot, 1, &vertexBufferView);
 	TrackResource(vertexBuffer);
+	if (slot == 0)
+	{
+		mBoundVertexBuffer = vertexBuffer.GetResource().Get();
+		mBoundVertexBufferView = vertexBufferView;
+	}
 }
 
 void CommandList::SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size_t vertexSize,
@@ -414,15 +487,27 @@ void CommandList::SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size
 	vertexBufferView.SizeInBytes = static_cast<UINT>(bufferSize);
 	vertexBufferView.StrideInBytes = static_cast<UINT>(vertexSize);
 
+	if (slot == 0)
+	{
+		mBoundVertexBuffer = nullptr;
+	}
 	mCommandList->IASetVertexBuffers(slot, 1, &vertexBufferView);
 }
 
 void CommandList::SetIndexBuffer(const IndexBuffer& indexBuffer)
 {
-	TransitionBarrier(indexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
 	auto indexBufferView = indexBuffer.GetIndexBufferView();
+	if (indexBuffer.GetResource().Get() == mBoundIndexBuffer && indexBufferView.BufferLocation == mBoundIndexBufferView.BufferLocation &&
+		indexBufferView.SizeInBytes == mBoundIndexBufferView.SizeInBytes && indexBufferView.Format == mBoundIndexBufferView.Format)
+	{
+		return;
+	}
+
+	TransitionBarrier(indexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
 	mCommandList->IASetIndexBuffer(&indexBufferView);
 	TrackResource(indexBuffer);
+	mBoundIndexBuffer = indexBuffer.GetResource().Get();
+	mBoundIndexBufferView = indexBufferView;
 }
 
 void CommandList::SetDynamicIndexBuffer(size_t numIndicies, DXGI_FORMAT indexFormat, const void* indexBufferData)
@@ -437,6 +522,7 @@ void CommandList::SetDynamicIndexBuffer(size_t numIndicies, DXGI_FORMAT indexFor
 	indexBufferView.SizeInBytes = static_cast<UINT>(bufferSize);
 	indexBufferView.Format = indexFormat;
 
+	mBoundIndexBuffer = nullptr;
 	mCommandList->IASetIndexBuffer(&indexBufferView);
 }
 
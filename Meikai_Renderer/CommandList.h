@@ -56,6 +56,15 @@ public:
 		CopyIndexBuffer(indexBuffer, indexBufferData.size(), indexFormat, indexBufferData.data());
 	}
 
+	/**
+	 * @brief Upload data into part of a buffer that already has its resource, such as a range of a GeometryPool block.
+	 */
+	void CopyBufferRegion(Buffer& dstBuffer, size_t dstOffset, const void* data, size_t sizeInBytes);
+	/**
+	 * @brief Copy part of one buffer into another on the GPU.
+	 */
+	void CopyBufferRegion(Buffer& dstBuffer, size_t dstOffset, const Buffer& srcBuffer, size_t srcOffset, size_t sizeInBytes);
+
 	void SetGraphicsDynamicConstantBuffer(uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData);
 	template<typename T>
 	void SetGraphicsDynamicConstantBuffer(uint32_t rootParameterIndex, const T& data)
@@ -149,6 +158,14 @@ private:
 	std::unique_ptr<ResourceStateTracker> mResourceStateTracker;
 	std::unique_ptr<UploadBuffer> mUploadBuffer;
 
+	//Input assembler state already set, so meshes sharing the buffers of a GeometryPool do not bind them again for every draw.
+	//Cleared when the buffers go through any other transition.
+	ID3D12Resource* mBoundVertexBuffer = nullptr;
+	D3D12_VERTEX_BUFFER_VIEW mBoundVertexBufferView = {};
+	ID3D12Resource* mBoundIndexBuffer = nullptr;
+	D3D12_INDEX_BUFFER_VIEW mBoundIndexBufferView = {};
+	D3D_PRIMITIVE_TOPOLOGY mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
 	using TrackedObjects = std::vector < Microsoft::WRL::ComPtr<ID3D12Object> >;
 	TrackedObjects m_TrackedObjects;
 
@@ -54,6 +54,11 @@ bool CommandQueue::IsFenceComplete()
     return mFence->GetCompletedValue() >= mFenceValue;
 }
 
+bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
+{
+    return mFence->GetCompletedValue() >= fenceValue;
+}
+
 void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
 {
     if(!IsFenceComplete())
@@ -8,6 +8,8 @@
 #include "Texture.h"
 #include "DescriptorHeap.h"
 #include "ResourceStateTracker.h"
+#include "GeometryPool.h"
+#include "VertexCompression.h"
 
 #include <imgui_impl_win32.h>
 
@@ -79,6 +81,11 @@ ComPtr<ID3D12Device2> DXApp::GetDevice()
 	return mdxDevice;
 }
 
+GeometryPool& DXApp::GetGeometryPool()
+{
+	return *mGeometryPool;
+}
+
 float DXApp::AspectRatio() const
 {
 	return static_cast<float>(mClientWidth) / mClientHeight;
@@ -248,6 +255,7 @@ bool DXApp::Initialize()
 	if (!InitDirect3D())
 		return false;
 
+	mGeometryPool = std::make_unique<GeometryPool>(this, static_cast<uint32_t>(sizeof(PackedVertex)));
 	InitCommonTextures();
 	return true;
 }
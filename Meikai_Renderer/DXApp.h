@@ -28,6 +28,7 @@ class CommandQueue;
 class Texture;
 class UploadBuffer;
 class DescriptorHeap;
+class GeometryPool;
 enum HeapType
 {
     RTV,
@@ -53,6 +54,8 @@ public:
     HINSTANCE AppInst()const;
     HWND      MainWnd()const;
     ComPtr<ID3D12Device2> GetDevice();
+    //Shared buffers of the static meshes, in the PackedVertex format.
+    GeometryPool& GetGeometryPool();
     float     AspectRatio()const;
 
     bool Get4xMsaaState();
@@ -136,6 +139,7 @@ protected:
     std::shared_ptr<CommandQueue> mDirectCommandQueue;
     std::shared_ptr<CommandQueue> mComputeCommandQueue;
     std::shared_ptr<CommandQueue> mCopyCommandQueue;
+    std::unique_ptr<GeometryPool> mGeometryPool;
 
 protected://Descriptor heaps
     std::map<HeapType, std::shared_ptr<DescriptorHeap>> mDescriptorHeaps;
@@ -9,6 +9,17 @@
 #include "DescriptorHeap.h"
 
 #include "PathGenerator.h"
+#include "Path.h"
+#include "PathCrowd.h"
+#include "SpeedProfile.h"
+#include "NavMesh.h"
+#include "NavQuery.h"
+#include "ThreadPool.h"
+#include "AssetRegistry.h"
+#include "MeshletCuller.h"
+#include "LodSelector.h"
+#include "GeometryPool.h"
+#include "Benchmark.h"
 
 #include <d3dcompiler.h>
 #include <d3dx12.h>
@@ -51,15 +62,20 @@ bool Demo::Initialize()
 		return false;
 	}
 
+	mThreadPool = std::make_unique<ThreadPool>();
+	mAssetRegistry = std::make_unique<AssetRegistry>(this, *mThreadPool);
+
 	auto initList = mDirectCommandQueue->GetCommandList();
 	CreateIBLResources(initList);
-	BuildModels(initList);
+	BuildModels();
 	LoadAnimations();
 	BuildObjects();
 
 	float aspectRatio = mClientWidth / static_cast<float>(mClientHeight);
 	mCamera = std::make_unique<Camera>(aspectRatio);
-	mPathGenerator = std::make_unique<PathGenerator>(mModels["Sphere"]);
+	mLodSelector = std::make_unique<LodSelector>();
+	BuildPatrol();
+	BuildCrowd();
 
 	BuildFrameResource();
 	CreateShaderFromHLSL();
@@ -88,6 +104,10 @@ bool Demo::Initialize()
 	PreCompute();
 	InitImgui();
 
+#if defined(MEIKAI_BENCHMARK)
+	Benchmark::RunAll();
+#endif
+
 	return true;
 }
 
@@ -148,9 +168,97 @@ void Demo::UpdateGUI()
 	{
 		mMainObject->SetModel(mModels[mModelIndexMap[modelIndex]]);
 	}
+	UpdateLodGUI();
+	GeometryPoolStats poolStats = mGeometryPool->GetStats();
+	ImGui::Text("Geometry Pool %d blocks, %d meshes, %.1f%% vertices used, %.2f fragmentation", poolStats.blockCount, poolStats.rangeCount,
+		poolStats.vertexCapacity > 0 ? 100.0 * poolStats.usedVertices / poolStats.vertexCapacity : 0.0, poolStats.fragmentation);
+	UpdatePathGUI();
 	ImGui::End();
 }
 
+void Demo::UpdateLodGUI()
+{
+	static int triangleBudget;
+	ImGui::SliderFloat("LOD Pixel Error", &mLodSelector->mPixelThreshold, 0.1f, 16.f);
+	ImGui::SliderFloat("LOD Hysteresis", &mLodSelector->mHysteresis, 0.f, 0.9f);
+	//0 leaves the triangle count to the pixel error alone.
+	if (ImGui::SliderInt("LOD Triangle Budget", &triangleBudget, 0, 4000000))
+	{
+		mLodSelector->mTriangleBudget = triangleBudget;
+	}
+	ImGui::Text("LOD Triangles %llu / %llu, Pixel Error %.2f", mLodSelector->GetSelectedTriangles(),
+		mLodSelector->GetFullDetailTriangles(), mLodSelector->GetEffectiveThreshold());
+}
+
+void Demo::UpdatePathGUI()
+{
+	static int controlPointIndex;
+	auto path = mPathGenerator->GetPath();
+	int lastIndex = path->GetControlPointCount() - 1;
+
+	//The last control point closes the loop, so the editable range stops before it.
+	controlPointIndex = std::min(controlPointIndex, lastIndex - 1);
+	ImGui::SliderInt("Control Point", &controlPointIndex, 0, lastIndex - 1);
+
+	XMFLOAT3 position;
+	XMStoreFloat3(&position, path->GetControlPoints()[controlPointIndex]);
+	bool edited = false;
+	if (ImGui::DragFloat3("Control Point Position", &(position.x), 0.05f))
+	{
+		mPathGenerator->MoveControlPoint(controlPointIndex, XMLoadFloat3(&position));
+		edited = true;
+	}
+	if (ImGui::Button("Insert Control Point"))
+	{
+		auto& controlPoints = path->GetControlPoints();
+		XMVECTOR midPoint = (controlPoints[controlPointIndex] + controlPoints[controlPointIndex + 1]) * 0.5f;
+		mPathGenerator->InsertControlPoint(controlPointIndex + 1, midPoint);
+		edited = true;
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Remove Control Point") && controlPointIndex > 0 && lastIndex > 3)
+	{
+		mPathGenerator->RemoveControlPoint(controlPointIndex);
+		edited = true;
+	}
+
+	if (edited)
+	{
+		mPathCrowd->RefreshPath(mCrowdPathId);
+	}
+
+	bool avoidance = mPathCrowd->IsAvoidanceEnabled();
+	if (ImGui::Checkbox("Crowd Avoidance", &avoidance))
+	{
+		if (avoidance)
+		{
+			mPathCrowd->EnableAvoidance(CrowdAvoidanceSettings());
+		}
+		else
+		{
+			mPathCrowd->DisableAvoidance();
+		}
+	}
+
+	//Geometry is gathered here, since the main object may move while the plan runs on a worker.
+	if (ImGui::Button("Replan Patrol") && mPatrolPlan.valid() == false)
+	{
+		std::shared_ptr<NavMesh> navMesh = CollectNavMeshGeometry();
+		std::vector<XMVECTOR> waypoints = mPatrolWaypoints;
+		mPatrolPlan = mThreadPool->Submit([navMesh, waypoints]() { return PlanPatrol(*navMesh, waypoints); });
+	}
+}
+
+void Demo::ApplyPatrolPlan()
+{
+	if (mPatrolPlan.valid() == false || mPatrolPlan.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+	mPathGenerator->SetControlPoints(mPatrolPlan.get());
+	mPathCrowd->SetPath(mCrowdPathId, mPathGenerator->GetPath());
+}
+
 void Demo::UpdateMainObject()
 {
 	mMainObject->SetPosition(XMLoadFloat3(&mMainPosition));
@@ -165,6 +273,33 @@ void Demo::UpdateMainObject()
 	mMoveTestSkeletal->SetRoughness(mMainRoughness);
 }
 
+void Demo::SelectLods()
+{
+	//Skinned models have no LOD chains, so like the meshlet culling this only covers the static objects.
+	mLodSelector->Clear();
+	auto add = [this](const Object& object)
+		{
+			const Model& model = *object.GetModel();
+			mLodSelector->Add(object.GetWorldMat(), model.GetBounds(), model.GetLodStats(), model.GetLodLevelCount(), object.GetLod());
+		};
+	for (const auto& object : mObjects)
+	{
+		add(*object);
+	}
+	add(*mMainObject);
+
+	XMFLOAT3 eyePosition = mCamera->GetPosition();
+	float pixelsPerUnit = mCamera->GetProjMat()._22 * mClientHeight * 0.5f;
+	mLodSelector->Select(XMLoadFloat3(&eyePosition), pixelsPerUnit);
+
+	int slot = 0;
+	for (const auto& object : mObjects)
+	{
+		object->SetLod(mLodSelector->GetLod(slot++));
+	}
+	mMainObject->SetLod(mLodSelector->GetLod(slot));
+}
+
 void Demo::ClearImGui()
 {
 	ImGui_ImplDX12_Shutdown();
@@ -180,19 +315,33 @@ void Demo::Update(const GameTimer& gt)
 	UpdateLightCB(gt);
 	UpdateGUI();
 	UpdateMainObject();
+	SelectLods();
+	ApplyPatrolPlan();
 	float tick = mPathGenerator->Update(gt, mMoveTestSkeletal->GetTicksPerSec(), mMoveTestSkeletal->GetDuration(), mMoveTestSkeletal->GetDistacnePerDuration());
   	mMoveTestSkeletal->SetPosition(mPathGenerator->GetPosition());
-	mMoveTestSkeletal->SetDirection(mPathGenerator->GetDirection());
+	mMoveTestSkeletal->SetOrientation(mPathGenerator->GetOrientation());
 	for(auto& skeletalObject : mSkeletalObjects)
 	{
 		skeletalObject->Update(gt.DeltaTime() * skeletalObject->GetTicksPerSec());
 	}
 	mMoveTestSkeletal->Update(tick);
+
+	mPathCrowd->Update(gt.DeltaTime(), mThreadPool.get());
+	for (int i = 0; i < mPathCrowd->GetAgentCount(); ++i)
+	{
+		auto& walker = mCrowdSkeletals[i];
+		float distancePerTick = walker->GetDistacnePerDuration() / walker->GetDuration();
+		walker->SetPosition(mPathCrowd->GetPosition(i));
+		walker->SetOrientation(mPathCrowd->GetOrientation(i));
+		walker->Update(mPathCrowd->GetDistance(i) / distancePerTick);
+	}
 }
 
 void Demo::Draw(const GameTimer& gt)
 {
 	auto drawcmdList = mDirectCommandQueue->GetCommandList();
+	//Meshes unloaded since the last frame leave holes, packed a block at a time before the draws read the blocks.
+	mGeometryPool->Defragment(*drawcmdList);
 	//DrawShadowPass(*drawcmdList);
 	DrawGeometryPasses(*drawcmdList);
 	DrawSsaoPass(*drawcmdList);
@@ -220,19 +369,37 @@ void Demo::PreCompute()
 	mDirectCommandQueue->WaitForFenceValue(fenceValue);
 }
 
-void Demo::BuildModels(std::shared_ptr<CommandList>& cmdList)
+void Demo::BuildModels()
 {
-	mModels["Skybox"] = std::make_shared<Model>("../models/Skybox.obj", this, *cmdList);
-	mModels["Sphere"] = std::make_shared<Model>("../models/Sphere.obj", this, *cmdList);
-	mModels["Plane"] = std::make_shared<Model>("../models/Plane.obj", this, *cmdList);
-	mModels["bunny"] = std::make_shared<Model>("../models/bunny.obj", this, *cmdList);
-	mModels["Cube"] = std::make_shared<Model>("../models/Cube.obj", this, *cmdList);
-	mModels["Torus"] = std::make_shared<Model>("../models/Torus.obj", this, *cmdList);
-	mModels["Monkey"] = std::make_shared<Model>("../models/Monkey.obj", this, *cmdList);
-	mModels["bunny"] = std::make_shared<Model>("../models/bunny.obj", this, *cmdList);
-	mModels["dragon"] = std::make_shared<Model>("../models/dragon.obj", this, *cmdList);
-	mModels["bmw"] = std::make_shared<Model>("../models/bmw.obj", this, *cmdList);
-	mModels["buddha"] = std::make_shared<Model>("../models/buddha.obj", this, *cmdList);
+	const std::pair<const char*, const char*> modelFiles[] =
+	{
+		{ "Skybox", "../models/Skybox.obj" },
+		{ "Sphere", "../models/Sphere.obj" },
+		{ "Plane", "../models/Plane.obj" },
+		{ "bunny", "../models/bunny.obj" },
+		{ "Cube", "../models/Cube.obj" },
+		{ "Torus", "../models/Torus.obj" },
+		{ "Monkey", "../models/Monkey.obj" },
+		{ "dragon", "../models/dragon.obj" },
+		{ "bmw", "../models/bmw.obj" },
+		{ "buddha", "../models/buddha.obj" },
+	};
+
+	//Every file is imported on the pool at once, uploads are recorded as the imports come in.
+	std::vector<std::pair<std::string, std::shared_future<std::shared_ptr<Model>>>> models;
+	for (const auto& [modelName, filePath] : modelFiles)
+	{
+		//Any of them can become the main object, whose triangles go into the nav mesh.
+		models.push_back({ modelName, mAssetRegistry->LoadModel(filePath, GeometryRetention::Positions) });
+	}
+	auto xBot = mAssetRegistry->LoadSkeletalModel("../models/X_Bot.dae", GeometryRetention::None);
+	auto yBot = mAssetRegistry->LoadSkeletalModel("../models/Y_Bot.dae", GeometryRetention::None);
+	mAssetRegistry->Finish(*mDirectCommandQueue);
+
+	for (auto& [modelName, model] : models)
+	{
+		mModels[modelName] = model.get();
+	}
 
 	int i = 0;
 	for (auto model : mModels)
@@ -241,8 +408,8 @@ void Demo::BuildModels(std::shared_ptr<CommandList>& cmdList)
 		mModelIndexMap[i++] = model.first;
 	}
 
-	mSkeletalModels["X_Bot"] = std::make_shared<SkeletalModel>("../models/X_Bot.dae", this, *cmdList);
-	mSkeletalModels["Y_Bot"] = std::make_shared<SkeletalModel>("../models/Y_Bot.dae", this, *cmdList);
+	mSkeletalModels["X_Bot"] = xBot.get();
+	mSkeletalModels["Y_Bot"] = yBot.get();
 }
 
 void Demo::LoadAnimations()
@@ -268,10 +435,89 @@ void Demo::BuildObjects()
 	mMainPosition = XMFLOAT3(0, 0, 0);
 	mMainScale = 1;
 	mObjects.push_back(std::make_unique<Object>(mModels["Plane"], XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1), 0.f, 1.f, XMFLOAT3(0.1f, 0.1, 0.1f)));
+	mNavMeshObjects.push_back(mObjects.back().get());
+	//Obstacles across the patrol route.
+	mObjects.push_back(std::make_unique<Object>(mModels["Cube"], XMFLOAT3(-1.5f, 0.f, 3.f), XMFLOAT3(0.8f, 0.3f, 0.2f), 0.f, 0.8f));
+	mNavMeshObjects.push_back(mObjects.back().get());
+	mObjects.push_back(std::make_unique<Object>(mModels["Cube"], XMFLOAT3(4.5f, 0.f, -1.5f), XMFLOAT3(0.8f, 0.3f, 0.2f), 0.f, 0.8f));
+	mNavMeshObjects.push_back(mObjects.back().get());
 	mSkybox = std::make_unique<Object>(mModels["Skybox"], XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(1, 1, 1),  0.f, 0.f);
 	mMoveTestSkeletal = std::make_unique<SkeletalObject>(this, mSkeletalModels["Y_Bot"], mAnimations["walking"], XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0, 0, 0), 1.0, 1.0);
 }
 
+void Demo::BuildPatrol()
+{
+	float scale = 3.f;
+	mPatrolWaypoints =
+	{
+		XMVectorSet(0.f, 0.f, scale, 0.f),
+		XMVectorSet(-scale, 0.f, scale, 0.f),
+		XMVectorSet(-scale * 2.f, 0.f, 0.f, 0.f),
+		XMVectorSet(-scale, 0.f, -scale, 0.f),
+		XMVectorSet(0.f, 0.f, -scale * 2.f, 0.f),
+		XMVectorSet(scale, 0.f, -scale, 0.f),
+		XMVectorSet(scale * 2.f, 0.f, 0.f, 0.f),
+		XMVectorSet(scale, 0.f, scale, 0.f),
+	};
+	mPathGenerator = std::make_unique<PathGenerator>(this, mModels["Sphere"], PlanPatrol(*CollectNavMeshGeometry(), mPatrolWaypoints));
+}
+
+std::shared_ptr<NavMesh> Demo::CollectNavMeshGeometry() const
+{
+	std::vector<const Object*> objects = mNavMeshObjects;
+	objects.push_back(mMainObject.get());
+
+	auto navMesh = std::make_shared<NavMesh>();
+	for (const Object* object : objects)
+	{
+		for (const Mesh& mesh : object->GetModel()->mMeshes)
+		{
+			const std::vector<UINT>& indices = mesh.GetIndices();
+			navMesh->AddTriangles(mesh.GetPositions(), mesh.GetPositionStride(), mesh.GetPositionCount(), indices.data(), indices.size(), object->GetWorldMat());
+		}
+	}
+	return navMesh;
+}
+
+std::vector<XMVECTOR> Demo::PlanPatrol(NavMesh& navMesh, const std::vector<XMVECTOR>& waypoints)
+{
+	navMesh.Build(NavMeshSettings());
+	NavQuery navQuery(navMesh);
+	std::vector<XMVECTOR> controlPoints;
+	if (navQuery.FindLoop(waypoints, 2.f, controlPoints) == false)
+	{
+		//Walk the bare waypoints when the mesh cannot connect them.
+		controlPoints = waypoints;
+		controlPoints.push_back(waypoints.front());
+	}
+	return controlPoints;
+}
+
+void Demo::BuildCrowd()
+{
+	const int walkerCount = 8;
+	mPathCrowd = std::make_unique<PathCrowd>();
+	mCrowdPathId = mPathCrowd->AddPath(mPathGenerator->GetPath());
+	float pathLength = mPathGenerator->GetPath()->GetWorldArcLength();
+	int easeProfileId = mPathCrowd->AddProfile(std::make_shared<const SpeedProfile>(SpeedProfile::EaseInOut()));
+
+	for (int i = 0; i < walkerCount; ++i)
+	{
+		auto walker = std::make_unique<SkeletalObject>(this, mSkeletalModels["Y_Bot"], mAnimations["walking"], XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0, 0, 0), 1.0, 1.0);
+		//Speed that keeps the feet planted, varied a little per walker.
+		float distancePerTick = walker->GetDistacnePerDuration() / walker->GetDuration();
+		float speed = distancePerTick * walker->GetTicksPerSec() * MathHelper::RandF(0.8f, 1.2f);
+
+		int agent = mPathCrowd->AddAgent(mCrowdPathId, pathLength * i / walkerCount, speed);
+		if (i % 2 == 1)
+		{
+			mPathCrowd->SetAgentProfile(agent, easeProfileId);
+		}
+		mCrowdSkeletals.push_back(std::move(walker));
+	}
+	mPathCrowd->EnableAvoidance(CrowdAvoidanceSettings());
+}
+
 void Demo::BuildFrameResource()
 {
 	mCommonCB = std::make_unique<CommonCB>();
@@ -281,10 +527,8 @@ void Demo::BuildFrameResource()
 
 void Demo::CreateIBLResources(std::shared_ptr<CommandList>& commandList)
 {
-	mIBLResource.mHDRImage = std::make_shared<Texture>(this);
-	commandList->LoadTextureFromFile(*mIBLResource.mHDRImage, L"../textures/Alexs_Apt_2k.hdr", D3D12_SRV_DIMENSION_TEXTURE2D);
-	mIBLResource.mDiffuseMap = std::make_shared<Texture>(this);
-	commandList->LoadTextureFromFile(*mIBLResource.mDiffuseMap, L"../textures/Alexs_Apt_2k.irr.hdr", D3D12_SRV_DIMENSION_TEXTURE2D);
+	mIBLResource.mHDRImage = mAssetRegistry->LoadTexture(*commandList, L"../textures/Alexs_Apt_2k.hdr", D3D12_SRV_DIMENSION_TEXTURE2D);
+	mIBLResource.mDiffuseMap = mAssetRegistry->LoadTexture(*commandList, L"../textures/Alexs_Apt_2k.irr.hdr", D3D12_SRV_DIMENSION_TEXTURE2D);
 
 	auto cubemapDesc = mIBLResource.mHDRImage->GetD3D12ResourceDesc();
 	cubemapDesc.Format = AlbedoFormat;
@@ -472,11 +716,15 @@ void Demo::DrawGeometryPasses(CommandList& cmdList)
 
 	cmdList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+	//Skinned meshes are left out, their meshlet bounds only hold in the bind pose.
+	XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&mCamera->GetViewMat()), XMLoadFloat4x4(&mCamera->GetProjMat()));
+	XMFLOAT3 eyePosition = mCamera->GetPosition();
+	MeshletCuller culler(viewProj, XMLoadFloat3(&eyePosition));
 	for (const auto& object : mObjects)
 	{
-		object->Draw(cmdList);
+		object->Draw(cmdList, culler);
 	}
-	mMainObject->Draw(cmdList);
+	mMainObject->Draw(cmdList, culler);
 	cmdList.SetPipelineState(mSkeletalGeometryPass->mPSO.Get());
 	cmdList.SetGraphicsRootSignature(mSkeletalGeometryPass->mRootSig.Get());
 
@@ -487,6 +735,10 @@ void Demo::DrawGeometryPasses(CommandList& cmdList)
 		skeletalObject->Draw(cmdList);
 	}
 	mMoveTestSkeletal->Draw(cmdList);
+	for (const auto& walker : mCrowdSkeletals)
+	{
+		walker->Draw(cmdList);
+	}
 }
 
 void Demo::DrawLightingPass(CommandList& cmdList)
@@ -602,6 +854,10 @@ void Demo::DrawBoneDebug(CommandList& cmdList)
 		object->DrawBone(cmdList);
 	}
 	mMoveTestSkeletal->DrawBone(cmdList);
+	for (auto& walker : mCrowdSkeletals)
+	{
+		walker->DrawBone(cmdList);
+	}
 }
 
 void Demo::DrawPathDebug(CommandList& cmdList)
@@ -619,7 +875,9 @@ void Demo::DrawPathDebug(CommandList& cmdList)
 
 	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> rtvArray = { rtvHeapCPUHandle };
 	cmdList.SetRenderTargets(rtvArray, &dsvHeapCPUHandle);
-	mPathGenerator->DrawPaths(cmdList);
+	XMFLOAT3 eyePosition = mCamera->GetPosition();
+	float focalLengthPixels = mCamera->GetProjMat()._22 * mClientHeight * 0.5f;
+	mPathGenerator->DrawPaths(cmdList, XMLoadFloat3(&eyePosition), focalLengthPixels);
 }
 
 void Demo::DrawMeshDebug(CommandList& cmdList)
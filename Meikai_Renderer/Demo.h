@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <future>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -20,6 +21,11 @@ class Camera;
 class Texture;
 
 class PathGenerator;
+class PathCrowd;
+class ThreadPool;
+class AssetRegistry;
+class NavMesh;
+class LodSelector;
 
 class SkeletalGeometryPass;
 class EquiRectToCubemapPass;
@@ -48,12 +54,23 @@ protected:
 	void StartImGuiFrame();
 	void UpdateGUI();
 	void UpdateMainObject();
+	void UpdatePathGUI();
+	void UpdateLodGUI();
+	/**
+	 * @brief Pick the level of detail of every static object from the camera, see LodSelector.
+	 */
+	void SelectLods();
 	void ClearImGui();
 
 private:
-	void BuildModels(std::shared_ptr<CommandList>& cmdList);
+	void BuildModels();
 	void LoadAnimations();
 	void BuildObjects();
+	void BuildPatrol();
+	void BuildCrowd();
+	std::shared_ptr<NavMesh> CollectNavMeshGeometry() const;
+	static std::vector<XMVECTOR> PlanPatrol(NavMesh& navMesh, const std::vector<XMVECTOR>& waypoints);
+	void ApplyPatrolPlan();
 
 	void BuildFrameResource();
 	void CreateIBLResources(std::shared_ptr<CommandList>& commandList);
@@ -146,8 +163,20 @@ private:
 	float mMainScale;
 
 	std::unique_ptr<Camera> mCamera;
+	std::unique_ptr<LodSelector> mLodSelector;
 
 	std::unique_ptr<PathGenerator> mPathGenerator;
+	//Static geometry walked around by the patrol. The main object is added when the navmesh is built.
+	std::vector<const Object*> mNavMeshObjects;
+	std::vector<XMVECTOR> mPatrolWaypoints;
+	std::future<std::vector<XMVECTOR>> mPatrolPlan;
+	std::unique_ptr<PathCrowd> mPathCrowd;
+	int mCrowdPathId;
+	std::vector<std::unique_ptr<SkeletalObject>> mCrowdSkeletals;
+
+	std::unique_ptr<ThreadPool> mThreadPool;
+	//Declared after the pool, since it waits for its imports on destruction.
+	std::unique_ptr<AssetRegistry> mAssetRegistry;
 	POINT mLastMousePos;
 
 	bool m_ContentLoaded = false;
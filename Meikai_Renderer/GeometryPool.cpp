@@ -0,0 +1,250 @@
+#include "GeometryPool.h"
+#include "CommandList.h"
+#include "DXApp.h"
+#include <algorithm>
+#include <cassert>
+
+GeometryHandle::GeometryHandle(GeometryPool* pool, uint32_t id)
+	:mPool(pool), mId(id)
+{
+}
+
+GeometryHandle::GeometryHandle(GeometryHandle&& other) noexcept
+	:mPool(other.mPool), mId(other.mId)
+{
+	other.mPool = nullptr;
+}
+
+GeometryHandle& GeometryHandle::operator=(GeometryHandle&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		mPool = other.mPool;
+		mId = other.mId;
+		other.mPool = nullptr;
+	}
+	return *this;
+}
+
+GeometryHandle::~GeometryHandle()
+{
+	Release();
+}
+
+void GeometryHandle::Release()
+{
+	if (mPool)
+	{
+		mPool->Free(mId);
+		mPool = nullptr;
+	}
+}
+
+GeometryPool::Block::Block(DXApp* app, uint32_t vertexCapacity, uint32_t indexCapacity)
+	:vertexBuffer(app, L"Geometry Pool Vertices"), indexBuffer(app, L"Geometry Pool Indices"), vertices(vertexCapacity), indices(indexCapacity)
+{
+}
+
+GeometryPool::GeometryPool(DXApp* app, uint32_t vertexStride)
+	:mApp(app), mVertexStride(vertexStride)
+{
+}
+
+GeometryHandle GeometryPool::Allocate(CommandList& commandList, const void* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount)
+{
+	assert(vertexCount > 0 && indexCount > 0);
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	GeometryRange range = { FreeBlock, 0, vertexCount, 0, indexCount };
+	for (uint32_t i = 0; i < mBlocks.size() && range.block == FreeBlock; ++i)
+	{
+		Block* block = mBlocks[i].get();
+		if (block == nullptr || block->vertices.GetLargestFreeRange() < vertexCount || block->indices.GetLargestFreeRange() < indexCount)
+		{
+			continue;
+		}
+		range.block = i;
+		range.firstVertex = static_cast<uint32_t>(block->vertices.Allocate(vertexCount));
+		range.firstIndex = static_cast<uint32_t>(block->indices.Allocate(indexCount));
+	}
+
+	if (range.block == FreeBlock)
+	{
+		//A mesh larger than a block gets a block of its own size.
+		auto block = CreateBlock(commandList, std::max(BlockVertices, vertexCount), std::max(BlockIndices, indexCount));
+		range.firstVertex = static_cast<uint32_t>(block->vertices.Allocate(vertexCount));
+		range.firstIndex = static_cast<uint32_t>(block->indices.Allocate(indexCount));
+
+		auto emptySlot = std::find(mBlocks.begin(), mBlocks.end(), nullptr);
+		range.block = static_cast<uint32_t>(emptySlot - mBlocks.begin());
+		if (emptySlot == mBlocks.end())
+		{
+			mBlocks.push_back(std::move(block));
+		}
+		else
+		{
+			*emptySlot = std::move(block);
+		}
+	}
+
+	Block& block = *mBlocks[range.block];
+	++block.rangeCount;
+	commandList.CopyBufferRegion(block.vertexBuffer, static_cast<size_t>(range.firstVertex) * mVertexStride, vertices, static_cast<size_t>(vertexCount) * mVertexStride);
+	commandList.CopyBufferRegion(block.indexBuffer, static_cast<size_t>(range.firstIndex) * sizeof(uint16_t), indices, static_cast<size_t>(indexCount) * sizeof(uint16_t));
+
+	uint32_t id;
+	if (mFreeIds.empty())
+	{
+		id = static_cast<uint32_t>(mRanges.size());
+		mRanges.push_back(range);
+	}
+	else
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+		mRanges[id] = range;
+	}
+	return GeometryHandle(this, id);
+}
+
+void GeometryPool::Free(uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	GeometryRange& range = mRanges[id];
+	assert(range.block != FreeBlock);
+	Block& block = *mBlocks[range.block];
+	block.vertices.Free(range.firstVertex, range.vertexCount);
+	block.indices.Free(range.firstIndex, range.indexCount);
+	--block.rangeCount;
+	range.block = FreeBlock;
+	mFreeIds.push_back(id);
+}
+
+GeometryRange GeometryPool::Bind(CommandList& commandList, const GeometryHandle& handle)
+{
+	assert(handle.mPool == this);
+	std::lock_guard<std::mutex> lock(mMutex);
+	GeometryRange range = mRanges[handle.mId];
+	Block& block = *mBlocks[range.block];
+	commandList.SetVertexBuffer(0, block.vertexBuffer);
+	commandList.SetIndexBuffer(block.indexBuffer);
+	return range;
+}
+
+int GeometryPool::Defragment(CommandList& commandList, float minFragmentation)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	//The first block stays even when empty, the next mesh would only create it again.
+	for (size_t i = 1; i < mBlocks.size(); ++i)
+	{
+		if (mBlocks[i] && mBlocks[i]->rangeCount == 0)
+		{
+			mBlocks[i].reset();
+		}
+	}
+
+	uint32_t worstBlock = FreeBlock;
+	float worstFragmentation = minFragmentation;
+	for (uint32_t i = 0; i < mBlocks.size(); ++i)
+	{
+		if (mBlocks[i] == nullptr)
+		{
+			continue;
+		}
+		float fragmentation = GetFragmentation(*mBlocks[i]);
+		if (fragmentation >= worstFragmentation && fragmentation > 0.f)
+		{
+			worstBlock = i;
+			worstFragmentation = fragmentation;
+		}
+	}
+	if (worstBlock == FreeBlock)
+	{
+		return 0;
+	}
+
+	Block& oldBlock = *mBlocks[worstBlock];
+	auto block = CreateBlock(commandList, static_cast<uint32_t>(oldBlock.vertices.GetCapacity()), static_cast<uint32_t>(oldBlock.indices.GetCapacity()));
+	block->rangeCount = oldBlock.rangeCount;
+
+	std::vector<uint32_t> ids;
+	for (uint32_t id = 0; id < mRanges.size(); ++id)
+	{
+		if (mRanges[id].block == worstBlock)
+		{
+			ids.push_back(id);
+		}
+	}
+
+	//Vertices and indices are packed each in their own order, so ranges that were already next to each other stay so
+	//and go in one copy.
+	auto pack = [&](uint32_t GeometryRange::* first, uint32_t GeometryRange::* count, RangeAllocator& allocator, Buffer& dst, Buffer& src, size_t stride)
+		{
+			std::sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b) { return mRanges[a].*first < mRanges[b].*first; });
+			size_t copySrc = 0;
+			size_t copyDst = 0;
+			size_t copySize = 0;
+			for (uint32_t id : ids)
+			{
+				GeometryRange& range = mRanges[id];
+				uint32_t offset = static_cast<uint32_t>(allocator.Allocate(range.*count));
+				if (copySize > 0 && copySrc + copySize == range.*first && copyDst + copySize == offset)
+				{
+					copySize += range.*count;
+				}
+				else
+				{
+					commandList.CopyBufferRegion(dst, copyDst * stride, src, copySrc * stride, copySize * stride);
+					copySrc = range.*first;
+					copyDst = offset;
+					copySize = range.*count;
+				}
+				range.*first = offset;
+			}
+			commandList.CopyBufferRegion(dst, copyDst * stride, src, copySrc * stride, copySize * stride);
+		};
+	pack(&GeometryRange::firstVertex, &GeometryRange::vertexCount, block->vertices, block->vertexBuffer, oldBlock.vertexBuffer, mVertexStride);
+	pack(&GeometryRange::firstIndex, &GeometryRange::indexCount, block->indices, block->indexBuffer, oldBlock.indexBuffer, sizeof(uint16_t));
+
+	//The copies tracked the old buffers, so they outlive the block until commandList completes.
+	mBlocks[worstBlock] = std::move(block);
+	return static_cast<int>(ids.size());
+}
+
+GeometryPoolStats GeometryPool::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	GeometryPoolStats stats;
+	for (const auto& block : mBlocks)
+	{
+		if (block == nullptr)
+		{
+			continue;
+		}
+		++stats.blockCount;
+		stats.rangeCount += block->rangeCount;
+		stats.vertexCapacity += block->vertices.GetCapacity();
+		stats.usedVertices += block->vertices.GetCapacity() - block->vertices.GetFreeSize();
+		stats.indexCapacity += block->indices.GetCapacity();
+		stats.usedIndices += block->indices.GetCapacity() - block->indices.GetFreeSize();
+		stats.fragmentation = std::max(stats.fragmentation, GetFragmentation(*block));
+	}
+	return stats;
+}
+
+std::unique_ptr<GeometryPool::Block> GeometryPool::CreateBlock(CommandList& commandList, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	auto block = std::make_unique<Block>(mApp, vertexCapacity, indexCapacity);
+	commandList.CopyVertexBuffer(block->vertexBuffer, vertexCapacity, mVertexStride, nullptr);
+	block->vertexBuffer.CreateVertexBufferView(vertexCapacity, mVertexStride);
+	commandList.CopyIndexBuffer(block->indexBuffer, indexCapacity, DXGI_FORMAT_R16_UINT, nullptr);
+	block->indexBuffer.CreateViews(indexCapacity, sizeof(uint16_t));
+	return block;
+}
+
+float GeometryPool::GetFragmentation(const Block& block) const
+{
+	return std::max(block.vertices.GetFragmentation(), block.indices.GetFragmentation());
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "RangeAllocator.h"
+
+class DXApp;
+class CommandList;
+class GeometryPool;
+
+/**
+ * @brief Where a mesh lies in the blocks of a GeometryPool, in vertices and indices.
+ */
+struct GeometryRange
+{
+	uint32_t block;
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+struct GeometryPoolStats
+{
+	int blockCount = 0;
+	int rangeCount = 0;
+	uint64_t vertexCapacity = 0;
+	uint64_t usedVertices = 0;
+	uint64_t indexCapacity = 0;
+	uint64_t usedIndices = 0;
+	//Of the most fragmented block, see RangeAllocator::GetFragmentation.
+	float fragmentation = 0.f;
+};
+
+/**
+ * @brief Owns a range of a GeometryPool and frees it when destroyed.
+ */
+class GeometryHandle
+{
+public:
+	GeometryHandle() = default;
+	GeometryHandle(GeometryHandle&& other) noexcept;
+	GeometryHandle& operator= (GeometryHandle&& other) noexcept;
+	~GeometryHandle();
+
+	GeometryHandle(const GeometryHandle& copy) = delete;
+	GeometryHandle& operator= (const GeometryHandle& other) = delete;
+
+	bool IsValid() const { return mPool != nullptr; }
+
+private:
+	friend class GeometryPool;
+	GeometryHandle(GeometryPool* pool, uint32_t id);
+	void Release();
+
+	GeometryPool* mPool = nullptr;
+	uint32_t mId = 0;
+};
+
+/**
+ * @brief Vertices and 16-bit indices of many meshes of one vertex format, suballocated from a few large buffers.
+ * @detail Meshes in the same block only differ by their first vertex and first index, so drawing them one after the other
+ * binds the buffers once and needs no committed resource per mesh. A range is found again through its handle, as
+ * Defragment moves it. Blocks are only written by the GPU, so uploads and Defragment have to be recorded on the same
+ * queue and an upload submitted before the list that defragments its block.
+ */
+class GeometryPool
+{
+public:
+	static constexpr uint32_t BlockVertices = 1 << 20;
+	static constexpr uint32_t BlockIndices = 1 << 22;
+
+	GeometryPool(DXApp* app, uint32_t vertexStride);
+
+	GeometryPool(const GeometryPool& copy) = delete;
+	GeometryPool& operator= (const GeometryPool& other) = delete;
+
+	/**
+	 * @brief Find room for a mesh, adding a block when none has it, and record the copy of its data into commandList.
+	 * @param vertices vertexCount vertices of the stride of the pool.
+	 */
+	GeometryHandle Allocate(CommandList& commandList, const void* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount);
+	/**
+	 * @brief Bind the buffers of the block the range is in, nothing when they already are.
+	 * @return Range to offset the draws by, valid until the next Defragment.
+	 */
+	GeometryRange Bind(CommandList& commandList, const GeometryHandle& handle);
+	/**
+	 * @brief Pack the ranges of the most fragmented block from the front of new buffers, and release blocks left empty.
+	 * @detail One block at a time, so the copies of a call stay a block at most. The old buffers live until commandList completes.
+	 * @return Ranges moved.
+	 */
+	int Defragment(CommandList& commandList, float minFragmentation = 0.25f);
+	GeometryPoolStats GetStats() const;
+
+private:
+	friend class GeometryHandle;
+	void Free(uint32_t id);
+
+	struct Block
+	{
+		Block(DXApp* app, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+		VertexBuffer vertexBuffer;
+		IndexBuffer indexBuffer;
+		RangeAllocator vertices;
+		RangeAllocator indices;
+		int rangeCount = 0;
+	};
+
+	static constexpr uint32_t FreeBlock = UINT32_MAX;
+
+	std::unique_ptr<Block> CreateBlock(CommandList& commandList, uint32_t vertexCapacity, uint32_t indexCapacity);
+	float GetFragmentation(const Block& block) const;
+
+	DXApp* mApp;
+	uint32_t mVertexStride;
+	//Blocks released by Defragment leave a null slot for the next block.
+	std::vector<std::unique_ptr<Block>> mBlocks;
+	//Indexed by handle id, block is FreeBlock for ids in mFreeIds.
+	std::vector<GeometryRange> mRanges;
+	std::vector<uint32_t> mFreeIds;
+	mutable std::mutex mMutex;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+
+class BezierSpline;
+
+enum class ArcLengthMethod
+{
+	AdaptiveTable,
+	GaussLegendre
+};
+
+/**
+ * @brief Interface for arc length reparameterization of a BezierSpline.
+ */
+class IArcLength
+{
+public:
+	virtual ~IArcLength() = default;
+
+	virtual void Build(const BezierSpline& spline) = 0;
+
+	/**
+	 * @brief Replace the tables of old segments [first, first + oldCount) with those of spline segments [first, first + newCount).
+	 * @detail Segments outside the range are kept and only the cumulative lengths behind it are patched.
+	 */
+	virtual void Splice(const BezierSpline& spline, int firstSegment, int oldSegmentCount, int newSegmentCount) = 0;
+
+	/**
+	 * @brief Map normalized arc length [0, 1] to global curve parameter.
+	 */
+	virtual float ArcLengthToParam(float normalizedArcLength) const = 0;
+
+	/**
+	 * @brief Find the segment holding normalized arc length [0, 1] and the arc length from that segment's start.
+	 */
+	virtual int FindSegment(float normalizedArcLength, float& localArcLength) const = 0;
+	/**
+	 * @brief Map arc length measured from the start of a segment to the segment's local parameter.
+	 */
+	virtual float LocalArcLengthToParam(int segment, float localArcLength) const = 0;
+	/**
+	 * @brief Inverse of LocalArcLengthToParam.
+	 */
+	virtual float LocalParamToArcLength(int segment, float localParam) const = 0;
+	virtual float GetSegmentStartArcLength(int segment) const = 0;
+	virtual float GetSegmentArcLength(int segment) const = 0;
+	virtual float GetWorldArcLength() const = 0;
+	virtual size_t GetMemorySize() const = 0;
+};
@@ -0,0 +1,115 @@
+#include "LodSelector.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	//Keeps the camera inside a bounding sphere from dividing by zero, everything is at full detail there anyway.
+	constexpr float MinDistance = 1e-3f;
+	//The threshold rises fast while over the triangle budget and falls back slowly, so it settles instead of oscillating.
+	constexpr float BudgetRaise = 1.25f;
+	constexpr float BudgetRelax = 1.02f;
+	//Relaxing only starts this far under the budget.
+	constexpr float BudgetSlack = 0.9f;
+	constexpr float MaxBudgetScale = 1024.f;
+
+	XMVECTOR LoadSlots(const std::vector<float>& values, int slot)
+	{
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&values[slot]));
+	}
+}
+
+void LodSelector::Clear()
+{
+	mCount = 0;
+}
+
+int LodSelector::Add(FXMMATRIX world, const MeshBounds& bounds, const LodChainStats& stats, int levelCount, int currentLod)
+{
+	if (mCount % 4 == 0 && static_cast<size_t>(mCount) == mPositionX.size())
+	{
+		size_t size = mPositionX.size() + 4;
+		mPositionX.resize(size, 0.f);
+		mPositionY.resize(size, 0.f);
+		mPositionZ.resize(size, 0.f);
+		mRadii.resize(size, 0.f);
+		mScales.resize(size, 0.f);
+		mCurrentLods.resize(size, 0.f);
+		for (int level = 0; level < MaxLevels; ++level)
+		{
+			mErrors[level].resize(size, FLT_MAX);
+			mTriangleCounts[level].resize(size, 0);
+		}
+	}
+
+	int slot = mCount++;
+	XMFLOAT3 center;
+	XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&bounds.center), world));
+	mPositionX[slot] = center.x;
+	mPositionY[slot] = center.y;
+	mPositionZ[slot] = center.z;
+	//The error grows with the largest axis scale, as does the sphere.
+	mScales[slot] = sqrtf(std::max({ XMVectorGetX(XMVector3LengthSq(world.r[0])), XMVectorGetX(XMVector3LengthSq(world.r[1])),
+		XMVectorGetX(XMVector3LengthSq(world.r[2])) }));
+	mRadii[slot] = std::max(bounds.radius, 0.f) * mScales[slot];
+	mCurrentLods[slot] = static_cast<float>(std::min(currentLod, levelCount - 1));
+	for (int level = 0; level < MaxLevels; ++level)
+	{
+		mErrors[level][slot] = level < levelCount ? stats.errors[level] : FLT_MAX;
+		mTriangleCounts[level][slot] = static_cast<uint32_t>(stats.triangleCounts[std::min(level, levelCount - 1)]);
+	}
+	return slot;
+}
+
+void LodSelector::Select(FXMVECTOR eyePosition, float pixelsPerUnit)
+{
+	float threshold = GetEffectiveThreshold();
+	XMVECTOR keepThreshold = XMVectorReplicate(threshold);
+	XMVECTOR coarserThreshold = XMVectorReplicate(threshold * (1.f - mHysteresis));
+	XMVECTOR eyeX = XMVectorSplatX(eyePosition);
+	XMVECTOR eyeY = XMVectorSplatY(eyePosition);
+	XMVECTOR eyeZ = XMVectorSplatZ(eyePosition);
+	XMVECTOR minDistance = XMVectorReplicate(MinDistance);
+	XMVECTOR one = XMVectorSplatOne();
+
+	for (int slot = 0; slot < mCount; slot += 4)
+	{
+		XMVECTOR dx = XMVectorSubtract(LoadSlots(mPositionX, slot), eyeX);
+		XMVECTOR dy = XMVectorSubtract(LoadSlots(mPositionY, slot), eyeY);
+		XMVECTOR dz = XMVectorSubtract(LoadSlots(mPositionZ, slot), eyeZ);
+		XMVECTOR distanceSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz)));
+		XMVECTOR distance = XMVectorMax(XMVectorSubtract(XMVectorSqrt(distanceSq), LoadSlots(mRadii, slot)), minDistance);
+		//Pixels one object space unit of error covers.
+		XMVECTOR errorScale = XMVectorDivide(XMVectorScale(LoadSlots(mScales, slot), pixelsPerUnit), distance);
+
+		//Errors only grow along a chain and the threshold only drops past the current level, so the levels that
+		//pass are always a prefix and counting them gives the coarsest one.
+		XMVECTOR current = LoadSlots(mCurrentLods, slot);
+		XMVECTOR lod = XMVectorZero();
+		for (int level = 1; level < MaxLevels; ++level)
+		{
+			XMVECTOR coarser = XMVectorGreater(XMVectorReplicate(static_cast<float>(level)), current);
+			XMVECTOR limit = XMVectorSelect(keepThreshold, coarserThreshold, coarser);
+			XMVECTOR pass = XMVectorLessOrEqual(XMVectorMultiply(LoadSlots(mErrors[level], slot), errorScale), limit);
+			lod = XMVectorAdd(lod, XMVectorAndInt(pass, one));
+		}
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&mCurrentLods[slot]), lod);
+	}
+
+	mSelectedTriangles = 0;
+	mFullDetailTriangles = 0;
+	for (int slot = 0; slot < mCount; ++slot)
+	{
+		mSelectedTriangles += mTriangleCounts[GetLod(slot)][slot];
+		mFullDetailTriangles += mTriangleCounts[0][slot];
+	}
+
+	if (mTriangleBudget > 0 && mSelectedTriangles > mTriangleBudget)
+	{
+		mBudgetScale = std::min(mBudgetScale * BudgetRaise, MaxBudgetScale);
+	}
+	else if (mTriangleBudget == 0 || mSelectedTriangles < mTriangleBudget * BudgetSlack)
+	{
+		mBudgetScale = std::max(mBudgetScale / BudgetRelax, 1.f);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "MeshSimplifier.h"
+#include "MeshBounds.h"
+
+using namespace DirectX;
+
+/**
+ * @brief Picks a level of detail per object from the screen space size of each level's error.
+ * @detail Objects are gathered into structure of arrays form each frame and selected four at a time. An object takes
+ * the coarsest level whose error projects to at most the pixel threshold at the near side of its bounding sphere.
+ * Going coarser than the level it drew last frame takes an error below the threshold by the hysteresis fraction,
+ * so an object at the edge does not pop back and forth.
+ */
+class LodSelector
+{
+public:
+	static constexpr int MaxLevels = MeshSimplifier::MaxLodCount + 1;
+
+	LodSelector() = default;
+
+	LodSelector(const LodSelector& copy) = delete;
+	LodSelector& operator= (const LodSelector& other) = delete;
+
+	void Clear();
+	/**
+	 * @brief Queue an object for the next Select.
+	 * @param bounds Object space bounds of the object's model.
+	 * @param stats Error and triangles of each level of the object's model, in its object space.
+	 * @return Slot to read the selected level from.
+	 */
+	int Add(FXMMATRIX world, const MeshBounds& bounds, const LodChainStats& stats, int levelCount, int currentLod);
+	/**
+	 * @param pixelsPerUnit Pixels a unit long object covers at a distance of one unit, half the viewport height times _22 of the projection.
+	 */
+	void Select(FXMVECTOR eyePosition, float pixelsPerUnit);
+	int GetLod(int slot) const { return static_cast<int>(mCurrentLods[slot]); }
+
+	//Largest error in pixels an object may show, the quality knob.
+	float mPixelThreshold = 1.f;
+	//Fraction below the threshold an error has to be to move to a coarser level.
+	float mHysteresis = 0.25f;
+	//Triangles the selected levels should add up to, 0 for no budget. Over it, the threshold is raised over the next frames until it fits.
+	uint64_t mTriangleBudget = 0;
+
+	//Threshold after the budget, what the last Select used.
+	float GetEffectiveThreshold() const { return mPixelThreshold * mBudgetScale; }
+	uint64_t GetSelectedTriangles() const { return mSelectedTriangles; }
+	uint64_t GetFullDetailTriangles() const { return mFullDetailTriangles; }
+
+private:
+	int mCount = 0;
+	//Padded to a multiple of four so Select never needs a scalar tail.
+	std::vector<float> mPositionX;
+	std::vector<float> mPositionY;
+	std::vector<float> mPositionZ;
+	std::vector<float> mRadii;
+	std::vector<float> mScales;
+	std::vector<float> mCurrentLods;
+	//Levels a model does not have hold FLT_MAX so they are never picked.
+	std::vector<float> mErrors[MaxLevels];
+	std::vector<uint32_t> mTriangleCounts[MaxLevels];
+
+	float mBudgetScale = 1.f;
+	uint64_t mSelectedTriangles = 0;
+	uint64_t mFullDetailTriangles = 0;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read only view of a whole file mapped into memory.
+ * @detail Pages are read by the OS on first touch, so only the parts that are used cost any IO.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile& copy) = delete;
+	MappedFile& operator= (const MappedFile& other) = delete;
+
+	/**
+	 * @brief Map the file. Returns false when it is missing, empty or cannot be mapped.
+	 */
+	bool Open(const std::string& filePath);
+	void Close();
+
+	const uint8_t* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+	bool IsOpen() const { return mData != nullptr; }
+
+private:
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -1,32 +1,127 @@
 #include "Mesh.h"
 #include "DXApp.h"
+#include "VertexCompression.h"
+#include "MeshletCuller.h"
+#include <algorithm>
 
-Mesh::Mesh(DXApp* dxApp, std::vector<Vertex> input_vertices, std::vector<UINT> input_indices, CommandList& commandList)
-	:mApp(dxApp), mVertices(std::move(input_vertices)), mIndices(std::move(input_indices)), mVertexBuffer(dxApp), mIndexBuffer(dxApp),
-	mIndexCount(0), mBoneCount(0)
+Mesh::Mesh(DXApp* dxApp, std::vector<Vertex> input_vertices, std::vector<UINT> input_indices, const MeshBounds& bounds, CommandList& commandList,
+	GeometryRetention retention, std::vector<MeshLod> lods)
+	:mApp(dxApp), mVertices(std::move(input_vertices)), mIndices(std::move(input_indices)),
+	mBounds(bounds), mBoneCount(0)
 {
-	Init(commandList);
+	Init(commandList, lods);
+	ReleaseCpuGeometry(retention);
 }
 
-void Mesh::Init(CommandList& commandList)
+void Mesh::Init(CommandList& commandList, const std::vector<MeshLod>& lods)
 {
 	if(mVertices.size() >= UINT_MAX)
 	{
-		throw std::exception("Too many vertices for 16-bit index buffer");
+		throw std::exception("Too many vertices for 32-bit index buffer");
 	}
 
-	commandList.CopyVertexBuffer(mVertexBuffer, mVertices);
-	mVertexBuffer.CreateVertexBufferView(mVertices.size(), sizeof(mVertices[0]));
-	commandList.CopyIndexBuffer(mIndexBuffer, mIndices);
-	mIndexBuffer.CreateViews(mIndices.size(), sizeof(mIndices[0]));
+	//Every level goes into the same range, one after the other.
+	std::vector<PackedVertex> packedVertices;
+	std::vector<uint16_t> indices;
+	auto addLevel = [&](const std::vector<UINT>& levelIndices, float error)
+		{
+			//The GPU copy always has 16-bit indices, meshes with more vertices are drawn in parts.
+			MeshPartition partition = MeshPartition::Build(levelIndices, mVertices.size());
+			MeshLodParts level = { {}, {}, error };
+			//Before the parts move out of the partition, the meshlets are cut from them.
+			if (mVertices.empty() == false)
+			{
+				level.meshlets = Meshlet::Build(partition, &mVertices[0].position, sizeof(Vertex));
+			}
+			level.parts = std::move(partition.parts);
 
-	mIndexCount = static_cast<UINT>(mIndices.size());
+			//A mesh that fits a single part keeps its vertices as they are, so its levels share those of LOD 0.
+			//Larger meshes get a copy of the vertices each level uses.
+			int32_t baseVertex = 0;
+			if (packedVertices.empty() || mVertices.size() > MeshPartition::MaxPartVertices)
+			{
+				baseVertex = static_cast<int32_t>(packedVertices.size());
+				for (size_t i = 0; i < partition.vertexCount; ++i)
+				{
+					packedVertices.push_back(VertexCompression::Pack(mVertices[partition.GetSourceVertex(i)]));
+				}
+			}
+			uint32_t startIndex = static_cast<uint32_t>(indices.size());
+			indices.insert(indices.end(), partition.indices.begin(), partition.indices.end());
+
+			for (MeshPart& part : level.parts)
+			{
+				part.startIndex += startIndex;
+				part.baseVertex += baseVertex;
+			}
+			for (Meshlet& meshlet : level.meshlets)
+			{
+				meshlet.startIndex += startIndex;
+				meshlet.baseVertex += baseVertex;
+			}
+			mLods.push_back(std::move(level));
+		};
+	addLevel(mIndices, 0.f);
+	for (const MeshLod& lod : lods)
+	{
+		addLevel(lod.indices, lod.error);
+	}
+
+	if (indices.empty())
+	{
+		return;
+	}
+	mGeometry = mApp->GetGeometryPool().Allocate(commandList, packedVertices.data(), static_cast<uint32_t>(packedVertices.size()),
+		indices.data(), static_cast<uint32_t>(indices.size()));
+}
+
+void Mesh::ReleaseCpuGeometry(GeometryRetention retention)
+{
+	//Recording the copies already staged the data in upload buffers, so the GPU no longer needs these.
+	if (retention == GeometryRetention::Positions)
+	{
+		mPositions.resize(mVertices.size());
+		for (size_t i = 0; i < mVertices.size(); ++i)
+		{
+			mPositions[i] = mVertices[i].position;
+		}
+	}
+	if (retention != GeometryRetention::Full)
+	{
+		std::vector<Vertex>().swap(mVertices);
+	}
+	if (retention == GeometryRetention::None)
+	{
+		std::vector<UINT>().swap(mIndices);
+	}
+}
+
+void Mesh::Draw(CommandList& commandList, int lod)
+{
+	if (mGeometry.IsValid() == false)
+	{
+		return;
+	}
+	commandList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	GeometryRange range = mApp->GetGeometryPool().Bind(commandList, mGeometry);
+	for (const MeshPart& part : GetLod(lod).parts)
+	{
+		commandList.DrawIndexed(part.indexCount, 1, part.startIndex + range.firstIndex, part.baseVertex + static_cast<int32_t>(range.firstVertex));
+	}
 }
 
-void Mesh::Draw(CommandList& commandList)
+void Mesh::Draw(CommandList& commandList, MeshletCuller& culler, int lod)
 {
+	const std::vector<MeshPart>& visibleRanges = culler.Cull(GetLod(lod).meshlets);
+	if (visibleRanges.empty())
+	{
+		return;
+	}
+
 	commandList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	commandList.SetVertexBuffer(0, mVertexBuffer);
-	commandList.SetIndexBuffer(mIndexBuffer);
-	commandList.DrawIndexed(mIndexCount);
+	GeometryRange range = mApp->GetGeometryPool().Bind(commandList, mGeometry);
+	for (const MeshPart& visibleRange : visibleRanges)
+	{
+		commandList.DrawIndexed(visibleRange.indexCount, 1, visibleRange.startIndex + range.firstIndex, visibleRange.baseVertex + static_cast<int32_t>(range.firstVertex));
+	}
 }
@@ -1,17 +1,34 @@
 #pragma once
+#include <algorithm>
 #include <DirectXMath.h>
 #include <d3dx12.h>
 #include <vector>
 #include <wrl.h>
 
 #include "CommandList.h"
-#include "VertexBuffer.h"
-#include "IndexBuffer.h"
+#include "GeometryPool.h"
+#include "MeshPartition.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "MeshBounds.h"
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
 
 class DXApp;
+class MeshletCuller;
+
+/**
+ * @brief What a mesh keeps on the CPU once its buffers are recorded for upload.
+ */
+enum class GeometryRetention
+{
+	Full,
+	//Positions and indices only, for CPU queries such as picking and nav mesh building.
+	Positions,
+	None
+};
+
 struct Vertex
 {
 	XMFLOAT3 position;
@@ -21,26 +38,69 @@ struct Vertex
 	XMFLOAT3 biTangent;
 };
 
+/**
+ * @brief Where one level of detail of a mesh lies in its buffers.
+ */
+struct MeshLodParts
+{
+	std::vector<MeshPart> parts;
+	std::vector<Meshlet> meshlets;
+	//See MeshLod, 0 for LOD 0.
+	float error;
+};
+
 struct Mesh
 {
 private:
 	DXApp* mApp = nullptr;
 
 public:
-	Mesh(DXApp* dxApp, std::vector<Vertex> input_vertices, std::vector<UINT> input_indices, CommandList& commandList);
-	void Draw(CommandList& commandList);
+	/**
+	 * @param bounds Object space bounds of input_vertices.
+	 * @param lods Coarser levels over input_vertices, uploaded into the same range of the geometry pool.
+	 */
+	Mesh(DXApp* dxApp, std::vector<Vertex> input_vertices, std::vector<UINT> input_indices, const MeshBounds& bounds, CommandList& commandList,
+		GeometryRetention retention = GeometryRetention::Full, std::vector<MeshLod> lods = {});
+	/**
+	 * @brief Draw a level of detail, levels past the last one draw the last one.
+	 */
+	void Draw(CommandList& commandList, int lod = 0);
+	/**
+	 * @brief Draw only the meshlets that pass culler, which has to be set to the object drawn.
+	 */
+	void Draw(CommandList& commandList, MeshletCuller& culler, int lod = 0);
+	int GetLodCount() const { return static_cast<int>(mLods.size()); }
+	//Levels past the last one return the last one, as Draw does.
+	float GetLodError(int lod) const { return GetLod(lod).error; }
+	const std::vector<Meshlet>& GetMeshlets(int lod = 0) const { return GetLod(lod).meshlets; }
+	//Empty unless the retention is Full.
+	const std::vector<Vertex>& GetVertices() const { return mVertices; }
+	//Of LOD 0. Empty when the retention is None.
+	const std::vector<UINT>& GetIndices() const { return mIndices; }
+	/**
+	 * @brief Positions kept on the CPU, GetPositionStride bytes apart. Null when the retention is None.
+	 */
+	const XMFLOAT3* GetPositions() const { return mVertices.empty() ? mPositions.data() : &mVertices[0].position; }
+	UINT GetPositionStride() const { return mVertices.empty() ? sizeof(XMFLOAT3) : sizeof(Vertex); }
+	size_t GetPositionCount() const { return mVertices.empty() ? mPositions.size() : mVertices.size(); }
+	//Object space, kept whatever the retention.
+	const MeshBounds& GetBounds() const { return mBounds; }
 
 private:
-	VertexBuffer mVertexBuffer;
-	IndexBuffer mIndexBuffer;
+	//Every level, in the geometry pool of mApp. Draws offset the parts by where the range is.
+	GeometryHandle mGeometry;
 
 	std::vector<Vertex> mVertices;
 	std::vector<UINT> mIndices;
+	std::vector<XMFLOAT3> mPositions;
 
-	UINT mIndexCount;
+	std::vector<MeshLodParts> mLods;
+	MeshBounds mBounds;
 	UINT mBoneCount;
 
 private:
-	void Init(CommandList& commandList);
+	const MeshLodParts& GetLod(int lod) const { return mLods[std::min(lod, GetLodCount() - 1)]; }
+	void Init(CommandList& commandList, const std::vector<MeshLod>& lods);
+	void ReleaseCpuGeometry(GeometryRetention retention);
 };
 
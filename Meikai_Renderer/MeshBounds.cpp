@@ -0,0 +1,130 @@
+#include "MeshBounds.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	XMVECTOR LoadPosition(const XMFLOAT3* positions, size_t index, size_t stride)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + index * stride));
+	}
+}
+
+MeshBounds MeshBounds::FromPositions(const XMFLOAT3* positions, size_t count, size_t stride)
+{
+	MeshBounds bounds;
+	if (count == 0)
+	{
+		return bounds;
+	}
+
+	//Four independent accumulators, so each min and max does not wait on the one before.
+	XMVECTOR boundsMin[4];
+	XMVECTOR boundsMax[4];
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		boundsMin[lane] = LoadPosition(positions, 0, stride);
+		boundsMax[lane] = boundsMin[lane];
+	}
+	size_t index = 0;
+	for (; index + 4 <= count; index += 4)
+	{
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			XMVECTOR position = LoadPosition(positions, index + lane, stride);
+			boundsMin[lane] = XMVectorMin(boundsMin[lane], position);
+			boundsMax[lane] = XMVectorMax(boundsMax[lane], position);
+		}
+	}
+	for (; index < count; ++index)
+	{
+		XMVECTOR position = LoadPosition(positions, index, stride);
+		boundsMin[0] = XMVectorMin(boundsMin[0], position);
+		boundsMax[0] = XMVectorMax(boundsMax[0], position);
+	}
+	XMVECTOR minimum = XMVectorMin(XMVectorMin(boundsMin[0], boundsMin[1]), XMVectorMin(boundsMin[2], boundsMin[3]));
+	XMVECTOR maximum = XMVectorMax(XMVectorMax(boundsMax[0], boundsMax[1]), XMVectorMax(boundsMax[2], boundsMax[3]));
+	XMVECTOR center = XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f);
+
+	//The half diagonal of the box would do, but the farthest position is often well inside its corners.
+	XMVECTOR radiusSq[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+	for (index = 0; index + 4 <= count; index += 4)
+	{
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			radiusSq[lane] = XMVectorMax(radiusSq[lane], XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, index + lane, stride), center)));
+		}
+	}
+	for (; index < count; ++index)
+	{
+		radiusSq[0] = XMVectorMax(radiusSq[0], XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, index, stride), center)));
+	}
+
+	XMStoreFloat3(&bounds.boundsMin, minimum);
+	XMStoreFloat3(&bounds.boundsMax, maximum);
+	XMStoreFloat3(&bounds.center, center);
+	bounds.radius = sqrtf(XMVectorGetX(XMVectorMax(XMVectorMax(radiusSq[0], radiusSq[1]), XMVectorMax(radiusSq[2], radiusSq[3]))));
+	return bounds;
+}
+
+MeshBounds MeshBounds::Merge(const MeshBounds& first, const MeshBounds& second)
+{
+	if (first.IsEmpty())
+	{
+		return second;
+	}
+	if (second.IsEmpty())
+	{
+		return first;
+	}
+
+	MeshBounds bounds;
+	XMStoreFloat3(&bounds.boundsMin, XMVectorMin(XMLoadFloat3(&first.boundsMin), XMLoadFloat3(&second.boundsMin)));
+	XMStoreFloat3(&bounds.boundsMax, XMVectorMax(XMLoadFloat3(&first.boundsMax), XMLoadFloat3(&second.boundsMax)));
+
+	XMVECTOR firstCenter = XMLoadFloat3(&first.center);
+	XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&second.center), firstCenter);
+	float distance = XMVectorGetX(XMVector3Length(offset));
+	if (distance + second.radius <= first.radius)
+	{
+		bounds.center = first.center;
+		bounds.radius = first.radius;
+	}
+	else if (distance + first.radius <= second.radius)
+	{
+		bounds.center = second.center;
+		bounds.radius = second.radius;
+	}
+	else
+	{
+		//From the far side of the first sphere to the far side of the second, along the line through both centers.
+		bounds.radius = (distance + first.radius + second.radius) * 0.5f;
+		XMStoreFloat3(&bounds.center, XMVectorAdd(firstCenter, XMVectorScale(offset, (bounds.radius - first.radius) / distance)));
+	}
+	return bounds;
+}
+
+MeshBounds MeshBounds::Transform(FXMMATRIX world) const
+{
+	if (IsEmpty())
+	{
+		return *this;
+	}
+
+	//Each axis of the box adds its transformed half extent to every world axis, whatever the sign.
+	XMVECTOR boxCenter = XMVectorScale(XMVectorAdd(XMLoadFloat3(&boundsMin), XMLoadFloat3(&boundsMax)), 0.5f);
+	XMVECTOR extents = XMVectorScale(XMVectorSubtract(XMLoadFloat3(&boundsMax), XMLoadFloat3(&boundsMin)), 0.5f);
+	XMVECTOR worldExtents = XMVectorMultiply(XMVectorAbs(world.r[0]), XMVectorSplatX(extents));
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[1]), XMVectorSplatY(extents), worldExtents);
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[2]), XMVectorSplatZ(extents), worldExtents);
+	XMVECTOR worldCenter = XMVector3Transform(boxCenter, world);
+
+	MeshBounds bounds;
+	XMStoreFloat3(&bounds.boundsMin, XMVectorSubtract(worldCenter, worldExtents));
+	XMStoreFloat3(&bounds.boundsMax, XMVectorAdd(worldCenter, worldExtents));
+	XMStoreFloat3(&bounds.center, XMVector3Transform(XMLoadFloat3(&center), world));
+	float scaleSq = std::max({ XMVectorGetX(XMVector3LengthSq(world.r[0])), XMVectorGetX(XMVector3LengthSq(world.r[1])),
+		XMVectorGetX(XMVector3LengthSq(world.r[2])) });
+	bounds.radius = radius * sqrtf(scaleSq);
+	return bounds;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+/**
+ * @brief Axis aligned box and bounding sphere of a mesh or model.
+ * @detail Either may be the tighter one depending on the shape, so both are kept. A default constructed MeshBounds
+ * is empty, its box inside out and its radius negative, and merging it changes nothing.
+ */
+struct MeshBounds
+{
+	XMFLOAT3 boundsMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 boundsMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	XMFLOAT3 center = XMFLOAT3(0.f, 0.f, 0.f);
+	float radius = -1.f;
+
+	bool IsEmpty() const { return radius < 0.f; }
+
+	/**
+	 * @brief Box from a min/max reduction over the positions, and the sphere around them centered on the box.
+	 * @param positions First of count positions, stride bytes apart.
+	 */
+	static MeshBounds FromPositions(const XMFLOAT3* positions, size_t count, size_t stride);
+
+	template<typename VertexType>
+	static MeshBounds FromVertices(const std::vector<VertexType>& vertices)
+	{
+		return vertices.empty() ? MeshBounds() : FromPositions(&vertices[0].position, vertices.size(), sizeof(VertexType));
+	}
+	/**
+	 * @brief Bounds of both, the sphere enclosing the two spheres rather than the box.
+	 */
+	static MeshBounds Merge(const MeshBounds& first, const MeshBounds& second);
+	/**
+	 * @brief Bounds after world, the box around the transformed box and the sphere scaled by the largest axis.
+	 */
+	MeshBounds Transform(FXMMATRIX world) const;
+};
@@ -0,0 +1,268 @@
+#include "MeshCache.h"
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	constexpr uint32_t MeshCacheMagic = 0x48534D4D; //"MMSH"
+	//Bump whenever the layout of the file or of the cooked vertices changes.
+	constexpr uint32_t MeshCacheVersion = 6;
+	constexpr uint64_t StreamAlignment = 16;
+
+	struct MeshCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t layout;
+		uint32_t vertexStride;
+		uint32_t importFlags;
+		uint32_t subMeshCount;
+		uint64_t sourceHash;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+		uint32_t boneCount;
+		uint32_t boneBytes;
+		uint32_t lodCount;
+		uint32_t padding;
+		uint64_t subMeshOffset;
+		uint64_t lodOffset;
+		uint64_t boneOffset;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+	};
+
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + StreamAlignment - 1) & ~(StreamAlignment - 1);
+	}
+
+	bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+
+	//Each bone is its id, 16 floats of offset matrix, the name length and the name.
+	constexpr size_t BoneFixedBytes = 8 + sizeof(XMFLOAT4X4);
+
+	bool AreBonesValid(const uint8_t* bones, uint32_t boneCount, uint64_t boneBytes)
+	{
+		uint64_t cursor = 0;
+		for (uint32_t bone = 0; bone < boneCount; ++bone)
+		{
+			if (InFile(cursor, BoneFixedBytes, boneBytes) == false)
+			{
+				return false;
+			}
+			uint32_t nameLength;
+			memcpy(&nameLength, bones + cursor + BoneFixedBytes - 4, sizeof(uint32_t));
+			cursor += BoneFixedBytes;
+			if (InFile(cursor, nameLength, boneBytes) == false)
+			{
+				return false;
+			}
+			cursor += nameLength;
+		}
+		return true;
+	}
+}
+
+bool MeshCache::Open(const std::string& sourcePath, MeshCacheLayout layout, uint32_t vertexStride, uint32_t importFlags)
+{
+	if (mFile.Open(GetCachePath(sourcePath)) == false || mFile.GetSize() < sizeof(MeshCacheHeader))
+	{
+		mFile.Close();
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memcpy(&header, mFile.GetData(), sizeof(header));
+	uint64_t fileSize = mFile.GetSize();
+	bool valid = header.magic == MeshCacheMagic && header.version == MeshCacheVersion &&
+		header.layout == static_cast<uint32_t>(layout) && header.vertexStride == vertexStride && header.importFlags == importFlags &&
+		InFile(header.subMeshOffset, static_cast<uint64_t>(header.subMeshCount) * sizeof(MeshCacheSubMesh), fileSize) &&
+		InFile(header.lodOffset, static_cast<uint64_t>(header.lodCount) * sizeof(MeshCacheLod), fileSize) &&
+		InFile(header.boneOffset, header.boneBytes, fileSize) &&
+		header.vertexCount <= fileSize && InFile(header.vertexOffset, header.vertexCount * vertexStride, fileSize) &&
+		header.indexCount <= fileSize && InFile(header.indexOffset, header.indexCount * sizeof(uint32_t), fileSize) &&
+		AreBonesValid(mFile.GetData() + header.boneOffset, header.boneCount, header.boneBytes);
+	//Hashing last, since it reads the whole source.
+	if (valid == false || header.sourceHash != HashFile(sourcePath))
+	{
+		mFile.Close();
+		return false;
+	}
+
+	mSubMeshCount = header.subMeshCount;
+	mBoneCount = header.boneCount;
+	mSubMeshes = mFile.GetData() + header.subMeshOffset;
+	mLods = mFile.GetData() + header.lodOffset;
+	mBones = mFile.GetData() + header.boneOffset;
+	mVertices = mFile.GetData() + header.vertexOffset;
+	mIndices = mFile.GetData() + header.indexOffset;
+
+	for (int subMesh = 0; subMesh < GetSubMeshCount(); ++subMesh)
+	{
+		MeshCacheSubMesh range = GetSubMesh(subMesh);
+		bool rangeValid = static_cast<uint64_t>(range.firstVertex) + range.vertexCount <= header.vertexCount &&
+			static_cast<uint64_t>(range.firstIndex) + range.indexCount <= header.indexCount &&
+			static_cast<uint64_t>(range.firstLod) + range.lodCount <= header.lodCount;
+		for (uint32_t lod = 0; rangeValid && lod < range.lodCount; ++lod)
+		{
+			MeshCacheLod lodRange;
+			memcpy(&lodRange, mLods + (range.firstLod + lod) * sizeof(MeshCacheLod), sizeof(lodRange));
+			rangeValid = static_cast<uint64_t>(lodRange.firstIndex) + lodRange.indexCount <= header.indexCount;
+		}
+		if (rangeValid == false)
+		{
+			mFile.Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+MeshCacheSubMesh MeshCache::GetSubMesh(int subMesh) const
+{
+	MeshCacheSubMesh range;
+	memcpy(&range, mSubMeshes + subMesh * sizeof(MeshCacheSubMesh), sizeof(range));
+	return range;
+}
+
+std::vector<uint32_t> MeshCache::GetIndices(int subMesh) const
+{
+	MeshCacheSubMesh range = GetSubMesh(subMesh);
+	std::vector<uint32_t> indices(range.indexCount);
+	memcpy(indices.data(), mIndices + static_cast<size_t>(range.firstIndex) * sizeof(uint32_t), range.indexCount * sizeof(uint32_t));
+	return indices;
+}
+
+std::vector<MeshLod> MeshCache::GetLods(int subMesh) const
+{
+	MeshCacheSubMesh range = GetSubMesh(subMesh);
+	std::vector<MeshLod> lods(range.lodCount);
+	for (uint32_t lod = 0; lod < range.lodCount; ++lod)
+	{
+		MeshCacheLod lodRange;
+		memcpy(&lodRange, mLods + (range.firstLod + lod) * sizeof(MeshCacheLod), sizeof(lodRange));
+		lods[lod].indices.resize(lodRange.indexCount);
+		memcpy(lods[lod].indices.data(), mIndices + static_cast<size_t>(lodRange.firstIndex) * sizeof(uint32_t), lodRange.indexCount * sizeof(uint32_t));
+		lods[lod].error = lodRange.error;
+	}
+	return lods;
+}
+
+std::vector<MeshCacheBone> MeshCache::GetBones() const
+{
+	std::vector<MeshCacheBone> bones(mBoneCount);
+	const uint8_t* cursor = mBones;
+	for (MeshCacheBone& bone : bones)
+	{
+		uint32_t nameLength;
+		memcpy(&bone.id, cursor, sizeof(int32_t));
+		memcpy(&bone.offset, cursor + 4, sizeof(XMFLOAT4X4));
+		memcpy(&nameLength, cursor + BoneFixedBytes - 4, sizeof(uint32_t));
+		cursor += BoneFixedBytes;
+		bone.name.assign(reinterpret_cast<const char*>(cursor), nameLength);
+		cursor += nameLength;
+	}
+	return bones;
+}
+
+bool MeshCache::Write(const std::string& sourcePath, MeshCacheLayout layout, uint32_t vertexStride, uint32_t importFlags,
+	const std::vector<MeshCacheSubMesh>& subMeshes, const void* vertices, size_t vertexCount,
+	const uint32_t* indices, size_t indexCount, const std::vector<MeshCacheLod>& lods, const std::vector<MeshCacheBone>& bones)
+{
+	std::vector<uint8_t> boneBytes;
+	for (const MeshCacheBone& bone : bones)
+	{
+		size_t start = boneBytes.size();
+		uint32_t nameLength = static_cast<uint32_t>(bone.name.size());
+		boneBytes.resize(start + BoneFixedBytes + nameLength);
+		memcpy(&boneBytes[start], &bone.id, sizeof(int32_t));
+		memcpy(&boneBytes[start + 4], &bone.offset, sizeof(XMFLOAT4X4));
+		memcpy(&boneBytes[start + BoneFixedBytes - 4], &nameLength, sizeof(uint32_t));
+		memcpy(&boneBytes[start + BoneFixedBytes], bone.name.data(), nameLength);
+	}
+
+	MeshCacheHeader header = {};
+	header.magic = MeshCacheMagic;
+	header.version = MeshCacheVersion;
+	header.layout = static_cast<uint32_t>(layout);
+	header.vertexStride = vertexStride;
+	header.importFlags = importFlags;
+	header.subMeshCount = static_cast<uint32_t>(subMeshes.size());
+	header.sourceHash = HashFile(sourcePath);
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.boneCount = static_cast<uint32_t>(bones.size());
+	header.boneBytes = static_cast<uint32_t>(boneBytes.size());
+	header.lodCount = static_cast<uint32_t>(lods.size());
+	header.subMeshOffset = Align(sizeof(MeshCacheHeader));
+	header.lodOffset = Align(header.subMeshOffset + subMeshes.size() * sizeof(MeshCacheSubMesh));
+	header.boneOffset = Align(header.lodOffset + lods.size() * sizeof(MeshCacheLod));
+	header.vertexOffset = Align(header.boneOffset + boneBytes.size());
+	header.indexOffset = Align(header.vertexOffset + vertexCount * vertexStride);
+	if (header.sourceHash == 0)
+	{
+		return false;
+	}
+
+	std::string cachePath = GetCachePath(sourcePath);
+	std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (file.is_open() == false)
+		{
+			return false;
+		}
+
+		auto writeAt = [&file](uint64_t offset, const void* data, size_t size)
+		{
+			static const char padding[StreamAlignment] = {};
+			uint64_t position = static_cast<uint64_t>(file.tellp());
+			file.write(padding, static_cast<std::streamsize>(offset - position));
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writeAt(header.subMeshOffset, subMeshes.data(), subMeshes.size() * sizeof(MeshCacheSubMesh));
+		writeAt(header.lodOffset, lods.data(), lods.size() * sizeof(MeshCacheLod));
+		writeAt(header.boneOffset, boneBytes.data(), boneBytes.size());
+		writeAt(header.vertexOffset, vertices, vertexCount * vertexStride);
+		writeAt(header.indexOffset, indices, indexCount * sizeof(uint32_t));
+		if (file.good() == false)
+		{
+			file.close();
+			std::remove(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	std::remove(cachePath.c_str());
+	return std::rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+}
+
+uint64_t MeshCache::HashFile(const std::string& filePath)
+{
+	MappedFile file;
+	if (file.Open(filePath) == false)
+	{
+		return 0;
+	}
+
+	//FNV-1a over 8 byte words rather than bytes, which keeps hashing far below the cost of parsing.
+	const uint64_t prime = 1099511628211ull;
+	uint64_t hash = 14695981039346656037ull ^ file.GetSize();
+	const uint8_t* data = file.GetData();
+	size_t wordCount = file.GetSize() / 8;
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		uint64_t word;
+		memcpy(&word, data + i * 8, 8);
+		hash = (hash ^ word) * prime;
+	}
+	for (size_t i = wordCount * 8; i < file.GetSize(); ++i)
+	{
+		hash = (hash ^ data[i]) * prime;
+	}
+	return hash == 0 ? 1 : hash;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+
+using namespace DirectX;
+
+enum class MeshCacheLayout : uint32_t
+{
+	Static,
+	Skeletal
+};
+
+struct MeshCacheSubMesh
+{
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	//Range of the LOD table.
+	uint32_t firstLod;
+	uint32_t lodCount;
+};
+
+//LOD of a sub mesh, its indices live in the index stream too.
+struct MeshCacheLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+};
+
+struct MeshCacheBone
+{
+	std::string name;
+	int id;
+	//Row major, as aiMatrix4x4 stores it.
+	XMFLOAT4X4 offset;
+};
+
+/**
+ * @brief Cooked binary copy of an imported model, kept next to the source as <source>.mesh.
+ * @detail The file holds the final vertex and index streams of every sub mesh, so a warm start maps it
+ * and copies the streams out without running the importer. It is only used while the hash of the source
+ * file, the import flags, the vertex layout and the format version all still match.
+ */
+class MeshCache
+{
+public:
+	MeshCache() = default;
+
+	/**
+	 * @brief Map the cooked file of sourcePath. Returns false when it is missing or stale.
+	 */
+	bool Open(const std::string& sourcePath, MeshCacheLayout layout, uint32_t vertexStride, uint32_t importFlags);
+
+	int GetSubMeshCount() const { return static_cast<int>(mSubMeshCount); }
+	MeshCacheSubMesh GetSubMesh(int subMesh) const;
+	template<typename VertexType>
+	std::vector<VertexType> GetVertices(int subMesh) const
+	{
+		MeshCacheSubMesh range = GetSubMesh(subMesh);
+		std::vector<VertexType> vertices(range.vertexCount);
+		memcpy(vertices.data(), mVertices + static_cast<size_t>(range.firstVertex) * sizeof(VertexType), range.vertexCount * sizeof(VertexType));
+		return vertices;
+	}
+	std::vector<uint32_t> GetIndices(int subMesh) const;
+	std::vector<MeshLod> GetLods(int subMesh) const;
+	std::vector<MeshCacheBone> GetBones() const;
+
+	/**
+	 * @brief Cook sub meshes whose streams were appended to vertices and indices in order.
+	 * @detail Written to a temporary file and renamed, so a crash never leaves a half written cache behind.
+	 * Returns false when the file cannot be written, e.g. next to read only sources.
+	 */
+	static bool Write(const std::string& sourcePath, MeshCacheLayout layout, uint32_t vertexStride, uint32_t importFlags,
+		const std::vector<MeshCacheSubMesh>& subMeshes, const void* vertices, size_t vertexCount,
+		const uint32_t* indices, size_t indexCount, const std::vector<MeshCacheLod>& lods, const std::vector<MeshCacheBone>& bones);
+
+	static std::string GetCachePath(const std::string& sourcePath) { return sourcePath + ".mesh"; }
+	/**
+	 * @brief Hash of the file contents, or 0 when it cannot be read.
+	 */
+	static uint64_t HashFile(const std::string& filePath);
+
+private:
+	MappedFile mFile;
+	uint32_t mSubMeshCount = 0;
+	uint32_t mBoneCount = 0;
+	const uint8_t* mSubMeshes = nullptr;
+	const uint8_t* mLods = nullptr;
+	const uint8_t* mBones = nullptr;
+	const uint8_t* mVertices = nullptr;
+	const uint8_t* mIndices = nullptr;
+};
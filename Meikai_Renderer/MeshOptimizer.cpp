@@ -0,0 +1,373 @@
+#include "MeshOptimizer.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	//Forsyth's scoring, tuned for a larger cache than the simulated one so it degrades gracefully on any GPU.
+	constexpr int ScoringCacheSize = 32;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float ValenceBoostScale = 2.f;
+	constexpr float ValenceBoostPower = 0.5f;
+	constexpr uint32_t ValenceTableSize = 32;
+	constexpr uint32_t NoTriangle = UINT32_MAX;
+
+	struct ScoreTables
+	{
+		float cache[ScoringCacheSize];
+		float valence[ValenceTableSize];
+
+		ScoreTables()
+		{
+			for (int position = 0; position < ScoringCacheSize; ++position)
+			{
+				//The last triangle's vertices get a fixed score, so the next triangle does not just go back and forth.
+				cache[position] = position < 3 ? LastTriangleScore : powf(1.f - (position - 3) / static_cast<float>(ScoringCacheSize - 3), CacheDecayPower);
+			}
+			valence[0] = 0.f;
+			for (uint32_t remaining = 1; remaining < ValenceTableSize; ++remaining)
+			{
+				valence[remaining] = ValenceBoostScale * powf(static_cast<float>(remaining), -ValenceBoostPower);
+			}
+		}
+
+		float Score(int cachePosition, uint32_t remainingValence) const
+		{
+			if (remainingValence == 0)
+			{
+				return -1.f;
+			}
+			float score = cachePosition >= 0 ? cache[cachePosition] : 0.f;
+			return score + (remainingValence < ValenceTableSize ? valence[remainingValence] :
+				ValenceBoostScale * powf(static_cast<float>(remainingValence), -ValenceBoostPower));
+		}
+	};
+
+	const XMFLOAT3& GetPosition(const XMFLOAT3* positions, size_t positionStride, uint32_t vertex)
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+	}
+
+	/**
+	 * @brief FIFO cache simulation that can be flushed in constant time.
+	 */
+	class CacheSimulator
+	{
+	public:
+		CacheSimulator(size_t vertexCount, int cacheSize)
+			:mTimestamps(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize)
+		{
+		}
+
+		//Returns whether the vertex had to be transformed.
+		bool Access(uint32_t vertex)
+		{
+			if (mTime - mTimestamps[vertex] > static_cast<uint32_t>(mCacheSize))
+			{
+				mTimestamps[vertex] = mTime++;
+				return true;
+			}
+			return false;
+		}
+
+		void Flush()
+		{
+			mTime += mCacheSize + 1;
+		}
+
+	private:
+		std::vector<uint32_t> mTimestamps;
+		uint32_t mTime;
+		int mCacheSize;
+	};
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	assert(indices.size() % 3 == 0);
+	static const ScoreTables scoreTables;
+	size_t triangleCount = indices.size() / 3;
+
+	//Triangles of each vertex. The live ones are the first remainingValence of its range.
+	std::vector<uint32_t> remainingValence(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		assert(index < vertexCount);
+		++remainingValence[index];
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingValence[vertex];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		vertexScores[vertex] = scoreTables.Score(-1, remainingValence[vertex]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	uint32_t bestTriangle = NoTriangle;
+	float bestScore = -1.f;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		const uint32_t* corners = &indices[triangle * 3];
+		triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+		if (triangleScores[triangle] > bestScore)
+		{
+			bestScore = triangleScores[triangle];
+			bestTriangle = static_cast<uint32_t>(triangle);
+		}
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	uint32_t cache[ScoringCacheSize + 3];
+	int cacheCount = 0;
+	size_t scanCursor = 0;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		if (bestTriangle == NoTriangle)
+		{
+			//Nothing left around the cache, restart from the first triangle not emitted yet.
+			while (emitted[scanCursor])
+			{
+				++scanCursor;
+			}
+			bestTriangle = static_cast<uint32_t>(scanCursor);
+		}
+
+		const uint32_t* corners = &indices[bestTriangle * 3];
+		output.insert(output.end(), corners, corners + 3);
+		emitted[bestTriangle] = true;
+
+		uint32_t newCache[ScoringCacheSize + 3];
+		int newCacheCount = 0;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = corners[corner];
+			uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+			uint32_t* found = std::find(triangles, triangles + remainingValence[vertex], bestTriangle);
+			assert(found != triangles + remainingValence[vertex]);
+			std::swap(*found, triangles[--remainingValence[vertex]]);
+
+			if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			if (corners[0] != cache[i] && corners[1] != cache[i] && corners[2] != cache[i])
+			{
+				newCache[newCacheCount++] = cache[i];
+			}
+		}
+
+		//Rescore the cached vertices, including the ones just pushed out, and the triangles around them.
+		for (int i = 0; i < newCacheCount; ++i)
+		{
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < ScoringCacheSize ? i : -1;
+			vertexScores[vertex] = scoreTables.Score(cachePositions[vertex], remainingValence[vertex]);
+		}
+		bestTriangle = NoTriangle;
+		bestScore = -1.f;
+		for (int i = 0; i < newCacheCount; ++i)
+		{
+			uint32_t vertex = newCache[i];
+			const uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t j = 0; j < remainingValence[vertex]; ++j)
+			{
+				uint32_t triangle = triangles[j];
+				const uint32_t* triangleCorners = &indices[triangle * 3];
+				float score = vertexScores[triangleCorners[0]] + vertexScores[triangleCorners[1]] + vertexScores[triangleCorners[2]];
+				triangleScores[triangle] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = triangle;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCacheCount, ScoringCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const XMFLOAT3* positions, size_t positionStride, size_t vertexCount)
+{
+	assert(indices.size() % 3 == 0);
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//Hard boundaries, where a triangle misses on every vertex so the cache starts over regardless.
+	std::vector<uint32_t> hardStarts;
+	std::vector<uint32_t> triangleMisses(triangleCount);
+	{
+		CacheSimulator cache(vertexCount, CacheSize);
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			const uint32_t* corners = &indices[triangle * 3];
+			triangleMisses[triangle] = cache.Access(corners[0]) + cache.Access(corners[1]) + cache.Access(corners[2]);
+			if (triangle == 0 || triangleMisses[triangle] == 3)
+			{
+				hardStarts.push_back(triangle);
+			}
+		}
+	}
+	hardStarts.push_back(triangleCount);
+
+	//Soft boundaries inside each hard cluster, wherever flushing the cache there keeps its ACMR within the threshold.
+	std::vector<uint32_t> clusterStarts;
+	CacheSimulator cache(vertexCount, CacheSize);
+	for (size_t hard = 0; hard + 1 < hardStarts.size(); ++hard)
+	{
+		uint32_t start = hardStarts[hard];
+		uint32_t end = hardStarts[hard + 1];
+		uint32_t hardMisses = 0;
+		for (uint32_t triangle = start; triangle < end; ++triangle)
+		{
+			hardMisses += triangleMisses[triangle];
+		}
+		float threshold = OverdrawThreshold * hardMisses / (end - start);
+
+		clusterStarts.push_back(start);
+		cache.Flush();
+		uint32_t clusterStart = start;
+		uint32_t clusterMisses = 0;
+		for (uint32_t triangle = start; triangle < end; ++triangle)
+		{
+			const uint32_t* corners = &indices[triangle * 3];
+			clusterMisses += cache.Access(corners[0]) + cache.Access(corners[1]) + cache.Access(corners[2]);
+			if (triangle + 1 < end && clusterMisses <= threshold * (triangle + 1 - clusterStart))
+			{
+				clusterStarts.push_back(triangle + 1);
+				clusterStart = triangle + 1;
+				clusterMisses = 0;
+				cache.Flush();
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+	size_t clusterCount = clusterStarts.size() - 1;
+
+	//Area weighted centroids and normals. Front faces are clockwise, so cross(b - a, c - a) points out.
+	std::vector<XMFLOAT3> clusterCentroids(clusterCount);
+	std::vector<XMFLOAT3> clusterNormals(clusterCount);
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.f;
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.f;
+		for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+		{
+			XMVECTOR a = XMLoadFloat3(&GetPosition(positions, positionStride, indices[triangle * 3]));
+			XMVECTOR b = XMLoadFloat3(&GetPosition(positions, positionStride, indices[triangle * 3 + 1]));
+			XMVECTOR c = XMLoadFloat3(&GetPosition(positions, positionStride, indices[triangle * 3 + 2]));
+			XMVECTOR cross = XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a));
+			float triangleArea = XMVectorGetX(XMVector3Length(cross));
+			centroid = XMVectorAdd(centroid, XMVectorScale(XMVectorAdd(XMVectorAdd(a, b), c), triangleArea / 3.f));
+			normal = XMVectorAdd(normal, cross);
+			area += triangleArea;
+		}
+		meshCentroid = XMVectorAdd(meshCentroid, centroid);
+		meshArea += area;
+		XMStoreFloat3(&clusterCentroids[cluster], area > 0.f ? XMVectorScale(centroid, 1.f / area) : centroid);
+		XMStoreFloat3(&clusterNormals[cluster], XMVector3Normalize(normal));
+	}
+	meshCentroid = meshArea > 0.f ? XMVectorScale(meshCentroid, 1.f / meshArea) : meshCentroid;
+
+	//Clusters facing away from the center, and far from it, are likely to occlude the rest.
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&clusterCentroids[cluster]), meshCentroid);
+		float key = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&clusterNormals[cluster])));
+		sortKeys[cluster] = std::isfinite(key) ? key : 0.f;
+		clusterOrder[cluster] = static_cast<uint32_t>(cluster);
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (uint32_t cluster : clusterOrder)
+	{
+		output.insert(output.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+	}
+	indices.swap(output);
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	std::vector<uint32_t> newIndices(vertexCount, UINT32_MAX);
+	std::vector<uint32_t> vertexOrder;
+	vertexOrder.reserve(vertexCount);
+	for (uint32_t& index : indices)
+	{
+		if (newIndices[index] == UINT32_MAX)
+		{
+			newIndices[index] = static_cast<uint32_t>(vertexOrder.size());
+			vertexOrder.push_back(index);
+		}
+		index = newIndices[index];
+	}
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		if (newIndices[vertex] == UINT32_MAX)
+		{
+			vertexOrder.push_back(static_cast<uint32_t>(vertex));
+		}
+	}
+	return vertexOrder;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize)
+{
+	VertexCacheStats stats;
+	stats.triangleCount = indices.size() / 3;
+	std::vector<bool> referenced(vertexCount, false);
+	CacheSimulator cache(vertexCount, cacheSize);
+	for (uint32_t index : indices)
+	{
+		stats.transformCount += cache.Access(index) ? 1 : 0;
+		if (referenced[index] == false)
+		{
+			referenced[index] = true;
+			++stats.vertexCount;
+		}
+	}
+	return stats;
+}
+
+void MeshOptimizer::Report(const std::string& assetName, const VertexCacheStats& before, const VertexCacheStats& after)
+{
+	char text[512];
+	snprintf(text, sizeof(text), "***Optimized %s: %zu triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", assetName.c_str(),
+		after.triangleCount, before.GetACMR(), after.GetACMR(), before.GetATVR(), after.GetATVR());
+	OutputDebugStringA(text);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+/**
+ * @brief Vertex shader invocations of an index order, from a FIFO post-transform cache simulation.
+ */
+struct VertexCacheStats
+{
+	size_t triangleCount = 0;
+	size_t vertexCount = 0;
+	size_t transformCount = 0;
+
+	//Average cache miss ratio, transforms per triangle. 0.5 is the lower bound of a closed mesh.
+	float GetACMR() const { return triangleCount == 0 ? 0.f : static_cast<float>(transformCount) / triangleCount; }
+	//Average transform to vertex ratio. 1 is the lower bound.
+	float GetATVR() const { return vertexCount == 0 ? 0.f : static_cast<float>(transformCount) / vertexCount; }
+
+	void Add(const VertexCacheStats& other)
+	{
+		triangleCount += other.triangleCount;
+		vertexCount += other.vertexCount;
+		transformCount += other.transformCount;
+	}
+};
+
+/**
+ * @brief Import time reordering of triangle lists for fewer vertex shader invocations, less overdraw and linear vertex fetch.
+ * @detail Optimize runs the stages in order: Forsyth's vertex cache optimization, then clusters of that order are sorted
+ * front to back as seen from outside the mesh (Sander et al.), then the vertices are renumbered in first use order.
+ */
+class MeshOptimizer
+{
+public:
+	//Cache size of the simulator. Small enough to hold on any GPU.
+	static constexpr int CacheSize = 16;
+	//How much ACMR the overdraw ordering may give up.
+	static constexpr float OverdrawThreshold = 1.05f;
+
+	/**
+	 * @brief All stages on one mesh. Returns the simulated cost before and after.
+	 */
+	template<typename VertexType>
+	static void Optimize(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, VertexCacheStats& before, VertexCacheStats& after)
+	{
+		before = AnalyzeVertexCache(indices, vertices.size());
+		if (indices.empty() == false)
+		{
+			OptimizeVertexCache(indices, vertices.size());
+			OptimizeOverdraw(indices, &vertices[0].position, sizeof(VertexType), vertices.size());
+			std::vector<uint32_t> vertexOrder = OptimizeVertexFetch(indices, vertices.size());
+			std::vector<VertexType> reordered;
+			reordered.reserve(vertices.size());
+			for (uint32_t vertex : vertexOrder)
+			{
+				reordered.push_back(vertices[vertex]);
+			}
+			vertices.swap(reordered);
+		}
+		after = AnalyzeVertexCache(indices, vertices.size());
+	}
+
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+	/**
+	 * @brief Reorder clusters of an already cache optimized list so faces likely to occlude others come first.
+	 * @detail The list is cut where the cache restarts anyway, and further where it costs less than OverdrawThreshold in ACMR.
+	 */
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices, const XMFLOAT3* positions, size_t positionStride, size_t vertexCount);
+	/**
+	 * @brief Renumber the vertices in the order the indices first use them. Returns the old index of each new vertex.
+	 * @detail Unreferenced vertices are kept, after the used ones.
+	 */
+	static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = CacheSize);
+	/**
+	 * @brief Write the before and after cost of an optimized asset to the debugger output.
+	 */
+	static void Report(const std::string& assetName, const VertexCacheStats& before, const VertexCacheStats& after);
+};
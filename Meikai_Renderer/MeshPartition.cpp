@@ -0,0 +1,65 @@
+#include "MeshPartition.h"
+#include <cassert>
+
+MeshPartition MeshPartition::Build(const std::vector<uint32_t>& sourceIndices, size_t sourceVertexCount)
+{
+	assert(sourceIndices.size() % 3 == 0);
+
+	MeshPartition partition;
+	partition.indices.reserve(sourceIndices.size());
+	if (sourceVertexCount <= MaxPartVertices)
+	{
+		for (uint32_t index : sourceIndices)
+		{
+			partition.indices.push_back(static_cast<uint16_t>(index));
+		}
+		partition.parts.push_back({ 0, static_cast<uint32_t>(sourceIndices.size()), 0 });
+		partition.vertexCount = sourceVertexCount;
+		return partition;
+	}
+
+	//Part that last used each source vertex, and the vertex's index within that part.
+	std::vector<uint32_t> vertexPart(sourceVertexCount, UINT32_MAX);
+	std::vector<uint16_t> localIndex(sourceVertexCount, 0);
+	uint32_t part = 0;
+	uint32_t partStart = 0;
+	uint32_t partBaseVertex = 0;
+	partition.mVertexOrder.reserve(sourceVertexCount + sourceVertexCount / 8);
+
+	for (size_t triangle = 0; triangle < sourceIndices.size(); triangle += 3)
+	{
+		const uint32_t* corners = &sourceIndices[triangle];
+		uint32_t newVertexCount = 0;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			assert(corners[corner] < sourceVertexCount);
+			bool repeated = (corner > 0 && corners[corner] == corners[0]) || (corner > 1 && corners[corner] == corners[1]);
+			newVertexCount += (vertexPart[corners[corner]] != part && repeated == false) ? 1 : 0;
+		}
+
+		uint32_t partVertexCount = static_cast<uint32_t>(partition.mVertexOrder.size()) - partBaseVertex;
+		if (partVertexCount + newVertexCount > MaxPartVertices)
+		{
+			uint32_t triangleStart = static_cast<uint32_t>(partition.indices.size());
+			partition.parts.push_back({ partStart, triangleStart - partStart, static_cast<int32_t>(partBaseVertex) });
+			++part;
+			partStart = triangleStart;
+			partBaseVertex = static_cast<uint32_t>(partition.mVertexOrder.size());
+		}
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = corners[corner];
+			if (vertexPart[vertex] != part)
+			{
+				vertexPart[vertex] = part;
+				localIndex[vertex] = static_cast<uint16_t>(partition.mVertexOrder.size() - partBaseVertex);
+				partition.mVertexOrder.push_back(vertex);
+			}
+			partition.indices.push_back(localIndex[vertex]);
+		}
+	}
+	partition.parts.push_back({ partStart, static_cast<uint32_t>(partition.indices.size()) - partStart, static_cast<int32_t>(partBaseVertex) });
+	partition.vertexCount = partition.mVertexOrder.size();
+	return partition;
+}
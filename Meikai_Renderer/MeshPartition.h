@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Range of a mesh's index buffer drawn with one DrawIndexed.
+ */
+struct MeshPart
+{
+	uint32_t startIndex;
+	uint32_t indexCount;
+	int32_t baseVertex;
+};
+
+/**
+ * @brief Triangle list split into parts small enough for 16-bit indices relative to each part's base vertex.
+ * @detail A mesh that fits is a single part and keeps its vertices as they are. Larger meshes are cut in triangle order,
+ * each part gets its own copy of the vertices it uses, so vertices on the cuts are duplicated.
+ */
+struct MeshPartition
+{
+	//0xFFFF stays unused, as it is the strip cut value.
+	static constexpr uint32_t MaxPartVertices = 65535;
+
+	std::vector<MeshPart> parts;
+	std::vector<uint16_t> indices;
+	size_t vertexCount = 0;
+
+	/**
+	 * @brief Index into the source vertices of the partition's vertex.
+	 */
+	uint32_t GetSourceVertex(size_t vertex) const { return mVertexOrder.empty() ? static_cast<uint32_t>(vertex) : mVertexOrder[vertex]; }
+
+	static MeshPartition Build(const std::vector<uint32_t>& sourceIndices, size_t sourceVertexCount);
+
+private:
+	//Empty when the mesh is a single part.
+	std::vector<uint32_t> mVertexOrder;
+};
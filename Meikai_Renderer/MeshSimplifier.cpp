@@ -0,0 +1,775 @@
+#include "MeshSimplifier.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	//Weights of the constraint planes through open borders and attribute seams, against those of the faces.
+	constexpr double BorderWeight = 10.0;
+	constexpr double SeamWeight = 1.0;
+	//Cost of the attribute difference across a collapsed edge, scaled by the edge's squared length so it compares to distances.
+	constexpr float NormalWeight = 1.f;
+	constexpr float UVWeight = 1.f;
+	//A pass takes collapses up to this multiple of the cost of the one that would just reach the target.
+	//Cheaper collapses blocked by this pass's neighbours get their turn in the next one, before the expensive ones.
+	constexpr float PassCostSlack = 1.5f;
+	//A collapse may not turn a triangle further than about 75 degrees.
+	constexpr float MinNormalDot = 0.25f;
+
+	enum class VertexKind : uint8_t
+	{
+		Manifold,
+		//On an open border. Collapses along it only.
+		Border,
+		//Two vertices on a closed surface whose attributes differ. Collapses along the seam only, both vertices at once.
+		Seam,
+		//Corners of borders and seams, and anything non-manifold.
+		Locked
+	};
+
+	/**
+	 * @brief Sum of weighted squared distances to planes, as a symmetric matrix.
+	 */
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double weight = 0;
+
+		//n has to be normalized.
+		void AddPlane(const XMFLOAT3& n, const XMFLOAT3& point, double planeWeight)
+		{
+			double d = -(static_cast<double>(n.x) * point.x + static_cast<double>(n.y) * point.y + static_cast<double>(n.z) * point.z);
+			a00 += planeWeight * n.x * n.x;
+			a01 += planeWeight * n.x * n.y;
+			a02 += planeWeight * n.x * n.z;
+			a11 += planeWeight * n.y * n.y;
+			a12 += planeWeight * n.y * n.z;
+			a22 += planeWeight * n.z * n.z;
+			b0 += planeWeight * n.x * d;
+			b1 += planeWeight * n.y * d;
+			b2 += planeWeight * n.z * d;
+			c += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		//Weighted mean of the squared distances of point to the planes.
+		double Evaluate(const XMFLOAT3& point) const
+		{
+			if (weight <= 0.0)
+			{
+				return 0.0;
+			}
+			double x = point.x;
+			double y = point.y;
+			double z = point.z;
+			double r = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::max(r, 0.0) / weight;
+		}
+	};
+
+	struct Collapse
+	{
+		//Vertices moved and where to, the seam pair is UINT32_MAX off seams.
+		uint32_t from;
+		uint32_t to;
+		uint32_t seamFrom;
+		uint32_t seamTo;
+		//Triangles it removes.
+		uint32_t removed;
+		float cost;
+		//Squared geometric part of the cost.
+		float error;
+	};
+
+	XMVECTOR Cross(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+	{
+		XMVECTOR origin = XMLoadFloat3(&a);
+		return XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&b), origin), XMVectorSubtract(XMLoadFloat3(&c), origin));
+	}
+
+	/**
+	 * @brief Collapse state of one mesh, so a LOD chain continues from the previous LOD with the quadrics of the source.
+	 * @detail Works in passes. Each pass ranks every edge by its cheaper allowed direction and applies the cheapest
+	 * collapses whose neighbourhoods do not overlap, then rewrites the index list.
+	 */
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::vector<SimplifierVertex>& vertices, const std::vector<uint32_t>& indices);
+
+		/**
+		 * @brief Collapse until targetTriangleCount, or until the collapses left exceed maxError relative to the extent.
+		 */
+		void Run(size_t targetTriangleCount, float maxError);
+
+		const std::vector<uint32_t>& GetIndices() const { return mIndices; }
+		size_t GetTriangleCount() const { return mIndices.size() / 3; }
+		//In object space units.
+		float GetError() const { return sqrtf(mMaxError) * mExtent; }
+		float GetExtent() const { return mExtent; }
+
+	private:
+		void BuildRemap();
+		//Also adds the constraint planes of the open edges it finds.
+		void Classify();
+		void BuildQuadrics();
+		void BuildTriangleAdjacency();
+		void PickCollapses();
+		bool EvaluateDirection(uint32_t from, uint32_t to, const uint32_t* fromWedges, const uint32_t* toWedges, uint32_t shared, Collapse& collapse) const;
+		//Whether collapsing from onto to keeps the surface manifold and no triangle turns over.
+		bool IsCollapseValid(uint32_t from, uint32_t to, uint32_t shared);
+		void Apply(const Collapse& collapse);
+		//Apply the collapses of the sorted keys in order that are still valid. Returns how many were applied.
+		size_t ApplyCollapses(const uint64_t* begin, const uint64_t* end, size_t targetTriangleCount, float maxErrorSq, size_t& triangleCount);
+		void RewriteIndices();
+
+		const uint32_t* GetTriangles(uint32_t vertex, uint32_t& count) const
+		{
+			count = mTriangleStarts[vertex + 1] - mTriangleStarts[vertex];
+			return mTriangleList.data() + mTriangleStarts[vertex];
+		}
+		//Position at a corner, with the collapses of the current pass applied.
+		uint32_t GetCorner(uint32_t triangle, int corner) const
+		{
+			return mRemap[mCollapseTarget[mIndices[triangle * 3 + corner]]];
+		}
+		bool IsDegenerate(size_t triangle) const
+		{
+			uint32_t a = mRemap[mIndices[triangle * 3]];
+			uint32_t b = mRemap[mIndices[triangle * 3 + 1]];
+			uint32_t c = mRemap[mIndices[triangle * 3 + 2]];
+			return a == b || b == c || c == a;
+		}
+
+	private:
+		const std::vector<SimplifierVertex>& mVertices;
+		std::vector<uint32_t> mIndices;
+		//Positions moved into the unit cube, so the error and weights do not depend on the size of the mesh.
+		std::vector<XMFLOAT3> mPositions;
+		float mExtent = 1.f;
+
+		//First vertex at the same position, which holds the position's quadric and kind. The others are its wedges.
+		std::vector<uint32_t> mRemap;
+		//Next vertex at the same position, in a cycle.
+		std::vector<uint32_t> mWedge;
+		std::vector<VertexKind> mKinds;
+		std::vector<Quadric> mQuadrics;
+		//Where each vertex went, applied to the indices after every pass.
+		std::vector<uint32_t> mCollapseTarget;
+		float mMaxError = 0.f;
+
+		//Per pass. Triangles around each position, the ends of the collapses so far, and marks to intersect neighbourhoods.
+		std::vector<uint32_t> mTriangleStarts;
+		std::vector<uint32_t> mTriangleList;
+		std::vector<uint8_t> mLocked;
+		std::vector<uint32_t> mMarks;
+		uint32_t mMark = 0;
+		std::vector<Collapse> mCollapses;
+	};
+
+	Simplifier::Simplifier(const std::vector<SimplifierVertex>& vertices, const std::vector<uint32_t>& indices)
+		:mVertices(vertices), mIndices(indices)
+	{
+		assert(indices.size() % 3 == 0);
+		size_t vertexCount = vertices.size();
+		mPositions.resize(vertexCount);
+		if (vertexCount > 0)
+		{
+			XMVECTOR boundsMin = XMLoadFloat3(&vertices[0].position);
+			XMVECTOR boundsMax = boundsMin;
+			for (const SimplifierVertex& vertex : vertices)
+			{
+				boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&vertex.position));
+				boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&vertex.position));
+			}
+			XMFLOAT3 size;
+			XMStoreFloat3(&size, XMVectorSubtract(boundsMax, boundsMin));
+			mExtent = std::max(std::max(size.x, size.y), std::max(size.z, 1e-12f));
+			XMVECTOR scale = XMVectorReplicate(1.f / mExtent);
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				XMStoreFloat3(&mPositions[i], XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&vertices[i].position), boundsMin), scale));
+			}
+		}
+
+		mCollapseTarget.resize(vertexCount);
+		std::iota(mCollapseTarget.begin(), mCollapseTarget.end(), 0);
+		mLocked.resize(vertexCount);
+		mMarks.resize(vertexCount, 0);
+		mQuadrics.resize(vertexCount);
+
+		BuildRemap();
+		//Degenerate input triangles have no plane and would confuse the classification.
+		RewriteIndices();
+		Classify();
+		BuildQuadrics();
+	}
+
+	void Simplifier::BuildRemap()
+	{
+		size_t vertexCount = mPositions.size();
+		std::vector<uint32_t> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0);
+		auto less = [this](uint32_t a, uint32_t b)
+			{
+				const XMFLOAT3& pa = mPositions[a];
+				const XMFLOAT3& pb = mPositions[b];
+				return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : (pa.z != pb.z ? pa.z < pb.z : a < b));
+			};
+		std::sort(order.begin(), order.end(), less);
+
+		mRemap.resize(vertexCount);
+		mWedge.resize(vertexCount);
+		for (size_t start = 0; start < vertexCount;)
+		{
+			size_t end = start + 1;
+			const XMFLOAT3& position = mPositions[order[start]];
+			while (end < vertexCount && mPositions[order[end]].x == position.x && mPositions[order[end]].y == position.y &&
+				mPositions[order[end]].z == position.z)
+			{
+				++end;
+			}
+			for (size_t i = start; i < end; ++i)
+			{
+				mRemap[order[i]] = order[start];
+				mWedge[order[i]] = order[i + 1 < end ? i + 1 : start];
+			}
+			start = end;
+		}
+	}
+
+	void Simplifier::Classify()
+	{
+		size_t vertexCount = mPositions.size();
+		//Directed edges leaving each vertex.
+		std::vector<uint32_t> edgeStarts(vertexCount + 1, 0);
+		for (size_t i = 0; i < mIndices.size(); ++i)
+		{
+			++edgeStarts[mIndices[i] + 1];
+		}
+		std::partial_sum(edgeStarts.begin(), edgeStarts.end(), edgeStarts.begin());
+		std::vector<uint32_t> edgeTargets(mIndices.size());
+		std::vector<uint32_t> cursors(edgeStarts.begin(), edgeStarts.end() - 1);
+		for (size_t triangle = 0; triangle < mIndices.size(); triangle += 3)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t from = mIndices[triangle + corner];
+				edgeTargets[cursors[from]++] = mIndices[triangle + (corner + 1) % 3];
+			}
+		}
+		auto hasEdge = [&](uint32_t from, uint32_t to)
+			{
+				return std::find(edgeTargets.begin() + edgeStarts[from], edgeTargets.begin() + edgeStarts[from + 1], to) !=
+					edgeTargets.begin() + edgeStarts[from + 1];
+			};
+		auto hasPositionEdge = [&](uint32_t from, uint32_t to)
+			{
+				uint32_t target = mRemap[to];
+				uint32_t wedge = from;
+				do
+				{
+					for (uint32_t edge = edgeStarts[wedge]; edge < edgeStarts[wedge + 1]; ++edge)
+					{
+						if (mRemap[edgeTargets[edge]] == target)
+						{
+							return true;
+						}
+					}
+					wedge = mWedge[wedge];
+				} while (wedge != from);
+				return false;
+			};
+
+		//Open edges leaving and entering each position and each vertex.
+		std::vector<uint32_t> openOut(vertexCount, 0);
+		std::vector<uint32_t> openIn(vertexCount, 0);
+		std::vector<uint32_t> wedgeOpenOut(vertexCount, 0);
+		std::vector<uint32_t> wedgeOpenIn(vertexCount, 0);
+		for (uint32_t from = 0; from < vertexCount; ++from)
+		{
+			for (uint32_t edge = edgeStarts[from]; edge < edgeStarts[from + 1]; ++edge)
+			{
+				uint32_t to = edgeTargets[edge];
+				if (hasPositionEdge(to, from) == false)
+				{
+					++openOut[mRemap[from]];
+					++openIn[mRemap[to]];
+				}
+				else if (hasEdge(to, from) == false)
+				{
+					++wedgeOpenOut[from];
+					++wedgeOpenIn[to];
+				}
+			}
+		}
+
+		mKinds.assign(vertexCount, VertexKind::Locked);
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			if (mRemap[vertex] != vertex)
+			{
+				continue;
+			}
+
+			VertexKind kind = VertexKind::Locked;
+			uint32_t other = mWedge[vertex];
+			if (other == vertex)
+			{
+				if (openOut[vertex] == 0 && openIn[vertex] == 0)
+				{
+					kind = VertexKind::Manifold;
+				}
+				else if (openOut[vertex] == 1 && openIn[vertex] == 1)
+				{
+					kind = VertexKind::Border;
+				}
+			}
+			else if (mWedge[other] == vertex && openOut[vertex] == 0 && openIn[vertex] == 0 &&
+				wedgeOpenOut[vertex] == 1 && wedgeOpenIn[vertex] == 1 && wedgeOpenOut[other] == 1 && wedgeOpenIn[other] == 1)
+			{
+				kind = VertexKind::Seam;
+			}
+
+			uint32_t wedge = vertex;
+			do
+			{
+				mKinds[wedge] = kind;
+				wedge = mWedge[wedge];
+			} while (wedge != vertex);
+		}
+
+		//Edges open at the position or vertex level get constraint planes.
+		for (size_t triangle = 0; triangle < mIndices.size(); triangle += 3)
+		{
+			XMFLOAT3 faceNormal;
+			XMStoreFloat3(&faceNormal, XMVector3Normalize(Cross(mPositions[mIndices[triangle]], mPositions[mIndices[triangle + 1]], mPositions[mIndices[triangle + 2]])));
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t from = mIndices[triangle + corner];
+				uint32_t to = mIndices[triangle + (corner + 1) % 3];
+				double weight = hasPositionEdge(to, from) == false ? BorderWeight : (hasEdge(to, from) == false ? SeamWeight : 0.0);
+				if (weight == 0.0)
+				{
+					continue;
+				}
+
+				XMVECTOR edge = XMVectorSubtract(XMLoadFloat3(&mPositions[to]), XMLoadFloat3(&mPositions[from]));
+				XMFLOAT3 normal;
+				XMStoreFloat3(&normal, XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&faceNormal), edge)));
+				Quadric constraint;
+				constraint.AddPlane(normal, mPositions[from], weight * XMVectorGetX(XMVector3LengthSq(edge)));
+				mQuadrics[mRemap[from]].Add(constraint);
+				mQuadrics[mRemap[to]].Add(constraint);
+			}
+		}
+	}
+
+	void Simplifier::BuildQuadrics()
+	{
+		for (size_t triangle = 0; triangle < mIndices.size(); triangle += 3)
+		{
+			const XMFLOAT3& a = mPositions[mIndices[triangle]];
+			XMVECTOR normal = Cross(a, mPositions[mIndices[triangle + 1]], mPositions[mIndices[triangle + 2]]);
+			float doubleArea = XMVectorGetX(XMVector3Length(normal));
+			if (doubleArea <= 0.f)
+			{
+				continue;
+			}
+
+			XMFLOAT3 unitNormal;
+			XMStoreFloat3(&unitNormal, XMVectorScale(normal, 1.f / doubleArea));
+			Quadric plane;
+			plane.AddPlane(unitNormal, a, 0.5 * doubleArea);
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				mQuadrics[mRemap[mIndices[triangle + corner]]].Add(plane);
+			}
+		}
+	}
+
+	void Simplifier::BuildTriangleAdjacency()
+	{
+		size_t vertexCount = mPositions.size();
+		mTriangleStarts.assign(vertexCount + 1, 0);
+		for (uint32_t index : mIndices)
+		{
+			++mTriangleStarts[mRemap[index] + 1];
+		}
+		std::partial_sum(mTriangleStarts.begin(), mTriangleStarts.end(), mTriangleStarts.begin());
+		mTriangleList.resize(mIndices.size());
+		std::vector<uint32_t> cursors(mTriangleStarts.begin(), mTriangleStarts.end() - 1);
+		for (size_t i = 0; i < mIndices.size(); ++i)
+		{
+			mTriangleList[cursors[mRemap[mIndices[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	bool Simplifier::EvaluateDirection(uint32_t from, uint32_t to, const uint32_t* fromWedges, const uint32_t* toWedges, uint32_t shared,
+		Collapse& collapse) const
+	{
+		collapse = { fromWedges[0], toWedges[0], UINT32_MAX, UINT32_MAX, shared, 0.f, 0.f };
+		switch (mKinds[from])
+		{
+		case VertexKind::Manifold:
+			//Off the seams of to, the triangles on both sides of the edge use the same vertex of it.
+			if (shared != 2 || toWedges[0] != toWedges[1])
+			{
+				return false;
+			}
+			break;
+		case VertexKind::Border:
+			if (mKinds[to] != VertexKind::Border || shared != 1)
+			{
+				return false;
+			}
+			break;
+		case VertexKind::Seam:
+			if (mKinds[to] != VertexKind::Seam || shared != 2 || fromWedges[0] == fromWedges[1] || toWedges[0] == toWedges[1])
+			{
+				return false;
+			}
+			collapse.seamFrom = fromWedges[1];
+			collapse.seamTo = toWedges[1];
+			break;
+		default:
+			return false;
+		}
+
+		float edgeLengthSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&mPositions[to]), XMLoadFloat3(&mPositions[from]))));
+		auto attributeCost = [&](uint32_t a, uint32_t b)
+			{
+				const SimplifierVertex& va = mVertices[a];
+				const SimplifierVertex& vb = mVertices[b];
+				float normalDifference = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&va.normal), XMLoadFloat3(&vb.normal))));
+				float uvDifference = XMVectorGetX(XMVector2LengthSq(XMVectorSubtract(XMLoadFloat2(&va.UV), XMLoadFloat2(&vb.UV))));
+				return edgeLengthSq * (NormalWeight * normalDifference + UVWeight * uvDifference);
+			};
+		collapse.error = static_cast<float>(mQuadrics[from].Evaluate(mPositions[to]));
+		collapse.cost = collapse.error + attributeCost(collapse.from, collapse.to);
+		if (collapse.seamFrom != UINT32_MAX)
+		{
+			collapse.cost += attributeCost(collapse.seamFrom, collapse.seamTo);
+		}
+		return true;
+	}
+
+	void Simplifier::PickCollapses()
+	{
+		mCollapses.clear();
+		for (uint32_t vertex = 0; vertex < mPositions.size(); ++vertex)
+		{
+			if (mRemap[vertex] != vertex || mKinds[vertex] == VertexKind::Locked)
+			{
+				continue;
+			}
+
+			//Each edge once, from its smaller position or from whichever end is not locked.
+			++mMark;
+			uint32_t triangleCount;
+			const uint32_t* triangles = GetTriangles(vertex, triangleCount);
+			for (uint32_t i = 0; i < triangleCount; ++i)
+			{
+				const uint32_t* corners = &mIndices[triangles[i] * 3];
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					uint32_t other = mRemap[corners[corner]];
+					if (other == vertex || mMarks[other] == mMark || (other < vertex && mKinds[other] != VertexKind::Locked))
+					{
+						continue;
+					}
+					mMarks[other] = mMark;
+
+					//Vertices of both ends in the triangles on the edge. More than two triangles makes the edge non-manifold.
+					uint32_t vertexWedges[2];
+					uint32_t otherWedges[2];
+					uint32_t shared = 0;
+					for (uint32_t j = 0; j < triangleCount && shared <= 2; ++j)
+					{
+						const uint32_t* sharedCorners = &mIndices[triangles[j] * 3];
+						int otherCorner = mRemap[sharedCorners[0]] == other ? 0 : (mRemap[sharedCorners[1]] == other ? 1 : (mRemap[sharedCorners[2]] == other ? 2 : -1));
+						if (otherCorner < 0)
+						{
+							continue;
+						}
+						if (shared < 2)
+						{
+							int vertexCorner = mRemap[sharedCorners[0]] == vertex ? 0 : (mRemap[sharedCorners[1]] == vertex ? 1 : 2);
+							vertexWedges[shared] = sharedCorners[vertexCorner];
+							otherWedges[shared] = sharedCorners[otherCorner];
+						}
+						++shared;
+					}
+					if (shared > 2)
+					{
+						continue;
+					}
+					if (shared == 1)
+					{
+						vertexWedges[1] = vertexWedges[0];
+						otherWedges[1] = otherWedges[0];
+					}
+
+					Collapse forward;
+					Collapse backward;
+					bool canForward = EvaluateDirection(vertex, other, vertexWedges, otherWedges, shared, forward);
+					bool canBackward = EvaluateDirection(other, vertex, otherWedges, vertexWedges, shared, backward);
+					if (canForward || canBackward)
+					{
+						mCollapses.push_back(canForward && (canBackward == false || forward.cost <= backward.cost) ? forward : backward);
+					}
+				}
+			}
+		}
+	}
+
+	bool Simplifier::IsCollapseValid(uint32_t from, uint32_t to, uint32_t shared)
+	{
+		//Link condition: the ends may only share the neighbours across the triangles on the edge, or the collapse pinches the surface.
+		uint32_t fromCount;
+		uint32_t toCount;
+		const uint32_t* fromTriangles = GetTriangles(from, fromCount);
+		const uint32_t* toTriangles = GetTriangles(to, toCount);
+		mMark += 2;
+		for (uint32_t i = 0; i < toCount; ++i)
+		{
+			uint32_t corners[3] = { GetCorner(toTriangles[i], 0), GetCorner(toTriangles[i], 1), GetCorner(toTriangles[i], 2) };
+			if (corners[0] != corners[1] && corners[1] != corners[2] && corners[2] != corners[0])
+			{
+				mMarks[corners[0]] = mMarks[corners[1]] = mMarks[corners[2]] = mMark - 1;
+			}
+		}
+		uint32_t commonCount = 0;
+		for (uint32_t i = 0; i < fromCount; ++i)
+		{
+			uint32_t corners[3] = { GetCorner(fromTriangles[i], 0), GetCorner(fromTriangles[i], 1), GetCorner(fromTriangles[i], 2) };
+			if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+			{
+				continue;
+			}
+			for (uint32_t neighbour : corners)
+			{
+				if (neighbour != from && neighbour != to && mMarks[neighbour] == mMark - 1)
+				{
+					mMarks[neighbour] = mMark;
+					++commonCount;
+				}
+			}
+		}
+		if (commonCount != shared)
+		{
+			return false;
+		}
+
+		for (uint32_t i = 0; i < fromCount; ++i)
+		{
+			uint32_t corners[3] = { GetCorner(fromTriangles[i], 0), GetCorner(fromTriangles[i], 1), GetCorner(fromTriangles[i], 2) };
+			int fromCorner = corners[0] == from ? 0 : (corners[1] == from ? 1 : 2);
+			uint32_t b = corners[(fromCorner + 1) % 3];
+			uint32_t c = corners[(fromCorner + 2) % 3];
+			if (b == to || c == to || b == c)
+			{
+				continue;
+			}
+
+			XMVECTOR before = Cross(mPositions[from], mPositions[b], mPositions[c]);
+			XMVECTOR after = Cross(mPositions[to], mPositions[b], mPositions[c]);
+			float dot = XMVectorGetX(XMVector3Dot(before, after));
+			if (dot <= MinNormalDot * sqrtf(XMVectorGetX(XMVector3LengthSq(before)) * XMVectorGetX(XMVector3LengthSq(after))))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Simplifier::Apply(const Collapse& collapse)
+	{
+		uint32_t from = mRemap[collapse.from];
+		uint32_t to = mRemap[collapse.to];
+		mCollapseTarget[collapse.from] = collapse.to;
+		if (collapse.seamFrom != UINT32_MAX)
+		{
+			mCollapseTarget[collapse.seamFrom] = collapse.seamTo;
+		}
+		mQuadrics[to].Add(mQuadrics[from]);
+		mMaxError = std::max(mMaxError, collapse.error);
+		//Both ends would need their candidates evaluated again. Their neighbours are still exact, as the checks see the moved corners.
+		mLocked[from] = 1;
+		mLocked[to] = 1;
+	}
+
+	void Simplifier::RewriteIndices()
+	{
+		size_t write = 0;
+		for (size_t triangle = 0; triangle < mIndices.size() / 3; ++triangle)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				mIndices[triangle * 3 + corner] = mCollapseTarget[mIndices[triangle * 3 + corner]];
+			}
+			if (IsDegenerate(triangle) == false)
+			{
+				std::copy(mIndices.begin() + triangle * 3, mIndices.begin() + triangle * 3 + 3, mIndices.begin() + write * 3);
+				++write;
+			}
+		}
+		mIndices.resize(write * 3);
+	}
+
+	size_t Simplifier::ApplyCollapses(const uint64_t* begin, const uint64_t* end, size_t targetTriangleCount, float maxErrorSq, size_t& triangleCount)
+	{
+		size_t appliedCount = 0;
+		for (const uint64_t* key = begin; key != end && triangleCount > targetTriangleCount; ++key)
+		{
+			const Collapse& collapse = mCollapses[static_cast<uint32_t>(*key)];
+			uint32_t from = mRemap[collapse.from];
+			uint32_t to = mRemap[collapse.to];
+			if (mLocked[from] || mLocked[to] || collapse.error > maxErrorSq || IsCollapseValid(from, to, collapse.removed) == false)
+			{
+				continue;
+			}
+			Apply(collapse);
+			triangleCount -= collapse.removed;
+			++appliedCount;
+		}
+		return appliedCount;
+	}
+
+	void Simplifier::Run(size_t targetTriangleCount, float maxError)
+	{
+		float maxErrorSq = maxError * maxError;
+		std::vector<uint64_t> order;
+		while (GetTriangleCount() > targetTriangleCount)
+		{
+			BuildTriangleAdjacency();
+			PickCollapses();
+			if (mCollapses.empty())
+			{
+				return;
+			}
+
+			//Costs are never negative, so their bits order like their values, and the keys sort without an indirect compare.
+			order.resize(mCollapses.size());
+			for (size_t i = 0; i < mCollapses.size(); ++i)
+			{
+				uint32_t costBits;
+				memcpy(&costBits, &mCollapses[i].cost, sizeof(costBits));
+				order[i] = (static_cast<uint64_t>(costBits) << 32) | i;
+			}
+
+			//Most collapses remove two triangles. Only the collapses under the pass's cost limit need sorting.
+			size_t triangleCount = GetTriangleCount();
+			size_t goal = std::min((triangleCount - targetTriangleCount) / 2, order.size() - 1);
+			std::nth_element(order.begin(), order.begin() + goal, order.end());
+			float costLimit = mCollapses[static_cast<uint32_t>(order[goal])].cost * PassCostSlack;
+			uint32_t costLimitBits;
+			memcpy(&costLimitBits, &costLimit, sizeof(costLimitBits));
+			uint64_t limitKey = (static_cast<uint64_t>(costLimitBits) << 32) | UINT32_MAX;
+			auto limited = std::partition(order.begin(), order.end(), [limitKey](uint64_t key) { return key <= limitKey; });
+			std::sort(order.begin(), limited);
+
+			std::fill(mLocked.begin(), mLocked.end(), 0);
+			size_t appliedCount = ApplyCollapses(order.data(), order.data() + (limited - order.begin()), targetTriangleCount, maxErrorSq, triangleCount);
+			if (appliedCount == 0)
+			{
+				//Everything cheap turned something over, the rest may not.
+				std::sort(limited, order.end());
+				appliedCount = ApplyCollapses(order.data() + (limited - order.begin()), order.data() + order.size(), targetTriangleCount, maxErrorSq, triangleCount);
+			}
+			if (appliedCount == 0)
+			{
+				return;
+			}
+			RewriteIndices();
+		}
+	}
+}
+
+std::vector<MeshLod> MeshSimplifier::BuildLods(const std::vector<SimplifierVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	std::vector<MeshLod> lods;
+	if (indices.size() / 3 < MinLodTriangles * 2)
+	{
+		return lods;
+	}
+
+	Simplifier simplifier(vertices, indices);
+	size_t triangleCount = simplifier.GetTriangleCount();
+	for (int lod = 0; lod < MaxLodCount; ++lod)
+	{
+		size_t targetTriangleCount = static_cast<size_t>(triangleCount * LodTriangleRatio);
+		if (targetTriangleCount < MinLodTriangles)
+		{
+			break;
+		}
+		simplifier.Run(targetTriangleCount, MaxRelativeError);
+		if (simplifier.GetTriangleCount() > triangleCount * MinLodReduction)
+		{
+			break;
+		}
+		triangleCount = simplifier.GetTriangleCount();
+		lods.push_back({ simplifier.GetIndices(), simplifier.GetError() });
+	}
+	return lods;
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<SimplifierVertex>& vertices, const std::vector<uint32_t>& indices,
+	size_t targetIndexCount, float maxError, float& resultError)
+{
+	Simplifier simplifier(vertices, indices);
+	simplifier.Run(targetIndexCount / 3, maxError / simplifier.GetExtent());
+	resultError = simplifier.GetError();
+	return simplifier.GetIndices();
+}
+
+void LodChainStats::Add(size_t sourceTriangleCount, const std::vector<MeshLod>& lods)
+{
+	triangleCounts[0] += sourceTriangleCount;
+	for (size_t level = 1; level <= MeshSimplifier::MaxLodCount; ++level)
+	{
+		if (lods.empty())
+		{
+			triangleCounts[level] += sourceTriangleCount;
+			continue;
+		}
+		const MeshLod& lod = lods[std::min(level, lods.size()) - 1];
+		triangleCounts[level] += lod.indices.size() / 3;
+		errors[level] = std::max(errors[level], lod.error);
+	}
+}
+
+void MeshSimplifier::Report(const std::string& assetName, const LodChainStats& stats)
+{
+	char text[512];
+	int length = snprintf(text, sizeof(text), "***LODs of %s: %zu triangles", assetName.c_str(), stats.triangleCounts[0]);
+	for (int level = 1; level <= MaxLodCount && length > 0 && length < static_cast<int>(sizeof(text)); ++level)
+	{
+		length += snprintf(text + length, sizeof(text) - length, ", %zu (error %.4g)", stats.triangleCounts[level], stats.errors[level]);
+	}
+	OutputDebugStringA(text);
+	OutputDebugStringA("\n");
+}
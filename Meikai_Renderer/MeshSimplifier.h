@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+/**
+ * @brief Coarser index list over the vertices of the mesh it was simplified from.
+ */
+struct MeshLod
+{
+	std::vector<uint32_t> indices;
+	//Object space distance the surface of the LOD is estimated to be off the full detail one.
+	float error;
+};
+
+/**
+ * @brief Attributes the simplifier weighs, copied out of the vertex type.
+ */
+struct SimplifierVertex
+{
+	XMFLOAT3 position;
+	XMFLOAT3 normal;
+	XMFLOAT2 UV;
+};
+
+struct LodChainStats;
+
+/**
+ * @brief Import time LOD generation by quadric error edge collapse (Garland and Heckbert).
+ * @detail Vertices collapse onto one of their neighbours, so every LOD indexes the vertices of the source mesh and
+ * no new vertices are made. Open borders and attribute seams only collapse along themselves, and constraint planes
+ * through their edges keep them in place. Differences in normal and UV across the collapsed edge add to its cost.
+ */
+class MeshSimplifier
+{
+public:
+	//LODs built beyond the source mesh, at most.
+	static constexpr int MaxLodCount = 4;
+	//Each LOD aims for this fraction of the triangles of the one before.
+	static constexpr float LodTriangleRatio = 0.5f;
+	//The chain ends at a LOD that cannot get below this fraction of the one before, it would not be worth its memory.
+	static constexpr float MinLodReduction = 0.8f;
+	//Meshes this small are not worth a chain.
+	static constexpr size_t MinLodTriangles = 64;
+	//Largest error a LOD may have, relative to the largest extent of the mesh.
+	static constexpr float MaxRelativeError = 0.05f;
+
+	template<typename VertexType>
+	static std::vector<MeshLod> BuildLods(const std::vector<VertexType>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<SimplifierVertex> attributes(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			attributes[i] = { vertices[i].position, vertices[i].normal, vertices[i].UV };
+		}
+		return BuildLods(attributes, indices);
+	}
+
+	/**
+	 * @brief Simplify indices in one run, taking a LOD each time the triangle count halves, until MaxLodCount or MaxRelativeError.
+	 * @detail The quadrics keep accumulating over the run, so the error of every LOD is measured against the source.
+	 */
+	static std::vector<MeshLod> BuildLods(const std::vector<SimplifierVertex>& vertices, const std::vector<uint32_t>& indices);
+	/**
+	 * @brief Simplify indices to targetIndexCount or as far as it goes with an error below maxError, in object space units.
+	 * @param resultError Error of the result, in object space units.
+	 */
+	static std::vector<uint32_t> Simplify(const std::vector<SimplifierVertex>& vertices, const std::vector<uint32_t>& indices,
+		size_t targetIndexCount, float maxError, float& resultError);
+
+	/**
+	 * @brief Write the triangles and error of each level of an asset's chains to the debugger output.
+	 */
+	static void Report(const std::string& assetName, const LodChainStats& stats);
+};
+
+/**
+ * @brief Triangles and largest error of each level over the meshes of an asset, LOD 0 being the source.
+ * @detail A mesh with a shorter chain counts its last LOD at the levels past it, as that is what it draws there.
+ */
+struct LodChainStats
+{
+	size_t triangleCounts[MeshSimplifier::MaxLodCount + 1] = {};
+	float errors[MeshSimplifier::MaxLodCount + 1] = {};
+
+	void Add(size_t sourceTriangleCount, const std::vector<MeshLod>& lods);
+};
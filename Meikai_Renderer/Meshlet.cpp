@@ -0,0 +1,119 @@
+#include "Meshlet.h"
+#include "MeshPartition.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Cones wider than this are not worth testing, they reject next to nothing.
+	constexpr float MinConeDot = 0.1f;
+
+	void ComputeBounds(Meshlet& meshlet, const MeshPartition& partition, const XMFLOAT3* positions, size_t positionStride)
+	{
+		auto position = [&](uint32_t index)
+			{
+				uint32_t vertex = partition.GetSourceVertex(meshlet.baseVertex + partition.indices[index]);
+				return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + vertex * positionStride));
+			};
+		uint32_t endIndex = meshlet.startIndex + meshlet.triangleCount * 3;
+
+		XMVECTOR boundsMin = position(meshlet.startIndex);
+		XMVECTOR boundsMax = boundsMin;
+		XMVECTOR normalSum = XMVectorZero();
+		for (uint32_t index = meshlet.startIndex; index < endIndex; index += 3)
+		{
+			XMVECTOR a = position(index);
+			XMVECTOR b = position(index + 1);
+			XMVECTOR c = position(index + 2);
+			boundsMin = XMVectorMin(boundsMin, XMVectorMin(a, XMVectorMin(b, c)));
+			boundsMax = XMVectorMax(boundsMax, XMVectorMax(a, XMVectorMax(b, c)));
+			//Front faces are clockwise, so this points out of the surface.
+			XMVECTOR normal = XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a));
+			if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.f)
+			{
+				normalSum = XMVectorAdd(normalSum, XMVector3Normalize(normal));
+			}
+		}
+
+		XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+		float radiusSq = 0.f;
+		for (uint32_t index = meshlet.startIndex; index < endIndex; ++index)
+		{
+			radiusSq = std::max(radiusSq, XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(position(index), center))));
+		}
+		XMStoreFloat3(&meshlet.center, center);
+		meshlet.radius = sqrtf(radiusSq);
+
+		meshlet.coneAxis = XMFLOAT3(0.f, 0.f, 0.f);
+		meshlet.coneCutoff = 2.f;
+		if (XMVectorGetX(XMVector3LengthSq(normalSum)) <= 0.f)
+		{
+			return;
+		}
+		XMVECTOR axis = XMVector3Normalize(normalSum);
+		float minDot = 1.f;
+		for (uint32_t index = meshlet.startIndex; index < endIndex; index += 3)
+		{
+			XMVECTOR a = position(index);
+			XMVECTOR normal = XMVector3Cross(XMVectorSubtract(position(index + 1), a), XMVectorSubtract(position(index + 2), a));
+			if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.f)
+			{
+				minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, XMVector3Normalize(normal))));
+			}
+		}
+		if (minDot >= MinConeDot)
+		{
+			//Sine of the cone's half angle, the view direction has to be that far past perpendicular to every normal.
+			XMStoreFloat3(&meshlet.coneAxis, axis);
+			meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+		}
+	}
+}
+
+std::vector<Meshlet> Meshlet::Build(const MeshPartition& partition, const XMFLOAT3* positions, size_t positionStride)
+{
+	std::vector<Meshlet> meshlets;
+	meshlets.reserve(partition.indices.size() / (MaxTriangles * 3 / 2) + partition.parts.size());
+
+	//Meshlet that last used each partition vertex.
+	std::vector<uint32_t> vertexMeshlet(partition.vertexCount, UINT32_MAX);
+	for (const MeshPart& part : partition.parts)
+	{
+		uint32_t endIndex = part.startIndex + part.indexCount;
+		Meshlet meshlet = { part.startIndex, 0, part.baseVertex };
+		uint32_t vertexCount = 0;
+		for (uint32_t index = part.startIndex; index < endIndex; index += 3)
+		{
+			uint32_t corners[3];
+			uint32_t newVertexCount = 0;
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				corners[corner] = part.baseVertex + partition.indices[index + corner];
+				bool repeated = (corner > 0 && corners[corner] == corners[0]) || (corner > 1 && corners[corner] == corners[1]);
+				newVertexCount += (vertexMeshlet[corners[corner]] != meshlets.size() && repeated == false) ? 1 : 0;
+			}
+
+			if (meshlet.triangleCount == MaxTriangles || vertexCount + newVertexCount > MaxVertices)
+			{
+				ComputeBounds(meshlet, partition, positions, positionStride);
+				meshlets.push_back(meshlet);
+				meshlet = { index, 0, part.baseVertex };
+				vertexCount = 0;
+				newVertexCount = (corners[1] != corners[0]) + (corners[2] != corners[0] && corners[2] != corners[1]) + 1;
+			}
+
+			for (uint32_t vertex : corners)
+			{
+				vertexMeshlet[vertex] = static_cast<uint32_t>(meshlets.size());
+			}
+			vertexCount += newVertexCount;
+			++meshlet.triangleCount;
+		}
+		if (meshlet.triangleCount > 0)
+		{
+			ComputeBounds(meshlet, partition, positions, positionStride);
+			meshlets.push_back(meshlet);
+		}
+	}
+	return meshlets;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+struct MeshPartition;
+
+/**
+ * @brief Small run of a mesh's index buffer with the bounds to cull it on the CPU.
+ * @detail Meshlets never cross the parts of the MeshPartition they are built from, so each is drawn with its part's base vertex.
+ */
+struct Meshlet
+{
+	static constexpr uint32_t MaxVertices = 64;
+	static constexpr uint32_t MaxTriangles = 124;
+
+	uint32_t startIndex;
+	uint32_t triangleCount;
+	int32_t baseVertex;
+
+	//Bounding sphere in object space.
+	XMFLOAT3 center;
+	float radius;
+	//Normal cone. Every triangle faces away from cameras far enough along the axis, see MeshletCuller.
+	//The cutoff is above 1 when the normals spread too wide for a cone.
+	XMFLOAT3 coneAxis;
+	float coneCutoff;
+
+	/**
+	 * @brief Cut the parts of partition into meshlets in index order, so a cache optimized order gives compact meshlets.
+	 * @detail The indices are left in the order MeshOptimizer gave them, which whole mesh draws such as the shadow pass
+	 * still rely on for the vertex cache and overdraw.
+	 * @param positions Positions of the source vertices of partition, positionStride bytes apart.
+	 */
+	static std::vector<Meshlet> Build(const MeshPartition& partition, const XMFLOAT3* positions, size_t positionStride);
+};
@@ -0,0 +1,92 @@
+#include "MeshletCuller.h"
+
+MeshletCuller::MeshletCuller(FXMMATRIX viewProj, FXMVECTOR cameraPosition, bool backfaceCulling, uint32_t maxMergeGap)
+	:mBackfaceCulling(backfaceCulling), mMaxMergeGap(maxMergeGap)
+{
+	XMStoreFloat4x4(&mViewProj, viewProj);
+	XMStoreFloat3(&mCameraPosition, cameraPosition);
+	SetObject(XMMatrixIdentity());
+}
+
+void MeshletCuller::SetObject(FXMMATRIX world)
+{
+	//Planes of the clip volume 0 <= z <= w, -w <= x, y <= w, read from the columns of the object to clip matrix.
+	XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(world, XMLoadFloat4x4(&mViewProj)));
+	const XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),
+		XMVectorSubtract(columns.r[3], columns.r[0]),
+		XMVectorAdd(columns.r[3], columns.r[1]),
+		XMVectorSubtract(columns.r[3], columns.r[1]),
+		columns.r[2],
+		XMVectorSubtract(columns.r[3], columns.r[2])
+	};
+	for (int i = 0; i < 6; ++i)
+	{
+		XMStoreFloat4(&mObjectPlanes[i], XMPlaneNormalize(planes[i]));
+	}
+
+	XMMATRIX invWorld = XMMatrixInverse(nullptr, world);
+	XMStoreFloat3(&mObjectCameraPosition, XMVector3TransformCoord(XMLoadFloat3(&mCameraPosition), invWorld));
+}
+
+bool MeshletCuller::IsVisible(const Meshlet& meshlet)
+{
+	++mStats.meshletCount;
+	mStats.triangleCount += meshlet.triangleCount;
+
+	XMVECTOR center = XMLoadFloat3(&meshlet.center);
+	for (const XMFLOAT4& plane : mObjectPlanes)
+	{
+		if (XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&plane), center)) < -meshlet.radius)
+		{
+			mStats.frustumCulledTriangles += meshlet.triangleCount;
+			return false;
+		}
+	}
+
+	if (mBackfaceCulling && meshlet.coneCutoff <= 1.f)
+	{
+		XMVECTOR view = XMVectorSubtract(center, XMLoadFloat3(&mObjectCameraPosition));
+		float viewDot = XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&meshlet.coneAxis)));
+		if (viewDot >= meshlet.coneCutoff * XMVectorGetX(XMVector3Length(view)) + meshlet.radius)
+		{
+			mStats.backfaceCulledTriangles += meshlet.triangleCount;
+			return false;
+		}
+	}
+	return true;
+}
+
+const std::vector<MeshPart>& MeshletCuller::Cull(const std::vector<Meshlet>& meshlets)
+{
+	mVisibleRanges.clear();
+	for (const Meshlet& meshlet : meshlets)
+	{
+		if (IsVisible(meshlet) == false)
+		{
+			continue;
+		}
+
+		//Meshlets follow each other in the index buffer, so those of the same part with few culled triangles between them draw as one range.
+		//The rasterizer rejects the culled ones again for less than a draw costs.
+		uint32_t endIndex = meshlet.startIndex + meshlet.triangleCount * 3;
+		if (mVisibleRanges.empty() == false)
+		{
+			MeshPart& last = mVisibleRanges.back();
+			uint32_t lastEndIndex = last.startIndex + last.indexCount;
+			if (last.baseVertex == meshlet.baseVertex && meshlet.startIndex - lastEndIndex <= mMaxMergeGap * 3)
+			{
+				last.indexCount = endIndex - last.startIndex;
+				continue;
+			}
+		}
+		mVisibleRanges.push_back({ meshlet.startIndex, meshlet.triangleCount * 3, meshlet.baseVertex });
+	}
+	mStats.rangeCount += mVisibleRanges.size();
+	for (const MeshPart& range : mVisibleRanges)
+	{
+		mStats.drawnTriangles += range.indexCount / 3;
+	}
+	return mVisibleRanges;
+}
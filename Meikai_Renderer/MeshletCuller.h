@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "Meshlet.h"
+#include "MeshPartition.h"
+
+using namespace DirectX;
+
+struct MeshletCullStats
+{
+	uint64_t meshletCount = 0;
+	uint64_t triangleCount = 0;
+	uint64_t frustumCulledTriangles = 0;
+	uint64_t backfaceCulledTriangles = 0;
+	//DrawIndexed calls left after merging visible meshlets, and the triangles they draw.
+	uint64_t rangeCount = 0;
+	uint64_t drawnTriangles = 0;
+};
+
+/**
+ * @brief Culls meshlets against the view frustum and by their normal cones, and merges what is left into index ranges to draw.
+ * @detail Tests run in the object space of the meshlets, so the world matrix may scale non-uniformly. Only valid for
+ * geometry whose vertices do not move on the GPU, the bounds of skinned meshes are those of the bind pose.
+ */
+class MeshletCuller
+{
+public:
+	/**
+	 * @param maxMergeGap Culled triangles that may be drawn anyway to join two ranges into one draw.
+	 */
+	MeshletCuller(FXMMATRIX viewProj, FXMVECTOR cameraPosition, bool backfaceCulling = true, uint32_t maxMergeGap = 4 * Meshlet::MaxTriangles);
+
+	/**
+	 * @brief Bring the frustum and the camera into the object space of the meshlets culled next.
+	 */
+	void SetObject(FXMMATRIX world);
+	bool IsVisible(const Meshlet& meshlet);
+	/**
+	 * @brief Ranges of the visible meshlets. Valid until the next call.
+	 */
+	const std::vector<MeshPart>& Cull(const std::vector<Meshlet>& meshlets);
+
+	const MeshletCullStats& GetStats() const { return mStats; }
+	void ResetStats() { mStats = {}; }
+
+private:
+	XMFLOAT4X4 mViewProj;
+	XMFLOAT3 mCameraPosition;
+	bool mBackfaceCulling;
+	uint32_t mMaxMergeGap;
+
+	//Normalized, pointing inside.
+	XMFLOAT4 mObjectPlanes[6];
+	XMFLOAT3 mObjectCameraPosition;
+
+	std::vector<MeshPart> mVisibleRanges;
+	MeshletCullStats mStats;
+};
@@ -3,28 +3,178 @@
 #include "CommandList.h"
 #include "MathHelper.h"
 #include "Animation.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+#include "ObjParser.h"
+#include "VertexWelder.h"
+#include <algorithm>
 
-Model::Model(const std::string& file_path, DXApp* app, CommandList& commandList)
-	:mApp(app)
+Model::Model(const std::string& file_path, DXApp* app, CommandList& commandList, GeometryRetention retention)
+	:mApp(app), mRetention(retention)
 {
-    LoadModel(file_path, commandList);
+    LoadModel(file_path);
+	Upload(commandList);
 }
 
-void Model::LoadModel(const std::string& file_path, CommandList& commandList)
+Model::Model(const std::string& file_path, DXApp* app, GeometryRetention retention, ThreadPool* threadPool)
+	:mApp(app), mRetention(retention)
 {
-    pScene = mImporter.ReadFile(file_path,
-        aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_ConvertToLeftHanded);
+	LoadModel(file_path, threadPool);
+}
 
-    if (!pScene || pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !pScene->mRootNode)
-    {
-        assert("Fail to Load %s", file_path.c_str());
-    }
+void Model::Upload(CommandList& commandList)
+{
+	for (MeshData& mesh : mImportedMeshes)
+	{
+		mLodStats.Add(mesh.indices.size() / 3, mesh.lods);
+		mLodLevelCount = std::max(mLodLevelCount, static_cast<int>(mesh.lods.size()) + 1);
+		mBounds = MeshBounds::Merge(mBounds, mesh.bounds);
+		mMeshes.push_back(Mesh(mApp, std::move(mesh.vertices), std::move(mesh.indices), mesh.bounds, commandList, mRetention, std::move(mesh.lods)));
+	}
+	std::vector<MeshData>().swap(mImportedMeshes);
+}
 
+void Model::LoadModel(const std::string& file_path, ThreadPool* threadPool)
+{
 	name = file_path.substr(0, file_path.find_last_of('/'));
-    ProcessNode(pScene->mRootNode, pScene, commandList);
+	if (LoadCooked(file_path))
+	{
+		return;
+	}
+
+	if (LoadObj(file_path, threadPool) == false)
+	{
+		//Local, so the scene is freed as soon as it is converted.
+		Assimp::Importer importer;
+		const aiScene* pScene = importer.ReadFile(file_path, ImportFlags);
+
+		if (!pScene || pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !pScene->mRootNode)
+		{
+			assert("Fail to Load %s", file_path.c_str());
+		}
+
+		ProcessNode(pScene->mRootNode, pScene);
+	}
+	OptimizeMeshes(file_path, threadPool);
+	Cook(file_path);
+}
+
+void Model::OptimizeMeshes(const std::string& file_path, ThreadPool* threadPool)
+{
+	int meshCount = static_cast<int>(mImportedMeshes.size());
+	std::vector<VertexCacheStats> meshBefore(meshCount);
+	std::vector<VertexCacheStats> meshAfter(meshCount);
+	std::vector<WeldStats> meshWelds(meshCount);
+	//Simplification dominates the import of dense meshes, so each mesh is a job of its own.
+	auto optimizeRange = [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				MeshData& mesh = mImportedMeshes[i];
+				//Before anything else, every later stage is cheaper on fewer vertices.
+				meshWelds[i] = VertexWelder::Weld(mesh.vertices, mesh.indices);
+				MeshOptimizer::Optimize(mesh.vertices, mesh.indices, meshBefore[i], meshAfter[i]);
+				mesh.lods = MeshSimplifier::BuildLods(mesh.vertices, mesh.indices);
+				for (MeshLod& lod : mesh.lods)
+				{
+					MeshOptimizer::OptimizeVertexCache(lod.indices, mesh.vertices.size());
+				}
+			}
+		};
+	if (threadPool == nullptr)
+	{
+		optimizeRange(0, meshCount);
+	}
+	else
+	{
+		threadPool->ParallelFor(meshCount, 1, optimizeRange);
+	}
+
+	VertexCacheStats before;
+	VertexCacheStats after;
+	LodChainStats lodStats;
+	WeldStats welds;
+	for (int i = 0; i < meshCount; ++i)
+	{
+		welds.Add(meshWelds[i]);
+		before.Add(meshBefore[i]);
+		after.Add(meshAfter[i]);
+		lodStats.Add(mImportedMeshes[i].indices.size() / 3, mImportedMeshes[i].lods);
+	}
+	VertexWelder::Report(file_path, welds);
+	MeshOptimizer::Report(file_path, before, after);
+	MeshSimplifier::Report(file_path, lodStats);
+}
+
+bool Model::LoadObj(const std::string& file_path, ThreadPool* threadPool)
+{
+	if (ObjParser::IsObjFile(file_path) == false)
+	{
+		return false;
+	}
+
+	std::vector<ObjMesh> meshes;
+	ObjParseStats stats;
+	if (ObjParser::Load(file_path, meshes, threadPool, &stats) == false)
+	{
+		return false;
+	}
+	ObjParser::Report(file_path, stats);
+
+	for (ObjMesh& mesh : meshes)
+	{
+		MeshData meshData;
+		meshData.vertices = std::move(mesh.vertices);
+		meshData.indices = std::move(mesh.indices);
+		meshData.bounds = MeshBounds::FromVertices(meshData.vertices);
+		mImportedMeshes.push_back(std::move(meshData));
+	}
+	return true;
+}
+
+bool Model::LoadCooked(const std::string& file_path)
+{
+	MeshCache cache;
+	if (cache.Open(file_path, MeshCacheLayout::Static, sizeof(Vertex), ImportFlags) == false)
+	{
+		return false;
+	}
+
+	for (int subMesh = 0; subMesh < cache.GetSubMeshCount(); ++subMesh)
+	{
+		MeshData mesh = { cache.GetVertices<Vertex>(subMesh), cache.GetIndices(subMesh), cache.GetLods(subMesh) };
+		mesh.bounds = MeshBounds::FromVertices(mesh.vertices);
+		mImportedMeshes.push_back(std::move(mesh));
+	}
+	return true;
+}
+
+void Model::Cook(const std::string& file_path) const
+{
+	std::vector<MeshCacheSubMesh> subMeshes;
+	std::vector<MeshCacheLod> lods;
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	for (const MeshData& mesh : mImportedMeshes)
+	{
+		subMeshes.push_back({ static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(mesh.vertices.size()),
+			static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(mesh.indices.size()),
+			static_cast<uint32_t>(lods.size()), static_cast<uint32_t>(mesh.lods.size()) });
+		vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+		indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+		for (const MeshLod& lod : mesh.lods)
+		{
+			lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.indices.size()), lod.error });
+			indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+		}
+	}
+	//A cache that cannot be written only costs the next start another import.
+	MeshCache::Write(file_path, MeshCacheLayout::Static, sizeof(Vertex), ImportFlags, subMeshes, vertices.data(), vertices.size(),
+		indices.data(), indices.size(), lods, {});
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene, CommandList& commandList)
+void Model::ProcessNode(aiNode* node, const aiScene* scene)
 {
     // process each mesh located at the current node
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -32,35 +182,37 @@ void Model::ProcessNode(aiNode* node, const aiScene* scene, CommandList& command
         // the node object only contains indices to index the actual objects in the scene. 
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        mMeshes.push_back(ProcessMesh(mesh, scene, commandList));
+        mImportedMeshes.push_back(ProcessMesh(mesh, scene));
     }
     // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        ProcessNode(node->mChildren[i], scene, commandList);
+        ProcessNode(node->mChildren[i], scene);
     }
 }
 
-Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene, CommandList& commandList)
+MeshData Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 {
-    std::vector<Vertex> vertices;
-    std::vector<UINT> indices;
+    MeshData meshData;
     //std::vector<textures>
 
-    LoadVertices(mesh, vertices);
+    LoadVertices(mesh, meshData.vertices);
     if(mesh->HasFaces())
     {
-        LoadIndices(mesh, indices);
+        LoadIndices(mesh, meshData.indices);
     }
+    meshData.bounds = MeshBounds::FromVertices(meshData.vertices);
    
-    return Mesh(mApp, vertices, indices, commandList);
+    return meshData;
 }
 
 void Model::LoadVertices(aiMesh* mesh, std::vector<Vertex>& vertices)
 {
+    vertices.reserve(vertices.size() + mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
     {
-        Vertex vertex;
+        //Zeroed, as attributes the mesh lacks are compared when welding.
+        Vertex vertex = {};
         XMFLOAT3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
         // positions
         vector.x = mesh->mVertices[i].x;
@@ -105,6 +257,7 @@ void Model::LoadVertices(aiMesh* mesh, std::vector<Vertex>& vertices)
 
 void Model::LoadIndices(aiMesh* mesh, std::vector<UINT>& indices)
 {
+    indices.reserve(indices.size() + mesh->mNumFaces * 3);
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
         aiFace face = mesh->mFaces[i];
@@ -10,12 +10,23 @@
 #include <map>
 
 #include "Mesh.h"
+#include "MeshSimplifier.h"
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
 
 struct DXApp;
 class CommandList;
+class ThreadPool;
+
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+	//Coarser levels over the same vertices, see MeshSimplifier.
+	std::vector<MeshLod> lods;
+	MeshBounds bounds;
+};
 
 class Model
 {
@@ -23,19 +34,61 @@ private:
 	DXApp* mApp;
 
 public:
-	Model(const std::string& file_path, DXApp* app, CommandList& commandList);
+	//Postprocessing every import runs with. Part of the cooked cache and asset registry keys.
+	static constexpr unsigned int ImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_ConvertToLeftHanded;
+
+	Model(const std::string& file_path, DXApp* app, CommandList& commandList, GeometryRetention retention = GeometryRetention::Full);
+	/**
+	 * @brief Import only, without touching the GPU, so it may run on a worker thread.
+	 * @detail The meshes stay on the CPU until Upload records them. The importer and its scene are released
+	 * as soon as the meshes are converted, and retention decides what the meshes keep after the upload.
+	 * A threadPool spreads the per mesh processing of the import over its workers.
+	 */
+	Model(const std::string& file_path, DXApp* app, GeometryRetention retention = GeometryRetention::Full, ThreadPool* threadPool = nullptr);
 	std::string name;
 
-	void LoadModel(const std::string& file_path, CommandList& commandList);
-	void ProcessNode(aiNode* node, const aiScene* scene, CommandList& commandList);
-	Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene, CommandList& commandList);
+	void LoadModel(const std::string& file_path, ThreadPool* threadPool = nullptr);
+	void ProcessNode(aiNode* node, const aiScene* scene);
+	MeshData ProcessMesh(aiMesh* mesh, const aiScene* scene);
+	/**
+	 * @brief Record the copies of the imported meshes into commandList and build mMeshes.
+	 */
+	void Upload(CommandList& commandList);
 
 	void LoadVertices(aiMesh* mesh, std::vector<Vertex>& vertices);
 	void LoadIndices(aiMesh* mesh, std::vector<UINT>& indices);
 
+	/**
+	 * @brief Error and triangles of each level over all meshes, what LodSelector picks a level of the whole model from.
+	 */
+	const LodChainStats& GetLodStats() const { return mLodStats; }
+	int GetLodLevelCount() const { return mLodLevelCount; }
+	//Object space bounds of all meshes, empty until Upload.
+	const MeshBounds& GetBounds() const { return mBounds; }
+
+private:
+	/**
+	 * @brief Build the meshes from the cooked .mesh file instead of importing, when it is up to date.
+	 */
+	bool LoadCooked(const std::string& file_path);
+	/**
+	 * @brief Import an .obj file through ObjParser instead of Assimp. False for other files, or when the parser rejects it.
+	 */
+	bool LoadObj(const std::string& file_path, ThreadPool* threadPool);
+	void Cook(const std::string& file_path) const;
+	/**
+	 * @brief Reorder the imported meshes for the vertex cache, overdraw and vertex fetch, and build their LOD chains.
+	 * @detail Runs before cooking, so the cache holds the result.
+	 */
+	void OptimizeMeshes(const std::string& file_path, ThreadPool* threadPool);
+
 private:
-	Assimp::Importer mImporter;
-	const aiScene* pScene = nullptr;
+	//Imported meshes waiting for Upload.
+	std::vector<MeshData> mImportedMeshes;
+	GeometryRetention mRetention;
+	LodChainStats mLodStats;
+	int mLodLevelCount = 1;
+	MeshBounds mBounds;
 
 public:
 	std::vector<Mesh> mMeshes;
@@ -0,0 +1,141 @@
+#include "ModelLoader.h"
+#include "CommandList.h"
+#include "CommandQueue.h"
+#include "Model.h"
+#include "SkeletalModel.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+
+ModelLoader::ModelLoader(DXApp* app, ThreadPool& threadPool)
+	:mApp(app), mThreadPool(threadPool)
+{
+}
+
+ModelLoader::~ModelLoader()
+{
+	//The import jobs point back at the loader.
+	for (std::future<void>& import : mImports)
+	{
+		mThreadPool.Wait(import);
+	}
+}
+
+template<typename ModelType>
+std::shared_future<std::shared_ptr<ModelType>> ModelLoader::Enqueue(const std::string& filePath, GeometryRetention retention)
+{
+	auto promise = std::make_shared<std::promise<std::shared_ptr<ModelType>>>();
+	std::shared_future<std::shared_ptr<ModelType>> handle = promise->get_future().share();
+
+	mImports.push_back(mThreadPool.Submit([this, filePath, retention, promise]()
+	{
+		std::shared_ptr<ModelType> model;
+		try
+		{
+			model = std::make_shared<ModelType>(filePath, mApp, retention, &mThreadPool);
+		}
+		catch (...)
+		{
+			promise->set_exception(std::current_exception());
+			return;
+		}
+
+		PendingModel pending;
+		pending.upload = [model](CommandList& commandList) { model->Upload(commandList); };
+		pending.resolve = [model, promise]() { promise->set_value(model); };
+		std::lock_guard<std::mutex> lock(mMutex);
+		mImportedModels.push_back(std::move(pending));
+	}));
+	return handle;
+}
+
+std::shared_future<std::shared_ptr<Model>> ModelLoader::Load(const std::string& filePath, GeometryRetention retention)
+{
+	return Enqueue<Model>(filePath, retention);
+}
+
+std::shared_future<std::shared_ptr<SkeletalModel>> ModelLoader::LoadSkeletal(const std::string& filePath, GeometryRetention retention)
+{
+	return Enqueue<SkeletalModel>(filePath, retention);
+}
+
+int ModelLoader::RecordUploads(CommandList& commandList)
+{
+	std::vector<PendingModel> importedModels;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		importedModels.swap(mImportedModels);
+	}
+
+	for (PendingModel& pending : importedModels)
+	{
+		pending.upload(commandList);
+		mRecordedModels.push_back(std::move(pending));
+	}
+	return static_cast<int>(importedModels.size());
+}
+
+void ModelLoader::SubmitUploads(uint64_t fenceValue)
+{
+	for (PendingModel& pending : mRecordedModels)
+	{
+		pending.fenceValue = fenceValue;
+		mSubmittedModels.push_back(std::move(pending));
+	}
+	mRecordedModels.clear();
+	mLastFenceValue = fenceValue;
+}
+
+void ModelLoader::Update(CommandQueue& commandQueue)
+{
+	bool hasImportedModels;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		hasImportedModels = mImportedModels.empty() == false;
+	}
+	if (hasImportedModels)
+	{
+		std::shared_ptr<CommandList> commandList = commandQueue.GetCommandList();
+		RecordUploads(*commandList);
+		SubmitUploads(commandQueue.ExecuteCommandList(commandList));
+	}
+	ResolveCompleted(commandQueue);
+
+	mImports.erase(std::remove_if(mImports.begin(), mImports.end(),
+		[](std::future<void>& import) { return import.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }), mImports.end());
+}
+
+void ModelLoader::ResolveCompleted(CommandQueue& commandQueue)
+{
+	std::vector<PendingModel> inFlightModels;
+	for (PendingModel& pending : mSubmittedModels)
+	{
+		if (commandQueue.IsFenceComplete(pending.fenceValue))
+		{
+			pending.resolve();
+		}
+		else
+		{
+			inFlightModels.push_back(std::move(pending));
+		}
+	}
+	mSubmittedModels.swap(inFlightModels);
+}
+
+void ModelLoader::Finish(CommandQueue& commandQueue)
+{
+	//Waiting in submission order still uploads everything imported meanwhile, whichever order it finished in.
+	//Update drops the finished imports, the front one included.
+	while (mImports.empty() == false)
+	{
+		mThreadPool.Wait(mImports.front());
+		Update(commandQueue);
+	}
+
+	assert(mRecordedModels.empty() && "Uploads recorded outside Finish were never submitted");
+	if (mSubmittedModels.empty() == false)
+	{
+		commandQueue.WaitForFenceValue(mLastFenceValue);
+		ResolveCompleted(commandQueue);
+	}
+}
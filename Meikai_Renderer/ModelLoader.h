@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct DXApp;
+class CommandList;
+class CommandQueue;
+class ThreadPool;
+class Model;
+class SkeletalModel;
+enum class GeometryRetention;
+
+/**
+ * @brief Loads models in parallel on the thread pool.
+ * @detail Import, conversion and cooking run on the workers. Only the owner thread records the uploads, in batches
+ * of whatever has been imported so far, so parsing the next files overlaps the copies of the previous ones.
+ * A handle becomes ready once the copy of its model has completed on the GPU.
+ */
+class ModelLoader
+{
+public:
+	ModelLoader(DXApp* app, ThreadPool& threadPool);
+	~ModelLoader();
+
+	ModelLoader(const ModelLoader& copy) = delete;
+	ModelLoader& operator= (const ModelLoader& other) = delete;
+
+	std::shared_future<std::shared_ptr<Model>> Load(const std::string& filePath, GeometryRetention retention);
+	std::shared_future<std::shared_ptr<SkeletalModel>> LoadSkeletal(const std::string& filePath, GeometryRetention retention);
+
+	/**
+	 * @brief Record the uploads of every model imported so far. Returns how many were recorded.
+	 */
+	int RecordUploads(CommandList& commandList);
+	/**
+	 * @brief Hand over the fence value at which the uploads recorded since the last call complete.
+	 */
+	void SubmitUploads(uint64_t fenceValue);
+	/**
+	 * @brief Execute the uploads of the models imported so far on commandQueue, without waiting,
+	 * and make the handles of the models whose uploads have finished ready.
+	 */
+	void Update(CommandQueue& commandQueue);
+	/**
+	 * @brief Record and execute uploads on commandQueue as imports finish, until every handle is ready.
+	 * @detail The calling thread runs import jobs while it waits for them.
+	 */
+	void Finish(CommandQueue& commandQueue);
+
+private:
+	struct PendingModel
+	{
+		std::function<void(CommandList&)> upload;
+		std::function<void()> resolve;
+		uint64_t fenceValue = 0;
+	};
+
+	template<typename ModelType>
+	std::shared_future<std::shared_ptr<ModelType>> Enqueue(const std::string& filePath, GeometryRetention retention);
+	void ResolveCompleted(CommandQueue& commandQueue);
+
+private:
+	DXApp* mApp;
+	ThreadPool& mThreadPool;
+
+	std::vector<std::future<void>> mImports;
+	//Filled by the workers, so guarded by mMutex.
+	std::vector<PendingModel> mImportedModels;
+	std::mutex mMutex;
+	//Owner thread only.
+	std::vector<PendingModel> mRecordedModels;
+	std::vector<PendingModel> mSubmittedModels;
+	uint64_t mLastFenceValue = 0;
+};
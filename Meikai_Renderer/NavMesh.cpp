@@ -0,0 +1,578 @@
+#include "NavMesh.h"
+#include "NavQuery.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <tuple>
+
+namespace
+{
+	constexpr float DegenerateArea = 1e-8f;
+
+	/**
+	 * @brief Separating axis test of a triangle against a square cell, both projected onto the XZ plane.
+	 */
+	bool OverlapsCell(const XMFLOAT3* triangle, float centerX, float centerZ, float halfSize)
+	{
+		if (std::min({ triangle[0].x, triangle[1].x, triangle[2].x }) > centerX + halfSize || std::max({ triangle[0].x, triangle[1].x, triangle[2].x }) < centerX - halfSize ||
+			std::min({ triangle[0].z, triangle[1].z, triangle[2].z }) > centerZ + halfSize || std::max({ triangle[0].z, triangle[1].z, triangle[2].z }) < centerZ - halfSize)
+		{
+			return false;
+		}
+		for (int edge = 0; edge < 3; ++edge)
+		{
+			const XMFLOAT3& p_0 = triangle[edge];
+			const XMFLOAT3& p_1 = triangle[(edge + 1) % 3];
+			float normalX = p_0.z - p_1.z;
+			float normalZ = p_1.x - p_0.x;
+
+			float triangleMin = FLT_MAX;
+			float triangleMax = -FLT_MAX;
+			for (int i = 0; i < 3; ++i)
+			{
+				float projection = triangle[i].x * normalX + triangle[i].z * normalZ;
+				triangleMin = std::min(triangleMin, projection);
+				triangleMax = std::max(triangleMax, projection);
+			}
+			float cellCenter = centerX * normalX + centerZ * normalZ;
+			float cellExtent = (fabsf(normalX) + fabsf(normalZ)) * halfSize;
+			if (triangleMin > cellCenter + cellExtent || triangleMax < cellCenter - cellExtent)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+void NavMesh::AddTriangles(const XMFLOAT3* positions, size_t stride, size_t vertexCount, const unsigned int* indices, size_t indexCount, FXMMATRIX world)
+{
+	unsigned int baseVertex = static_cast<unsigned int>(mPositions.size());
+	const char* bytes = reinterpret_cast<const char*>(positions);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		XMFLOAT3 position;
+		XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(bytes + i * stride)), world));
+		mPositions.push_back(position);
+	}
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		mIndices.push_back(baseVertex + indices[i]);
+	}
+}
+
+void NavMesh::Build(const NavMeshSettings& settings)
+{
+	assert(mPositions.empty() == false);
+	mSettings = settings;
+
+	XMVECTOR boundsMin = XMLoadFloat3(&mPositions[0]);
+	XMVECTOR boundsMax = boundsMin;
+	for (const XMFLOAT3& position : mPositions)
+	{
+		boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&position));
+		boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&position));
+	}
+	mOrigin = XMFLOAT2(XMVectorGetX(boundsMin), XMVectorGetZ(boundsMin));
+	mWidth = std::max(1, static_cast<int>(ceilf((XMVectorGetX(boundsMax) - mOrigin.x) / mSettings.cellSize)));
+	mDepth = std::max(1, static_cast<int>(ceilf((XMVectorGetZ(boundsMax) - mOrigin.y) / mSettings.cellSize)));
+	mClusterCountX = (mWidth + mSettings.clusterCells - 1) / mSettings.clusterCells;
+	mClusterCountZ = (mDepth + mSettings.clusterCells - 1) / mSettings.clusterCells;
+
+	mCellHeights.assign(static_cast<size_t>(mWidth) * mDepth, FLT_MAX);
+	RasterizeGround();
+	RasterizeObstacles();
+	ErodeWalkable();
+	BuildPolygons();
+	BuildPortals();
+	BuildEntrances();
+	BuildEntranceEdges();
+}
+
+void NavMesh::RasterizeGround()
+{
+	float cellSize = mSettings.cellSize;
+	float minNormalY = cosf(XMConvertToRadians(mSettings.maxSlopeDegrees));
+	for (size_t i = 0; i + 2 < mIndices.size(); i += 3)
+	{
+		XMFLOAT3 t[3] = { mPositions[mIndices[i]], mPositions[mIndices[i + 1]], mPositions[mIndices[i + 2]] };
+		XMVECTOR normal = XMVector3Cross(XMLoadFloat3(&t[1]) - XMLoadFloat3(&t[0]), XMLoadFloat3(&t[2]) - XMLoadFloat3(&t[0]));
+		//Winding differs between sources, so either face of a flat enough triangle counts.
+		if (fabsf(XMVectorGetY(XMVector3Normalize(normal))) < minNormalY)
+		{
+			continue;
+		}
+
+		float edge0X = t[1].x - t[0].x, edge0Z = t[1].z - t[0].z;
+		float edge1X = t[2].x - t[0].x, edge1Z = t[2].z - t[0].z;
+		float area = edge0X * edge1Z - edge1X * edge0Z;
+		if (fabsf(area) < DegenerateArea)
+		{
+			continue;
+		}
+
+		int minX = std::max(0, static_cast<int>(floorf((std::min({ t[0].x, t[1].x, t[2].x }) - mOrigin.x) / cellSize)));
+		int maxX = std::min(mWidth - 1, static_cast<int>(floorf((std::max({ t[0].x, t[1].x, t[2].x }) - mOrigin.x) / cellSize)));
+		int minZ = std::max(0, static_cast<int>(floorf((std::min({ t[0].z, t[1].z, t[2].z }) - mOrigin.y) / cellSize)));
+		int maxZ = std::min(mDepth - 1, static_cast<int>(floorf((std::max({ t[0].z, t[1].z, t[2].z }) - mOrigin.y) / cellSize)));
+		for (int z = minZ; z <= maxZ; ++z)
+		{
+			for (int x = minX; x <= maxX; ++x)
+			{
+				//Barycentric coordinates of the cell center.
+				float pointX = mOrigin.x + (x + 0.5f) * cellSize - t[0].x;
+				float pointZ = mOrigin.y + (z + 0.5f) * cellSize - t[0].z;
+				float u = (pointX * edge1Z - edge1X * pointZ) / area;
+				float v = (edge0X * pointZ - pointX * edge0Z) / area;
+				if (u < 0.f || v < 0.f || u + v > 1.f)
+				{
+					continue;
+				}
+
+				//Keep the lowest surface. Tops of obstacles are walkable triangles too, and the obstacle pass blocks what stands on the ground.
+				float height = t[0].y + u * (t[1].y - t[0].y) + v * (t[2].y - t[0].y);
+				float& cellHeight = mCellHeights[z * mWidth + x];
+				cellHeight = std::min(cellHeight, height);
+			}
+		}
+	}
+}
+
+void NavMesh::RasterizeObstacles()
+{
+	float cellSize = mSettings.cellSize;
+	//A little over half a cell, so walls lying exactly on a cell border block the cells on both sides despite rounding.
+	float halfSize = cellSize * 0.501f;
+	for (size_t i = 0; i + 2 < mIndices.size(); i += 3)
+	{
+		XMFLOAT3 t[3] = { mPositions[mIndices[i]], mPositions[mIndices[i + 1]], mPositions[mIndices[i + 2]] };
+		float triangleMinY = std::min({ t[0].y, t[1].y, t[2].y });
+		float triangleMaxY = std::max({ t[0].y, t[1].y, t[2].y });
+
+		//Height of the triangle's plane as y = y0 + slopeX * (x - x0) + slopeZ * (z - z0), unless it stands vertical.
+		float edge0X = t[1].x - t[0].x, edge0Z = t[1].z - t[0].z, edge0Y = t[1].y - t[0].y;
+		float edge1X = t[2].x - t[0].x, edge1Z = t[2].z - t[0].z, edge1Y = t[2].y - t[0].y;
+		float area = edge0X * edge1Z - edge1X * edge0Z;
+		bool vertical = fabsf(area) < DegenerateArea;
+		float slopeX = vertical ? 0.f : (edge0Y * edge1Z - edge1Y * edge0Z) / area;
+		float slopeZ = vertical ? 0.f : (edge0X * edge1Y - edge1X * edge0Y) / area;
+
+		//One cell of slack for the same reason.
+		int minX = std::max(0, static_cast<int>(floorf((std::min({ t[0].x, t[1].x, t[2].x }) - mOrigin.x) / cellSize)) - 1);
+		int maxX = std::min(mWidth - 1, static_cast<int>(floorf((std::max({ t[0].x, t[1].x, t[2].x }) - mOrigin.x) / cellSize)) + 1);
+		int minZ = std::max(0, static_cast<int>(floorf((std::min({ t[0].z, t[1].z, t[2].z }) - mOrigin.y) / cellSize)) - 1);
+		int maxZ = std::min(mDepth - 1, static_cast<int>(floorf((std::max({ t[0].z, t[1].z, t[2].z }) - mOrigin.y) / cellSize)) + 1);
+		for (int z = minZ; z <= maxZ; ++z)
+		{
+			for (int x = minX; x <= maxX; ++x)
+			{
+				float& ground = mCellHeights[z * mWidth + x];
+				if (ground == FLT_MAX)
+				{
+					continue;
+				}
+
+				float centerX = mOrigin.x + (x + 0.5f) * cellSize;
+				float centerZ = mOrigin.y + (z + 0.5f) * cellSize;
+				if (OverlapsCell(t, centerX, centerZ, halfSize) == false)
+				{
+					continue;
+				}
+
+				float minY = triangleMinY;
+				float maxY = triangleMaxY;
+				if (vertical == false)
+				{
+					float centerY = t[0].y + slopeX * (centerX - t[0].x) + slopeZ * (centerZ - t[0].z);
+					float spread = (fabsf(slopeX) + fabsf(slopeZ)) * halfSize;
+					minY = std::max(minY, centerY - spread);
+					maxY = std::min(maxY, centerY + spread);
+				}
+
+				//Anything between a step and the agent's head blocks the cell.
+				if (maxY > ground + mSettings.maxStepHeight && minY < ground + mSettings.agentHeight)
+				{
+					ground = FLT_MAX;
+				}
+			}
+		}
+	}
+}
+
+void NavMesh::ErodeWalkable()
+{
+	//Clear every walkable cell closer than the agent radius to a blocked cell or the grid border.
+	//Distances are measured between cell edges, since an obstacle may reach anywhere into a blocked cell.
+	float radiusInCells = mSettings.agentRadius / mSettings.cellSize;
+	int reach = static_cast<int>(ceilf(radiusInCells)) + 1;
+	std::vector<std::pair<int, int>> disk;
+	for (int dz = -reach; dz <= reach; ++dz)
+	{
+		for (int dx = -reach; dx <= reach; ++dx)
+		{
+			int gapX = std::max(abs(dx) - 1, 0);
+			int gapZ = std::max(abs(dz) - 1, 0);
+			if (static_cast<float>(gapX * gapX + gapZ * gapZ) < radiusInCells * radiusInCells)
+			{
+				disk.push_back({ dx, dz });
+			}
+		}
+	}
+
+	std::vector<bool> eroded(mCellHeights.size(), false);
+	auto isBlocked = [this](int x, int z) { return x < 0 || z < 0 || x >= mWidth || z >= mDepth || mCellHeights[z * mWidth + x] == FLT_MAX; };
+	for (int z = -1; z <= mDepth; ++z)
+	{
+		for (int x = -1; x <= mWidth; ++x)
+		{
+			//Only blocked cells on the edge of a walkable area can reach one.
+			if (isBlocked(x, z) == false ||
+				(isBlocked(x - 1, z) && isBlocked(x + 1, z) && isBlocked(x, z - 1) && isBlocked(x, z + 1)))
+			{
+				continue;
+			}
+			for (auto [dx, dz] : disk)
+			{
+				int cellX = x + dx;
+				int cellZ = z + dz;
+				if (cellX >= 0 && cellZ >= 0 && cellX < mWidth && cellZ < mDepth)
+				{
+					eroded[cellZ * mWidth + cellX] = true;
+				}
+			}
+		}
+	}
+
+	mWalkableCellCount = 0;
+	for (size_t cell = 0; cell < mCellHeights.size(); ++cell)
+	{
+		if (eroded[cell])
+		{
+			mCellHeights[cell] = FLT_MAX;
+		}
+		mWalkableCellCount += mCellHeights[cell] != FLT_MAX;
+	}
+}
+
+bool NavMesh::CanMerge(int cell, float height) const
+{
+	return mCellHeights[cell] != FLT_MAX && mCellPolygons[cell] < 0 && fabsf(mCellHeights[cell] - height) <= mSettings.maxStepHeight;
+}
+
+void NavMesh::BuildPolygons()
+{
+	//Grow the widest row first, then as many rows as fit. Rectangles stay inside their cluster.
+	mCellPolygons.assign(mCellHeights.size(), -1);
+	mPolygons.clear();
+	for (int clusterZ = 0; clusterZ < mClusterCountZ; ++clusterZ)
+	{
+		for (int clusterX = 0; clusterX < mClusterCountX; ++clusterX)
+		{
+			int beginX = clusterX * mSettings.clusterCells;
+			int beginZ = clusterZ * mSettings.clusterCells;
+			int endX = std::min(beginX + mSettings.clusterCells, mWidth);
+			int endZ = std::min(beginZ + mSettings.clusterCells, mDepth);
+			for (int z = beginZ; z < endZ; ++z)
+			{
+				for (int x = beginX; x < endX; ++x)
+				{
+					float height = mCellHeights[z * mWidth + x];
+					if (CanMerge(z * mWidth + x, height) == false)
+					{
+						continue;
+					}
+
+					int rowEnd = x + 1;
+					while (rowEnd < endX && CanMerge(z * mWidth + rowEnd, height))
+					{
+						++rowEnd;
+					}
+					int columnEnd = z + 1;
+					for (; columnEnd < endZ; ++columnEnd)
+					{
+						int cell = columnEnd * mWidth + x;
+						int rowCell = cell;
+						while (rowCell < cell + (rowEnd - x) && CanMerge(rowCell, height))
+						{
+							++rowCell;
+						}
+						if (rowCell != cell + (rowEnd - x))
+						{
+							break;
+						}
+					}
+
+					int polygon = static_cast<int>(mPolygons.size());
+					mPolygons.push_back({ x, z, rowEnd, columnEnd, height, clusterZ * mClusterCountX + clusterX, 0, 0 });
+					for (int cellZ = z; cellZ < columnEnd; ++cellZ)
+					{
+						std::fill(mCellPolygons.begin() + cellZ * mWidth + x, mCellPolygons.begin() + cellZ * mWidth + rowEnd, polygon);
+					}
+				}
+			}
+		}
+	}
+}
+
+void NavMesh::BuildPortals()
+{
+	mPortals.clear();
+	float cellSize = mSettings.cellSize;
+	for (int polygon = 0; polygon < GetPolygonCount(); ++polygon)
+	{
+		NavPolygon& p = mPolygons[polygon];
+		p.firstPortal = static_cast<int>(mPortals.size());
+
+		//Each side as the run of cells just outside it: (first outside cell, step along the side, cells, inside offset).
+		struct Side
+		{
+			int x;
+			int z;
+			int stepX;
+			int stepZ;
+			int length;
+			int insideX;
+			int insideZ;
+		};
+		Side sides[4] =
+		{
+			{ p.minX - 1, p.minZ, 0, 1, p.maxZ - p.minZ, 1, 0 },
+			{ p.maxX, p.minZ, 0, 1, p.maxZ - p.minZ, -1, 0 },
+			{ p.minX, p.minZ - 1, 1, 0, p.maxX - p.minX, 0, 1 },
+			{ p.minX, p.maxZ, 1, 0, p.maxX - p.minX, 0, -1 },
+		};
+		for (const Side& side : sides)
+		{
+			//Group neighbouring cells that lead to the same polygon within a step into one portal.
+			int runStart = 0;
+			int runNeighbour = -1;
+			for (int i = 0; i <= side.length; ++i)
+			{
+				int neighbour = -1;
+				if (i < side.length)
+				{
+					int x = side.x + side.stepX * i;
+					int z = side.z + side.stepZ * i;
+					if (IsWalkable(x, z))
+					{
+						float insideHeight = mCellHeights[(z + side.insideZ) * mWidth + x + side.insideX];
+						if (fabsf(mCellHeights[z * mWidth + x] - insideHeight) <= mSettings.maxStepHeight)
+						{
+							neighbour = mCellPolygons[z * mWidth + x];
+						}
+					}
+				}
+				if (neighbour == runNeighbour)
+				{
+					continue;
+				}
+
+				if (runNeighbour >= 0)
+				{
+					//The shared edge lies on the border between the inside and outside cells.
+					int edgeX = side.stepX == 0 ? std::max(side.x, side.x + side.insideX) : side.x + runStart;
+					int edgeZ = side.stepZ == 0 ? std::max(side.z, side.z + side.insideZ) : side.z + runStart;
+					int endX = side.stepX == 0 ? edgeX : side.x + i;
+					int endZ = side.stepZ == 0 ? edgeZ : side.z + i;
+					float height = (p.height + mPolygons[runNeighbour].height) * 0.5f;
+
+					NavPortal portal;
+					portal.a = XMFLOAT3(mOrigin.x + edgeX * cellSize, height, mOrigin.y + edgeZ * cellSize);
+					portal.b = XMFLOAT3(mOrigin.x + endX * cellSize, height, mOrigin.y + endZ * cellSize);
+					portal.neighbour = runNeighbour;
+					mPortals.push_back(portal);
+				}
+				runStart = i;
+				runNeighbour = neighbour;
+			}
+		}
+		p.portalCount = static_cast<int>(mPortals.size()) - p.firstPortal;
+	}
+}
+
+void NavMesh::BuildEntrances()
+{
+	//Portals across a cluster border, keyed by the cluster pair and their start along the border.
+	struct Crossing
+	{
+		int clusterLow;
+		int clusterHigh;
+		float start;
+		float end;
+		int polygon;
+		int portal;
+	};
+	std::vector<Crossing> crossings;
+	for (int polygon = 0; polygon < GetPolygonCount(); ++polygon)
+	{
+		const NavPolygon& p = mPolygons[polygon];
+		for (int portal = p.firstPortal; portal < p.firstPortal + p.portalCount; ++portal)
+		{
+			const NavPortal& n = mPortals[portal];
+			int neighbourCluster = mPolygons[n.neighbour].cluster;
+			if (n.neighbour < polygon || neighbourCluster == p.cluster)
+			{
+				continue;
+			}
+			//Portals run along x or along z, and a cluster pair shares a single border line.
+			bool alongX = n.a.z == n.b.z;
+			float start = alongX ? std::min(n.a.x, n.b.x) : std::min(n.a.z, n.b.z);
+			float end = alongX ? std::max(n.a.x, n.b.x) : std::max(n.a.z, n.b.z);
+			crossings.push_back({ std::min(p.cluster, neighbourCluster), std::max(p.cluster, neighbourCluster), start, end, polygon, portal });
+		}
+	}
+	std::sort(crossings.begin(), crossings.end(), [](const Crossing& lhs, const Crossing& rhs)
+	{
+		return std::tie(lhs.clusterLow, lhs.clusterHigh, lhs.start) < std::tie(rhs.clusterLow, rhs.clusterHigh, rhs.start);
+	});
+
+	//Touching portals along one border form a single run, and only its widest portal becomes an entrance.
+	//This keeps the abstract graph far smaller than the polygon graph, at the cost of routes bending through it.
+	mEntrances.clear();
+	std::vector<std::vector<int>> clusterEntrances(GetClusterCount());
+	float touchTolerance = mSettings.cellSize * 0.5f;
+	for (size_t runStart = 0; runStart < crossings.size();)
+	{
+		size_t runEnd = runStart + 1;
+		size_t widest = runStart;
+		while (runEnd < crossings.size() &&
+			crossings[runEnd].clusterLow == crossings[runStart].clusterLow && crossings[runEnd].clusterHigh == crossings[runStart].clusterHigh &&
+			crossings[runEnd].start <= crossings[runEnd - 1].end + touchTolerance)
+		{
+			if (crossings[runEnd].end - crossings[runEnd].start > crossings[widest].end - crossings[widest].start)
+			{
+				widest = runEnd;
+			}
+			++runEnd;
+		}
+
+		const Crossing& crossing = crossings[widest];
+		const NavPortal& portal = mPortals[crossing.portal];
+		NavEntrance entrance;
+		XMStoreFloat3(&entrance.position, (XMLoadFloat3(&portal.a) + XMLoadFloat3(&portal.b)) * 0.5f);
+		entrance.polygons[0] = crossing.polygon;
+		entrance.polygons[1] = portal.neighbour;
+		entrance.clusters[0] = mPolygons[crossing.polygon].cluster;
+		entrance.clusters[1] = mPolygons[portal.neighbour].cluster;
+		clusterEntrances[entrance.clusters[0]].push_back(static_cast<int>(mEntrances.size()));
+		clusterEntrances[entrance.clusters[1]].push_back(static_cast<int>(mEntrances.size()));
+		mEntrances.push_back(entrance);
+		runStart = runEnd;
+	}
+
+	mClusterEntranceOffsets.assign(1, 0);
+	mClusterEntrances.clear();
+	for (const auto& entrances : clusterEntrances)
+	{
+		mClusterEntrances.insert(mClusterEntrances.end(), entrances.begin(), entrances.end());
+		mClusterEntranceOffsets.push_back(static_cast<int>(mClusterEntrances.size()));
+	}
+}
+
+void NavMesh::BuildEntranceEdges()
+{
+	//One Dijkstra per entrance and cluster side, limited to that cluster, gives the cost to every other entrance of the cluster.
+	std::vector<std::vector<NavEdge>> edges(mEntrances.size());
+	NavQuery query(*this);
+	for (int cluster = 0; cluster < GetClusterCount(); ++cluster)
+	{
+		int entranceCount;
+		const int* entrances = GetClusterEntrances(cluster, entranceCount);
+		for (int i = 0; i < entranceCount; ++i)
+		{
+			const NavEntrance& from = mEntrances[entrances[i]];
+			int fromPolygon = from.polygons[from.clusters[0] == cluster ? 0 : 1];
+
+			query.BeginClusterFilter();
+			query.AllowCluster(cluster);
+			query.SearchPolygons(fromPolygon, XMLoadFloat3(&from.position), -1, XMVectorZero(), true);
+
+			for (int j = 0; j < entranceCount; ++j)
+			{
+				const NavEntrance& to = mEntrances[entrances[j]];
+				int toPolygon = to.polygons[to.clusters[0] == cluster ? 0 : 1];
+				const NavQuery::SearchNode& node = query.mPolygonNodes[toPolygon];
+				if (j == i || node.stamp != query.mStamp)
+				{
+					continue;
+				}
+				float cost = node.cost + XMVectorGetX(XMVector3Length(XMLoadFloat3(&to.position) - XMLoadFloat3(&node.position)));
+				edges[entrances[i]].push_back({ entrances[j], cost, cluster });
+			}
+		}
+	}
+
+	mEntranceEdgeOffsets.assign(1, 0);
+	mEntranceEdges.clear();
+	for (const auto& entranceEdges : edges)
+	{
+		mEntranceEdges.insert(mEntranceEdges.end(), entranceEdges.begin(), entranceEdges.end());
+		mEntranceEdgeOffsets.push_back(static_cast<int>(mEntranceEdges.size()));
+	}
+}
+
+const int* NavMesh::GetClusterEntrances(int cluster, int& count) const
+{
+	count = mClusterEntranceOffsets[cluster + 1] - mClusterEntranceOffsets[cluster];
+	return mClusterEntrances.data() + mClusterEntranceOffsets[cluster];
+}
+
+const NavEdge* NavMesh::GetEntranceEdges(int entrance, int& count) const
+{
+	count = mEntranceEdgeOffsets[entrance + 1] - mEntranceEdgeOffsets[entrance];
+	return mEntranceEdges.data() + mEntranceEdgeOffsets[entrance];
+}
+
+int NavMesh::FindNearestPolygon(XMVECTOR point, float searchRadius, XMVECTOR& nearestPoint) const
+{
+	float cellSize = mSettings.cellSize;
+	float pointX = XMVectorGetX(point);
+	float pointZ = XMVectorGetZ(point);
+	int cellX = static_cast<int>(floorf((pointX - mOrigin.x) / cellSize));
+	int cellZ = static_cast<int>(floorf((pointZ - mOrigin.y) / cellSize));
+
+	//Walk square rings outward. A ring r cells out is at least (r - 1) cells away, so stop once that passes the best so far.
+	int reach = static_cast<int>(ceilf(searchRadius / cellSize));
+	int bestPolygon = -1;
+	float bestDistanceSquared = searchRadius * searchRadius;
+	XMFLOAT3 best;
+	for (int ring = 0; ring <= reach; ++ring)
+	{
+		float ringDistance = (ring - 1) * cellSize;
+		if (bestPolygon >= 0 && ringDistance > 0.f && ringDistance * ringDistance > bestDistanceSquared)
+		{
+			break;
+		}
+
+		for (int z = cellZ - ring; z <= cellZ + ring; ++z)
+		{
+			int stepX = (z == cellZ - ring || z == cellZ + ring) ? 1 : std::max(1, ring * 2);
+			for (int x = cellX - ring; x <= cellX + ring; x += stepX)
+			{
+				if (IsWalkable(x, z) == false)
+				{
+					continue;
+				}
+
+				int polygon = mCellPolygons[z * mWidth + x];
+				const NavPolygon& p = mPolygons[polygon];
+				float clampedX = std::clamp(pointX, mOrigin.x + p.minX * cellSize, mOrigin.x + p.maxX * cellSize);
+				float clampedZ = std::clamp(pointZ, mOrigin.y + p.minZ * cellSize, mOrigin.y + p.maxZ * cellSize);
+				float distanceSquared = (clampedX - pointX) * (clampedX - pointX) + (clampedZ - pointZ) * (clampedZ - pointZ);
+				if (distanceSquared <= bestDistanceSquared)
+				{
+					bestDistanceSquared = distanceSquared;
+					bestPolygon = polygon;
+					best = XMFLOAT3(clampedX, p.height, clampedZ);
+				}
+			}
+		}
+	}
+
+	if (bestPolygon >= 0)
+	{
+		nearestPoint = XMLoadFloat3(&best);
+	}
+	return bestPolygon;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+struct NavMeshSettings
+{
+	float cellSize = 0.1f;
+	float agentRadius = 0.3f;
+	float agentHeight = 1.8f;
+	float maxStepHeight = 0.3f;
+	float maxSlopeDegrees = 45.f;
+	//Side of a square cluster in cells. Polygons never cross a cluster border.
+	int clusterCells = 64;
+};
+
+/**
+ * @brief Walkable axis aligned rectangle of cells [minX, maxX) x [minZ, maxZ).
+ */
+struct NavPolygon
+{
+	int minX;
+	int minZ;
+	int maxX;
+	int maxZ;
+	float height;
+	int cluster;
+	int firstPortal;
+	int portalCount;
+};
+
+/**
+ * @brief Shared edge to a neighbouring polygon, from a to b in world space.
+ */
+struct NavPortal
+{
+	XMFLOAT3 a;
+	XMFLOAT3 b;
+	int neighbour;
+};
+
+/**
+ * @brief Portal between two clusters. It is a node of the abstract graph used by hierarchical search.
+ */
+struct NavEntrance
+{
+	XMFLOAT3 position;
+	int polygons[2];
+	int clusters[2];
+};
+
+struct NavEdge
+{
+	int target;
+	float cost;
+	//Cluster the cost was measured in.
+	int cluster;
+};
+
+/**
+ * @brief Navigation mesh built from static triangles.
+ * @detail Build voxelizes the triangles into a single layer heightfield of cells. Up facing triangles give
+ * ground heights, and anything inside the agent's height above the ground blocks the cell. Blocked cells
+ * are grown by the agent radius, so paths may run along polygon edges. Walkable cells are merged greedily into
+ * rectangles inside square clusters. Each run of portals across a cluster border becomes an entrance of an abstract graph whose edge costs are
+ * precomputed inside each cluster, which is what NavQuery searches first on large maps.
+ * The mesh is immutable after Build and may be searched from many threads, each with its own NavQuery.
+ */
+class NavMesh
+{
+public:
+	NavMesh() = default;
+
+	NavMesh(const NavMesh& copy) = delete;
+	NavMesh& operator= (const NavMesh& other) = delete;
+
+	/**
+	 * @brief Add indexed triangles. Positions are read with the given byte stride, so vertex structs can be passed as is.
+	 */
+	void AddTriangles(const XMFLOAT3* positions, size_t stride, size_t vertexCount, const unsigned int* indices, size_t indexCount, FXMMATRIX world);
+	void Build(const NavMeshSettings& settings);
+
+	/**
+	 * @brief Find the polygon under point, or the closest one within searchRadius on the XZ plane.
+	 * @detail Returns -1 when there is none. nearestPoint is clamped into the polygon and put on its height.
+	 */
+	int FindNearestPolygon(XMVECTOR point, float searchRadius, XMVECTOR& nearestPoint) const;
+
+	const NavPolygon& GetPolygon(int polygon) const { return mPolygons[polygon]; }
+	const NavPortal& GetPortal(int portal) const { return mPortals[portal]; }
+	int GetPolygonCount() const { return static_cast<int>(mPolygons.size()); }
+	int GetClusterCount() const { return mClusterCountX * mClusterCountZ; }
+	int GetClusterCountX() const { return mClusterCountX; }
+
+	const NavEntrance& GetEntrance(int entrance) const { return mEntrances[entrance]; }
+	int GetEntranceCount() const { return static_cast<int>(mEntrances.size()); }
+	const int* GetClusterEntrances(int cluster, int& count) const;
+	const NavEdge* GetEntranceEdges(int entrance, int& count) const;
+
+	const NavMeshSettings& GetSettings() const { return mSettings; }
+	int GetWalkableCellCount() const { return mWalkableCellCount; }
+
+private:
+	void RasterizeGround();
+	void RasterizeObstacles();
+	void ErodeWalkable();
+	void BuildPolygons();
+	void BuildPortals();
+	void BuildEntrances();
+	void BuildEntranceEdges();
+	bool CanMerge(int cell, float height) const;
+	bool IsWalkable(int x, int z) const { return x >= 0 && z >= 0 && x < mWidth && z < mDepth && mCellPolygons[z * mWidth + x] >= 0; }
+
+private:
+	NavMeshSettings mSettings;
+
+	//Input triangles in world space.
+	std::vector<XMFLOAT3> mPositions;
+	std::vector<unsigned int> mIndices;
+
+	XMFLOAT2 mOrigin = XMFLOAT2(0.f, 0.f);
+	int mWidth = 0;
+	int mDepth = 0;
+	int mWalkableCellCount = 0;
+	//Per cell, row major in z. FLT_MAX marks a cell that cannot be stood on.
+	std::vector<float> mCellHeights;
+	std::vector<int> mCellPolygons;
+
+	std::vector<NavPolygon> mPolygons;
+	std::vector<NavPortal> mPortals;
+
+	int mClusterCountX = 0;
+	int mClusterCountZ = 0;
+	std::vector<NavEntrance> mEntrances;
+	//Entrances of cluster i live in [mClusterEntranceOffsets[i], mClusterEntranceOffsets[i + 1]), edges of entrance i likewise.
+	std::vector<int> mClusterEntranceOffsets;
+	std::vector<int> mClusterEntrances;
+	std::vector<int> mEntranceEdgeOffsets;
+	std::vector<NavEdge> mEntranceEdges;
+};
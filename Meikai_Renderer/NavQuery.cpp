@@ -0,0 +1,474 @@
+#include "NavQuery.h"
+#include "NavMesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+	using OpenEntry = std::pair<float, int>;
+
+	void PushOpen(std::vector<OpenEntry>& open, float estimate, int node)
+	{
+		open.push_back({ estimate, node });
+		std::push_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+	}
+
+	int PopOpen(std::vector<OpenEntry>& open)
+	{
+		std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+		int node = open.back().second;
+		open.pop_back();
+		return node;
+	}
+
+	float Distance(XMVECTOR a, XMVECTOR b)
+	{
+		return XMVectorGetX(XMVector3Length(b - a));
+	}
+
+	//Twice the signed area of triangle abc on the XZ plane. Positive when c lies right of a to b.
+	float TriangleArea2(XMVECTOR a, XMVECTOR b, XMVECTOR c)
+	{
+		XMFLOAT3 ab, ac;
+		XMStoreFloat3(&ab, b - a);
+		XMStoreFloat3(&ac, c - a);
+		return ac.x * ab.z - ab.x * ac.z;
+	}
+
+	bool IsSamePoint(XMVECTOR a, XMVECTOR b)
+	{
+		return XMVectorGetX(XMVector3LengthSq(b - a)) < 1e-8f;
+	}
+}
+
+NavQuery::NavQuery(const NavMesh& navMesh)
+	:mNavMesh(navMesh)
+{
+	mPolygonNodes.resize(navMesh.GetPolygonCount(), SearchNode{});
+	mEntranceNodes.resize(navMesh.GetEntranceCount() + 1, SearchNode{});
+	mEntranceStartCosts.resize(navMesh.GetEntranceCount(), 0.f);
+	mEntranceGoalCosts.resize(navMesh.GetEntranceCount(), 0.f);
+	mEntranceStartStamps.resize(navMesh.GetEntranceCount(), 0);
+	mEntranceGoalStamps.resize(navMesh.GetEntranceCount(), 0);
+	mClusterStamps.resize(navMesh.GetClusterCount(), 0);
+}
+
+bool NavQuery::FindPath(XMVECTOR start, XMVECTOR goal, std::vector<XMVECTOR>& outPoints, NavSearchMethod method)
+{
+	outPoints.clear();
+	mExpandedNodeCount = 0;
+
+	const NavMeshSettings& settings = mNavMesh.GetSettings();
+	float snapRadius = std::max(settings.agentRadius * 4.f, settings.cellSize * 8.f);
+	int startPolygon = mNavMesh.FindNearestPolygon(start, snapRadius, start);
+	int goalPolygon = mNavMesh.FindNearestPolygon(goal, snapRadius, goal);
+	if (startPolygon < 0 || goalPolygon < 0)
+	{
+		return false;
+	}
+
+	//Goals in the same or a neighbouring cluster are cheap for plain A*, and routing them through an entrance only adds a bend.
+	int clusterCountX = mNavMesh.GetClusterCountX();
+	int startCluster = mNavMesh.GetPolygon(startPolygon).cluster;
+	int goalCluster = mNavMesh.GetPolygon(goalPolygon).cluster;
+	bool nearby = abs(startCluster % clusterCountX - goalCluster % clusterCountX) <= 1 && abs(startCluster / clusterCountX - goalCluster / clusterCountX) <= 1;
+
+	bool found = false;
+	if (method == NavSearchMethod::Hierarchical && nearby == false)
+	{
+		//The abstract graph connects the same clusters the polygons do, so a miss there needs no flat search to confirm.
+		if (SearchEntrances(startPolygon, start, goalPolygon, goal) == false)
+		{
+			return false;
+		}
+		found = RefineAbstractPath(startPolygon, start, goalPolygon, goal);
+	}
+	if (found == false)
+	{
+		if (SearchPolygons(startPolygon, start, goalPolygon, goal, false) == false)
+		{
+			return false;
+		}
+		BuildCorridor(goalPolygon);
+	}
+
+	StringPull(start, goal, outPoints);
+	return true;
+}
+
+bool NavQuery::FindLoop(const std::vector<XMVECTOR>& waypoints, float maxSpacing, std::vector<XMVECTOR>& outControlPoints, NavSearchMethod method)
+{
+	outControlPoints.clear();
+	for (size_t i = 0; i < waypoints.size(); ++i)
+	{
+		if (FindPath(waypoints[i], waypoints[(i + 1) % waypoints.size()], mLegPoints, method) == false)
+		{
+			return false;
+		}
+
+		//The last corner of a leg starts the next one.
+		for (size_t corner = 0; corner + 1 < mLegPoints.size(); ++corner)
+		{
+			XMVECTOR from = mLegPoints[corner];
+			XMVECTOR to = mLegPoints[corner + 1];
+			int pieces = std::max(1, static_cast<int>(ceilf(Distance(from, to) / maxSpacing)));
+			for (int piece = 0; piece < pieces; ++piece)
+			{
+				XMVECTOR point = XMVectorLerp(from, to, static_cast<float>(piece) / pieces);
+				if (outControlPoints.empty() || IsSamePoint(outControlPoints.back(), point) == false)
+				{
+					outControlPoints.push_back(point);
+				}
+			}
+		}
+	}
+
+	if (outControlPoints.size() < 3)
+	{
+		outControlPoints.clear();
+		return false;
+	}
+	outControlPoints.push_back(outControlPoints.front());
+	return true;
+}
+
+bool NavQuery::SearchPolygons(int startPolygon, XMVECTOR start, int goalPolygon, XMVECTOR goal, bool clusterFilter)
+{
+	++mStamp;
+	mOpen.clear();
+
+	SearchNode& startNode = mPolygonNodes[startPolygon];
+	startNode.cost = 0.f;
+	startNode.parent = -1;
+	XMStoreFloat3(&startNode.position, start);
+	startNode.stamp = mStamp;
+	startNode.closed = false;
+	PushOpen(mOpen, goalPolygon >= 0 ? Distance(start, goal) : 0.f, startPolygon);
+
+	while (mOpen.empty() == false)
+	{
+		int polygon = PopOpen(mOpen);
+		SearchNode& node = mPolygonNodes[polygon];
+		//Stale entry of a node that was reached cheaper later.
+		if (node.closed)
+		{
+			continue;
+		}
+		node.closed = true;
+		++mExpandedNodeCount;
+		if (polygon == goalPolygon)
+		{
+			return true;
+		}
+
+		//Nodes sit on the middle of the portal they were entered through. The goal node sits on the goal.
+		XMVECTOR position = XMLoadFloat3(&node.position);
+		const NavPolygon& p = mNavMesh.GetPolygon(polygon);
+		for (int i = p.firstPortal; i < p.firstPortal + p.portalCount; ++i)
+		{
+			const NavPortal& portal = mNavMesh.GetPortal(i);
+			if (clusterFilter && IsClusterAllowed(mNavMesh.GetPolygon(portal.neighbour).cluster) == false)
+			{
+				continue;
+			}
+
+			SearchNode& next = mPolygonNodes[portal.neighbour];
+			if (next.stamp != mStamp)
+			{
+				next.cost = FLT_MAX;
+				next.stamp = mStamp;
+				next.closed = false;
+			}
+			if (next.closed)
+			{
+				continue;
+			}
+
+			XMVECTOR nextPosition = (XMLoadFloat3(&portal.a) + XMLoadFloat3(&portal.b)) * 0.5f;
+			float cost = node.cost + Distance(position, nextPosition);
+			if (portal.neighbour == goalPolygon)
+			{
+				cost += Distance(nextPosition, goal);
+				nextPosition = goal;
+			}
+			if (cost < next.cost)
+			{
+				next.cost = cost;
+				next.parent = polygon;
+				XMStoreFloat3(&next.position, nextPosition);
+				PushOpen(mOpen, cost + (goalPolygon >= 0 ? Distance(nextPosition, goal) : 0.f), portal.neighbour);
+			}
+		}
+	}
+
+	//A search without a goal fills in costs to everything reachable.
+	return goalPolygon < 0;
+}
+
+bool NavQuery::SearchEntrances(int startPolygon, XMVECTOR start, int goalPolygon, XMVECTOR goal)
+{
+	//Costs from the start to the entrances of its cluster and from the goal to those of its cluster.
+	int startCluster = mNavMesh.GetPolygon(startPolygon).cluster;
+	int goalCluster = mNavMesh.GetPolygon(goalPolygon).cluster;
+
+	BeginClusterFilter();
+	AllowCluster(startCluster);
+	SearchPolygons(startPolygon, start, -1, goal, true);
+	unsigned int startStamp = mStamp;
+	RecordEntranceCosts(startCluster, mEntranceStartCosts, mEntranceStartStamps);
+
+	BeginClusterFilter();
+	AllowCluster(goalCluster);
+	SearchPolygons(goalPolygon, goal, -1, start, true);
+	unsigned int goalStamp = mStamp;
+	RecordEntranceCosts(goalCluster, mEntranceGoalCosts, mEntranceGoalStamps);
+
+	//A* over entrances, with one extra node for the goal.
+	++mStamp;
+	mOpen.clear();
+	int goalNode = mNavMesh.GetEntranceCount();
+	mEntranceNodes[goalNode].stamp = 0;
+
+	auto relax = [this, goal](int target, int parent, int cluster, float cost, XMFLOAT3 position)
+	{
+		SearchNode& next = mEntranceNodes[target];
+		if (next.stamp != mStamp)
+		{
+			next.cost = FLT_MAX;
+			next.stamp = mStamp;
+			next.closed = false;
+		}
+		if (next.closed || cost >= next.cost)
+		{
+			return;
+		}
+		next.cost = cost;
+		next.parent = parent;
+		next.cluster = cluster;
+		next.position = position;
+		PushOpen(mOpen, cost + Distance(XMLoadFloat3(&position), goal), target);
+	};
+
+	int entranceCount;
+	const int* entrances = mNavMesh.GetClusterEntrances(startCluster, entranceCount);
+	for (int i = 0; i < entranceCount; ++i)
+	{
+		if (mEntranceStartStamps[entrances[i]] == startStamp)
+		{
+			relax(entrances[i], -1, startCluster, mEntranceStartCosts[entrances[i]], mNavMesh.GetEntrance(entrances[i]).position);
+		}
+	}
+
+	XMFLOAT3 goalPosition;
+	XMStoreFloat3(&goalPosition, goal);
+	while (mOpen.empty() == false)
+	{
+		int entrance = PopOpen(mOpen);
+		SearchNode& node = mEntranceNodes[entrance];
+		if (node.closed)
+		{
+			continue;
+		}
+		node.closed = true;
+		++mExpandedNodeCount;
+
+		if (entrance == goalNode)
+		{
+			mAbstractPath.clear();
+			for (int e = entrance; e >= 0; e = mEntranceNodes[e].parent)
+			{
+				mAbstractPath.push_back({ e, mEntranceNodes[e].cluster });
+			}
+			std::reverse(mAbstractPath.begin(), mAbstractPath.end());
+			return true;
+		}
+
+		if (mEntranceGoalStamps[entrance] == goalStamp)
+		{
+			relax(goalNode, entrance, goalCluster, node.cost + mEntranceGoalCosts[entrance], goalPosition);
+		}
+		int edgeCount;
+		const NavEdge* edges = mNavMesh.GetEntranceEdges(entrance, edgeCount);
+		for (int i = 0; i < edgeCount; ++i)
+		{
+			relax(edges[i].target, entrance, edges[i].cluster, node.cost + edges[i].cost, mNavMesh.GetEntrance(edges[i].target).position);
+		}
+	}
+	return false;
+}
+
+bool NavQuery::RefineAbstractPath(int startPolygon, XMVECTOR start, int goalPolygon, XMVECTOR goal)
+{
+	//Each leg of the abstract path stays inside one cluster, so the polygon searches are short.
+	mCorridor.assign(1, startPolygon);
+	int polygon = startPolygon;
+	XMVECTOR position = start;
+	int previousEntrance = -1;
+	for (auto [entrance, cluster] : mAbstractPath)
+	{
+		if (mNavMesh.GetPolygon(polygon).cluster != cluster)
+		{
+			//Step through the previous entrance into this leg's cluster.
+			const NavEntrance& crossed = mNavMesh.GetEntrance(previousEntrance);
+			polygon = crossed.polygons[crossed.clusters[0] == cluster ? 0 : 1];
+			mCorridor.push_back(polygon);
+		}
+
+		int target = goalPolygon;
+		XMVECTOR targetPosition = goal;
+		if (entrance < mNavMesh.GetEntranceCount())
+		{
+			const NavEntrance& next = mNavMesh.GetEntrance(entrance);
+			target = next.polygons[next.clusters[0] == cluster ? 0 : 1];
+			targetPosition = XMLoadFloat3(&next.position);
+		}
+
+		BeginClusterFilter();
+		AllowCluster(cluster);
+		if (SearchPolygons(polygon, position, target, targetPosition, true) == false)
+		{
+			return false;
+		}
+		size_t legStart = mCorridor.size();
+		for (int p = target; p != polygon; p = mPolygonNodes[p].parent)
+		{
+			mCorridor.push_back(p);
+		}
+		std::reverse(mCorridor.begin() + legStart, mCorridor.end());
+
+		polygon = target;
+		position = targetPosition;
+		previousEntrance = entrance;
+	}
+	return true;
+}
+
+void NavQuery::RecordEntranceCosts(int cluster, std::vector<float>& costs, std::vector<unsigned int>& stamps)
+{
+	//Reads the polygon costs of the search that just ran, and marks valid entries with its stamp.
+	int entranceCount;
+	const int* entrances = mNavMesh.GetClusterEntrances(cluster, entranceCount);
+	for (int i = 0; i < entranceCount; ++i)
+	{
+		const NavEntrance& entrance = mNavMesh.GetEntrance(entrances[i]);
+		const SearchNode& node = mPolygonNodes[entrance.polygons[entrance.clusters[0] == cluster ? 0 : 1]];
+		if (node.stamp != mStamp)
+		{
+			continue;
+		}
+		costs[entrances[i]] = node.cost + Distance(XMLoadFloat3(&node.position), XMLoadFloat3(&entrance.position));
+		stamps[entrances[i]] = mStamp;
+	}
+}
+
+void NavQuery::BuildCorridor(int goalPolygon)
+{
+	mCorridor.clear();
+	for (int polygon = goalPolygon; polygon >= 0; polygon = mPolygonNodes[polygon].parent)
+	{
+		mCorridor.push_back(polygon);
+	}
+	std::reverse(mCorridor.begin(), mCorridor.end());
+}
+
+void NavQuery::StringPull(XMVECTOR start, XMVECTOR goal, std::vector<XMVECTOR>& outPoints) const
+{
+	//Portals along the corridor as (left, right) seen walking forward, with the goal as a final zero width portal.
+	size_t portalCount = mCorridor.size();
+	std::vector<XMVECTOR> lefts(portalCount);
+	std::vector<XMVECTOR> rights(portalCount);
+	for (size_t i = 0; i + 1 < mCorridor.size(); ++i)
+	{
+		const NavPolygon& p = mNavMesh.GetPolygon(mCorridor[i]);
+		const NavPolygon& q = mNavMesh.GetPolygon(mCorridor[i + 1]);
+		const NavPortal* portal = nullptr;
+		for (int j = p.firstPortal; j < p.firstPortal + p.portalCount; ++j)
+		{
+			if (mNavMesh.GetPortal(j).neighbour == mCorridor[i + 1])
+			{
+				portal = &mNavMesh.GetPortal(j);
+				break;
+			}
+		}
+
+		//Only the walking direction matters, so cell units are fine for it.
+		float directionX = static_cast<float>(q.minX + q.maxX - p.minX - p.maxX);
+		float directionZ = static_cast<float>(q.minZ + q.maxZ - p.minZ - p.maxZ);
+		bool aIsRight = (portal->a.x - portal->b.x) * directionZ - directionX * (portal->a.z - portal->b.z) > 0.f;
+		lefts[i] = XMLoadFloat3(aIsRight ? &portal->b : &portal->a);
+		rights[i] = XMLoadFloat3(aIsRight ? &portal->a : &portal->b);
+	}
+	lefts[portalCount - 1] = goal;
+	rights[portalCount - 1] = goal;
+
+	outPoints.push_back(start);
+	XMVECTOR apex = start;
+	XMVECTOR portalLeft = start;
+	XMVECTOR portalRight = start;
+	size_t apexIndex = 0;
+	size_t leftIndex = 0;
+	size_t rightIndex = 0;
+	for (size_t i = 0; i < portalCount; ++i)
+	{
+		XMVECTOR left = lefts[i];
+		XMVECTOR right = rights[i];
+
+		//Tighten the right side, or turn around the left corner once right crosses over it.
+		if (TriangleArea2(apex, portalRight, right) <= 0.f)
+		{
+			if (IsSamePoint(apex, portalRight) || TriangleArea2(apex, portalLeft, right) > 0.f)
+			{
+				portalRight = right;
+				rightIndex = i;
+			}
+			else
+			{
+				apex = portalLeft;
+				apexIndex = leftIndex;
+				if (IsSamePoint(outPoints.back(), apex) == false)
+				{
+					outPoints.push_back(apex);
+				}
+				portalLeft = apex;
+				portalRight = apex;
+				leftIndex = apexIndex;
+				rightIndex = apexIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+
+		//Same for the left side.
+		if (TriangleArea2(apex, portalLeft, left) >= 0.f)
+		{
+			if (IsSamePoint(apex, portalLeft) || TriangleArea2(apex, portalRight, left) < 0.f)
+			{
+				portalLeft = left;
+				leftIndex = i;
+			}
+			else
+			{
+				apex = portalRight;
+				apexIndex = rightIndex;
+				if (IsSamePoint(outPoints.back(), apex) == false)
+				{
+					outPoints.push_back(apex);
+				}
+				portalLeft = apex;
+				portalRight = apex;
+				leftIndex = apexIndex;
+				rightIndex = apexIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+	}
+
+	if (IsSamePoint(outPoints.back(), goal) == false)
+	{
+		outPoints.push_back(goal);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+class NavMesh;
+
+enum class NavSearchMethod
+{
+	Flat,
+	Hierarchical
+};
+
+/**
+ * @brief A* path queries on a NavMesh with scratch storage reused between queries.
+ * @detail Hierarchical search first runs A* on the graph of cluster entrances, then refines each step of
+ * that path with polygon A* inside the one cluster it crosses. Goals in the same or a neighbouring cluster
+ * skip the abstract graph. The polygon corridor is string pulled with the funnel algorithm into the fewest
+ * corners that keep to the mesh.
+ * Queries on one NavQuery are not thread safe. Give each worker thread its own.
+ */
+class NavQuery
+{
+public:
+	explicit NavQuery(const NavMesh& navMesh);
+
+	/**
+	 * @brief Find the corners of a path from start to goal, both included.
+	 * @detail Points off the mesh are moved onto the closest polygon first. Returns false when the two are not connected.
+	 */
+	bool FindPath(XMVECTOR start, XMVECTOR goal, std::vector<XMVECTOR>& outPoints, NavSearchMethod method = NavSearchMethod::Hierarchical);
+
+	/**
+	 * @brief Chain paths through waypoints and back to the first one into control points for a closed Path.
+	 * @detail Legs longer than maxSpacing are split, since the spline tangents come from neighbouring points
+	 * and very uneven spacing makes the curve overshoot its corners.
+	 */
+	bool FindLoop(const std::vector<XMVECTOR>& waypoints, float maxSpacing, std::vector<XMVECTOR>& outControlPoints,
+		NavSearchMethod method = NavSearchMethod::Hierarchical);
+
+	/**
+	 * @brief Polygons and entrances expanded by the last FindPath.
+	 */
+	int GetExpandedNodeCount() const { return mExpandedNodeCount; }
+
+private:
+	friend class NavMesh;
+
+	struct SearchNode
+	{
+		float cost;
+		int parent;
+		XMFLOAT3 position;
+		unsigned int stamp;
+		//Cluster travelled through to reach an entrance node.
+		int cluster;
+		bool closed;
+	};
+
+	bool SearchPolygons(int startPolygon, XMVECTOR start, int goalPolygon, XMVECTOR goal, bool clusterFilter);
+	bool SearchEntrances(int startPolygon, XMVECTOR start, int goalPolygon, XMVECTOR goal);
+	bool RefineAbstractPath(int startPolygon, XMVECTOR start, int goalPolygon, XMVECTOR goal);
+	void RecordEntranceCosts(int cluster, std::vector<float>& costs, std::vector<unsigned int>& stamps);
+	void BuildCorridor(int goalPolygon);
+	void StringPull(XMVECTOR start, XMVECTOR goal, std::vector<XMVECTOR>& outPoints) const;
+	void BeginClusterFilter() { ++mClusterStamp; }
+	void AllowCluster(int cluster) { mClusterStamps[cluster] = mClusterStamp; }
+	bool IsClusterAllowed(int cluster) const { return mClusterStamps[cluster] == mClusterStamp; }
+
+private:
+	const NavMesh& mNavMesh;
+
+	std::vector<SearchNode> mPolygonNodes;
+	//One extra node at the back stands for the goal.
+	std::vector<SearchNode> mEntranceNodes;
+	std::vector<float> mEntranceStartCosts;
+	std::vector<float> mEntranceGoalCosts;
+	std::vector<unsigned int> mEntranceStartStamps;
+	std::vector<unsigned int> mEntranceGoalStamps;
+	std::vector<unsigned int> mClusterStamps;
+	unsigned int mStamp = 0;
+	unsigned int mClusterStamp = 0;
+
+	//Min heap of (estimated total cost, node).
+	std::vector<std::pair<float, int>> mOpen;
+	//(entrance, cluster walked through to reach it), ending with the goal node.
+	std::vector<std::pair<int, int>> mAbstractPath;
+	std::vector<int> mCorridor;
+	std::vector<XMVECTOR> mLegPoints;
+	int mExpandedNodeCount = 0;
+};
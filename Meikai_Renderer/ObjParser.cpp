@@ -0,0 +1,860 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "MeshBounds.h"
+#include "ThreadPool.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	//Index of an attribute the corner does not have.
+	constexpr int32_t Missing = INT32_MIN;
+	constexpr UINT EmptySlot = UINT_MAX;
+
+	//ObjCorner::flags, an attribute index counting back from the end of its chunk, see ObjChunk.
+	constexpr uint32_t RelativePosition = 1;
+	constexpr uint32_t RelativeUV = 2;
+	constexpr uint32_t RelativeNormal = 4;
+	//First corner of the two triangles of a quad, which BuildMesh splits again as Assimp does.
+	constexpr uint32_t QuadStart = 8;
+	//Corner whose face normal a later triangle of the same polygon replaces, as Assimp keeps one per polygon corner.
+	constexpr uint32_t SharedCorner = 16;
+
+	const double PowersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	struct ObjCorner
+	{
+		int32_t position;
+		int32_t uv;
+		int32_t normal;
+		uint32_t flags;
+	};
+
+	struct ObjChunk
+	{
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT2> uvs;
+		std::vector<XMFLOAT3> normals;
+		//Three per triangle.
+		std::vector<ObjCorner> corners;
+		//Triangles of the chunk before each o, g and usemtl line.
+		std::vector<size_t> groupStarts;
+		//Negative indices count back from the attributes read so far, which a chunk only knows from its own.
+		//They are stored relative to the chunk's start and fixed once the chunks before it are counted.
+		bool hasRelative = false;
+	};
+
+	bool IsDigit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') < 10;
+	}
+
+	bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	const char* SkipBlanks(const char* p, const char* end)
+	{
+		while (p < end && IsBlank(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	bool IsKeyword(const char* p, const char* end, const char* keyword, size_t length)
+	{
+		return static_cast<size_t>(end - p) >= length && memcmp(p, keyword, length) == 0 && (p + length == end || IsBlank(p[length]));
+	}
+
+	/**
+	 * @brief Decimal to float through a 64-bit mantissa and one multiply or divide by an exact power of ten.
+	 * @detail Digits past the 19th no longer fit and only shift the exponent, far below float precision.
+	 */
+	const char* ParseFloat(const char* p, const char* end, float& value)
+	{
+		p = SkipBlanks(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		for (; p < end && IsDigit(*p); ++p)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+			}
+			else
+			{
+				++exponent;
+			}
+		}
+		if (p < end && *p == '.')
+		{
+			for (++p; p < end && IsDigit(*p); ++p)
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + (*p - '0');
+					digits += mantissa != 0;
+					--exponent;
+				}
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+'))
+			{
+				negativeExponent = *p == '-';
+				++p;
+			}
+			int explicitExponent = 0;
+			for (; p < end && IsDigit(*p); ++p)
+			{
+				explicitExponent = std::min(explicitExponent * 10 + (*p - '0'), 10000);
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+
+		double result = static_cast<double>(mantissa);
+		if (mantissa != 0 && exponent != 0)
+		{
+			if (exponent > 0)
+			{
+				result = exponent <= 22 ? result * PowersOfTen[exponent] : result * pow(10.0, exponent);
+			}
+			else
+			{
+				result = exponent >= -22 ? result / PowersOfTen[-exponent] : result * pow(10.0, exponent);
+			}
+		}
+		value = static_cast<float>(negative ? -result : result);
+		return p;
+	}
+
+	const char* ParseIndex(const char* p, const char* end, int32_t& value)
+	{
+		bool negative = false;
+		if (p < end && *p == '-')
+		{
+			negative = true;
+			++p;
+		}
+		int64_t index = 0;
+		for (; p < end && IsDigit(*p); ++p)
+		{
+			index = std::min<int64_t>(index * 10 + (*p - '0'), INT32_MAX);
+		}
+		value = static_cast<int32_t>(negative ? -index : index);
+		return p;
+	}
+
+	//Positive indices start at 1, negative ones count back from the last attribute read, 0 is not an index.
+	bool ResolveIndex(int32_t& index, size_t readCount, uint32_t relativeBit, ObjCorner& corner, ObjChunk& chunk)
+	{
+		if (index > 0)
+		{
+			--index;
+			return true;
+		}
+		if (index < 0)
+		{
+			index += static_cast<int32_t>(readCount);
+			corner.flags |= relativeBit;
+			chunk.hasRelative = true;
+			return true;
+		}
+		return false;
+	}
+
+	bool ParseFace(const char* p, const char* end, ObjChunk& chunk)
+	{
+		ObjCorner first = {};
+		ObjCorner previous = {};
+		int cornerCount = 0;
+		while (true)
+		{
+			p = SkipBlanks(p, end);
+			if (p == end)
+			{
+				break;
+			}
+
+			ObjCorner corner = { Missing, Missing, Missing, 0 };
+			p = ParseIndex(p, end, corner.position);
+			if (ResolveIndex(corner.position, chunk.positions.size(), RelativePosition, corner, chunk) == false)
+			{
+				return false;
+			}
+			if (p < end && *p == '/')
+			{
+				++p;
+				if (p < end && *p != '/')
+				{
+					p = ParseIndex(p, end, corner.uv);
+					if (ResolveIndex(corner.uv, chunk.uvs.size(), RelativeUV, corner, chunk) == false)
+					{
+						return false;
+					}
+				}
+				if (p < end && *p == '/')
+				{
+					p = ParseIndex(p + 1, end, corner.normal);
+					if (ResolveIndex(corner.normal, chunk.normals.size(), RelativeNormal, corner, chunk) == false)
+					{
+						return false;
+					}
+				}
+			}
+			if (p < end && IsBlank(*p) == false)
+			{
+				return false;
+			}
+
+			//Fanned from the first corner, as the triangulation of a convex polygon.
+			if (cornerCount == 0)
+			{
+				first = corner;
+			}
+			else if (cornerCount >= 2)
+			{
+				if (cornerCount >= 3)
+				{
+					size_t previousTriangle = chunk.corners.size() - 3;
+					chunk.corners[previousTriangle].flags |= SharedCorner;
+					chunk.corners[previousTriangle + 2].flags |= SharedCorner;
+				}
+				chunk.corners.push_back(first);
+				chunk.corners.push_back(previous);
+				chunk.corners.push_back(corner);
+			}
+			previous = corner;
+			++cornerCount;
+		}
+		if (cornerCount == 4)
+		{
+			chunk.corners[chunk.corners.size() - 6].flags |= QuadStart;
+		}
+		return cornerCount >= 3;
+	}
+
+	bool ParseChunk(const char* p, const char* end, ObjChunk& chunk)
+	{
+		while (p < end)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (lineEnd == nullptr)
+			{
+				lineEnd = end;
+			}
+			p = SkipBlanks(p, lineEnd);
+
+			if (p == lineEnd || *p == '#')
+			{
+				p = lineEnd + 1;
+				continue;
+			}
+
+			if (IsKeyword(p, lineEnd, "v", 1))
+			{
+				XMFLOAT3 position;
+				p = ParseFloat(p + 1, lineEnd, position.x);
+				p = ParseFloat(p, lineEnd, position.y);
+				ParseFloat(p, lineEnd, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if (IsKeyword(p, lineEnd, "vt", 2))
+			{
+				XMFLOAT2 uv;
+				p = ParseFloat(p + 2, lineEnd, uv.x);
+				ParseFloat(p, lineEnd, uv.y);
+				chunk.uvs.push_back(uv);
+			}
+			else if (IsKeyword(p, lineEnd, "vn", 2))
+			{
+				XMFLOAT3 normal;
+				p = ParseFloat(p + 2, lineEnd, normal.x);
+				p = ParseFloat(p, lineEnd, normal.y);
+				ParseFloat(p, lineEnd, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if (IsKeyword(p, lineEnd, "f", 1))
+			{
+				if (ParseFace(p + 1, lineEnd, chunk) == false)
+				{
+					return false;
+				}
+			}
+			else if (IsKeyword(p, lineEnd, "o", 1) || IsKeyword(p, lineEnd, "g", 1) || IsKeyword(p, lineEnd, "usemtl", 6))
+			{
+				chunk.groupStarts.push_back(chunk.corners.size() / 3);
+			}
+			p = lineEnd + 1;
+		}
+		return true;
+	}
+
+	template<typename T>
+	void Append(std::vector<T>& all, const std::vector<T>& chunk)
+	{
+		all.insert(all.end(), chunk.begin(), chunk.end());
+	}
+
+	size_t HashCorner(const ObjCorner& corner)
+	{
+		uint64_t hash = static_cast<uint32_t>(corner.position) * 0x9E3779B97F4A7C15ull;
+		hash ^= static_cast<uint32_t>(corner.uv) * 0xC2B2AE3D27D4EB4Full + (hash >> 29);
+		hash ^= static_cast<uint32_t>(corner.normal) * 0x165667B19E3779F9ull + (hash >> 32);
+		return static_cast<size_t>(hash ^ (hash >> 31));
+	}
+
+	XMVECTOR AnyPerpendicular(FXMVECTOR normal)
+	{
+		XMVECTOR axis = fabsf(XMVectorGetX(normal)) < 0.9f ? XMVectorSet(1.f, 0.f, 0.f, 0.f) : XMVectorSet(0.f, 1.f, 0.f, 0.f);
+		return XMVector3Normalize(XMVector3Cross(normal, axis));
+	}
+
+	/**
+	 * @brief Per vertex sum of the face tangents and bitangents from the UV gradients, made orthonormal to the normal.
+	 */
+	void ComputeTangents(ObjMesh& mesh)
+	{
+		std::vector<XMFLOAT3> tangents(mesh.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
+		std::vector<XMFLOAT3> bitangents(mesh.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			const Vertex& v0 = mesh.vertices[mesh.indices[i]];
+			const Vertex& v1 = mesh.vertices[mesh.indices[i + 1]];
+			const Vertex& v2 = mesh.vertices[mesh.indices[i + 2]];
+			XMVECTOR edge1 = XMVectorSubtract(XMLoadFloat3(&v1.position), XMLoadFloat3(&v0.position));
+			XMVECTOR edge2 = XMVectorSubtract(XMLoadFloat3(&v2.position), XMLoadFloat3(&v0.position));
+			float du1 = v1.UV.x - v0.UV.x;
+			float dv1 = v1.UV.y - v0.UV.y;
+			float du2 = v2.UV.x - v0.UV.x;
+			float dv2 = v2.UV.y - v0.UV.y;
+			float determinant = du1 * dv2 - du2 * dv1;
+			if (determinant == 0.f)
+			{
+				continue;
+			}
+			//Only the direction matters, the length weights larger faces more.
+			float sign = determinant < 0.f ? -1.f : 1.f;
+			XMVECTOR tangent = XMVectorScale(XMVectorSubtract(XMVectorScale(edge1, dv2), XMVectorScale(edge2, dv1)), sign);
+			XMVECTOR bitangent = XMVectorScale(XMVectorSubtract(XMVectorScale(edge2, du1), XMVectorScale(edge1, du2)), sign);
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				UINT vertex = mesh.indices[i + corner];
+				XMStoreFloat3(&tangents[vertex], XMVectorAdd(XMLoadFloat3(&tangents[vertex]), tangent));
+				XMStoreFloat3(&bitangents[vertex], XMVectorAdd(XMLoadFloat3(&bitangents[vertex]), bitangent));
+			}
+		}
+
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			Vertex& vertex = mesh.vertices[i];
+			XMVECTOR normal = XMLoadFloat3(&vertex.normal);
+			XMVECTOR tangent = XMLoadFloat3(&tangents[i]);
+			tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+			tangent = XMVectorGetX(XMVector3LengthSq(tangent)) > 1e-12f ? XMVector3Normalize(tangent) : AnyPerpendicular(normal);
+			XMVECTOR bitangent = XMLoadFloat3(&bitangents[i]);
+			XMVECTOR crossed = XMVector3Cross(normal, tangent);
+			//Mirrored UVs keep their handedness.
+			bitangent = XMVectorGetX(XMVector3Dot(crossed, bitangent)) < 0.f ? XMVectorNegate(crossed) : crossed;
+			XMStoreFloat3(&vertex.tangent, tangent);
+			XMStoreFloat3(&vertex.biTangent, bitangent);
+		}
+	}
+
+	size_t HashCell(int32_t x, int32_t y, int32_t z)
+	{
+		return (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+	}
+
+	int32_t ToCell(float coordinate, float origin, float inverseCellSize)
+	{
+		return static_cast<int32_t>(std::min(floorf((coordinate - origin) * inverseCellSize), 1e9f));
+	}
+
+	//Unit vector from one position to another, rounded as aiVector3D::Normalize rounds it.
+	XMFLOAT3 Direction(const XMFLOAT3& from, const XMFLOAT3& to)
+	{
+		XMFLOAT3 direction(to.x - from.x, to.y - from.y, to.z - from.z);
+		float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+		if (length != 0.f)
+		{
+			float inverseLength = 1.f / length;
+			direction = XMFLOAT3(direction.x * inverseLength, direction.y * inverseLength, direction.z * inverseLength);
+		}
+		return direction;
+	}
+
+	float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	/**
+	 * @brief Split a quad along the diagonal aiProcess_Triangulate picks, which decides the face normals of a curved quad.
+	 * @detail Assimp reverses the corners for ConvertToLeftHanded first, then fans from the corner whose angles either
+	 * side of the diagonal sum past pi, or from the first when none does. The test is done in floats as Assimp does it,
+	 * so the quads it finds concave by rounding alone split the same way.
+	 * @param triangles The two triangles ParseFace fanned from the first corner, rewritten in place.
+	 */
+	void SplitQuad(ObjCorner* triangles, const std::vector<XMFLOAT3>& positions)
+	{
+		ObjCorner quad[4] = { triangles[5], triangles[2], triangles[1], triangles[0] };
+		for (ObjCorner& corner : quad)
+		{
+			//Wherever the first corner ends up, it must not start another quad.
+			corner.flags &= ~(QuadStart | SharedCorner);
+		}
+		for (const ObjCorner& corner : quad)
+		{
+			if (corner.position < 0 || static_cast<size_t>(corner.position) >= positions.size())
+			{
+				return;
+			}
+		}
+
+		int start = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const XMFLOAT3& position = positions[quad[i].position];
+			XMFLOAT3 left = Direction(position, positions[quad[(i + 3) % 4].position]);
+			XMFLOAT3 diagonal = Direction(position, positions[quad[(i + 2) % 4].position]);
+			XMFLOAT3 right = Direction(position, positions[quad[(i + 1) % 4].position]);
+			//The angles sum past pi exactly when the cosines sum below 0, so acos only settles the near ties.
+			float leftCosine = Dot(left, diagonal);
+			float rightCosine = Dot(right, diagonal);
+			float cosineSum = leftCosine + rightCosine;
+			if (cosineSum < -1e-3f || (cosineSum <= 1e-3f && acosf(leftCosine) + acosf(rightCosine) > 3.1415926538f))
+			{
+				start = i;
+				break;
+			}
+		}
+		//Triangles stay in the file's winding, BuildMesh flips them with the rest.
+		triangles[0] = quad[(start + 2) % 4];
+		triangles[1] = quad[(start + 1) % 4];
+		triangles[2] = quad[start];
+		triangles[3] = quad[(start + 3) % 4];
+		triangles[4] = quad[(start + 2) % 4];
+		triangles[5] = quad[start];
+		triangles[0].flags |= SharedCorner;
+		triangles[2].flags |= SharedCorner;
+	}
+
+	/**
+	 * @brief Normals as aiProcess_GenSmoothNormals leaves them with its default settings.
+	 * @detail Every polygon corner adds the unit normal of the last triangle on it, and each vertex takes the sum over
+	 * the corners within 1e-4 of the bounds diagonal of it, so vertices split by UVs or by repeated v lines shade
+	 * smoothly across the seam. The first vertex of a group names it, as Assimp walks its vertices. The default
+	 * smoothing angle of 175 degrees makes Assimp skip the angle test, so there is none here either.
+	 * @param corners Those of the triangles of mesh, in the file's winding.
+	 */
+	void GenerateSmoothNormals(ObjMesh& mesh, const ObjCorner* corners)
+	{
+		std::vector<XMFLOAT3> cornerNormals(mesh.vertices.size(), XMFLOAT3(0.f, 0.f, 0.f));
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&mesh.vertices[mesh.indices[i]].position);
+			XMVECTOR p1 = XMLoadFloat3(&mesh.vertices[mesh.indices[i + 1]].position);
+			XMVECTOR p2 = XMLoadFloat3(&mesh.vertices[mesh.indices[i + 2]].position);
+			XMVECTOR faceNormal = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				//The winding was flipped by swapping the last two corners.
+				if (corners[i + (corner == 0 ? 0 : 3 - corner)].flags & SharedCorner)
+				{
+					continue;
+				}
+				XMFLOAT3& sum = cornerNormals[mesh.indices[i + corner]];
+				XMStoreFloat3(&sum, XMVectorAdd(XMLoadFloat3(&sum), faceNormal));
+			}
+		}
+
+		MeshBounds bounds = MeshBounds::FromVertices(mesh.vertices);
+		const float origin[3] = { bounds.boundsMin.x, bounds.boundsMin.y, bounds.boundsMin.z };
+		float diagonal = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&bounds.boundsMax), XMLoadFloat3(&bounds.boundsMin))));
+		float epsilon = 1e-4f * diagonal;
+		float epsilonSquared = epsilon * epsilon;
+		//About one vertex per cell across a surface, so most searches stay in the cell of the vertex.
+		float cellSize = std::max(epsilon * 2.f, diagonal / sqrtf(static_cast<float>(mesh.vertices.size())));
+		float inverseCellSize = cellSize > 0.f ? 1.f / cellSize : 0.f;
+
+		//Positions bucketed by the slot of their cell, each bucket contiguous so a search reads one run of memory.
+		//Cells that share a slot share the bucket, the distance test tells them apart.
+		size_t capacity = 16;
+		while (capacity < mesh.vertices.size())
+		{
+			capacity *= 2;
+		}
+		std::vector<UINT> vertexSlots(mesh.vertices.size());
+		std::vector<UINT> bucketStarts(capacity + 1, 0);
+		for (UINT i = 0; i < mesh.vertices.size(); ++i)
+		{
+			const XMFLOAT3& position = mesh.vertices[i].position;
+			vertexSlots[i] = static_cast<UINT>(HashCell(ToCell(position.x, origin[0], inverseCellSize), ToCell(position.y, origin[1], inverseCellSize),
+				ToCell(position.z, origin[2], inverseCellSize)) & (capacity - 1));
+			++bucketStarts[vertexSlots[i] + 1];
+		}
+		for (size_t slot = 0; slot < capacity; ++slot)
+		{
+			bucketStarts[slot + 1] += bucketStarts[slot];
+		}
+		std::vector<XMFLOAT3> bucketPositions(mesh.vertices.size());
+		std::vector<UINT> bucketVertices(mesh.vertices.size());
+		{
+			std::vector<UINT> bucketEnds(bucketStarts.begin(), bucketStarts.end() - 1);
+			for (UINT i = 0; i < mesh.vertices.size(); ++i)
+			{
+				UINT entry = bucketEnds[vertexSlots[i]]++;
+				bucketPositions[entry] = mesh.vertices[i].position;
+				bucketVertices[entry] = i;
+			}
+		}
+
+		std::vector<char> smoothed(mesh.vertices.size(), 0);
+		std::vector<UINT> found;
+		for (UINT i = 0; i < mesh.vertices.size(); ++i)
+		{
+			if (smoothed[i])
+			{
+				continue;
+			}
+			const XMFLOAT3& position = mesh.vertices[i].position;
+			const float coordinates[3] = { position.x, position.y, position.z };
+			int32_t firstCell[3];
+			int32_t lastCell[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				firstCell[axis] = ToCell(coordinates[axis] - epsilon, origin[axis], inverseCellSize);
+				lastCell[axis] = ToCell(coordinates[axis] + epsilon, origin[axis], inverseCellSize);
+			}
+
+			XMVECTOR normal = XMVectorZero();
+			found.clear();
+			UINT searchedSlots[27];
+			int searchedSlotCount = 0;
+			for (int32_t x = firstCell[0]; x <= lastCell[0]; ++x)
+			{
+				for (int32_t y = firstCell[1]; y <= lastCell[1]; ++y)
+				{
+					for (int32_t z = firstCell[2]; z <= lastCell[2]; ++z)
+					{
+						UINT slot = static_cast<UINT>(HashCell(x, y, z) & (capacity - 1));
+						if (std::find(searchedSlots, searchedSlots + searchedSlotCount, slot) != searchedSlots + searchedSlotCount)
+						{
+							continue;
+						}
+						searchedSlots[searchedSlotCount++] = slot;
+						for (UINT entry = bucketStarts[slot]; entry < bucketStarts[slot + 1]; ++entry)
+						{
+							const XMFLOAT3& otherPosition = bucketPositions[entry];
+							float dx = otherPosition.x - position.x;
+							float dy = otherPosition.y - position.y;
+							float dz = otherPosition.z - position.z;
+							if (dx * dx + dy * dy + dz * dz <= epsilonSquared)
+							{
+								UINT other = bucketVertices[entry];
+								found.push_back(other);
+								normal = XMVectorAdd(normal, XMLoadFloat3(&cornerNormals[other]));
+							}
+						}
+					}
+				}
+			}
+			normal = XMVector3Normalize(normal);
+			for (UINT other : found)
+			{
+				XMStoreFloat3(&mesh.vertices[other].normal, normal);
+				smoothed[other] = 1;
+			}
+		}
+	}
+
+	/**
+	 * @brief Weld the corners of triangles [firstTriangle, lastTriangle) into a mesh.
+	 */
+	bool BuildMesh(std::vector<ObjCorner>& corners, size_t firstTriangle, size_t lastTriangle, const std::vector<XMFLOAT3>& positions,
+		const std::vector<XMFLOAT2>& uvs, const std::vector<XMFLOAT3>& normals, ObjMesh& mesh)
+	{
+		for (size_t triangle = firstTriangle; triangle < lastTriangle; ++triangle)
+		{
+			if (corners[triangle * 3].flags & QuadStart)
+			{
+				SplitQuad(&corners[triangle * 3], positions);
+			}
+		}
+
+		size_t cornerCount = (lastTriangle - firstTriangle) * 3;
+		size_t capacity = 16;
+		while (capacity < cornerCount * 2)
+		{
+			capacity *= 2;
+		}
+		//Open addressing over the index triples, each slot holds a vertex and the corner is read back from it.
+		std::vector<UINT> slots(capacity, EmptySlot);
+		std::vector<ObjCorner> vertexCorners;
+		vertexCorners.reserve(cornerCount / 2);
+		mesh.indices.resize(cornerCount);
+
+		bool hasNormals = true;
+		bool hasUVs = false;
+		for (size_t i = 0; i < cornerCount; ++i)
+		{
+			const ObjCorner& corner = corners[firstTriangle * 3 + i];
+			if (corner.position < 0 || static_cast<size_t>(corner.position) >= positions.size() ||
+				(corner.uv != Missing && (corner.uv < 0 || static_cast<size_t>(corner.uv) >= uvs.size())) ||
+				(corner.normal != Missing && (corner.normal < 0 || static_cast<size_t>(corner.normal) >= normals.size())))
+			{
+				return false;
+			}
+			hasNormals &= corner.normal != Missing;
+			hasUVs |= corner.uv != Missing;
+
+			size_t slot = HashCorner(corner) & (capacity - 1);
+			while (slots[slot] != EmptySlot)
+			{
+				const ObjCorner& other = vertexCorners[slots[slot]];
+				if (other.position == corner.position && other.uv == corner.uv && other.normal == corner.normal)
+				{
+					break;
+				}
+				slot = (slot + 1) & (capacity - 1);
+			}
+			if (slots[slot] == EmptySlot)
+			{
+				slots[slot] = static_cast<UINT>(vertexCorners.size());
+				vertexCorners.push_back(corner);
+			}
+			//The winding flips with the handedness.
+			size_t triangleCorner = i % 3;
+			size_t target = triangleCorner == 0 ? i : (triangleCorner == 1 ? i + 1 : i - 1);
+			mesh.indices[target] = slots[slot];
+		}
+
+		//Right handed to left handed, as aiProcess_ConvertToLeftHanded: z negated and V flipped.
+		mesh.vertices.resize(vertexCorners.size());
+		for (size_t i = 0; i < vertexCorners.size(); ++i)
+		{
+			const ObjCorner& corner = vertexCorners[i];
+			Vertex& vertex = mesh.vertices[i];
+			vertex = {};
+			const XMFLOAT3& position = positions[corner.position];
+			vertex.position = XMFLOAT3(position.x, position.y, -position.z);
+			if (corner.normal != Missing)
+			{
+				const XMFLOAT3& normal = normals[corner.normal];
+				vertex.normal = XMFLOAT3(normal.x, normal.y, -normal.z);
+			}
+			if (corner.uv != Missing)
+			{
+				vertex.UV = XMFLOAT2(uvs[corner.uv].x, 1.f - uvs[corner.uv].y);
+			}
+		}
+
+		if (hasNormals == false)
+		{
+			GenerateSmoothNormals(mesh, &corners[firstTriangle * 3]);
+		}
+		if (hasUVs)
+		{
+			ComputeTangents(mesh);
+		}
+		return true;
+	}
+}
+
+bool ObjParser::IsObjFile(const std::string& filePath)
+{
+	size_t dot = filePath.find_last_of('.');
+	if (dot == std::string::npos || filePath.size() - dot != 4)
+	{
+		return false;
+	}
+	std::string extension = filePath.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+	return extension == "obj";
+}
+
+bool ObjParser::Load(const std::string& filePath, std::vector<ObjMesh>& meshes, ThreadPool* threadPool, ObjParseStats* stats)
+{
+	MappedFile file;
+	if (file.Open(filePath) == false)
+	{
+		return false;
+	}
+	return Parse(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), meshes, threadPool, stats);
+}
+
+bool ObjParser::Parse(const char* text, size_t size, std::vector<ObjMesh>& meshes, ThreadPool* threadPool, ObjParseStats* stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//A few chunks per worker, so one holding the dense part of a file does not leave the others idle.
+	int chunkCount = 1;
+	if (threadPool != nullptr)
+	{
+		size_t maxChunks = std::max<size_t>(1, static_cast<size_t>(threadPool->GetThreadCount()) * 4);
+		chunkCount = static_cast<int>(std::min(maxChunks, std::max<size_t>(1, size / MinChunkBytes)));
+	}
+	std::vector<const char*> bounds(chunkCount + 1);
+	bounds[0] = text;
+	bounds[chunkCount] = text + size;
+	for (int i = 1; i < chunkCount; ++i)
+	{
+		const char* split = std::max(text + size * i / chunkCount, bounds[i - 1]);
+		const char* lineEnd = static_cast<const char*>(memchr(split, '\n', text + size - split));
+		bounds[i] = lineEnd ? lineEnd + 1 : text + size;
+	}
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	std::vector<char> chunkValid(chunkCount, 1);
+	auto parseRange = [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				chunkValid[i] = ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+			}
+		};
+	if (threadPool == nullptr || chunkCount == 1)
+	{
+		parseRange(0, chunkCount);
+	}
+	else
+	{
+		threadPool->ParallelFor(chunkCount, 1, parseRange);
+	}
+	if (std::find(chunkValid.begin(), chunkValid.end(), 0) != chunkValid.end())
+	{
+		return false;
+	}
+
+	size_t positionCount = 0;
+	size_t uvCount = 0;
+	size_t normalCount = 0;
+	size_t cornerCount = 0;
+	for (const ObjChunk& chunk : chunks)
+	{
+		positionCount += chunk.positions.size();
+		uvCount += chunk.uvs.size();
+		normalCount += chunk.normals.size();
+		cornerCount += chunk.corners.size();
+	}
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<XMFLOAT3> normals;
+	std::vector<ObjCorner> corners;
+	std::vector<size_t> groupStarts = { 0 };
+	positions.reserve(positionCount);
+	uvs.reserve(uvCount);
+	normals.reserve(normalCount);
+	corners.reserve(cornerCount);
+	for (ObjChunk& chunk : chunks)
+	{
+		if (chunk.hasRelative)
+		{
+			int32_t bases[3] = { static_cast<int32_t>(positions.size()), static_cast<int32_t>(uvs.size()), static_cast<int32_t>(normals.size()) };
+			for (ObjCorner& corner : chunk.corners)
+			{
+				int32_t* indices[3] = { &corner.position, &corner.uv, &corner.normal };
+				for (int attribute = 0; attribute < 3; ++attribute)
+				{
+					if (corner.flags & (RelativePosition << attribute))
+					{
+						*indices[attribute] += bases[attribute];
+					}
+				}
+			}
+		}
+		for (size_t groupStart : chunk.groupStarts)
+		{
+			groupStarts.push_back(corners.size() / 3 + groupStart);
+		}
+		Append(positions, chunk.positions);
+		Append(uvs, chunk.uvs);
+		Append(normals, chunk.normals);
+		Append(corners, chunk.corners);
+		chunk = ObjChunk();
+	}
+	std::vector<ObjChunk>().swap(chunks);
+	size_t triangleCount = corners.size() / 3;
+	groupStarts.push_back(triangleCount);
+	groupStarts.erase(std::unique(groupStarts.begin(), groupStarts.end()), groupStarts.end());
+	auto parsed = std::chrono::high_resolution_clock::now();
+
+	int meshCount = static_cast<int>(groupStarts.size()) - 1;
+	std::vector<ObjMesh> built(meshCount);
+	std::vector<char> meshValid(meshCount, 1);
+	auto buildRange = [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				meshValid[i] = BuildMesh(corners, groupStarts[i], groupStarts[i + 1], positions, uvs, normals, built[i]);
+			}
+		};
+	if (threadPool == nullptr)
+	{
+		buildRange(0, meshCount);
+	}
+	else
+	{
+		threadPool->ParallelFor(meshCount, 1, buildRange);
+	}
+	if (std::find(meshValid.begin(), meshValid.end(), 0) != meshValid.end())
+	{
+		return false;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	if (stats)
+	{
+		stats->bytes = size;
+		stats->chunkCount = chunkCount;
+		stats->triangleCount = triangleCount;
+		stats->cornerCount = corners.size();
+		stats->vertexCount = 0;
+		for (const ObjMesh& mesh : built)
+		{
+			stats->vertexCount += mesh.vertices.size();
+		}
+		stats->parseMilliseconds = std::chrono::duration<double, std::milli>(parsed - start).count();
+		stats->buildMilliseconds = std::chrono::duration<double, std::milli>(end - parsed).count();
+	}
+	for (ObjMesh& mesh : built)
+	{
+		meshes.push_back(std::move(mesh));
+	}
+	return true;
+}
+
+void ObjParser::Report(const std::string& assetName, const ObjParseStats& stats)
+{
+	char text[512];
+	snprintf(text, sizeof(text), "***Parsed %s: %.2f MB in %d chunks, %.2f + %.2f ms (%.1f MB/s), %zu triangles, %zu corners -> %zu vertices\n",
+		assetName.c_str(), stats.bytes / (1024.0 * 1024.0), stats.chunkCount, stats.parseMilliseconds, stats.buildMilliseconds,
+		stats.GetMegabytesPerSecond(), stats.triangleCount, stats.cornerCount, stats.vertexCount);
+	OutputDebugStringA(text);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+
+class ThreadPool;
+
+/**
+ * @brief One object, group or material run of an .obj file, indexed.
+ */
+struct ObjMesh
+{
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+};
+
+struct ObjParseStats
+{
+	size_t bytes = 0;
+	int chunkCount = 0;
+	size_t triangleCount = 0;
+	//Face corners, the vertices of an import that does not weld.
+	size_t cornerCount = 0;
+	size_t vertexCount = 0;
+	double parseMilliseconds = 0.0;
+	double buildMilliseconds = 0.0;
+
+	double GetMegabytesPerSecond() const
+	{
+		double milliseconds = parseMilliseconds + buildMilliseconds;
+		return milliseconds > 0.0 ? bytes / (milliseconds * 1000.0) : 0.0;
+	}
+};
+
+/**
+ * @brief Wavefront .obj reader for what the generic importer spends most of the startup on.
+ * @detail The file is mapped and cut into chunks at line ends, which are parsed in parallel with a float parser that
+ * skips the locale and strtod. The chunks are then joined, and each mesh turns its face corners into Vertex through
+ * a hash table of their position, UV and normal indices, so a corner shared between faces is a single vertex.
+ * The meshes come out as Model::ImportFlags would leave them: triangulated, converted to left handed with V flipped,
+ * and with tangents from the UVs. Quads split along the diagonal Assimp picks, larger polygons are fanned where Assimp
+ * clips ears, which only changes the surface of polygons that are not planar and convex.
+ * Where the file has no normals they are smoothed over positions as aiProcess_GenSmoothNormals groups them, but face
+ * out of counter-clockwise faces. Assimp computes them on the already mirrored positions in the reversed winding,
+ * which turns them inwards.
+ * Materials, lines and points are skipped.
+ */
+class ObjParser
+{
+public:
+	//Smallest chunk worth a job of its own.
+	static constexpr size_t MinChunkBytes = 256 * 1024;
+
+	static bool IsObjFile(const std::string& filePath);
+	/**
+	 * @brief Returns false when the file is missing or malformed, leaving meshes untouched.
+	 */
+	static bool Load(const std::string& filePath, std::vector<ObjMesh>& meshes, ThreadPool* threadPool = nullptr, ObjParseStats* stats = nullptr);
+	/**
+	 * @brief Load from text in memory.
+	 */
+	static bool Parse(const char* text, size_t size, std::vector<ObjMesh>& meshes, ThreadPool* threadPool = nullptr, ObjParseStats* stats = nullptr);
+	static void Report(const std::string& assetName, const ObjParseStats& stats);
+};
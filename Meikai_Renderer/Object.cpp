@@ -2,6 +2,7 @@
 #include "Model.h"
 #include "CommandList.h"
 #include "MaterialData.h"
+#include "MeshletCuller.h"
 
 
 Object::Object(std::shared_ptr<Model> model, XMFLOAT3 position, XMFLOAT3 albedo, float metalic, float roughness,  XMFLOAT3 scale)
@@ -34,13 +35,29 @@ XMMATRIX Object::GetWorldMat() const
 	return XMMatrixMultiply(translationMat, scaleMat);
 }
 
+MeshBounds Object::GetWorldBounds() const
+{
+	return mModel->GetBounds().Transform(GetWorldMat());
+}
+
 void Object::Draw(CommandList& commandList)
 {
 	SetWorldMatrix(commandList);
 	SetMaterial(commandList);
 	for (auto& mesh : mModel->mMeshes)
 	{
-		mesh.Draw(commandList);
+		mesh.Draw(commandList, mLod);
+	}
+}
+
+void Object::Draw(CommandList& commandList, MeshletCuller& culler)
+{
+	SetWorldMatrix(commandList);
+	SetMaterial(commandList);
+	culler.SetObject(GetWorldMat());
+	for (auto& mesh : mModel->mMeshes)
+	{
+		mesh.Draw(commandList, culler, mLod);
 	}
 }
 
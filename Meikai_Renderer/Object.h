@@ -4,10 +4,13 @@
 #include <wrl.h>
 #include <memory>
 
+#include "MeshBounds.h"
+
 using namespace Microsoft::WRL;
 using namespace DirectX;
 class CommandList;
 class Model;
+class MeshletCuller;
 
 class Object
 {
@@ -18,14 +21,28 @@ public:
 public:
 	virtual void Update(float dt);
 	virtual void Draw(CommandList& commandList);
+	/**
+	 * @brief Draw the meshlets of the model that pass culler.
+	 */
+	void Draw(CommandList& commandList, MeshletCuller& culler);
 	void DrawWithoutWorld(CommandList& commandList);
 	XMMATRIX GetWorldMat() const;
+	/**
+	 * @brief Bounds of the model moved to world space by GetWorldMat.
+	 */
+	MeshBounds GetWorldBounds() const;
+	std::shared_ptr<Model> GetModel() const { return mModel; }
 	void SetPosition(XMVECTOR newPos);
 	void SetScale(XMVECTOR newScale);
 	void SetAlbedo(XMFLOAT3 newAlbedo);
 	void SetMetalic(float newMetalic);
 	void SetRoughness(float newRoughness);
 	void SetModel(std::shared_ptr<Model> model);
+	/**
+	 * @brief Level of detail Draw uses, see LodSelector.
+	 */
+	void SetLod(int lod) { mLod = lod; }
+	int GetLod() const { return mLod; }
 
 protected:
 	void SetWorldMatrix(CommandList& commandList);
@@ -34,6 +51,7 @@ protected:
 	std::shared_ptr<Model> mModel = nullptr;
 	XMFLOAT3 mPosition;
 	XMFLOAT3 mScale;
+	int mLod = 0;
 
 	XMFLOAT3 mAlbedo;
 	float mMetalic;
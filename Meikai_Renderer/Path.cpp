@@ -0,0 +1,439 @@
+#include "Path.h"
+#include "ArcLengthTable.h"
+#include "ArcLengthQuadrature.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	//Frame count of a segment grows until neighbouring stations turn less than MaxFrameAngle.
+	constexpr int MinFramesPerSegment = 8;
+	constexpr int MaxFramesPerSegment = 64;
+	constexpr float MaxFrameAngle = 0.035f;
+	constexpr float DegenerateLengthSquared = 1e-12f;
+	constexpr float TwistEpsilon = 1e-5f;
+
+	XMVECTOR OrthogonalNormal(XMVECTOR normal, XMVECTOR tangent)
+	{
+		return XMVector3Normalize(normal - XMVector3Dot(normal, tangent) * tangent);
+	}
+}
+
+Path::Path(const std::vector<XMVECTOR>& controlPoints, ArcLengthMethod arcLengthMethod)
+	:mControlPoints(controlPoints)
+{
+	CalcSubPoints();
+	mSpline.Build(mControlPoints, mSubPoints);
+	if (arcLengthMethod == ArcLengthMethod::GaussLegendre)
+	{
+		mArcLength = std::make_unique<ArcLengthQuadrature>();
+	}
+	else
+	{
+		mArcLength = std::make_unique<ArcLengthTable>(0.000001f);
+	}
+	mArcLength->Build(mSpline);
+
+	mStationOffsets.assign(1, 0);
+	SpliceStations(0, 0, GetSegmentCount());
+	BuildSegmentBvh();
+}
+
+void Path::Sample(float normalizedArcLength, XMVECTOR& position, XMVECTOR& orientation) const
+{
+	float localArcLength;
+	int segment = mArcLength->FindSegment(std::clamp(normalizedArcLength, 0.f, 1.f), localArcLength);
+	SampleSegment(segment, localArcLength, position, orientation);
+}
+
+void Path::SampleBatch(const float* normalizedArcLengths, XMFLOAT3* outPositions, XMFLOAT4* outOrientations, size_t count) const
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR position;
+		XMVECTOR orientation;
+		Sample(normalizedArcLengths[i], position, orientation);
+		XMStoreFloat3(&outPositions[i], position);
+		XMStoreFloat4(&outOrientations[i], orientation);
+	}
+}
+
+PathProjection Path::Project(XMVECTOR point) const
+{
+	return FindClosest(point, -1, 0.f, FLT_MAX);
+}
+
+void Path::ProjectBatch(const XMFLOAT3* points, PathProjection* outProjections, size_t count) const
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR point = XMLoadFloat3(&points[i]);
+		if (i == 0)
+		{
+			outProjections[i] = FindClosest(point, -1, 0.f, FLT_MAX);
+			continue;
+		}
+
+		//The previous result lies on the curve, so its distance to this point bounds the search from above.
+		const PathProjection& previous = outProjections[i - 1];
+		float distanceSquared = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&previous.position) - point));
+		outProjections[i] = FindClosest(point, previous.segment, previous.localParam, distanceSquared);
+	}
+}
+
+PathProjection Path::FindClosest(XMVECTOR point, int segment, float localParam, float distanceSquared) const
+{
+	//The hint is kept unless some segment beats it.
+	mSegmentBvh.FindNearest(point, distanceSquared, [&](int candidate, float bound)
+	{
+		float candidateDistanceSquared;
+		float candidateParam = mSpline.FindClosestParam(candidate, point, candidateDistanceSquared);
+		if (candidateDistanceSquared < bound)
+		{
+			segment = candidate;
+			localParam = candidateParam;
+			return candidateDistanceSquared;
+		}
+		return bound;
+	});
+	assert(segment >= 0);
+
+	PathProjection projection;
+	XMVECTOR position = mSpline.Evaluate(segment, localParam);
+	XMStoreFloat3(&projection.position, position);
+	projection.distance = XMVectorGetX(XMVector3Length(position - point));
+	float arcLength = mArcLength->GetSegmentStartArcLength(segment) + mArcLength->LocalParamToArcLength(segment, localParam);
+	projection.normalizedArcLength = std::clamp(arcLength / GetWorldArcLength(), 0.f, 1.f);
+	projection.segment = segment;
+	projection.localParam = localParam;
+	return projection;
+}
+
+void Path::BuildSegmentBvh()
+{
+	//A cubic bezier stays inside the hull of its four points, so their box bounds the segment.
+	int segmentCount = GetSegmentCount();
+	mBuildBoundsMins.resize(segmentCount);
+	mBuildBoundsMaxs.resize(segmentCount);
+	for (int segment = 0; segment < segmentCount; ++segment)
+	{
+		XMVECTOR p_0 = mControlPoints[segment];
+		XMVECTOR p_1 = mSubPoints[2 * segment];
+		XMVECTOR p_2 = mSubPoints[2 * segment + 1];
+		XMVECTOR p_3 = mControlPoints[segment + 1];
+		XMStoreFloat3(&mBuildBoundsMins[segment], XMVectorMin(XMVectorMin(p_0, p_1), XMVectorMin(p_2, p_3)));
+		XMStoreFloat3(&mBuildBoundsMaxs[segment], XMVectorMax(XMVectorMax(p_0, p_1), XMVectorMax(p_2, p_3)));
+	}
+	mSegmentBvh.Build(mBuildBoundsMins, mBuildBoundsMaxs);
+}
+
+void Path::SampleSegment(int segment, float localArcLength, XMVECTOR& position, XMVECTOR& orientation) const
+{
+	int frameCount = mStationOffsets[segment + 1] - mStationOffsets[segment] - 1;
+	float spacing = mArcLength->GetSegmentArcLength(segment) / frameCount;
+	float scaled = spacing > 0.f ? std::clamp(localArcLength / spacing, 0.f, static_cast<float>(frameCount)) : 0.f;
+	int frame = std::min(static_cast<int>(scaled), frameCount - 1);
+	float t = scaled - frame;
+	int station = mStationOffsets[segment] + frame;
+
+	//Cubic hermite keeps positions on the curve between stations. Neighbouring frames turn by a few degrees, so nlerp is enough.
+	XMVECTOR tangentScale = XMVectorReplicate(spacing);
+	position = XMVectorHermite(XMLoadFloat3(&mStationPositions[station]), XMLoadFloat3(&mStationTangents[station]) * tangentScale,
+		XMLoadFloat3(&mStationPositions[station + 1]), XMLoadFloat3(&mStationTangents[station + 1]) * tangentScale, t);
+
+	XMVECTOR q_0 = XMLoadFloat4(&mStationOrientations[station]);
+	XMVECTOR q_1 = XMLoadFloat4(&mStationOrientations[station + 1]);
+	if (XMVectorGetX(XMQuaternionDot(q_0, q_1)) < 0.f)
+	{
+		q_1 = -q_1;
+	}
+	orientation = XMQuaternionNormalize(XMVectorLerp(q_0, q_1, t));
+}
+
+void Path::SpliceStations(int firstSegment, int oldSegmentCount, int newSegmentCount)
+{
+	//Build the new segments' stations aside, then swap them in place of the old range.
+	mBuildPositions.clear();
+	mBuildTangents.clear();
+	mBuildOffsets.clear();
+	for (int segment = firstSegment; segment < firstSegment + newSegmentCount; ++segment)
+	{
+		mBuildOffsets.push_back(static_cast<int>(mBuildPositions.size()));
+		BuildSegmentStations(segment);
+	}
+
+	int stationBegin = mStationOffsets[firstSegment];
+	int stationEnd = mStationOffsets[firstSegment + oldSegmentCount];
+	int stationDelta = static_cast<int>(mBuildPositions.size()) - (stationEnd - stationBegin);
+
+	mStationPositions.erase(mStationPositions.begin() + stationBegin, mStationPositions.begin() + stationEnd);
+	mStationPositions.insert(mStationPositions.begin() + stationBegin, mBuildPositions.begin(), mBuildPositions.end());
+	mStationTangents.erase(mStationTangents.begin() + stationBegin, mStationTangents.begin() + stationEnd);
+	mStationTangents.insert(mStationTangents.begin() + stationBegin, mBuildTangents.begin(), mBuildTangents.end());
+	//Keep the old frames behind the range, so transport can stop once it reproduces them.
+	mStationNormals.erase(mStationNormals.begin() + stationBegin, mStationNormals.begin() + stationEnd);
+	mStationNormals.insert(mStationNormals.begin() + stationBegin, mBuildPositions.size(), XMFLOAT3(0.f, 0.f, 0.f));
+	mStationOrientations.erase(mStationOrientations.begin() + stationBegin, mStationOrientations.begin() + stationEnd);
+	mStationOrientations.insert(mStationOrientations.begin() + stationBegin, mBuildPositions.size(), XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+
+	auto offsetItor = mStationOffsets.begin() + firstSegment;
+	offsetItor = mStationOffsets.erase(offsetItor, offsetItor + oldSegmentCount);
+	for (int& offset : mBuildOffsets)
+	{
+		offset += stationBegin;
+	}
+	offsetItor = mStationOffsets.insert(offsetItor, mBuildOffsets.begin(), mBuildOffsets.end());
+	for (auto itor = offsetItor + newSegmentCount; itor != mStationOffsets.end(); ++itor)
+	{
+		*itor += stationDelta;
+	}
+
+	TransportFrames(firstSegment, firstSegment + newSegmentCount);
+}
+
+void Path::BuildSegmentStations(int segment)
+{
+	size_t first = mBuildPositions.size();
+	int frameCount = MinFramesPerSegment;
+	while (true)
+	{
+		mBuildPositions.resize(first + frameCount + 1);
+		mBuildTangents.resize(first + frameCount + 1);
+		mBuildSegments.assign(frameCount + 1, segment);
+		mBuildParams.resize(frameCount + 1);
+
+		float spacing = mArcLength->GetSegmentArcLength(segment) / frameCount;
+		for (int frame = 0; frame <= frameCount; ++frame)
+		{
+			mBuildParams[frame] = mArcLength->LocalArcLengthToParam(segment, frame * spacing);
+		}
+		mSpline.EvaluateBatch(mBuildSegments.data(), mBuildParams.data(), &mBuildPositions[first], frameCount + 1);
+		mSpline.EvaluateDerivativeBatch(mBuildSegments.data(), mBuildParams.data(), &mBuildTangents[first], frameCount + 1);
+
+		float maxAngle = 0.f;
+		XMVECTOR previous = XMVector3Normalize(XMLoadFloat3(&mBuildTangents[first]));
+		XMStoreFloat3(&mBuildTangents[first], previous);
+		for (int frame = 1; frame <= frameCount; ++frame)
+		{
+			XMVECTOR tangent = XMVector3Normalize(XMLoadFloat3(&mBuildTangents[first + frame]));
+			XMStoreFloat3(&mBuildTangents[first + frame], tangent);
+			maxAngle = std::max(maxAngle, XMVectorGetX(XMVector3AngleBetweenNormals(previous, tangent)));
+			previous = tangent;
+		}
+
+		//Turning is rarely even along a segment, so the estimate may take a few rounds.
+		if (maxAngle <= MaxFrameAngle || frameCount == MaxFramesPerSegment)
+		{
+			return;
+		}
+		int needed = static_cast<int>(ceilf(frameCount * maxAngle / MaxFrameAngle));
+		frameCount = std::min(std::max(needed, frameCount * 2), MaxFramesPerSegment);
+	}
+}
+
+void Path::TransportFrames(int firstSegment, int endSegment)
+{
+	int bakeBegin = mStationOffsets[firstSegment];
+	int unchangedBegin = mStationOffsets[endSegment];
+	int first = bakeBegin;
+	if (first == 0)
+	{
+		//Start from world up, or world x when the path starts vertical.
+		XMVECTOR tangent = XMLoadFloat3(&mStationTangents[0]);
+		XMVECTOR up = XMVectorSet(0.f, 1.f, 0.f, 0.f);
+		if (fabsf(XMVectorGetX(XMVector3Dot(up, tangent))) > 0.999f)
+		{
+			up = XMVectorSet(1.f, 0.f, 0.f, 0.f);
+		}
+		XMStoreFloat3(&mStationNormals[0], OrthogonalNormal(up, tangent));
+		first = 1;
+	}
+
+	int station = first;
+	for (; station < static_cast<int>(mStationNormals.size()); ++station)
+	{
+		XMVECTOR x_0 = XMLoadFloat3(&mStationPositions[station - 1]);
+		XMVECTOR x_1 = XMLoadFloat3(&mStationPositions[station]);
+		XMVECTOR t_0 = XMLoadFloat3(&mStationTangents[station - 1]);
+		XMVECTOR t_1 = XMLoadFloat3(&mStationTangents[station]);
+		XMVECTOR r_0 = XMLoadFloat3(&mStationNormals[station - 1]);
+		XMVECTOR r_1 = r_0;
+
+		//Double reflection. Stations shared by two segments sit on the same point, so the normal is only projected onto the new tangent's plane.
+		XMVECTOR v_1 = x_1 - x_0;
+		float c_1 = XMVectorGetX(XMVector3Dot(v_1, v_1));
+		if (c_1 > DegenerateLengthSquared)
+		{
+			XMVECTOR r_L = r_0 - (2.f / c_1) * XMVector3Dot(v_1, r_0) * v_1;
+			XMVECTOR t_L = t_0 - (2.f / c_1) * XMVector3Dot(v_1, t_0) * v_1;
+			XMVECTOR v_2 = t_1 - t_L;
+			float c_2 = XMVectorGetX(XMVector3Dot(v_2, v_2));
+			r_1 = c_2 > DegenerateLengthSquared ? r_L - (2.f / c_2) * XMVector3Dot(v_2, r_L) * v_2 : r_L;
+		}
+		r_1 = OrthogonalNormal(r_1, t_1);
+
+		//Past the rebuilt segments the geometry is unchanged, so matching the old normal means the rest matches too.
+		if (station >= unchangedBegin && XMVector3NearEqual(r_1, XMLoadFloat3(&mStationNormals[station]), XMVectorReplicate(1e-6f)))
+		{
+			break;
+		}
+		XMStoreFloat3(&mStationNormals[station], r_1);
+	}
+
+	BakeOrientations(bakeBegin, station);
+}
+
+void Path::BakeOrientations(int beginStation, int endStation)
+{
+	//Carry the last normal across the seam and measure how far it twisted from the first one.
+	XMVECTOR t_0 = XMLoadFloat3(&mStationTangents.front());
+	XMVECTOR r_0 = XMLoadFloat3(&mStationNormals.front());
+	XMVECTOR r_end = OrthogonalNormal(XMLoadFloat3(&mStationNormals.back()), t_0);
+	float twist = atan2f(XMVectorGetX(XMVector3Dot(XMVector3Cross(r_end, r_0), t_0)), XMVectorGetX(XMVector3Dot(r_end, r_0)));
+	float twistPerLength = GetWorldArcLength() > 0.f ? twist / GetWorldArcLength() : 0.f;
+
+	//The correction depends on arc length from the start, so any twist forces a full bake.
+	if (fabsf(twist) > TwistEpsilon || fabsf(mTwist) > TwistEpsilon)
+	{
+		beginStation = 0;
+		endStation = static_cast<int>(mStationNormals.size());
+	}
+	mTwist = twist;
+
+	float segmentStart = 0.f;
+	for (int segment = 0; segment < GetSegmentCount(); ++segment)
+	{
+		float segmentLength = mArcLength->GetSegmentArcLength(segment);
+		int frameCount = mStationOffsets[segment + 1] - mStationOffsets[segment] - 1;
+		int first = std::max(mStationOffsets[segment], beginStation);
+		int end = std::min(mStationOffsets[segment + 1], endStation);
+		for (int station = first; station < end; ++station)
+		{
+			int frame = station - mStationOffsets[segment];
+			XMVECTOR tangent = XMLoadFloat3(&mStationTangents[station]);
+			XMVECTOR normal = XMLoadFloat3(&mStationNormals[station]);
+
+			float sinAngle;
+			float cosAngle;
+			XMScalarSinCos(&sinAngle, &cosAngle, twistPerLength * (segmentStart + segmentLength * frame / frameCount));
+			normal = normal * cosAngle + XMVector3Cross(tangent, normal) * sinAngle;
+
+			XMMATRIX basis;
+			basis.r[0] = XMVector3Cross(normal, tangent);
+			basis.r[1] = normal;
+			basis.r[2] = tangent;
+			basis.r[3] = XMVectorSet(0.f, 0.f, 0.f, 1.f);
+			XMStoreFloat4(&mStationOrientations[station], XMQuaternionNormalize(XMQuaternionRotationMatrix(basis)));
+		}
+		segmentStart += segmentLength;
+	}
+}
+
+std::vector<PathSplice> Path::MoveControlPoint(int index, XMVECTOR position)
+{
+	int last = GetControlPointCount() - 1;
+	assert(index >= 0 && index <= last);
+
+	std::vector<PathSplice> splices;
+	if (index == 0 || index == last)
+	{
+		//The seam point ends the last segment and starts the first one. Tangents at 0, 1 and last - 1, last change.
+		mControlPoints[0] = position;
+		mControlPoints[last] = position;
+		int segmentCount = GetSegmentCount();
+		int headCount = std::min(2, segmentCount);
+		splices.push_back(RebuildSegments(0, headCount, headCount));
+		int tailFirst = std::max(headCount, segmentCount - 2);
+		if (tailFirst < segmentCount)
+		{
+			splices.push_back(RebuildSegments(tailFirst, segmentCount - tailFirst, segmentCount - tailFirst));
+		}
+		return splices;
+	}
+
+	//Tangents at index - 1, index and index + 1 change, which touches segments index - 2 through index + 1.
+	mControlPoints[index] = position;
+	int first = std::max(index - 2, 0);
+	int end = std::min(index + 2, GetSegmentCount());
+	splices.push_back(RebuildSegments(first, end - first, end - first));
+	return splices;
+}
+
+std::vector<PathSplice> Path::InsertControlPoint(int index, XMVECTOR position)
+{
+	assert(index >= 1 && index <= GetControlPointCount() - 1);
+
+	//Old segment index - 1 splits in two, and the tangents around the new point change.
+	mControlPoints.insert(mControlPoints.begin() + index, position);
+	int first = std::max(index - 2, 0);
+	int end = std::min(index + 2, GetSegmentCount());
+	return { RebuildSegments(first, end - first - 1, end - first) };
+}
+
+std::vector<PathSplice> Path::RemoveControlPoint(int index)
+{
+	assert(index >= 1 && index <= GetControlPointCount() - 2);
+	assert(GetControlPointCount() > 4);
+
+	//Old segments index - 1 and index merge into one, and the tangents of both neighbours change.
+	mControlPoints.erase(mControlPoints.begin() + index);
+	int first = std::max(index - 2, 0);
+	int end = std::min(index + 1, GetSegmentCount());
+	return { RebuildSegments(first, end - first + 1, end - first) };
+}
+
+PathSplice Path::RebuildSegments(int firstSegment, int oldSegmentCount, int newSegmentCount)
+{
+	auto subPointItor = mSubPoints.begin() + firstSegment * 2;
+	subPointItor = mSubPoints.erase(subPointItor, subPointItor + oldSegmentCount * 2);
+	mSubPoints.insert(subPointItor, newSegmentCount * 2, XMVectorZero());
+	mSpline.Splice(firstSegment, oldSegmentCount, newSegmentCount);
+
+	for (int segment = firstSegment; segment < firstSegment + newSegmentCount; ++segment)
+	{
+		CalcSegmentSubPoints(segment);
+		mSpline.SetSegment(segment, mControlPoints[segment], mSubPoints[2 * segment], mSubPoints[2 * segment + 1], mControlPoints[segment + 1]);
+	}
+	mArcLength->Splice(mSpline, firstSegment, oldSegmentCount, newSegmentCount);
+
+	SpliceStations(firstSegment, oldSegmentCount, newSegmentCount);
+	//Segment indices behind the splice shift, and a few hundred segments rebuild in microseconds.
+	BuildSegmentBvh();
+
+	return { firstSegment, oldSegmentCount, newSegmentCount };
+}
+
+void Path::CalcSubPoints()
+{
+	mSubPoints.resize(GetSegmentCount() * 2);
+	for (int segment = 0; segment < GetSegmentCount(); ++segment)
+	{
+		CalcSegmentSubPoints(segment);
+	}
+}
+
+void Path::CalcSegmentSubPoints(int segment)
+{
+	//Neighbours wrap around the array ends, so the seam point sees itself as its outer neighbour.
+	int last = GetControlPointCount() - 1;
+	auto previous = [&](int i) { return mControlPoints[i == 0 ? last : i - 1]; };
+	auto next = [&](int i) { return mControlPoints[i == last ? 0 : i + 1]; };
+
+	//a_(segment)
+	mSubPoints[2 * segment] = CalcA(previous(segment), mControlPoints[segment], next(segment));
+
+	//b_(segment + 1)
+	mSubPoints[2 * segment + 1] = CalcB(previous(segment + 1), mControlPoints[segment + 1], next(segment + 1));
+}
+
+XMVECTOR Path::CalcA(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2)
+{
+	return p_1 + (p_2 - p_0) * 0.5f;
+}
+
+XMVECTOR Path::CalcB(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2)
+{
+	return p_1 - (p_2 - p_0) * 0.5f;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <DirectXMath.h>
+
+#include "BezierSpline.h"
+#include "IArcLength.h"
+#include "SegmentBvh.h"
+
+using namespace DirectX;
+
+/**
+ * @brief Segments [firstSegment, firstSegment + oldSegmentCount) replaced by newSegmentCount rebuilt segments.
+ */
+struct PathSplice
+{
+	int firstSegment;
+	int oldSegmentCount;
+	int newSegmentCount;
+};
+
+/**
+ * @brief Point on a path closest to a query point.
+ */
+struct PathProjection
+{
+	XMFLOAT3 position;
+	float distance;
+	float normalizedArcLength;
+	int segment;
+	float localParam;
+};
+
+/**
+ * @brief Closed route through control points with its spline, arc length tables and frame stations.
+ * @detail The last control point repeats the first one to close the loop.
+ * Each segment holds stations evenly spaced by arc length with a position, unit tangent and a
+ * rotation minimizing frame. Tighter segments get more stations. Frames are parallel transported by double reflection and the twist
+ * left over when the loop closes is spread along the length. The frame maps local +Z to the
+ * tangent and +Y to the transported normal.
+ * Sampling is const and may run on many threads. Edits rebuild only the segments whose tangents changed,
+ * and must not run while the path is being sampled.
+ */
+class Path
+{
+public:
+	Path(const std::vector<XMVECTOR>& controlPoints, ArcLengthMethod arcLengthMethod = ArcLengthMethod::AdaptiveTable);
+
+	Path(const Path& copy) = delete;
+	Path& operator= (const Path& other) = delete;
+
+	/**
+	 * @brief Interpolate position and orientation quaternion between the two nearest stations.
+	 */
+	void Sample(float normalizedArcLength, XMVECTOR& position, XMVECTOR& orientation) const;
+	void SampleBatch(const float* normalizedArcLengths, XMFLOAT3* outPositions, XMFLOAT4* outOrientations, size_t count) const;
+
+	/**
+	 * @brief Find the closest point on the curve.
+	 * @detail The segment BVH prunes segments whose boxes are farther than the best candidate so far,
+	 * and BezierSpline::FindClosestParam refines the remaining ones.
+	 */
+	PathProjection Project(XMVECTOR point) const;
+	/**
+	 * @brief Project many points. Each query starts from the previous result as its bound, so nearby points in a row prune more.
+	 */
+	void ProjectBatch(const XMFLOAT3* points, PathProjection* outProjections, size_t count) const;
+
+	/**
+	 * @brief Edits return the splices applied to the segment list, in order, so callers can patch data kept per segment.
+	 * @detail Moving the first or the last control point moves both, since they are the same point of the loop.
+	 */
+	std::vector<PathSplice> MoveControlPoint(int index, XMVECTOR position);
+	/**
+	 * @brief Insert a control point before index, in [1, GetControlPointCount() - 1].
+	 */
+	std::vector<PathSplice> InsertControlPoint(int index, XMVECTOR position);
+	/**
+	 * @brief Remove a control point in [1, GetControlPointCount() - 2]. The loop keeps at least three points.
+	 */
+	std::vector<PathSplice> RemoveControlPoint(int index);
+
+	float GetWorldArcLength() const { return mArcLength->GetWorldArcLength(); }
+	const BezierSpline& GetSpline() const { return mSpline; }
+	const std::vector<XMVECTOR>& GetControlPoints() const { return mControlPoints; }
+	int GetControlPointCount() const { return static_cast<int>(mControlPoints.size()); }
+
+private:
+	void CalcSubPoints();
+	void CalcSegmentSubPoints(int segment);
+	PathSplice RebuildSegments(int firstSegment, int oldSegmentCount, int newSegmentCount);
+	void SampleSegment(int segment, float localArcLength, XMVECTOR& position, XMVECTOR& orientation) const;
+	void SpliceStations(int firstSegment, int oldSegmentCount, int newSegmentCount);
+	void BuildSegmentStations(int segment);
+	void TransportFrames(int firstSegment, int endSegment);
+	void BakeOrientations(int beginStation, int endStation);
+	void BuildSegmentBvh();
+	PathProjection FindClosest(XMVECTOR point, int segment, float localParam, float distanceSquared) const;
+	int GetSegmentCount() const { return static_cast<int>(mControlPoints.size()) - 1; }
+	XMVECTOR CalcA(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2);
+	XMVECTOR CalcB(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2);
+
+private:
+	std::vector<XMVECTOR> mControlPoints;
+	std::vector<XMVECTOR> mSubPoints;
+	BezierSpline mSpline;
+	std::unique_ptr<IArcLength> mArcLength;
+
+	//Stations of segment i live in [mStationOffsets[i], mStationOffsets[i + 1]). Neighbouring segments both keep their shared end station.
+	std::vector<int> mStationOffsets;
+	std::vector<XMFLOAT3> mStationPositions;
+	std::vector<XMFLOAT3> mStationTangents;
+	std::vector<XMFLOAT3> mStationNormals;
+	std::vector<XMFLOAT4> mStationOrientations;
+	float mTwist = 0.f;
+
+	SegmentBvh mSegmentBvh;
+
+	//Scratch storage reused between builds.
+	std::vector<XMFLOAT3> mBuildPositions;
+	std::vector<XMFLOAT3> mBuildTangents;
+	std::vector<int> mBuildOffsets;
+	std::vector<int> mBuildSegments;
+	std::vector<float> mBuildParams;
+	std::vector<XMFLOAT3> mBuildBoundsMins;
+	std::vector<XMFLOAT3> mBuildBoundsMaxs;
+};
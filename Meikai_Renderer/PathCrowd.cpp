@@ -0,0 +1,403 @@
+#include "PathCrowd.h"
+#include "Path.h"
+#include "SpeedProfile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	//Multiple of 4 so no range but the last one has a scalar tail.
+	constexpr int AgentsPerJob = 1024;
+	//Rounds of projecting the velocity onto the constraints it breaks. Converges to a feasible velocity
+	//when one exists, and settles near the least bad one when it does not.
+	constexpr int AvoidancePasses = 4;
+
+	//Half plane of allowed velocities, left of direction through point. 2D vectors hold world X and Z.
+	//The inward normal of the boundary is (-direction.y, direction.x).
+	struct OrcaLine
+	{
+		XMVECTOR point;
+		XMVECTOR direction;
+	};
+
+	//Unit forward direction projected on the ground.
+	XMVECTOR GetGroundTangent(const XMFLOAT4& orientation)
+	{
+		XMFLOAT3 forward;
+		XMStoreFloat3(&forward, XMVector3Rotate(XMVectorSet(0.f, 0.f, 1.f, 0.f), XMLoadFloat4(&orientation)));
+		float length = sqrtf(forward.x * forward.x + forward.z * forward.z);
+		if (length < 1e-4f)
+		{
+			return XMVectorSet(0.f, 1.f, 0.f, 0.f);
+		}
+		return XMVectorSet(forward.x / length, forward.z / length, 0.f, 0.f);
+	}
+
+	XMVECTOR Perpendicular(XMVECTOR v)
+	{
+		return XMVectorSet(XMVectorGetY(v), -XMVectorGetX(v), 0.f, 0.f);
+	}
+}
+
+int PathCrowd::AddPath(std::shared_ptr<const Path> path)
+{
+	mPaths.push_back(path);
+	return static_cast<int>(mPaths.size()) - 1;
+}
+
+int PathCrowd::AddProfile(std::shared_ptr<const SpeedProfile> profile)
+{
+	mProfiles.push_back(profile);
+	return static_cast<int>(mProfiles.size()) - 1;
+}
+
+int PathCrowd::AddAgent(int pathId, float distance, float speed)
+{
+	float pathLength = mPaths[pathId]->GetWorldArcLength();
+
+	mDistances.push_back(fmodf(distance, pathLength));
+	mSpeeds.push_back(speed);
+	mPathLengths.push_back(pathLength);
+	mPathIds.push_back(pathId);
+	mProfileIds.push_back(-1);
+	mSpeedScales.push_back(1.f);
+	mLateralOffsets.push_back(0.f);
+	mVelocities.push_back(XMFLOAT2(0.f, 0.f));
+	mNextVelocities.push_back(XMFLOAT2(0.f, 0.f));
+	mNormalizedArcLengths.push_back(mDistances.back() / pathLength);
+
+	XMFLOAT3 position;
+	XMFLOAT4 orientation;
+	XMVECTOR samplePosition;
+	XMVECTOR sampleOrientation;
+	mPaths[pathId]->Sample(mNormalizedArcLengths.back(), samplePosition, sampleOrientation);
+	XMStoreFloat3(&position, samplePosition);
+	XMStoreFloat4(&orientation, sampleOrientation);
+	mPositions.push_back(position);
+	mOrientations.push_back(orientation);
+
+	return GetAgentCount() - 1;
+}
+
+int PathCrowd::AddAgentNear(int pathId, XMVECTOR position, float speed)
+{
+	PathProjection projection = mPaths[pathId]->Project(position);
+	return AddAgent(pathId, projection.normalizedArcLength * mPaths[pathId]->GetWorldArcLength(), speed);
+}
+
+void PathCrowd::SnapAgent(int agent, XMVECTOR position)
+{
+	const Path& path = *mPaths[mPathIds[agent]];
+	PathProjection projection = path.Project(position);
+	SetNormalizedArcLength(agent, projection.normalizedArcLength);
+
+	XMVECTOR samplePosition;
+	XMVECTOR sampleOrientation;
+	path.Sample(projection.normalizedArcLength, samplePosition, sampleOrientation);
+	XMStoreFloat3(&mPositions[agent], samplePosition);
+	XMStoreFloat4(&mOrientations[agent], sampleOrientation);
+}
+
+void PathCrowd::SetAgentProfile(int agent, int profileId)
+{
+	float normalizedArcLength = mNormalizedArcLengths[agent];
+	mProfileIds[agent] = profileId;
+	SetNormalizedArcLength(agent, normalizedArcLength);
+}
+
+void PathCrowd::SetNormalizedArcLength(int agent, float normalizedArcLength)
+{
+	//The inverse table turns a place on the path back into lap time.
+	int profileId = mProfileIds[agent];
+	float lapTime = profileId < 0 ? normalizedArcLength : mProfiles[profileId]->GetTime(normalizedArcLength);
+	mDistances[agent] = lapTime * mPathLengths[agent];
+	mNormalizedArcLengths[agent] = normalizedArcLength;
+}
+
+void PathCrowd::EnableAvoidance(const CrowdAvoidanceSettings& settings)
+{
+	//The 3x3 cell query only covers the neighbour radius when cells are at least that big.
+	assert(settings.neighbourRadius > settings.agentRadius * 2.f);
+	mAvoidanceSettings = settings;
+	mAvoidance = true;
+}
+
+void PathCrowd::DisableAvoidance()
+{
+	mAvoidance = false;
+	std::fill(mSpeedScales.begin(), mSpeedScales.end(), 1.f);
+	std::fill(mLateralOffsets.begin(), mLateralOffsets.end(), 0.f);
+	std::fill(mVelocities.begin(), mVelocities.end(), XMFLOAT2(0.f, 0.f));
+}
+
+void PathCrowd::RefreshPath(int pathId)
+{
+	float pathLength = mPaths[pathId]->GetWorldArcLength();
+	for (int agent = 0; agent < GetAgentCount(); ++agent)
+	{
+		if (mPathIds[agent] == pathId)
+		{
+			mDistances[agent] = mDistances[agent] / mPathLengths[agent] * pathLength;
+			mPathLengths[agent] = pathLength;
+		}
+	}
+}
+
+void PathCrowd::SetPath(int pathId, std::shared_ptr<const Path> path)
+{
+	mPaths[pathId] = path;
+	float pathLength = path->GetWorldArcLength();
+	for (int agent = 0; agent < GetAgentCount(); ++agent)
+	{
+		if (mPathIds[agent] == pathId)
+		{
+			mPathLengths[agent] = pathLength;
+			SnapAgent(agent, XMLoadFloat3(&mPositions[agent]));
+		}
+	}
+}
+
+void PathCrowd::Update(float deltaTime, ThreadPool* threadPool)
+{
+	int agentCount = GetAgentCount();
+	if (mAvoidance && deltaTime > 0.f)
+	{
+		mSpatialHash.Build(mPositions.data(), agentCount, mAvoidanceSettings.neighbourRadius, threadPool);
+		if (threadPool == nullptr)
+		{
+			AvoidRange(0, agentCount, deltaTime);
+		}
+		else
+		{
+			threadPool->ParallelFor(agentCount, AgentsPerJob, [this, deltaTime](int begin, int end)
+			{
+				AvoidRange(begin, end, deltaTime);
+			});
+		}
+		mVelocities.swap(mNextVelocities);
+	}
+
+	if (threadPool == nullptr)
+	{
+		UpdateRange(0, agentCount, deltaTime);
+		return;
+	}
+
+	threadPool->ParallelFor(agentCount, AgentsPerJob, [this, deltaTime](int begin, int end)
+	{
+		UpdateRange(begin, end, deltaTime);
+	});
+}
+
+void PathCrowd::AvoidRange(int begin, int end, float deltaTime)
+{
+	const CrowdAvoidanceSettings& settings = mAvoidanceSettings;
+	float neighbourRadiusSquared = settings.neighbourRadius * settings.neighbourRadius;
+	float combinedRadius = settings.agentRadius * 2.f;
+	float combinedRadiusSquared = combinedRadius * combinedRadius;
+	float inverseTimeHorizon = 1.f / settings.timeHorizon;
+	float inverseDeltaTime = 1.f / deltaTime;
+
+	//(distance squared, agent), nearest first.
+	std::vector<std::pair<float, int>> neighbours;
+	std::vector<OrcaLine> lines;
+	neighbours.reserve(settings.maxNeighbours + 1);
+	lines.reserve(settings.maxNeighbours + 4);
+
+	for (int agent = begin; agent < end; ++agent)
+	{
+		const XMFLOAT3& position = mPositions[agent];
+		neighbours.clear();
+		mSpatialHash.ForEachNear(position, [&](int other)
+		{
+			float dx = mPositions[other].x - position.x;
+			float dz = mPositions[other].z - position.z;
+			float distanceSquared = dx * dx + dz * dz;
+			if (other == agent || distanceSquared >= neighbourRadiusSquared)
+			{
+				return;
+			}
+			if (static_cast<int>(neighbours.size()) == settings.maxNeighbours && distanceSquared >= neighbours.back().first)
+			{
+				return;
+			}
+			neighbours.insert(std::upper_bound(neighbours.begin(), neighbours.end(), std::make_pair(distanceSquared, other)), { distanceSquared, other });
+			if (static_cast<int>(neighbours.size()) > settings.maxNeighbours)
+			{
+				neighbours.pop_back();
+			}
+		});
+
+		//Constraints as in van den Berg et al., Reciprocal n-body Collision Avoidance. Each agent takes half of the avoidance.
+		XMVECTOR velocity = XMLoadFloat2(&mVelocities[agent]);
+		lines.clear();
+		for (const auto& [distanceSquared, other] : neighbours)
+		{
+			XMVECTOR relativePosition = XMVectorSet(mPositions[other].x - position.x, mPositions[other].z - position.z, 0.f, 0.f);
+			XMVECTOR relativeVelocity = velocity - XMLoadFloat2(&mVelocities[other]);
+			if (distanceSquared < 1e-8f)
+			{
+				continue;
+			}
+
+			OrcaLine line;
+			XMVECTOR u;
+			if (distanceSquared > combinedRadiusSquared)
+			{
+				//Velocity obstacle truncated at the time horizon.
+				XMVECTOR w = relativeVelocity - relativePosition * inverseTimeHorizon;
+				float wLengthSquared = XMVectorGetX(XMVector2LengthSq(w));
+				float dotProduct = XMVectorGetX(XMVector2Dot(w, relativePosition));
+				if (dotProduct < 0.f && dotProduct * dotProduct > combinedRadiusSquared * wLengthSquared)
+				{
+					//Closest to the cut off circle.
+					float wLength = sqrtf(wLengthSquared);
+					XMVECTOR unitW = w / wLength;
+					line.direction = Perpendicular(unitW);
+					u = unitW * (combinedRadius * inverseTimeHorizon - wLength);
+				}
+				else
+				{
+					//Closest to one of the legs.
+					float x = XMVectorGetX(relativePosition);
+					float y = XMVectorGetY(relativePosition);
+					float leg = sqrtf(distanceSquared - combinedRadiusSquared);
+					if (XMVectorGetX(XMVector2Cross(relativePosition, w)) > 0.f)
+					{
+						line.direction = XMVectorSet(x * leg - y * combinedRadius, x * combinedRadius + y * leg, 0.f, 0.f) / distanceSquared;
+					}
+					else
+					{
+						line.direction = -XMVectorSet(x * leg + y * combinedRadius, -x * combinedRadius + y * leg, 0.f, 0.f) / distanceSquared;
+					}
+					u = line.direction * XMVector2Dot(relativeVelocity, line.direction) - relativeVelocity;
+				}
+			}
+			else
+			{
+				//Already overlapping. Separate within this step.
+				XMVECTOR w = relativeVelocity - relativePosition * inverseDeltaTime;
+				float wLength = XMVectorGetX(XMVector2Length(w));
+				if (wLength < 1e-6f)
+				{
+					continue;
+				}
+				XMVECTOR unitW = w / wLength;
+				line.direction = Perpendicular(unitW);
+				u = unitW * (combinedRadius * inverseDeltaTime - wLength);
+			}
+			line.point = velocity + u * 0.5f;
+			lines.push_back(line);
+		}
+
+		XMVECTOR tangent = GetGroundTangent(mOrientations[agent]);
+		XMVECTOR side = Perpendicular(tangent);
+		int profileId = mProfileIds[agent];
+		float preferredSpeed = mSpeeds[agent];
+		if (profileId >= 0)
+		{
+			preferredSpeed *= mProfiles[profileId]->GetVelocity(mDistances[agent] / mPathLengths[agent]);
+		}
+		float lateralOffset = mLateralOffsets[agent];
+		XMVECTOR preferred = tangent * preferredSpeed - side * (lateralOffset * settings.lateralReturnRate);
+
+		//Moves the path allows, last so they win every pass: forward along it, no faster than the
+		//speed limit, and sideways only within the lane.
+		XMVECTOR chosen = preferred;
+		bool avoiding = lines.empty() == false;
+		float laneSpeedMin = (-settings.maxLateralOffset - lateralOffset) * inverseDeltaTime;
+		float laneSpeedMax = (settings.maxLateralOffset - lateralOffset) * inverseDeltaTime;
+		lines.push_back({ XMVectorZero(), Perpendicular(tangent) });
+		lines.push_back({ tangent * (preferredSpeed * settings.maxSpeedScale), Perpendicular(-tangent) });
+		lines.push_back({ side * laneSpeedMin, Perpendicular(side) });
+		lines.push_back({ side * laneSpeedMax, Perpendicular(-side) });
+		for (int pass = 0; pass < AvoidancePasses && avoiding; ++pass)
+		{
+			avoiding = false;
+			for (const OrcaLine& line : lines)
+			{
+				if (XMVectorGetX(XMVector2Cross(line.direction, line.point - chosen)) > 0.f)
+				{
+					chosen = line.point + line.direction * XMVector2Dot(chosen - line.point, line.direction);
+					avoiding = true;
+				}
+			}
+		}
+
+		//The passes may stop short of a feasible velocity, so clamp to the path moves once more.
+		float alongSpeed = XMVectorGetX(XMVector2Dot(chosen, tangent));
+		float speedScale = preferredSpeed > 1e-4f ? std::clamp(alongSpeed / preferredSpeed, 0.f, settings.maxSpeedScale) : 1.f;
+		float newLateralOffset = lateralOffset + XMVectorGetX(XMVector2Dot(chosen, side)) * deltaTime;
+		newLateralOffset = std::clamp(newLateralOffset, -settings.maxLateralOffset, settings.maxLateralOffset);
+		float lateralSpeed = (newLateralOffset - lateralOffset) * inverseDeltaTime;
+
+		mSpeedScales[agent] = speedScale;
+		mLateralOffsets[agent] = newLateralOffset;
+		XMStoreFloat2(&mNextVelocities[agent], tangent * (preferredSpeed * speedScale) + side * lateralSpeed);
+	}
+}
+
+void PathCrowd::UpdateRange(int begin, int end, float deltaTime)
+{
+	XMVECTOR vDeltaTime = XMVectorReplicate(deltaTime);
+	int agent = begin;
+	for (; agent + 4 <= end; agent += 4)
+	{
+		XMVECTOR distance = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mDistances[agent]));
+		XMVECTOR speed = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mSpeeds[agent]));
+		speed = XMVectorMultiply(speed, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mSpeedScales[agent])));
+		XMVECTOR pathLength = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mPathLengths[agent]));
+
+		distance = XMVectorMultiplyAdd(speed, vDeltaTime, distance);
+		XMVECTOR laps = XMVectorFloor(XMVectorDivide(distance, pathLength));
+		distance = XMVectorNegativeMultiplySubtract(laps, pathLength, distance);
+
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&mDistances[agent]), distance);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&mNormalizedArcLengths[agent]), XMVectorDivide(distance, pathLength));
+	}
+	for (; agent < end; ++agent)
+	{
+		float distance = mDistances[agent] + mSpeeds[agent] * mSpeedScales[agent] * deltaTime;
+		distance -= floorf(distance / mPathLengths[agent]) * mPathLengths[agent];
+		mDistances[agent] = distance;
+		mNormalizedArcLengths[agent] = distance / mPathLengths[agent];
+	}
+
+	if (!mProfiles.empty())
+	{
+		for (agent = begin; agent < end; ++agent)
+		{
+			int profileId = mProfileIds[agent];
+			if (profileId >= 0)
+			{
+				mNormalizedArcLengths[agent] = mProfiles[profileId]->GetDistance(mNormalizedArcLengths[agent]);
+			}
+		}
+	}
+
+	//Sample each run of agents on the same path with one batch.
+	for (int runBegin = begin; runBegin < end;)
+	{
+		int pathId = mPathIds[runBegin];
+		int runEnd = runBegin + 1;
+		while (runEnd < end && mPathIds[runEnd] == pathId)
+		{
+			++runEnd;
+		}
+
+		mPaths[pathId]->SampleBatch(&mNormalizedArcLengths[runBegin], &mPositions[runBegin], &mOrientations[runBegin], runEnd - runBegin);
+		runBegin = runEnd;
+	}
+
+	if (mAvoidance)
+	{
+		for (agent = begin; agent < end; ++agent)
+		{
+			XMVECTOR side = Perpendicular(GetGroundTangent(mOrientations[agent]));
+			mPositions[agent].x += XMVectorGetX(side) * mLateralOffsets[agent];
+			mPositions[agent].z += XMVectorGetY(side) * mLateralOffsets[agent];
+		}
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <DirectXMath.h>
+
+#include "SpatialHash.h"
+
+using namespace DirectX;
+class Path;
+class SpeedProfile;
+class ThreadPool;
+
+struct CrowdAvoidanceSettings
+{
+	float agentRadius = 0.3f;
+	//Neighbours farther than this are ignored. Also the cell size of the spatial hash.
+	float neighbourRadius = 2.f;
+	//Collisions predicted further ahead than this many seconds are ignored.
+	float timeHorizon = 1.5f;
+	int maxNeighbours = 10;
+	float maxLateralOffset = 0.6f;
+	//Share of the lateral offset steered back per second when nothing is in the way.
+	float lateralReturnRate = 1.f;
+	float maxSpeedScale = 1.3f;
+};
+
+/**
+ * @brief Agents walking along shared paths, stored as structure of arrays.
+ * @detail Update advances every distance four lanes at a time, wraps it around the path length
+ * and samples positions and orientations in runs of agents that share a path.
+ * Agents with a SpeedProfile advance their lap time at a constant rate and map it to a distance
+ * through the profile table, so they ease without any per agent curve evaluation.
+ * With avoidance enabled, Update first hashes the agents into a grid and gives each one ORCA velocity
+ * constraints from its nearest neighbours. The velocity closest to the preferred one is split into a scale
+ * of the speed along the path and a sideways step away from the path, which is kept within a lane.
+ */
+class PathCrowd
+{
+public:
+	PathCrowd() = default;
+
+	int AddPath(std::shared_ptr<const Path> path);
+	int AddProfile(std::shared_ptr<const SpeedProfile> profile);
+	int AddAgent(int pathId, float distance, float speed);
+	/**
+	 * @brief Spawn an agent on the point of the path closest to position.
+	 */
+	int AddAgentNear(int pathId, XMVECTOR position, float speed);
+	/**
+	 * @brief Put an agent that was pushed off its route back on the closest point of its path.
+	 */
+	void SnapAgent(int agent, XMVECTOR position);
+
+	/**
+	 * @brief Pick up a new length after the path was edited. Agents keep their normalized progress.
+	 */
+	void RefreshPath(int pathId);
+	/**
+	 * @brief Replace a path with a new route. Agents on it move to the closest point of the new one.
+	 */
+	void SetPath(int pathId, std::shared_ptr<const Path> path);
+
+	void Update(float deltaTime, ThreadPool* threadPool = nullptr);
+
+	int GetAgentCount() const { return static_cast<int>(mDistances.size()); }
+	XMVECTOR GetPosition(int agent) const { return XMLoadFloat3(&mPositions[agent]); }
+	XMVECTOR GetOrientation(int agent) const { return XMLoadFloat4(&mOrientations[agent]); }
+	float GetDistance(int agent) const { return mNormalizedArcLengths[agent] * mPathLengths[agent]; }
+	void SetSpeed(int agent, float speed) { mSpeeds[agent] = speed; }
+	/**
+	 * @brief Ease the agent with a profile from AddProfile, or walk at constant speed with -1.
+	 * @detail The agent keeps its place on the path. speed becomes the average speed over a lap.
+	 */
+	void SetAgentProfile(int agent, int profileId);
+
+	void EnableAvoidance(const CrowdAvoidanceSettings& settings);
+	/**
+	 * @brief Stop steering. Agents step back onto their paths at full speed.
+	 */
+	void DisableAvoidance();
+	bool IsAvoidanceEnabled() const { return mAvoidance; }
+
+private:
+	void UpdateRange(int begin, int end, float deltaTime);
+	void AvoidRange(int begin, int end, float deltaTime);
+	void SetNormalizedArcLength(int agent, float normalizedArcLength);
+
+private:
+	std::vector<std::shared_ptr<const Path>> mPaths;
+	std::vector<std::shared_ptr<const SpeedProfile>> mProfiles;
+
+	//Per agent
+	//Lap time scaled by the path length. Equal to the distance walked for agents without a profile.
+	std::vector<float> mDistances;
+	std::vector<float> mSpeeds;
+	std::vector<float> mPathLengths;
+	std::vector<int> mPathIds;
+	std::vector<int> mProfileIds;
+	std::vector<float> mSpeedScales;
+	std::vector<float> mLateralOffsets;
+	//World XZ velocity chosen by the last avoidance pass, and the one being chosen.
+	std::vector<XMFLOAT2> mVelocities;
+	std::vector<XMFLOAT2> mNextVelocities;
+
+	std::vector<float> mNormalizedArcLengths;
+	std::vector<XMFLOAT3> mPositions;
+	std::vector<XMFLOAT4> mOrientations;
+
+	bool mAvoidance = false;
+	CrowdAvoidanceSettings mAvoidanceSettings;
+	SpatialHash mSpatialHash;
+};
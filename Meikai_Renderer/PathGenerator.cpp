@@ -2,62 +2,84 @@
 #include "CommandList.h"
 #include "MathHelper.h"
 #include "Model.h"
+#include "Path.h"
+#include "SpeedProfile.h"
+#include <algorithm>
+#include <cfloat>
 
-PathGenerator::PathGenerator(std::shared_ptr<Model> controlPointModel)
+namespace
+{
+	//Half of a one pixel budget, so the eye may halve its distance to the path before lines are redone.
+	constexpr float LineErrorPixels = 0.5f;
+	//Every segment gets at least 1 << MinSubdivisionDepth lines, so S bends whose midpoint lies on the chord are not missed.
+	constexpr int MinSubdivisionDepth = 2;
+	constexpr int MaxSubdivisionDepth = 10;
+	constexpr float MinEyeDistance = 0.1f;
+}
+
+PathGenerator::PathGenerator(DXApp* dxApp, std::shared_ptr<Model> controlPointModel, const std::vector<XMVECTOR>& controlPoints, ArcLengthMethod arcLengthMethod)
+	:mLineBuffer(dxApp)
 {
 	mControlPointModel = controlPointModel;
-	mSlice = 100;
+	mArcLengthMethod = arcLengthMethod;
 	mTickAccumulating = 0.f;
-	mWorldArcLength = 0.f;
-	float scale = 3.f;
+	mPlaybackRate = 0.03f;
+	mSpeedProfile = std::make_shared<const SpeedProfile>(SpeedProfile::EaseInOut());
 
-	auto test0 = XMFLOAT3(0, 0, scale * 1.f);
-	auto test1 = XMFLOAT3(-scale, 0, scale);
-	auto test2 = XMFLOAT3(-scale * 2.f, 0, 0);
-	auto test3 = XMFLOAT3(-scale, 0, -scale);
-	auto test4 = XMFLOAT3(0, 0, -scale * 2.f);
-	auto test5 = XMFLOAT3(scale, 0, -scale);
-	auto test6 = XMFLOAT3(scale * 2.f, 0, 0);
-	auto test7 = XMFLOAT3(scale, 0, scale);
+	mLineBufferDirty = true;
+	mTessellationEye = XMFLOAT3(0.f, 0.f, 0.f);
+	mTessellationFocalLength = 0.f;
+	mTessellationMinDistance = FLT_MAX;
 
-	mControlPoints.push_back(XMLoadFloat3(&test0));
-	mControlPoints.push_back(XMLoadFloat3(&test1));
-	mControlPoints.push_back(XMLoadFloat3(&test2));
-	mControlPoints.push_back(XMLoadFloat3(&test3));
-	mControlPoints.push_back(XMLoadFloat3(&test4));
-	mControlPoints.push_back(XMLoadFloat3(&test5));
-	mControlPoints.push_back(XMLoadFloat3(&test6));
-	mControlPoints.push_back(XMLoadFloat3(&test7));
-	mControlPoints.push_back(XMLoadFloat3(&test0));
-
-	CalcSubPoints();
-	BuildFunctions();
-	BuildAdaptiveTable(0.000001f);
-	GetPointStrip();
+	mPath = std::make_shared<Path>(controlPoints, arcLengthMethod);
+	TessellateLines();
 }
 
 float PathGenerator::Update(GameTimer timer, float tickPerSec, float duration, float distancePerDuration)
 {
-	float velocity = 0.03f;
-	mTickAccumulating += timer.DeltaTime() * tickPerSec * velocity;
+	mTickAccumulating += timer.DeltaTime() * tickPerSec * mPlaybackRate;
 	mTickAccumulating = fmod(mTickAccumulating, duration);
 	float normalizedTick = mTickAccumulating / duration;
-	float normalizedArcLength = DistanceTimeFunction(normalizedTick);
+	float normalizedArcLength = mSpeedProfile->GetDistance(normalizedTick);
 	ArcLengthToPosition(normalizedArcLength);
 
 	float distancePerTick = distancePerDuration / duration;// Ŭ  Ÿ /  Ŭ  ƽ
-	float worldDistance = mWorldArcLength * normalizedArcLength;
+	float worldDistance = mPath->GetWorldArcLength() * normalizedArcLength;
 	float tickAmount = worldDistance / distancePerTick;
 
 	return tickAmount;
 }
 
-void PathGenerator::DrawPaths(CommandList& commandList)
+void PathGenerator::DrawPaths(CommandList& commandList, XMVECTOR eyePosition, float focalLengthPixels)
 {
-	auto vertexCount = mPathLines.size();
-	auto vertexSize = sizeof(mPathLines[0]);
-	commandList.SetDynamicVertexBuffer(0, vertexCount, vertexSize, mPathLines.data());
-	commandList.Draw(vertexCount);
+	if (IsTessellationStale(eyePosition, focalLengthPixels))
+	{
+		XMStoreFloat3(&mTessellationEye, eyePosition);
+		mTessellationFocalLength = focalLengthPixels;
+		TessellateLines();
+	}
+
+	if (mLineBufferDirty)
+	{
+		mLineVertices.clear();
+		for (const auto& lines : mSegmentLines)
+		{
+			mLineVertices.insert(mLineVertices.end(), lines.begin(), lines.end());
+		}
+		if (mLineVertices.empty() == false)
+		{
+			commandList.CopyVertexBuffer(mLineBuffer, mLineVertices);
+			mLineBuffer.CreateVertexBufferView(mLineVertices.size(), sizeof(mLineVertices[0]));
+		}
+		mLineBufferDirty = false;
+	}
+
+	if (mLineVertices.empty())
+	{
+		return;
+	}
+	commandList.SetVertexBuffer(0, mLineBuffer);
+	commandList.Draw(static_cast<uint32_t>(mLineVertices.size()));
 }
 
 void PathGenerator::DrawControlPoints(CommandList& commandList)
@@ -65,13 +87,13 @@ void PathGenerator::DrawControlPoints(CommandList& commandList)
 	float pointScale = 0.05f;
 	XMMATRIX scale = XMMatrixScaling(pointScale, pointScale, pointScale);
 
-	for (auto element : mControlPoints)
+	for (auto element : mPath->GetControlPoints())
 	{
 		XMFLOAT3 position;
 		XMStoreFloat3(&position, element);
 		XMMATRIX translation = XMMatrixTranspose(scale * XMMatrixTranslation(position.x, position.y, position.z));
 		XMMATRIX result;
-		for (auto mesh : mControlPointModel->mMeshes)
+		for (auto& mesh : mControlPointModel->mMeshes)
 		{
 			commandList.SetGraphics32BitConstants(0, translation);
 			mesh.Draw(commandList);
@@ -79,229 +101,106 @@ void PathGenerator::DrawControlPoints(CommandList& commandList)
 	}
 }
 
-void PathGenerator::GetPointStrip()
+void PathGenerator::MoveControlPoint(int index, XMVECTOR position)
 {
-	mPathLines.clear();
-	float slice = static_cast<float>(mSlice);
-	for(const auto& curveFunc : mBezierEquations)
-	{
-		for(float i = 0.f; i < 1; i += (1.f / slice))
-		{
-			XMFLOAT3 value;
-			XMStoreFloat3(&value, curveFunc(i));
-			mPathLines.push_back(value);
-		}
-	}
+	PatchLines(mPath->MoveControlPoint(index, position));
 }
 
-void PathGenerator::BuildFunctions()
+void PathGenerator::InsertControlPoint(int index, XMVECTOR position)
 {
-	XMVECTOR controlPointsSet[4];
-	for(int i = 0; i < mControlPoints.size() - 1; ++i)
-	{
-		controlPointsSet[0] = mControlPoints[i];
-		for(int j = 0; j < 2; ++j)
-		{
-			controlPointsSet[j + 1] = mSubPoints[2 * i + j];
-		}
-		controlPointsSet[3] = mControlPoints[i + 1];
-		auto curveEquation = [=](float u) -> XMVECTOR
-		{
-			XMVECTOR result;
-			float u3 = u * u * u;
-			float u2 = u * u;
-
-			auto first = -u3 + 3.f * u2 - 3.f * u + 1.f;
-			auto second = 3.f * u3 - 6.f * u2 + 3.f * u;
-			auto third = -3.f * u3 + 3.f * u2;
-			auto fourth = u3;
-
-			result = first * controlPointsSet[0] + second * controlPointsSet[1] +
-				third * controlPointsSet[2] + fourth * controlPointsSet[3];
-
-			return result;
-		};
-		mBezierEquations.push_back(curveEquation);
-	}
+	PatchLines(mPath->InsertControlPoint(index, position));
 }
 
-void PathGenerator::CalcSubPoints()
+void PathGenerator::RemoveControlPoint(int index)
 {
-	auto length = mControlPoints.size();
-	//a_0
-	mSubPoints.push_back(CalcA(mControlPoints[length - 1], mControlPoints[0], mControlPoints[1]));
-
-	//b_1
-	mSubPoints.push_back(CalcB(mControlPoints[0], mControlPoints[1], mControlPoints[2]));
-
-	for(int i = 3; i < mControlPoints.size(); ++i)
-	{
-		//a_(i-1)
-		mSubPoints.push_back(CalcA(mControlPoints[i - 3], mControlPoints[i - 2], mControlPoints[i - 1]));
-
-		//b_(i)
-		mSubPoints.push_back(CalcB(mControlPoints[i - 2], mControlPoints[i - 1], mControlPoints[i]));
-	}
-
-	//a_(n-1)
-	//2,3,4
-	mSubPoints.push_back(CalcA(mControlPoints[length - 3], mControlPoints[length - 2], mControlPoints[length - 1]));
-
-	//b_(n)
-	//3,4,5(p[0])
-	mSubPoints.push_back(CalcB(mControlPoints[length - 2], mControlPoints[length - 1], mControlPoints[0]));
+	PatchLines(mPath->RemoveControlPoint(index));
 }
 
-XMVECTOR PathGenerator::CalcA(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2)
+void PathGenerator::SetControlPoints(const std::vector<XMVECTOR>& controlPoints)
 {
-	return p_1 + (p_2 - p_0) * 0.5f;
+	//A new Path rather than edits in place, since a Path may be shared with a PathCrowd that still samples the old route.
+	mPath = std::make_shared<Path>(controlPoints, mArcLengthMethod);
+	TessellateLines();
 }
 
-XMVECTOR PathGenerator::CalcB(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2)
+void PathGenerator::TessellateLines()
 {
-	return p_1 - (p_2 - p_0) * 0.5f;
-}
-
-int PathGenerator::GetBezierIndex(float globalU)
-{
-	return std::clamp(floorf(mBezierEquations.size() * globalU), 0.f, mBezierEquations.size()-1.f);
+	mTessellationMinDistance = FLT_MAX;
+	mSegmentLines.resize(mPath->GetSpline().GetSegmentCount());
+	for (int segment = 0; segment < mPath->GetSpline().GetSegmentCount(); ++segment)
+	{
+		TessellateSegment(segment);
+	}
+	mLineBufferDirty = true;
 }
 
-float PathGenerator::DenormalizeU(float globalU, int index)
+void PathGenerator::TessellateSegment(int segment)
 {
-	return globalU * mBezierEquations.size() - index;
+	const BezierSpline& spline = mPath->GetSpline();
+	std::vector<XMFLOAT3>& lines = mSegmentLines[segment];
+	lines.clear();
+	Subdivide(segment, 0.f, spline.Evaluate(segment, 0.f), 1.f, spline.Evaluate(segment, 1.f), 0, lines);
 }
 
-XMFLOAT3 PathGenerator::GetPointDistances(float u_a, float u_b, float u_m)
+void PathGenerator::Subdivide(int segment, float u0, XMVECTOR p0, float u1, XMVECTOR p1, int depth, std::vector<XMFLOAT3>& outLines)
 {
-	int a_funcIndex = GetBezierIndex(u_a);
-	int b_funcIndex = GetBezierIndex(u_b);
-	int m_funcIndex = GetBezierIndex(u_m);
-
-	float a_localU = DenormalizeU(u_a, a_funcIndex);
-	float b_localU = DenormalizeU(u_b, b_funcIndex);
-	float m_localU = DenormalizeU(u_m, m_funcIndex);
-
-	auto a_pos = mBezierEquations[a_funcIndex](a_localU);
-	auto m_pos = mBezierEquations[m_funcIndex](m_localU);
-	auto b_pos = mBezierEquations[b_funcIndex](b_localU);
+	//The midpoint strays from the chord by about curvature * chord length^2 / 8, so tight bends and
+	//long chords split first, and the projection scales that by how close the eye is.
+	float uMid = (u0 + u1) * 0.5f;
+	XMVECTOR pMid = mPath->GetSpline().Evaluate(segment, uMid);
+	XMVECTOR eye = XMLoadFloat3(&mTessellationEye);
+	float eyeDistance = XMVectorGetX(XMVectorMin(XMVector3Length(p0 - eye), XMVectorMin(XMVector3Length(pMid - eye), XMVector3Length(p1 - eye))));
+	eyeDistance = std::max(eyeDistance, MinEyeDistance);
+	float errorPixels = XMVectorGetX(XMVector3Length(pMid - (p0 + p1) * 0.5f)) * mTessellationFocalLength / eyeDistance;
 
-	XMVECTOR s_am = XMVector3Length(m_pos - a_pos);
-	XMVECTOR s_mb = XMVector3Length(b_pos - m_pos);
-	XMVECTOR s_ab = XMVector3Length(b_pos - a_pos);
-	XMFLOAT3 lengthOutputReadable;
-
-	XMStoreFloat3(&lengthOutputReadable, s_am);
-	float am_length = lengthOutputReadable.x;
-
-	XMStoreFloat3(&lengthOutputReadable, s_mb);
-	float mb_length = lengthOutputReadable.x;
-
-	XMStoreFloat3(&lengthOutputReadable, s_ab);
-	float ab_length = lengthOutputReadable.x;
+	if (depth < MaxSubdivisionDepth && (depth < MinSubdivisionDepth || errorPixels > LineErrorPixels))
+	{
+		Subdivide(segment, u0, p0, uMid, pMid, depth + 1, outLines);
+		Subdivide(segment, uMid, pMid, u1, p1, depth + 1, outLines);
+		return;
+	}
 
-	return XMFLOAT3(am_length, mb_length, ab_length);
+	mTessellationMinDistance = std::min(mTessellationMinDistance, eyeDistance);
+	XMFLOAT3 start;
+	XMFLOAT3 end;
+	XMStoreFloat3(&start, p0);
+	XMStoreFloat3(&end, p1);
+	outLines.push_back(start);
+	outLines.push_back(end);
 }
 
-void PathGenerator::BuildAdaptiveTable(float threshHold)
+void PathGenerator::PatchLines(const std::vector<PathSplice>& splices)
 {
-	std::list<std::pair<float, float>> segments;
-	mParamArcLengthMap[0.f] = 0.f;
-	int preSegmentAmount = 10;
-	float preSegmentSlice = 1.f / preSegmentAmount;
-	for(int i = 0; i < preSegmentAmount; ++i)
-	{
-		segments.push_back({i * preSegmentSlice, (i+1) * preSegmentSlice });
-	}
-	auto i = segments.begin();
-	while(segments.empty() == false)
+	for (const auto& splice : splices)
 	{
-		float u_a = i->first;
-		float u_b = i->second;
-		float u_m = (u_a + u_b) * 0.5f;
-
-		auto distances = GetPointDistances(u_a, u_b, u_m);//Return order: am -> mb -> ab
-		float am_length = distances.x;
-		float mb_length = distances.y;
-		float ab_length = distances.z;
-
-		if (am_length + mb_length - ab_length < threshHold)
+		auto first = mSegmentLines.begin() + splice.firstSegment;
+		first = mSegmentLines.erase(first, first + splice.oldSegmentCount);
+		mSegmentLines.insert(first, splice.newSegmentCount, std::vector<XMFLOAT3>());
+		for (int i = 0; i < splice.newSegmentCount; ++i)
 		{
-			//Case1: Complete
-			float firstHalfLength = mParamArcLengthMap[u_a] + am_length;
-			mParamArcLengthMap[u_m] = firstHalfLength;
-			mParamArcLengthMap[u_b] = firstHalfLength + mb_length;
-			segments.remove(*i);
+			TessellateSegment(splice.firstSegment + i);
 		}
-		else
-		{
-			//Case2: Divide and Repeat
-			segments.remove(*i);
-			std::pair firsthalf = {u_a, u_m};
-			std::pair secondhalf = {u_m, u_b};
-			segments.push_front(secondhalf);
-			segments.push_front(firsthalf);
-		}
-		i = segments.begin();
-	}
-	mWorldArcLength = (--mParamArcLengthMap.end())->second;
-
-	for (auto& element : mParamArcLengthMap)
-	{
-		element.second /= mWorldArcLength;
-	}
-	for (auto element : mParamArcLengthMap)
-	{
-		mArcLengthParamMap[element.second] = element.first;
 	}
+	mLineBufferDirty = true;
 }
 
-float PathGenerator::DistanceTimeFunction(float tick)
+bool PathGenerator::IsTessellationStale(XMVECTOR eyePosition, float focalLengthPixels) const
 {
-	return (sin(tick * MathHelper::Pi - MathHelper::Pi * 0.5f) + 1) * 0.5f;
-	//return tick;
-}
-
-float PathGenerator::VelocityTimeFunction(float tick)
-{
-	return 0.5f * MathHelper::Pi * sin(MathHelper::Pi * tick);
-
+	if (fabsf(focalLengthPixels - mTessellationFocalLength) > mTessellationFocalLength * 0.01f)
+	{
+		return true;
+	}
+	//Every vertex stays at least half as far as it was, so the error at most doubles to a pixel.
+	float moved = XMVectorGetX(XMVector3Length(eyePosition - XMLoadFloat3(&mTessellationEye)));
+	return moved > mTessellationMinDistance * 0.5f;
 }
 
 void PathGenerator::ArcLengthToPosition(float arcLength)
 {
-	static std::vector<int> test;
-	auto highUitor = mArcLengthParamMap.lower_bound(arcLength);
-	auto lowUitor = highUitor; --lowUitor;
-	if(highUitor == mArcLengthParamMap.begin())
-	{
-		mCurrentPosition = mBezierEquations[0](0);
-		return;
-	}
-	float highU = highUitor->second;
-	float lowU = lowUitor->second;
-
-	auto highS = mParamArcLengthMap[highU];
-	auto lowS = mParamArcLengthMap[lowU];
-
-	float interpolateArcLength = (arcLength - lowS) / (highS - lowS);
-	float interpolatedU = (highU - lowU) * interpolateArcLength + lowU;
-
-	int segmentNum = mBezierEquations.size();
-
-	int equationIndex = std::clamp(floorf(interpolatedU * segmentNum),0.f, (float)(segmentNum - 1));
-	float denormalizeU = interpolatedU * segmentNum - equationIndex;
-	auto currentPosition = mBezierEquations[equationIndex](denormalizeU);
-
-	int nextIndex = std::clamp(floorf(highU * segmentNum), 0.f, (float)(segmentNum - 1));
-	float nextDenormalizeU = highU * segmentNum - nextIndex;
-	auto nextPosition = mBezierEquations[nextIndex](nextDenormalizeU);
-
-	mCurrentFrameRotation = XMVector3Normalize(nextPosition - currentPosition);
-	mCurrentPosition = currentPosition;
+	mPath->Sample(arcLength, mCurrentPosition, mCurrentFrameRotation);
 }
 
-XMVECTOR PathGenerator::GetDirection()
+XMVECTOR PathGenerator::GetOrientation()
 {
 	return mCurrentFrameRotation;
 }
@@ -1,55 +1,82 @@
 #pragma once
 #include <vector>
 #include <DirectXMath.h>
-#include <functional>
-#include <map>
 #include <memory>
 
 #include "GameTimer.h"
+#include "IArcLength.h"
+#include "VertexBuffer.h"
 
 using namespace DirectX;
 class CommandList;
+class DXApp;
 class Model;
+class Path;
+class SpeedProfile;
+struct PathSplice;
 class PathGenerator
 {
 public:
-	PathGenerator(std::shared_ptr<Model> controlPointModel);
+	PathGenerator(DXApp* dxApp, std::shared_ptr<Model> controlPointModel, const std::vector<XMVECTOR>& controlPoints,
+		ArcLengthMethod arcLengthMethod = ArcLengthMethod::AdaptiveTable);
 	float Update(GameTimer dt, float tickPerSec, float duration, float distancePerDuration);
-	void DrawPaths(CommandList& commandList);
+	/**
+	 * @brief Draw the path as a line list, tessellated finely enough that it strays less than a pixel from the curve.
+	 * @detail focalLengthPixels is the projection scale times half the viewport height. Lines are kept in a vertex buffer
+	 * and only rebuilt after an edit, a change of projection, or a camera move that could bring them over the error bound.
+	 */
+	void DrawPaths(CommandList& commandList, XMVECTOR eyePosition, float focalLengthPixels);
 	void DrawControlPoints(CommandList& commandList);
-	XMVECTOR GetDirection();
+	XMVECTOR GetOrientation();
 	XMVECTOR GetPosition();
+	std::shared_ptr<const Path> GetPath() const { return mPath; }
+
+	void MoveControlPoint(int index, XMVECTOR position);
+	void InsertControlPoint(int index, XMVECTOR position);
+	void RemoveControlPoint(int index);
+	/**
+	 * @brief Replace the whole route, e.g. with a new plan from NavQuery::FindLoop.
+	 */
+	void SetControlPoints(const std::vector<XMVECTOR>& controlPoints);
+
+	/**
+	 * @brief Ease of each lap. Profiles are immutable and can be shared between generators and crowds.
+	 */
+	void SetSpeedProfile(std::shared_ptr<const SpeedProfile> speedProfile) { mSpeedProfile = speedProfile; }
+	/**
+	 * @brief Scale from timer ticks to lap time.
+	 */
+	void SetPlaybackRate(float playbackRate) { mPlaybackRate = playbackRate; }
 
 private:
-	void GetPointStrip();
-	void CalcSubPoints();
-	void BuildFunctions();
-	void BuildAdaptiveTable(float threshHold);
+	void TessellateLines();
+	void TessellateSegment(int segment);
+	void Subdivide(int segment, float u0, XMVECTOR p0, float u1, XMVECTOR p1, int depth, std::vector<XMFLOAT3>& outLines);
+	void PatchLines(const std::vector<PathSplice>& splices);
+	bool IsTessellationStale(XMVECTOR eyePosition, float focalLengthPixels) const;
 	void ArcLengthToPosition(float arcLength);
-	float DistanceTimeFunction(float tick);
-	float VelocityTimeFunction(float tick);
-	XMVECTOR CalcA(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2);
-	XMVECTOR CalcB(XMVECTOR p_0, XMVECTOR p_1, XMVECTOR p_2);
-	int GetBezierIndex(float u);
-	float DenormalizeU(float globalU, int index);
-	XMFLOAT3 GetPointDistances(float u_a, float u_b, float u_m);
 
 private:
-	std::vector<XMVECTOR> mControlPoints;
-	std::vector<XMVECTOR> mSubPoints;
-	std::vector<std::function<XMVECTOR(float)>> mBezierEquations;
-	std::vector<XMFLOAT3> mPathLines;
-	std::map<float, float> mParamArcLengthMap;//key: parameter, value: arc length
-	std::map<float, float> mArcLengthParamMap;//key: arc length , value: parameter
-	float mWorldArcLength;
+	std::shared_ptr<Path> mPath;
+
+	//Line list vertex pairs per segment, so edits only redo the segments they touch.
+	std::vector<std::vector<XMFLOAT3>> mSegmentLines;
+	std::vector<XMFLOAT3> mLineVertices;
+	VertexBuffer mLineBuffer;
+	bool mLineBufferDirty;
+	//Camera the lines were tessellated for. The eye may move by half the distance to the nearest vertex before they are redone.
+	XMFLOAT3 mTessellationEye;
+	float mTessellationFocalLength;
+	float mTessellationMinDistance;
 
 	XMVECTOR mCurrentFrameRotation;
 	XMVECTOR mCurrentPosition;
 
-	int mSlice;
-	float mDeltaU;
 	float mTickAccumulating;
+	float mPlaybackRate;
+	std::shared_ptr<const SpeedProfile> mSpeedProfile;
 
 	std::shared_ptr<Model> mControlPointModel;
+	ArcLengthMethod mArcLengthMethod;
 };
 
@@ -0,0 +1,88 @@
+#include "RangeAllocator.h"
+#include <cassert>
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint64_t capacity)
+	:mCapacity(capacity)
+{
+	Reset();
+}
+
+uint64_t RangeAllocator::Allocate(uint64_t size)
+{
+	assert(size > 0);
+	auto fit = mFreeBySize.lower_bound({ size, 0 });
+	if (fit == mFreeBySize.end())
+	{
+		return InvalidOffset;
+	}
+
+	uint64_t offset = fit->second;
+	uint64_t rangeSize = fit->first;
+	RemoveFreeRange(mFreeByOffset.find(offset));
+	if (rangeSize > size)
+	{
+		AddFreeRange(offset + size, rangeSize - size);
+	}
+	return offset;
+}
+
+void RangeAllocator::Free(uint64_t offset, uint64_t size)
+{
+	assert(size > 0 && offset + size <= mCapacity);
+	auto next = mFreeByOffset.lower_bound(offset);
+	assert(next == mFreeByOffset.end() || next->first >= offset + size);
+	if (next != mFreeByOffset.end() && next->first == offset + size)
+	{
+		size += next->second;
+		auto following = std::next(next);
+		RemoveFreeRange(next);
+		next = following;
+	}
+	if (next != mFreeByOffset.begin())
+	{
+		auto previous = std::prev(next);
+		assert(previous->first + previous->second <= offset);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			RemoveFreeRange(previous);
+		}
+	}
+	AddFreeRange(offset, size);
+}
+
+void RangeAllocator::Reset()
+{
+	mFreeByOffset.clear();
+	mFreeBySize.clear();
+	mFreeSize = 0;
+	if (mCapacity > 0)
+	{
+		AddFreeRange(0, mCapacity);
+	}
+}
+
+float RangeAllocator::GetFragmentation() const
+{
+	if (mFreeSize == 0)
+	{
+		return 0.f;
+	}
+	return 1.f - static_cast<float>(GetLargestFreeRange()) / static_cast<float>(mFreeSize);
+}
+
+void RangeAllocator::AddFreeRange(uint64_t offset, uint64_t size)
+{
+	mFreeByOffset.emplace(offset, size);
+	mFreeBySize.emplace(size, offset);
+	mFreeSize += size;
+}
+
+void RangeAllocator::RemoveFreeRange(std::map<uint64_t, uint64_t>::iterator range)
+{
+	mFreeBySize.erase({ range->second, range->first });
+	mFreeSize -= range->second;
+	mFreeByOffset.erase(range);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+/**
+ * @brief Free list over the range [0, capacity) of something else, such as the elements of a GPU buffer.
+ * @detail Allocation is best fit, smallest free range that holds the size, taking its front. Freed ranges merge
+ * with free neighbours, so freeing everything leaves a single range again. Only offsets are handed out,
+ * the caller keeps the sizes to free with.
+ */
+class RangeAllocator
+{
+public:
+	static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+	explicit RangeAllocator(uint64_t capacity = 0);
+
+	/**
+	 * @return Offset of the range, InvalidOffset when no free range is large enough.
+	 */
+	uint64_t Allocate(uint64_t size);
+	void Free(uint64_t offset, uint64_t size);
+	/**
+	 * @brief Free everything. Allocating in some order afterwards packs the ranges from 0 in that order.
+	 */
+	void Reset();
+
+	uint64_t GetCapacity() const { return mCapacity; }
+	uint64_t GetFreeSize() const { return mFreeSize; }
+	uint64_t GetLargestFreeRange() const { return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first; }
+	size_t GetFreeRangeCount() const { return mFreeByOffset.size(); }
+	/**
+	 * @brief Share of the free size outside the largest free range, 0 when all of it could go to one allocation.
+	 */
+	float GetFragmentation() const;
+
+private:
+	void AddFreeRange(uint64_t offset, uint64_t size);
+	void RemoveFreeRange(std::map<uint64_t, uint64_t>::iterator range);
+
+	uint64_t mCapacity;
+	uint64_t mFreeSize = 0;
+	//Offset to size, to find the neighbours of a freed range.
+	std::map<uint64_t, uint64_t> mFreeByOffset;
+	//Size and offset, for best fit. Ordered by both, so a range is found again without a search among equal sizes.
+	std::set<std::pair<uint64_t, uint64_t>> mFreeBySize;
+};
@@ -0,0 +1,73 @@
+#include "SegmentBvh.h"
+#include <algorithm>
+#include <cassert>
+
+void SegmentBvh::Build(const std::vector<XMFLOAT3>& boundsMins, const std::vector<XMFLOAT3>& boundsMaxs)
+{
+	assert(boundsMins.size() == boundsMaxs.size());
+	int segmentCount = static_cast<int>(boundsMins.size());
+	mSegmentMins = boundsMins;
+	mSegmentMaxs = boundsMaxs;
+
+	mSegments.resize(segmentCount);
+	mCentroids.resize(segmentCount);
+	for (int segment = 0; segment < segmentCount; ++segment)
+	{
+		mSegments[segment] = segment;
+		XMStoreFloat3(&mCentroids[segment], (XMLoadFloat3(&boundsMins[segment]) + XMLoadFloat3(&boundsMaxs[segment])) * 0.5f);
+	}
+
+	mNodes.clear();
+	mNodes.reserve(segmentCount * 2);
+	if (segmentCount > 0)
+	{
+		BuildNode(0, segmentCount);
+	}
+}
+
+int SegmentBvh::BuildNode(int begin, int end)
+{
+	int nodeIndex = static_cast<int>(mNodes.size());
+	mNodes.push_back({});
+
+	XMVECTOR boundsMin = XMLoadFloat3(&mSegmentMins[mSegments[begin]]);
+	XMVECTOR boundsMax = XMLoadFloat3(&mSegmentMaxs[mSegments[begin]]);
+	XMVECTOR centroidMin = XMLoadFloat3(&mCentroids[mSegments[begin]]);
+	XMVECTOR centroidMax = centroidMin;
+	for (int i = begin + 1; i < end; ++i)
+	{
+		int segment = mSegments[i];
+		boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&mSegmentMins[segment]));
+		boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&mSegmentMaxs[segment]));
+		centroidMin = XMVectorMin(centroidMin, XMLoadFloat3(&mCentroids[segment]));
+		centroidMax = XMVectorMax(centroidMax, XMLoadFloat3(&mCentroids[segment]));
+	}
+	XMStoreFloat3(&mNodes[nodeIndex].boundsMin, boundsMin);
+	XMStoreFloat3(&mNodes[nodeIndex].boundsMax, boundsMax);
+
+	if (end - begin <= LeafSize)
+	{
+		mNodes[nodeIndex].rightChild = -1;
+		mNodes[nodeIndex].segmentCount = end - begin;
+		mNodes[nodeIndex].firstSegment = begin;
+		return nodeIndex;
+	}
+
+	XMFLOAT3 extent;
+	XMStoreFloat3(&extent, centroidMax - centroidMin);
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	//Median split keeps the tree balanced, so the traversal stack stays shallow.
+	int middle = (begin + end) / 2;
+	std::nth_element(mSegments.begin() + begin, mSegments.begin() + middle, mSegments.begin() + end, [this, axis](int a, int b)
+	{
+		return (&mCentroids[a].x)[axis] < (&mCentroids[b].x)[axis];
+	});
+
+	BuildNode(begin, middle);
+	int rightChild = BuildNode(middle, end);
+	mNodes[nodeIndex].rightChild = rightChild;
+	mNodes[nodeIndex].segmentCount = 0;
+	mNodes[nodeIndex].firstSegment = 0;
+	return nodeIndex;
+}
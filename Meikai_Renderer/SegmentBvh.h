@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+/**
+ * @brief Bounding volume hierarchy over the axis aligned boxes of spline segments.
+ * @detail Nodes are stored depth first, so a node's left child directly follows it. Leaves hold up to
+ * LeafSize entries of mSegments. FindNearest visits the nearer child first and skips every box
+ * farther than the best distance found so far.
+ */
+class SegmentBvh
+{
+public:
+	static constexpr int LeafSize = 4;
+
+	SegmentBvh() = default;
+
+	/**
+	 * @brief Rebuild the tree top down, splitting at the median of the widest axis.
+	 */
+	void Build(const std::vector<XMFLOAT3>& boundsMins, const std::vector<XMFLOAT3>& boundsMaxs);
+
+	/**
+	 * @brief Walk the segments whose boxes lie closer to point than bestDistanceSquared.
+	 * @detail visitSegment(segment, bestDistanceSquared) returns the new best squared distance.
+	 */
+	template<typename Func>
+	float FindNearest(XMVECTOR point, float bestDistanceSquared, Func&& visitSegment) const
+	{
+		if (mNodes.empty())
+		{
+			return bestDistanceSquared;
+		}
+
+		int stack[64];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const Node& node = mNodes[stack[--stackSize]];
+			if (GetBoxDistanceSquared(node.boundsMin, node.boundsMax, point) >= bestDistanceSquared)
+			{
+				continue;
+			}
+
+			if (node.segmentCount > 0)
+			{
+				for (int i = node.firstSegment; i < node.firstSegment + node.segmentCount; ++i)
+				{
+					int segment = mSegments[i];
+					if (GetBoxDistanceSquared(mSegmentMins[segment], mSegmentMaxs[segment], point) < bestDistanceSquared)
+					{
+						bestDistanceSquared = visitSegment(segment, bestDistanceSquared);
+					}
+				}
+				continue;
+			}
+
+			//Push the farther child first so the nearer one tightens the bound before it is tested.
+			int left = static_cast<int>(&node - mNodes.data()) + 1;
+			int right = node.rightChild;
+			float leftDistance = GetBoxDistanceSquared(mNodes[left].boundsMin, mNodes[left].boundsMax, point);
+			float rightDistance = GetBoxDistanceSquared(mNodes[right].boundsMin, mNodes[right].boundsMax, point);
+			if (leftDistance < rightDistance)
+			{
+				stack[stackSize++] = right;
+				stack[stackSize++] = left;
+			}
+			else
+			{
+				stack[stackSize++] = left;
+				stack[stackSize++] = right;
+			}
+		}
+		return bestDistanceSquared;
+	}
+
+	size_t GetNodeCount() const { return mNodes.size(); }
+
+private:
+	struct Node
+	{
+		XMFLOAT3 boundsMin;
+		int rightChild;
+		XMFLOAT3 boundsMax;
+		//Zero for inner nodes.
+		int segmentCount;
+		int firstSegment;
+	};
+
+	int BuildNode(int begin, int end);
+
+	static float GetBoxDistanceSquared(const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax, XMVECTOR point)
+	{
+		XMVECTOR outside = XMVectorMax(XMLoadFloat3(&boundsMin) - point, point - XMLoadFloat3(&boundsMax));
+		outside = XMVectorMax(outside, XMVectorZero());
+		return XMVectorGetX(XMVector3Dot(outside, outside));
+	}
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<int> mSegments;
+	std::vector<XMFLOAT3> mSegmentMins;
+	std::vector<XMFLOAT3> mSegmentMaxs;
+	std::vector<XMFLOAT3> mCentroids;
+};
@@ -1,29 +1,58 @@
 #include "SkeletalMesh.h"
 #include "DXApp.h"
 #include "MathHelper.h"
+#include "VertexCompression.h"
 
-SkeletalMesh::SkeletalMesh(DXApp* dxApp, const aiScene* aiPtr, std::vector<SkeletalVertex> input_vertices,
-	std::vector<UINT> input_indices, CommandList& commandList)
-	:mApp(dxApp), mScenePtr(aiPtr), mSkeletalVertices(std::move(input_vertices)), mIndices(std::move(input_indices)),
-	mVertexBuffer(dxApp), mIndexBuffer(dxApp),
-	mIndexCount(0)
+SkeletalMesh::SkeletalMesh(DXApp* dxApp, std::vector<SkeletalVertex> input_vertices,
+	std::vector<UINT> input_indices, const MeshBounds& bounds, CommandList& commandList, GeometryRetention retention)
+	:mApp(dxApp), mSkeletalVertices(std::move(input_vertices)), mIndices(std::move(input_indices)),
+	mVertexBuffer(dxApp), mIndexBuffer(dxApp), mBounds(bounds)
 {
 	Init(commandList);
+	ReleaseCpuGeometry(retention);
 }
 
 void SkeletalMesh::Init(CommandList& commandList)
 {
 	if (mSkeletalVertices.size() >= UINT_MAX)
 	{
-		throw std::exception("Too many vertices for 16-bit index buffer");
+		throw std::exception("Too many vertices for 32-bit index buffer");
 	}
 
-	commandList.CopyVertexBuffer(mVertexBuffer, mSkeletalVertices);
-	mVertexBuffer.CreateVertexBufferView(mSkeletalVertices.size(), sizeof(mSkeletalVertices[0]));
-	commandList.CopyIndexBuffer(mIndexBuffer, mIndices);
-	mIndexBuffer.CreateViews(mIndices.size(), sizeof(mIndices[0]));
+	//The GPU copy always has 16-bit indices, meshes with more vertices are drawn in parts.
+	MeshPartition partition = MeshPartition::Build(mIndices, mSkeletalVertices.size());
+	std::vector<PackedSkeletalVertex> packedVertices(partition.vertexCount);
+	for (size_t i = 0; i < packedVertices.size(); ++i)
+	{
+		packedVertices[i] = VertexCompression::Pack(mSkeletalVertices[partition.GetSourceVertex(i)]);
+	}
+	commandList.CopyVertexBuffer(mVertexBuffer, packedVertices);
+	mVertexBuffer.CreateVertexBufferView(packedVertices.size(), sizeof(PackedSkeletalVertex));
+	commandList.CopyIndexBuffer(mIndexBuffer, partition.indices);
+	mIndexBuffer.CreateViews(partition.indices.size(), sizeof(partition.indices[0]));
 
-	mIndexCount = static_cast<UINT>(mIndices.size());
+	mParts = std::move(partition.parts);
+}
+
+void SkeletalMesh::ReleaseCpuGeometry(GeometryRetention retention)
+{
+	//Recording the copies already staged the data in upload buffers, so the GPU no longer needs these.
+	if (retention == GeometryRetention::Positions)
+	{
+		mPositions.resize(mSkeletalVertices.size());
+		for (size_t i = 0; i < mSkeletalVertices.size(); ++i)
+		{
+			mPositions[i] = mSkeletalVertices[i].position;
+		}
+	}
+	if (retention != GeometryRetention::Full)
+	{
+		std::vector<SkeletalVertex>().swap(mSkeletalVertices);
+	}
+	if (retention == GeometryRetention::None)
+	{
+		std::vector<UINT>().swap(mIndices);
+	}
 }
 
 void SkeletalMesh::Draw(CommandList& commandList)
@@ -31,7 +60,10 @@ void SkeletalMesh::Draw(CommandList& commandList)
 	commandList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	commandList.SetVertexBuffer(0, mVertexBuffer);
 	commandList.SetIndexBuffer(mIndexBuffer);
-	commandList.DrawIndexed(mIndexCount);
+	for (const MeshPart& part : mParts)
+	{
+		commandList.DrawIndexed(part.indexCount, 1, part.startIndex, part.baseVertex);
+	}
 }
 
 void SkeletalVertex::AddBoneData(int boneID, float weight)
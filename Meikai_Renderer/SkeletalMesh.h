@@ -8,6 +8,7 @@
 #include "CommandList.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
+#include "Mesh.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -44,21 +45,39 @@ private:
 	DXApp* mApp = nullptr;
 
 public:
-	SkeletalMesh(DXApp* dxApp, const aiScene* aiPtr, std::vector<SkeletalVertex> input_vertices, std::vector<UINT> input_indices, CommandList& commandList);
+	/**
+	 * @param bounds Object space bounds of input_vertices in the bind pose.
+	 */
+	SkeletalMesh(DXApp* dxApp, std::vector<SkeletalVertex> input_vertices, std::vector<UINT> input_indices, const MeshBounds& bounds,
+		CommandList& commandList, GeometryRetention retention = GeometryRetention::Full);
 
 	void Draw(CommandList& commandList);
+	//Empty unless the retention is Full.
+	const std::vector<SkeletalVertex>& GetVertices() const { return mSkeletalVertices; }
+	//Empty when the retention is None.
+	const std::vector<UINT>& GetIndices() const { return mIndices; }
+	/**
+	 * @brief Bind pose positions kept on the CPU, GetPositionStride bytes apart. Null when the retention is None.
+	 */
+	const XMFLOAT3* GetPositions() const { return mSkeletalVertices.empty() ? mPositions.data() : &mSkeletalVertices[0].position; }
+	UINT GetPositionStride() const { return mSkeletalVertices.empty() ? sizeof(XMFLOAT3) : sizeof(SkeletalVertex); }
+	size_t GetPositionCount() const { return mSkeletalVertices.empty() ? mPositions.size() : mSkeletalVertices.size(); }
+	//Of the bind pose, animation may move the vertices outside.
+	const MeshBounds& GetBounds() const { return mBounds; }
 private:
-	const aiScene* mScenePtr;
 
 	VertexBuffer mVertexBuffer;
 	IndexBuffer mIndexBuffer;
 
 	std::vector<SkeletalVertex> mSkeletalVertices;
 	std::vector<UINT> mIndices;
+	std::vector<XMFLOAT3> mPositions;
 
-	UINT mIndexCount;
+	std::vector<MeshPart> mParts;
+	MeshBounds mBounds;
 
 private:
 	void Init(CommandList& commandList);
+	void ReleaseCpuGeometry(GeometryRetention retention);
 };
 
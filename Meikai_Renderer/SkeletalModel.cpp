@@ -1,29 +1,149 @@
 #include "SkeletalModel.h"
 #include "MathHelper.h"
 #include "Animation.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "VertexWelder.h"
+#include "ThreadPool.h"
 
-SkeletalModel::SkeletalModel(const std::string& file_path, DXApp* app, CommandList& commandList)
-	:mApp(app)
+SkeletalModel::SkeletalModel(const std::string& file_path, DXApp* app, CommandList& commandList, GeometryRetention retention)
+	:mApp(app), mRetention(retention)
 {
-	LoadModel(file_path, commandList);
+	LoadModel(file_path);
+	Upload(commandList);
 }
 
-void SkeletalModel::LoadModel(const std::string& file_path, CommandList& commandList)
+SkeletalModel::SkeletalModel(const std::string& file_path, DXApp* app, GeometryRetention retention, ThreadPool* threadPool)
+	:mApp(app), mRetention(retention)
 {
-    mImporter.SetPropertyBool(AI_CONFIG_FBX_USE_SKELETON_BONE_CONTAINER, true);
+	LoadModel(file_path, threadPool);
+}
+
+void SkeletalModel::Upload(CommandList& commandList)
+{
+	for (SkeletalMeshData& mesh : mImportedMeshes)
+	{
+		mBounds = MeshBounds::Merge(mBounds, mesh.bounds);
+		mMeshes.push_back(SkeletalMesh(mApp, std::move(mesh.vertices), std::move(mesh.indices), mesh.bounds, commandList, mRetention));
+	}
+	std::vector<SkeletalMeshData>().swap(mImportedMeshes);
+}
+
+void SkeletalModel::LoadModel(const std::string& file_path, ThreadPool* threadPool)
+{
+	name = file_path.substr(0, file_path.find_last_of('/'));
+	if (LoadCooked(file_path))
+	{
+		return;
+	}
+
+	//Local, so the scene is freed as soon as it is converted.
+	Assimp::Importer importer;
+    importer.SetPropertyBool(AI_CONFIG_FBX_USE_SKELETON_BONE_CONTAINER, true);
 
-    pScene = mImporter.ReadFile(file_path,
-        aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_ConvertToLeftHanded);
+    const aiScene* pScene = importer.ReadFile(file_path, ImportFlags);
 
     if (!pScene || pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !pScene->mRootNode)
     {
         assert("Fail to Load %s", file_path.c_str());
     }
-	name = file_path.substr(0, file_path.find_last_of('/'));
-    ProcessNode(pScene->mRootNode, pScene, commandList);
+    ProcessNode(pScene->mRootNode, pScene);
+	OptimizeMeshes(file_path, threadPool);
+	Cook(file_path);
+}
+
+void SkeletalModel::OptimizeMeshes(const std::string& file_path, ThreadPool* threadPool)
+{
+	int meshCount = static_cast<int>(mImportedMeshes.size());
+	std::vector<VertexCacheStats> meshBefore(meshCount);
+	std::vector<VertexCacheStats> meshAfter(meshCount);
+	std::vector<WeldStats> meshWelds(meshCount);
+	auto optimizeRange = [&](int begin, int end)
+		{
+			for (int mesh = begin; mesh < end; ++mesh)
+			{
+				//Bone weights are compared as well, so only vertices skinned alike weld.
+				meshWelds[mesh] = VertexWelder::Weld(mImportedMeshes[mesh].vertices, mImportedMeshes[mesh].indices);
+				MeshOptimizer::Optimize(mImportedMeshes[mesh].vertices, mImportedMeshes[mesh].indices, meshBefore[mesh], meshAfter[mesh]);
+			}
+		};
+	if (threadPool == nullptr)
+	{
+		optimizeRange(0, meshCount);
+	}
+	else
+	{
+		threadPool->ParallelFor(meshCount, 1, optimizeRange);
+	}
+
+	VertexCacheStats before;
+	VertexCacheStats after;
+	WeldStats welds;
+	for (int mesh = 0; mesh < meshCount; ++mesh)
+	{
+		welds.Add(meshWelds[mesh]);
+		before.Add(meshBefore[mesh]);
+		after.Add(meshAfter[mesh]);
+	}
+	VertexWelder::Report(file_path, welds);
+	MeshOptimizer::Report(file_path, before, after);
+}
+
+bool SkeletalModel::LoadCooked(const std::string& file_path)
+{
+	MeshCache cache;
+	if (cache.Open(file_path, MeshCacheLayout::Skeletal, sizeof(SkeletalVertex), ImportFlags) == false)
+	{
+		return false;
+	}
+
+	for (const MeshCacheBone& bone : cache.GetBones())
+	{
+		BoneInfo boneInfo;
+		boneInfo.id = bone.id;
+		memcpy(&boneInfo.offset, &bone.offset, sizeof(boneInfo.offset));
+		mBoneInfoMap[bone.name] = boneInfo;
+	}
+	mBoneCounter = static_cast<UINT>(mBoneInfoMap.size());
+
+	for (int subMesh = 0; subMesh < cache.GetSubMeshCount(); ++subMesh)
+	{
+		SkeletalMeshData mesh = { cache.GetVertices<SkeletalVertex>(subMesh), cache.GetIndices(subMesh) };
+		mesh.bounds = MeshBounds::FromVertices(mesh.vertices);
+		mImportedMeshes.push_back(std::move(mesh));
+	}
+	return true;
+}
+
+void SkeletalModel::Cook(const std::string& file_path) const
+{
+	std::vector<MeshCacheSubMesh> subMeshes;
+	std::vector<SkeletalVertex> vertices;
+	std::vector<UINT> indices;
+	for (const SkeletalMeshData& mesh : mImportedMeshes)
+	{
+		subMeshes.push_back({ static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(mesh.vertices.size()),
+			static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(mesh.indices.size()), 0, 0 });
+		vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+		indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+	}
+
+	std::vector<MeshCacheBone> bones;
+	for (const auto& [boneName, boneInfo] : mBoneInfoMap)
+	{
+		MeshCacheBone bone;
+		bone.name = boneName;
+		bone.id = boneInfo.id;
+		memcpy(&bone.offset, &boneInfo.offset, sizeof(bone.offset));
+		bones.push_back(bone);
+	}
+
+	//A cache that cannot be written only costs the next start another import.
+	MeshCache::Write(file_path, MeshCacheLayout::Skeletal, sizeof(SkeletalVertex), ImportFlags, subMeshes, vertices.data(), vertices.size(),
+		indices.data(), indices.size(), {}, bones);
 }
 
-void SkeletalModel::ProcessNode(aiNode* node, const aiScene* scene, CommandList& commandList)
+void SkeletalModel::ProcessNode(aiNode* node, const aiScene* scene)
 {
     // process each mesh located at the current node
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -31,38 +151,40 @@ void SkeletalModel::ProcessNode(aiNode* node, const aiScene* scene, CommandList&
         // the node object only contains indices to index the actual objects in the scene. 
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        mMeshes.push_back(ProcessMesh(mesh, scene, commandList));
+        mImportedMeshes.push_back(ProcessMesh(mesh, scene));
     }
     // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        ProcessNode(node->mChildren[i], scene, commandList);
+        ProcessNode(node->mChildren[i], scene);
     }
 }
 
-SkeletalMesh SkeletalModel::ProcessMesh(aiMesh* mesh, const aiScene* scene, CommandList& commandList)
+SkeletalMeshData SkeletalModel::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 {
-    std::vector<SkeletalVertex> vertices;
-    std::vector<UINT> indices;
+    SkeletalMeshData meshData;
 
-    LoadVertices(mesh, vertices);
+    LoadVertices(mesh, meshData.vertices);
     if (mesh->HasFaces())
     {
-        LoadIndices(mesh, indices);
+        LoadIndices(mesh, meshData.indices);
     }
     if (mesh->HasBones())
     {
-        ExtractBoneWeightForVertices(vertices, mesh, scene);
+        ExtractBoneWeightForVertices(meshData.vertices, mesh, scene);
     }
+    meshData.bounds = MeshBounds::FromVertices(meshData.vertices);
 
-    return SkeletalMesh(mApp, scene, vertices, indices, commandList);
+    return meshData;
 }
 
 void SkeletalModel::LoadVertices(aiMesh* mesh, std::vector<SkeletalVertex>& vertices)
 {
+    vertices.reserve(vertices.size() + mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
     {
-        SkeletalVertex vertex;
+        //Zeroed, as attributes the mesh lacks are compared when welding.
+        SkeletalVertex vertex = {};
         XMFLOAT3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
         // positions
         vector.x = mesh->mVertices[i].x;
@@ -107,6 +229,7 @@ void SkeletalModel::LoadVertices(aiMesh* mesh, std::vector<SkeletalVertex>& vert
 
 void SkeletalModel::LoadIndices(aiMesh* mesh, std::vector<UINT>& indices)
 {
+    indices.reserve(indices.size() + mesh->mNumFaces * 3);
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
         aiFace face = mesh->mFaces[i];
@@ -15,6 +15,15 @@ using namespace DirectX;
 struct DXApp;
 class CommandList;
 class Animation;
+class ThreadPool;
+
+struct SkeletalMeshData
+{
+	std::vector<SkeletalVertex> vertices;
+	std::vector<UINT> indices;
+	//Of the bind pose.
+	MeshBounds bounds;
+};
 
 /**
  * @brief Class for manage model with bone data.
@@ -27,30 +36,59 @@ private:
 	DXApp* mApp;
 
 public:
-	SkeletalModel(const std::string& file_path, DXApp* app, CommandList& commandList);
+	//Postprocessing every import runs with. Part of the cooked cache and asset registry keys.
+	static constexpr unsigned int ImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_ConvertToLeftHanded;
+
+	SkeletalModel(const std::string& file_path, DXApp* app, CommandList& commandList, GeometryRetention retention = GeometryRetention::Full);
+	/**
+	 * @brief Import only, without touching the GPU, so it may run on a worker thread.
+	 * @detail The meshes stay on the CPU until Upload records them. The importer and its scene are released
+	 * as soon as the meshes are converted, and retention decides what the meshes keep after the upload.
+	 * A threadPool spreads the per mesh processing of the import over its workers.
+	 */
+	SkeletalModel(const std::string& file_path, DXApp* app, GeometryRetention retention = GeometryRetention::Full, ThreadPool* threadPool = nullptr);
 	void Draw(CommandList& commandList);
 
-	void LoadModel(const std::string& file_path, CommandList& commandList);
-	void ProcessNode(aiNode* node, const aiScene* scene, CommandList& commandList);
-	SkeletalMesh ProcessMesh(aiMesh* mesh, const aiScene* scene, CommandList& commandList);
+	void LoadModel(const std::string& file_path, ThreadPool* threadPool = nullptr);
+	void ProcessNode(aiNode* node, const aiScene* scene);
+	SkeletalMeshData ProcessMesh(aiMesh* mesh, const aiScene* scene);
+	/**
+	 * @brief Record the copies of the imported meshes into commandList and build mMeshes.
+	 */
+	void Upload(CommandList& commandList);
 
 	void LoadVertices(aiMesh* mesh, std::vector<SkeletalVertex>& vertices);
 	void LoadIndices(aiMesh* mesh, std::vector<UINT>& indices);
 
 	auto& GetBoneInfoMap() { return mBoneInfoMap; }
 	UINT& GetBoneCount() { return mBoneCounter; }
+	//Object space bounds of all meshes in the bind pose, empty until Upload.
+	const MeshBounds& GetBounds() const { return mBounds; }
 
 	void ExtractBoneWeightForVertices(std::vector<SkeletalVertex>& vertices, aiMesh* mesh, const aiScene* scene);
 
+private:
+	/**
+	 * @brief Build the meshes and bone table from the cooked .mesh file instead of importing, when it is up to date.
+	 */
+	bool LoadCooked(const std::string& file_path);
+	void Cook(const std::string& file_path) const;
+	/**
+	 * @brief Reorder the imported meshes for the vertex cache, overdraw and vertex fetch. Runs before cooking, so the cache holds the result.
+	 */
+	void OptimizeMeshes(const std::string& file_path, ThreadPool* threadPool);
+
 private:
 	//Bone information sorted by bond ID.
 	std::map<std::string, BoneInfo> mBoneInfoMap;
 	UINT mBoneCounter = 0;
+	//Imported meshes waiting for Upload.
+	std::vector<SkeletalMeshData> mImportedMeshes;
+	GeometryRetention mRetention;
+	MeshBounds mBounds;
 
 public:
 	std::string name;
-	Assimp::Importer mImporter;
-	const aiScene* pScene = nullptr;
 
 	std::vector<SkeletalMesh> mMeshes;
 };
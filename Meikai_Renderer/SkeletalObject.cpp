@@ -11,7 +11,7 @@
 SkeletalObject::SkeletalObject(DXApp* appPtr, std::shared_ptr<SkeletalModel> model, std::shared_ptr<Animation> initAnim,
 	XMFLOAT3 position, XMFLOAT3 albedo, float metalic, float roughness, XMFLOAT3 scale)
     :mApp(appPtr), mModel(model), mAnimation(initAnim), mAnimator(mAnimation), mPosition(position),
-		mAlbedo(albedo), mMetalic(metalic), mRoughness(roughness), mScale(scale)
+		mAlbedo(albedo), mMetalic(metalic), mRoughness(roughness), mScale(scale), mOrientation(0.f, 0.f, 0.f, 1.f)
 {
     mAnimator.PlayAnimation(mAnimation);
 }
@@ -58,37 +58,18 @@ void SkeletalObject::DrawBone(CommandList& commandList)
     commandList.Draw(vertexCount);
 }
 
+MeshBounds SkeletalObject::GetWorldBounds() const
+{
+	return mModel->GetBounds().Transform(GetWorldMat());
+}
+
 XMMATRIX SkeletalObject::GetWorldMat() const
 {
     XMMATRIX scaleMat = XMMatrixScaling(mScale.x, mScale.y, mScale.z);
+    XMMATRIX rotationMat = XMMatrixRotationQuaternion(XMLoadFloat4(&mOrientation));
     XMMATRIX translationMat = XMMatrixTranslation(mPosition.x, mPosition.y, mPosition.z);
 
-    XMMATRIX result;
-    if(mDirection.x == 0.f && mDirection.y == 0.f && mDirection.z == 0.f)
-    {
-	    result = translationMat * scaleMat;
-    }
-    else
-    {
-        XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-        XMVECTOR dir = XMLoadFloat3(&mDirection);
-        XMVECTOR position = XMLoadFloat3(&mPosition);
-        XMVECTOR target = position + dir;
-        XMMATRIX lookAt = XMMatrixLookAtLH(target, position, up);
-        XMFLOAT4X4 rotationPart;
-        XMStoreFloat4x4(&rotationPart, lookAt);
-
-        for(int i = 0; i < 3; ++i)
-        {
-            rotationPart.m[3][i] = 0.f;
-        }
-        lookAt = XMLoadFloat4x4(&rotationPart);
-        
-        lookAt = XMMatrixInverse(nullptr, lookAt);
-        result = scaleMat * lookAt * translationMat;
-    }
-
-    return result;
+    return scaleMat * rotationMat * translationMat;
 }
 
 float SkeletalObject::GetTicksPerSec()
@@ -126,8 +107,25 @@ void SkeletalObject::SetPosition(XMVECTOR newPos)
 
 void SkeletalObject::SetDirection(XMVECTOR newDir)
 {
-    XMStoreFloat3(&mDirection, newDir);
+    if (XMVector3Equal(newDir, XMVectorZero()))
+    {
+        XMStoreFloat4(&mOrientation, XMQuaternionIdentity());
+        return;
+    }
 
+    XMMATRIX basis;
+    basis.r[2] = XMVector3Normalize(newDir);
+    basis.r[0] = XMVector3Normalize(XMVector3Cross(XMVectorSet(0.f, 1.f, 0.f, 0.f), basis.r[2]));
+    basis.r[1] = XMVector3Cross(basis.r[2], basis.r[0]);
+    basis.r[3] = XMVectorSet(0.f, 0.f, 0.f, 1.f);
+    SetOrientation(XMQuaternionRotationMatrix(basis));
+}
+
+void SkeletalObject::SetOrientation(XMVECTOR newOrientation)
+{
+    //The model faces local -Z, so turn it around before applying the frame.
+    XMVECTOR faceForward = XMQuaternionRotationRollPitchYaw(0.f, XM_PI, 0.f);
+    XMStoreFloat4(&mOrientation, XMQuaternionMultiply(faceForward, newOrientation));
 }
 
 void SkeletalObject::SetAlbedo(XMFLOAT3 newAlbedo)
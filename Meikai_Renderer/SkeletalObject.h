@@ -35,6 +35,10 @@ public:
 	void DrawBone(CommandList& commandList);
 
 	XMMATRIX GetWorldMat() const;
+	/**
+	 * @brief Bind pose bounds of the model moved to world space by GetWorldMat.
+	 */
+	MeshBounds GetWorldBounds() const;
 	float GetTicksPerSec();
 	float GetDuration();
 	float GetDistacnePerDuration();
@@ -43,6 +47,10 @@ public:
 
 	void SetPosition(XMVECTOR newPos);
 	void SetDirection(XMVECTOR newDir);
+	/**
+	 * @brief Set rotation from a path frame quaternion, which maps local +Z to the heading and +Y to up.
+	 */
+	void SetOrientation(XMVECTOR newOrientation);
 	void SetAlbedo(XMFLOAT3 newAlbedo);
 	void SetMetalic(float newMetalic);
 	void SetRoughness(float newRoughness);
@@ -65,6 +73,6 @@ private:
 
 	XMFLOAT3 mPosition;
 	XMFLOAT3 mScale;
-	XMFLOAT3 mDirection;
+	XMFLOAT4 mOrientation;
 };
 
@@ -0,0 +1,83 @@
+#include "SpatialHash.h"
+#include "ThreadPool.h"
+#include <cassert>
+
+namespace
+{
+	constexpr int PointsPerJob = 4096;
+}
+
+void SpatialHash::Build(const XMFLOAT3* positions, int count, float cellSize, ThreadPool* threadPool)
+{
+	assert(cellSize > 0.f);
+	mCellSize = cellSize;
+	mInverseCellSize = 1.f / cellSize;
+
+	//About two buckets per point keeps collisions between occupied cells rare.
+	int bucketCount = 1;
+	while (bucketCount < count * 2)
+	{
+		bucketCount <<= 1;
+	}
+	mBucketMask = static_cast<unsigned int>(bucketCount - 1);
+	if (mBucketCursorCapacity < bucketCount)
+	{
+		mBucketCursors = std::make_unique<std::atomic<int>[]>(bucketCount);
+		mBucketCursorCapacity = bucketCount;
+	}
+	for (int bucket = 0; bucket < bucketCount; ++bucket)
+	{
+		mBucketCursors[bucket].store(0, std::memory_order_relaxed);
+	}
+	mPointBuckets.resize(count);
+	mEntries.resize(count);
+	mBucketStarts.resize(bucketCount + 1);
+
+	if (threadPool == nullptr)
+	{
+		HashRange(positions, 0, count);
+	}
+	else
+	{
+		threadPool->ParallelFor(count, PointsPerJob, [this, positions](int begin, int end) { HashRange(positions, begin, end); });
+	}
+
+	//Exclusive prefix sum. The cursors then count up from each bucket start while scattering.
+	int start = 0;
+	for (int bucket = 0; bucket < bucketCount; ++bucket)
+	{
+		int bucketSize = mBucketCursors[bucket].load(std::memory_order_relaxed);
+		mBucketStarts[bucket] = start;
+		mBucketCursors[bucket].store(start, std::memory_order_relaxed);
+		start += bucketSize;
+	}
+	mBucketStarts[bucketCount] = start;
+
+	if (threadPool == nullptr)
+	{
+		ScatterRange(0, count);
+	}
+	else
+	{
+		threadPool->ParallelFor(count, PointsPerJob, [this](int begin, int end) { ScatterRange(begin, end); });
+	}
+}
+
+void SpatialHash::HashRange(const XMFLOAT3* positions, int begin, int end)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		unsigned int bucket = Hash(GetCell(positions[i].x), GetCell(positions[i].z));
+		mPointBuckets[i] = bucket;
+		mBucketCursors[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void SpatialHash::ScatterRange(int begin, int end)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		int slot = mBucketCursors[mPointBuckets[i]].fetch_add(1, std::memory_order_relaxed);
+		mEntries[slot] = i;
+	}
+}
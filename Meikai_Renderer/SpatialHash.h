@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+class ThreadPool;
+
+/**
+ * @brief Uniform grid over the XZ plane, hashed into buckets and rebuilt from scratch each frame.
+ * @detail Build is a counting sort of points by bucket: hash and count, prefix sum, scatter.
+ * Counting and scattering use atomic bucket counters, so both may run on the thread pool and
+ * the order of points inside a bucket is not stable between builds.
+ * Distinct cells may share a bucket, so callers still test the distance of every point they visit.
+ */
+class SpatialHash
+{
+public:
+	SpatialHash() = default;
+
+	SpatialHash(const SpatialHash& copy) = delete;
+	SpatialHash& operator= (const SpatialHash& other) = delete;
+
+	void Build(const XMFLOAT3* positions, int count, float cellSize, ThreadPool* threadPool = nullptr);
+
+	/**
+	 * @brief Call func(index) for every point in the 3x3 cells around position, which covers any radius up to the cell size.
+	 */
+	template<typename Func>
+	void ForEachNear(const XMFLOAT3& position, Func&& func) const
+	{
+		int cellX = GetCell(position.x);
+		int cellZ = GetCell(position.z);
+		unsigned int visited[9];
+		int visitedCount = 0;
+		for (int z = cellZ - 1; z <= cellZ + 1; ++z)
+		{
+			for (int x = cellX - 1; x <= cellX + 1; ++x)
+			{
+				unsigned int bucket = Hash(x, z);
+				bool seen = false;
+				for (int i = 0; i < visitedCount; ++i)
+				{
+					seen |= visited[i] == bucket;
+				}
+				if (seen)
+				{
+					continue;
+				}
+				visited[visitedCount++] = bucket;
+
+				for (int entry = mBucketStarts[bucket]; entry < mBucketStarts[bucket + 1]; ++entry)
+				{
+					func(mEntries[entry]);
+				}
+			}
+		}
+	}
+
+	float GetCellSize() const { return mCellSize; }
+	int GetBucketCount() const { return static_cast<int>(mBucketMask) + 1; }
+
+private:
+	int GetCell(float coordinate) const { return static_cast<int>(floorf(coordinate * mInverseCellSize)); }
+	unsigned int Hash(int x, int z) const
+	{
+		return (static_cast<unsigned int>(x) * 73856093u ^ static_cast<unsigned int>(z) * 19349663u) & mBucketMask;
+	}
+	void HashRange(const XMFLOAT3* positions, int begin, int end);
+	void ScatterRange(int begin, int end);
+
+private:
+	float mCellSize = 1.f;
+	float mInverseCellSize = 1.f;
+	unsigned int mBucketMask = 0;
+
+	//Points of bucket b are mEntries[mBucketStarts[b], mBucketStarts[b + 1]).
+	std::vector<int> mBucketStarts = { 0, 0 };
+	std::vector<int> mEntries;
+	std::vector<unsigned int> mPointBuckets;
+	std::unique_ptr<std::atomic<int>[]> mBucketCursors;
+	int mBucketCursorCapacity = 0;
+};
@@ -0,0 +1,77 @@
+#include "SpeedProfile.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "MathHelper.h"
+
+SpeedProfile::SpeedProfile(const std::function<float(float)>& velocity, int tableSize)
+	:mTableSize(tableSize)
+{
+	assert(tableSize > 0);
+	mDistances.resize(tableSize + 1);
+	mTimes.resize(tableSize + 1);
+	mVelocities.resize(tableSize + 1);
+
+	//Round off, e.g. sinf(Pi), may dip just below zero.
+	auto sampleVelocity = [&velocity](float time)
+	{
+		float value = velocity(time);
+		assert(value >= -1e-4f);
+		return std::max(value, 0.f);
+	};
+
+	//Simpson's rule over each table step.
+	float step = 1.f / tableSize;
+	mDistances[0] = 0.f;
+	for (int i = 0; i <= tableSize; ++i)
+	{
+		mVelocities[i] = sampleVelocity(i * step);
+		if (i > 0)
+		{
+			float middle = sampleVelocity((i - 0.5f) * step);
+			mDistances[i] = mDistances[i - 1] + (mVelocities[i - 1] + 4.f * middle + mVelocities[i]) * step / 6.f;
+		}
+	}
+
+	float totalDistance = mDistances[tableSize];
+	assert(totalDistance > 0.f);
+	for (int i = 0; i <= tableSize; ++i)
+	{
+		mDistances[i] /= totalDistance;
+		mVelocities[i] /= totalDistance;
+	}
+	mDistances[tableSize] = 1.f;
+
+	//Invert at even distance steps. Flat stretches where the velocity is zero map to their first time.
+	for (int i = 0; i <= tableSize; ++i)
+	{
+		float distance = i * step;
+		int high = static_cast<int>(std::lower_bound(mDistances.begin(), mDistances.end(), distance) - mDistances.begin());
+		high = std::clamp(high, 1, tableSize);
+		float lowDistance = mDistances[high - 1];
+		float highDistance = mDistances[high];
+		float fraction = highDistance > lowDistance ? (distance - lowDistance) / (highDistance - lowDistance) : 0.f;
+		mTimes[i] = std::clamp((high - 1 + fraction) * step, 0.f, 1.f);
+	}
+	mTimes[0] = 0.f;
+	mTimes[tableSize] = 1.f;
+}
+
+SpeedProfile SpeedProfile::Constant()
+{
+	return SpeedProfile([](float) { return 1.f; }, 1);
+}
+
+SpeedProfile SpeedProfile::EaseInOut()
+{
+	return SpeedProfile([](float time) { return sinf(MathHelper::Pi * time); });
+}
+
+float SpeedProfile::Lookup(const std::vector<float>& table, float x) const
+{
+	float position = std::clamp(x, 0.f, 1.f) * mTableSize;
+	int low = std::min(static_cast<int>(position), mTableSize - 1);
+	float fraction = position - low;
+	return table[low] + (table[low + 1] - table[low]) * fraction;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Ease curve of a lap, as normalized distance over normalized time and back.
+ * @detail The velocity curve is integrated once into a monotone distance table at even time steps,
+ * and that table is inverted into a time table at even distance steps. Every query is one table
+ * lookup with linear interpolation, so per agent evaluation needs no transcendental math.
+ * Distance and velocity are scaled so that a whole lap covers a distance of 1 in a time of 1.
+ */
+class SpeedProfile
+{
+public:
+	/**
+	 * @brief Integrate velocity(t) over t in [0, 1]. The velocity must not be negative.
+	 */
+	explicit SpeedProfile(const std::function<float(float)>& velocity, int tableSize = 256);
+
+	static SpeedProfile Constant();
+	//Same curve as the sine ease PathGenerator used to evaluate every frame.
+	static SpeedProfile EaseInOut();
+
+	float GetDistance(float time) const { return Lookup(mDistances, time); }
+	float GetTime(float distance) const { return Lookup(mTimes, distance); }
+	float GetVelocity(float time) const { return Lookup(mVelocities, time); }
+
+private:
+	float Lookup(const std::vector<float>& table, float x) const;
+
+private:
+	int mTableSize;
+	//(mTableSize + 1) entries each.
+	std::vector<float> mDistances;
+	std::vector<float> mTimes;
+	std::vector<float> mVelocities;
+};
@@ -0,0 +1,96 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mCondition.notify_all();
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(int count, int grainSize, const std::function<void(int, int)>& func)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	grainSize = std::max(grainSize, 1);
+	int rangeCount = (count + grainSize - 1) / grainSize;
+	if (rangeCount == 1 || mWorkers.empty())
+	{
+		func(0, count);
+		return;
+	}
+
+	std::atomic<int> nextBegin = 0;
+	auto runRanges = [&]()
+	{
+		for (int begin = nextBegin.fetch_add(grainSize); begin < count; begin = nextBegin.fetch_add(grainSize))
+		{
+			func(begin, std::min(begin + grainSize, count));
+		}
+	};
+
+	int helperCount = std::min(static_cast<int>(mWorkers.size()), rangeCount - 1);
+	std::vector<std::future<void>> helpers;
+	helpers.reserve(helperCount);
+	for (int i = 0; i < helperCount; ++i)
+	{
+		helpers.push_back(Submit(runRanges));
+	}
+
+	runRanges();
+	for (auto& helper : helpers)
+	{
+		Wait(helper);
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStopping || mJobs.empty() == false; });
+			if (mStopping && mJobs.empty())
+			{
+				return;
+			}
+			job = std::move(mJobs.front());
+			mJobs.pop();
+		}
+		job();
+	}
+}
+
+bool ThreadPool::RunPendingJob()
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mJobs.empty())
+		{
+			return false;
+		}
+		job = std::move(mJobs.front());
+		mJobs.pop();
+	}
+	job();
+	return true;
+}
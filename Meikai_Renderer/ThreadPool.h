@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed size worker pool for CPU jobs.
+ * @detail Threads waiting on pool work run pending jobs instead of blocking, so ParallelFor may be nested inside a job.
+ */
+class ThreadPool
+{
+public:
+	//hardware_concurrency may report 0 when it cannot tell, which leaves one worker.
+	explicit ThreadPool(unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& copy) = delete;
+	ThreadPool& operator= (const ThreadPool& other) = delete;
+
+	template<typename Func>
+	auto Submit(Func&& func) -> std::future<decltype(func())>
+	{
+		using ResultType = decltype(func());
+		auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+		std::future<ResultType> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mJobs.push([task]() { (*task)(); });
+		}
+		mCondition.notify_one();
+		return result;
+	}
+
+	/**
+	 * @brief Split [0, count) into ranges of grainSize and run func(begin, end) on them in parallel.
+	 * @detail The calling thread takes part and returns once every range is done.
+	 */
+	void ParallelFor(int count, int grainSize, const std::function<void(int, int)>& func);
+
+	template<typename T>
+	void Wait(std::future<T>& future)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (RunPendingJob() == false)
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	unsigned int GetThreadCount() const { return static_cast<unsigned int>(mWorkers.size()); }
+
+private:
+	void WorkerLoop();
+	bool RunPendingJob();
+
+private:
+	std::vector<std::thread> mWorkers;
+	std::queue<std::function<void()>> mJobs;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mStopping = false;
+};
@@ -0,0 +1,190 @@
+#include "VertexCompression.h"
+#include "Mesh.h"
+#include "SkeletalMesh.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	int16_t ToSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+	}
+
+	float FromSnorm16(int16_t value)
+	{
+		return std::max(value / 32767.f, -1.f);
+	}
+
+	uint32_t ToUnorm10(float signedValue)
+	{
+		return static_cast<uint32_t>(std::lround((std::clamp(signedValue, -1.f, 1.f) * 0.5f + 0.5f) * 1023.f));
+	}
+
+	float FromUnorm10(uint32_t value)
+	{
+		return (value & 1023u) / 1023.f * 2.f - 1.f;
+	}
+
+	bool IsFinite(const XMFLOAT3& vector)
+	{
+		return std::isfinite(vector.x) && std::isfinite(vector.y) && std::isfinite(vector.z);
+	}
+
+	struct PackedFrame
+	{
+		int16_t normal[2];
+		uint32_t tangent;
+	};
+
+	//Vertices without UVs carry no tangent, so any unit vector perpendicular to the normal will do for them.
+	PackedFrame PackFrame(const XMFLOAT3& normalIn, const XMFLOAT3& tangentIn, const XMFLOAT3& biTangentIn)
+	{
+		XMVECTOR normal = IsFinite(normalIn) ? XMVector3Normalize(XMLoadFloat3(&normalIn)) : XMVectorSet(0.f, 0.f, 1.f, 0.f);
+		if (XMVectorGetX(XMVector3LengthSq(normal)) < 0.5f)
+		{
+			normal = XMVectorSet(0.f, 0.f, 1.f, 0.f);
+		}
+
+		//Gram-Schmidt, since only an orthonormal frame survives dropping the bitangent.
+		XMVECTOR tangent = IsFinite(tangentIn) ? XMLoadFloat3(&tangentIn) : XMVectorZero();
+		tangent = XMVectorSubtract(tangent, XMVectorScale(normal, XMVectorGetX(XMVector3Dot(normal, tangent))));
+		if (XMVectorGetX(XMVector3LengthSq(tangent)) < 1e-12f)
+		{
+			XMVECTOR axis = std::fabs(XMVectorGetX(normal)) < 0.9f ? XMVectorSet(1.f, 0.f, 0.f, 0.f) : XMVectorSet(0.f, 1.f, 0.f, 0.f);
+			tangent = XMVector3Cross(normal, axis);
+		}
+		tangent = XMVector3Normalize(tangent);
+
+		XMVECTOR biTangent = IsFinite(biTangentIn) ? XMLoadFloat3(&biTangentIn) : XMVectorZero();
+		bool positive = XMVectorGetX(XMVector3Dot(XMVector3Cross(normal, tangent), biTangent)) >= 0.f;
+
+		PackedFrame frame;
+		XMFLOAT2 octNormal = VertexCompression::EncodeOctahedral(normal);
+		frame.normal[0] = ToSnorm16(octNormal.x);
+		frame.normal[1] = ToSnorm16(octNormal.y);
+		XMFLOAT2 octTangent = VertexCompression::EncodeOctahedral(tangent);
+		frame.tangent = ToUnorm10(octTangent.x) | (ToUnorm10(octTangent.y) << 10) | ((positive ? 3u : 0u) << 30);
+		return frame;
+	}
+
+	void UnpackFrame(const int16_t packedNormal[2], uint32_t packedTangent, XMFLOAT3& normalOut, XMFLOAT3& tangentOut, XMFLOAT3& biTangentOut)
+	{
+		XMVECTOR normal = VertexCompression::DecodeOctahedral(XMFLOAT2(FromSnorm16(packedNormal[0]), FromSnorm16(packedNormal[1])));
+		XMVECTOR tangent = VertexCompression::DecodeOctahedral(XMFLOAT2(FromUnorm10(packedTangent), FromUnorm10(packedTangent >> 10)));
+		float sign = (packedTangent >> 30) != 0 ? 1.f : -1.f;
+		XMStoreFloat3(&normalOut, normal);
+		XMStoreFloat3(&tangentOut, tangent);
+		XMStoreFloat3(&biTangentOut, XMVectorScale(XMVector3Cross(normal, tangent), sign));
+	}
+}
+
+XMFLOAT2 VertexCompression::EncodeOctahedral(FXMVECTOR direction)
+{
+	XMFLOAT3 unit;
+	XMStoreFloat3(&unit, direction);
+	float l1Norm = std::fabs(unit.x) + std::fabs(unit.y) + std::fabs(unit.z);
+	if (l1Norm <= 0.f)
+	{
+		return XMFLOAT2(0.f, 0.f);
+	}
+
+	float x = unit.x / l1Norm;
+	float y = unit.y / l1Norm;
+	if (unit.z < 0.f)
+	{
+		//Fold the lower hemisphere over the diagonals.
+		float foldedX = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+		float foldedY = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = foldedX;
+		y = foldedY;
+	}
+	return XMFLOAT2(x, y);
+}
+
+XMVECTOR VertexCompression::DecodeOctahedral(XMFLOAT2 encoded)
+{
+	float x = encoded.x;
+	float y = encoded.y;
+	float z = 1.f - std::fabs(x) - std::fabs(y);
+	float fold = std::max(-z, 0.f);
+	x += x >= 0.f ? -fold : fold;
+	y += y >= 0.f ? -fold : fold;
+	return XMVector3Normalize(XMVectorSet(x, y, z, 0.f));
+}
+
+PackedVertex VertexCompression::Pack(const Vertex& vertex)
+{
+	PackedVertex packed;
+	packed.position = vertex.position;
+	PackedFrame frame = PackFrame(vertex.normal, vertex.tangent, vertex.biTangent);
+	packed.normal[0] = frame.normal[0];
+	packed.normal[1] = frame.normal[1];
+	packed.tangent = frame.tangent;
+	packed.UV[0] = PackedVector::XMConvertFloatToHalf(vertex.UV.x);
+	packed.UV[1] = PackedVector::XMConvertFloatToHalf(vertex.UV.y);
+	return packed;
+}
+
+PackedSkeletalVertex VertexCompression::Pack(const SkeletalVertex& vertex)
+{
+	PackedSkeletalVertex packed;
+	packed.position = vertex.position;
+	PackedFrame frame = PackFrame(vertex.normal, vertex.tangent, vertex.biTangent);
+	packed.normal[0] = frame.normal[0];
+	packed.normal[1] = frame.normal[1];
+	packed.tangent = frame.tangent;
+	packed.UV[0] = PackedVector::XMConvertFloatToHalf(vertex.UV.x);
+	packed.UV[1] = PackedVector::XMConvertFloatToHalf(vertex.UV.y);
+
+	int weightCount = std::min(static_cast<int>(vertex.weightNum), 4);
+	float weightSum = 0.f;
+	for (int i = 0; i < weightCount; ++i)
+	{
+		weightSum += std::max(vertex.weights[i], 0.f);
+	}
+
+	//Unused slots point at bone 0 with no weight. A vertex without any weight is left to the shader's identity fallback.
+	int quantizedSum = 0;
+	int heaviest = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		bool used = i < weightCount && weightSum > 0.f;
+		assert(used == false || vertex.boneIDs[i] < static_cast<UINT>(MaxBones));
+		packed.boneIDs[i] = used ? static_cast<uint8_t>(vertex.boneIDs[i]) : 0;
+		packed.weights[i] = used ? static_cast<uint8_t>(std::lround(std::max(vertex.weights[i], 0.f) / weightSum * 255.f)) : 0;
+		quantizedSum += packed.weights[i];
+		heaviest = packed.weights[i] > packed.weights[heaviest] ? i : heaviest;
+	}
+	//Rounding each weight on its own may miss 255 by a few steps. The heaviest weight absorbs the rest, so skinning never scales the vertex.
+	if (quantizedSum > 0)
+	{
+		packed.weights[heaviest] = static_cast<uint8_t>(packed.weights[heaviest] + 255 - quantizedSum);
+	}
+	return packed;
+}
+
+Vertex VertexCompression::Unpack(const PackedVertex& packed)
+{
+	Vertex vertex;
+	vertex.position = packed.position;
+	UnpackFrame(packed.normal, packed.tangent, vertex.normal, vertex.tangent, vertex.biTangent);
+	vertex.UV = XMFLOAT2(PackedVector::XMConvertHalfToFloat(packed.UV[0]), PackedVector::XMConvertHalfToFloat(packed.UV[1]));
+	return vertex;
+}
+
+SkeletalVertex VertexCompression::Unpack(const PackedSkeletalVertex& packed)
+{
+	SkeletalVertex vertex;
+	vertex.position = packed.position;
+	UnpackFrame(packed.normal, packed.tangent, vertex.normal, vertex.tangent, vertex.biTangent);
+	vertex.UV = XMFLOAT2(PackedVector::XMConvertHalfToFloat(packed.UV[0]), PackedVector::XMConvertHalfToFloat(packed.UV[1]));
+	for (int i = 0; i < 4; ++i)
+	{
+		vertex.boneIDs[i] = packed.boneIDs[i];
+		vertex.weights[i] = packed.weights[i] / 255.f;
+	}
+	vertex.weightNum = 4;
+	return vertex;
+}
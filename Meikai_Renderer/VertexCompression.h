@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+
+struct Vertex;
+struct SkeletalVertex;
+
+/**
+ * @brief GPU vertex of static meshes, 24 bytes instead of the 56 of Vertex.
+ * @detail Normal and tangent are octahedral encoded and the bitangent is rebuilt from their cross product and a sign.
+ * Decoded by VertexCompression.hlsli.
+ */
+struct PackedVertex
+{
+	//R32G32B32_FLOAT
+	XMFLOAT3 position;
+	//R16G16_SNORM, octahedral.
+	int16_t normal[2];
+	//R10G10B10A2_UNORM, octahedral in x and y, 1 in w when the bitangent is cross(normal, tangent).
+	uint32_t tangent;
+	//R16G16_FLOAT
+	PackedVector::HALF UV[2];
+};
+
+/**
+ * @brief GPU vertex of skinned meshes, 32 bytes instead of the 92 of SkeletalVertex.
+ * @detail Bone ids fit in a byte since the bone table holds at most MaxBones. Weights are unorm8 and always sum to 255.
+ */
+struct PackedSkeletalVertex
+{
+	XMFLOAT3 position;
+	int16_t normal[2];
+	uint32_t tangent;
+	PackedVector::HALF UV[2];
+	//R8G8B8A8_UINT
+	uint8_t boneIDs[4];
+	//R8G8B8A8_UNORM
+	uint8_t weights[4];
+};
+
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex must match the input layout of the mesh passes");
+static_assert(sizeof(PackedSkeletalVertex) == 32, "PackedSkeletalVertex must match the input layout of the skeletal geometry pass");
+
+struct VertexCompression
+{
+	//MAX_BONE of SkeletalGeometryPass.hlsl.
+	static constexpr int MaxBones = 100;
+
+	/**
+	 * @brief Octahedral encoding of a unit vector to [-1, 1]^2.
+	 */
+	static XMFLOAT2 EncodeOctahedral(FXMVECTOR direction);
+	static XMVECTOR DecodeOctahedral(XMFLOAT2 encoded);
+
+	static PackedVertex Pack(const Vertex& vertex);
+	static PackedSkeletalVertex Pack(const SkeletalVertex& vertex);
+	/**
+	 * @brief What the shaders see of a packed vertex. The bitangent is rebuilt.
+	 */
+	static Vertex Unpack(const PackedVertex& packed);
+	static SkeletalVertex Unpack(const PackedSkeletalVertex& packed);
+};
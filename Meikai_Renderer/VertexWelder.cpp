@@ -0,0 +1,180 @@
+#include "VertexWelder.h"
+#include "Mesh.h"
+#include "SkeletalMesh.h"
+#include "MeshBounds.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	constexpr uint32_t NoVertex = UINT32_MAX;
+
+	bool Near(const XMFLOAT3& a, const XMFLOAT3& b, float tolerance)
+	{
+		return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+	}
+
+	bool CanWeld(const WeldVertex& a, const WeldVertex& b, float positionTolerance, const WeldTolerance& tolerance)
+	{
+		if (Near(a.position, b.position, positionTolerance) == false || Near(a.normal, b.normal, tolerance.attribute) == false ||
+			fabsf(a.UV.x - b.UV.x) > tolerance.uv || fabsf(a.UV.y - b.UV.y) > tolerance.uv ||
+			Near(a.tangent, b.tangent, tolerance.attribute) == false || Near(a.biTangent, b.biTangent, tolerance.attribute) == false ||
+			a.weightCount != b.weightCount)
+		{
+			return false;
+		}
+		for (uint32_t i = 0; i < a.weightCount; ++i)
+		{
+			if (a.boneIDs[i] != b.boneIDs[i] || fabsf(a.weights[i] - b.weights[i]) > tolerance.attribute)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t HashCell(int32_t x, int32_t y, int32_t z)
+	{
+		return (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+	}
+
+	int32_t ToCell(float coordinate, float origin, float inverseCellSize)
+	{
+		return static_cast<int32_t>(std::min(floorf((coordinate - origin) * inverseCellSize), 1e9f));
+	}
+}
+
+WeldStats VertexWelder::Weld(const std::vector<WeldVertex>& vertices, std::vector<uint32_t>& indices, const WeldTolerance& tolerance,
+	std::vector<uint32_t>& keptVertices)
+{
+	WeldStats stats;
+	stats.vertexCountBefore = vertices.size();
+	keptVertices.clear();
+	if (vertices.empty())
+	{
+		return stats;
+	}
+
+	MeshBounds bounds = MeshBounds::FromPositions(&vertices[0].position, vertices.size(), sizeof(WeldVertex));
+	XMVECTOR boundsMin = XMLoadFloat3(&bounds.boundsMin);
+	float diagonal = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&bounds.boundsMax), boundsMin)));
+	float positionTolerance = tolerance.position * diagonal;
+	//About one vertex per cell across a surface, and never so small that welding vertices sit cells apart.
+	float cellSize = std::max(positionTolerance * 2.f, diagonal / sqrtf(static_cast<float>(vertices.size())));
+	float inverseCellSize = cellSize > 0.f ? 1.f / cellSize : 0.f;
+
+	size_t capacity = 16;
+	while (capacity < vertices.size() * 2)
+	{
+		capacity *= 2;
+	}
+	//Vertices kept so far, chained per slot. Cells that share a slot share the chain, CanWeld tells them apart.
+	std::vector<uint32_t> slots(capacity, NoVertex);
+	std::vector<uint32_t> nextInSlot;
+	std::vector<uint32_t> remap(vertices.size());
+	keptVertices.reserve(vertices.size());
+	nextInSlot.reserve(vertices.size());
+
+	for (uint32_t vertex = 0; vertex < vertices.size(); ++vertex)
+	{
+		const WeldVertex& attributes = vertices[vertex];
+		const float coordinates[3] = { attributes.position.x, attributes.position.y, attributes.position.z };
+		const float origin[3] = { bounds.boundsMin.x, bounds.boundsMin.y, bounds.boundsMin.z };
+		int32_t cell[3];
+		int32_t firstCell[3];
+		int32_t lastCell[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			cell[axis] = ToCell(coordinates[axis], origin[axis], inverseCellSize);
+			firstCell[axis] = ToCell(coordinates[axis] - positionTolerance, origin[axis], inverseCellSize);
+			lastCell[axis] = ToCell(coordinates[axis] + positionTolerance, origin[axis], inverseCellSize);
+		}
+
+		uint32_t match = NoVertex;
+		for (int32_t x = firstCell[0]; x <= lastCell[0] && match == NoVertex; ++x)
+		{
+			for (int32_t y = firstCell[1]; y <= lastCell[1] && match == NoVertex; ++y)
+			{
+				for (int32_t z = firstCell[2]; z <= lastCell[2] && match == NoVertex; ++z)
+				{
+					for (uint32_t kept = slots[HashCell(x, y, z) & (capacity - 1)]; kept != NoVertex; kept = nextInSlot[kept])
+					{
+						if (CanWeld(vertices[keptVertices[kept]], attributes, positionTolerance, tolerance))
+						{
+							match = kept;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		if (match == NoVertex)
+		{
+			match = static_cast<uint32_t>(keptVertices.size());
+			size_t slot = HashCell(cell[0], cell[1], cell[2]) & (capacity - 1);
+			keptVertices.push_back(vertex);
+			nextInSlot.push_back(slots[slot]);
+			slots[slot] = match;
+		}
+		remap[vertex] = match;
+	}
+	stats.vertexCountAfter = keptVertices.size();
+
+	//Lines and points would be cut apart by dropping triples, so only lists of triangles lose their degenerate ones.
+	if (indices.size() % 3 != 0)
+	{
+		for (uint32_t& index : indices)
+		{
+			index = remap[index];
+		}
+		return stats;
+	}
+	size_t written = 0;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		uint32_t a = remap[indices[i]];
+		uint32_t b = remap[indices[i + 1]];
+		uint32_t c = remap[indices[i + 2]];
+		if (a == b || b == c || c == a)
+		{
+			++stats.degenerateTriangles;
+			continue;
+		}
+		indices[written++] = a;
+		indices[written++] = b;
+		indices[written++] = c;
+	}
+	indices.resize(written);
+	return stats;
+}
+
+WeldVertex VertexWelder::ToWeldVertex(const Vertex& vertex)
+{
+	WeldVertex attributes = { vertex.position, vertex.normal, vertex.UV, vertex.tangent, vertex.biTangent };
+	attributes.weightCount = 0;
+	return attributes;
+}
+
+WeldVertex VertexWelder::ToWeldVertex(const SkeletalVertex& vertex)
+{
+	WeldVertex attributes = { vertex.position, vertex.normal, vertex.UV, vertex.tangent, vertex.biTangent };
+	attributes.weightCount = std::min(vertex.weightNum, 4u);
+	for (uint32_t i = 0; i < attributes.weightCount; ++i)
+	{
+		attributes.boneIDs[i] = vertex.boneIDs[i];
+		attributes.weights[i] = vertex.weights[i];
+	}
+	return attributes;
+}
+
+void VertexWelder::Report(const std::string& assetName, const WeldStats& stats)
+{
+	char text[512];
+	double removed = stats.vertexCountBefore > 0 ? 100.0 * (stats.vertexCountBefore - stats.vertexCountAfter) / stats.vertexCountBefore : 0.0;
+	snprintf(text, sizeof(text), "***Welded %s: %zu -> %zu vertices (%.1f%% removed), %zu degenerate triangles dropped\n", assetName.c_str(),
+		stats.vertexCountBefore, stats.vertexCountAfter, removed, stats.degenerateTriangles);
+	OutputDebugStringA(text);
+}
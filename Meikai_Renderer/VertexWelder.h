@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+struct Vertex;
+struct SkeletalVertex;
+
+/**
+ * @brief Attributes the welder compares, copied out of the vertex type.
+ */
+struct WeldVertex
+{
+	XMFLOAT3 position;
+	XMFLOAT3 normal;
+	XMFLOAT2 UV;
+	XMFLOAT3 tangent;
+	XMFLOAT3 biTangent;
+	//Only the first weightCount are compared, 0 for static vertices.
+	uint32_t boneIDs[4];
+	float weights[4];
+	uint32_t weightCount;
+};
+
+/**
+ * @brief How far apart attributes may be and still weld.
+ */
+struct WeldTolerance
+{
+	//Relative to the diagonal of the mesh bounds.
+	float position = 1e-6f;
+	//Per component of normals, tangents, bitangents and bone weights.
+	float attribute = 1e-3f;
+	//Per component, well under a texel of a 16K texture.
+	float uv = 1e-5f;
+};
+
+struct WeldStats
+{
+	size_t vertexCountBefore = 0;
+	size_t vertexCountAfter = 0;
+	//Triangles that lost an edge as their corners welded together, or never had one.
+	size_t degenerateTriangles = 0;
+
+	void Add(const WeldStats& other)
+	{
+		vertexCountBefore += other.vertexCountBefore;
+		vertexCountAfter += other.vertexCountAfter;
+		degenerateTriangles += other.degenerateTriangles;
+	}
+};
+
+/**
+ * @brief Import time merging of vertices whose attributes are equal within a tolerance.
+ * @detail Importers that split every face corner into a vertex of its own leave most vertices duplicated. Vertices are
+ * bucketed into a hashed grid with cells far larger than the position tolerance, so each is only compared with the
+ * vertices of its own cell, and of a neighbour when it lies within the tolerance of the border. The first vertex of
+ * each welded group is kept, in the original order, and the indices are rewritten to it.
+ */
+class VertexWelder
+{
+public:
+	template<typename VertexType>
+	static WeldStats Weld(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, const WeldTolerance& tolerance = WeldTolerance())
+	{
+		std::vector<WeldVertex> attributes(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			attributes[i] = ToWeldVertex(vertices[i]);
+		}
+		std::vector<uint32_t> keptVertices;
+		WeldStats stats = Weld(attributes, indices, tolerance, keptVertices);
+		if (keptVertices.size() < vertices.size())
+		{
+			std::vector<VertexType> welded;
+			welded.reserve(keptVertices.size());
+			for (uint32_t vertex : keptVertices)
+			{
+				welded.push_back(vertices[vertex]);
+			}
+			vertices.swap(welded);
+		}
+		return stats;
+	}
+
+	/**
+	 * @brief Rewrite indices to the welded vertices and drop the triangles left degenerate.
+	 * @param keptVertices Filled with the old index of each welded vertex.
+	 */
+	static WeldStats Weld(const std::vector<WeldVertex>& vertices, std::vector<uint32_t>& indices, const WeldTolerance& tolerance,
+		std::vector<uint32_t>& keptVertices);
+
+	static WeldVertex ToWeldVertex(const Vertex& vertex);
+	static WeldVertex ToWeldVertex(const SkeletalVertex& vertex);
+
+	static void Report(const std::string& assetName, const WeldStats& stats);
+};
@@ -1,3 +1,5 @@
+#include "VertexCompression.hlsli"
+
 struct WorldMatrix
 {
     matrix mat;
@@ -27,10 +29,9 @@ cbuffer cbPass : register(b1)
 struct VertexIn
 {
 	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+    float2 NormalL : NORMAL;
+	float4 TangentU : TANGENT;
 	float2 TexC    : UV;
-	float3 TangentU : TANGENT;
-    float3 BiTangentU : BITANGENT;
 };
 
 struct VertexOut
@@ -51,7 +52,7 @@ VertexOut VS(VertexIn vin)
     // Transform to homogeneous clip space.
     float4 posW = mul(float4(vin.PosL, 1.0f), objectWorld.mat);
     vout.position = mul(posW, gViewProj);
-    vout.normal = vin.NormalL;
+    vout.normal = DecodeNormal(vin.NormalL);
     return vout;
 }
 
@@ -1,3 +1,5 @@
+#include "VertexCompression.hlsli"
+
 struct WorldMatrix
 {
     matrix mat;
@@ -36,10 +38,9 @@ ConstantBuffer<MaterialData> materialDatas: register(b2);
 struct VertexIn
 {
 	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+    float2 NormalL : NORMAL;
+	float4 TangentU : TANGENT;
 	float2 TexC    : UV;
-	float3 TangentU : TANGENT;
-    float3 BiTangentU : BITANGENT;
 };
 
 struct VertexOut
@@ -65,8 +66,8 @@ VertexOut VS(VertexIn vin)
 	VertexOut vout = (VertexOut)0.0f;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3)objectWorld.mat);
-	vout.TangentW = mul(vin.TangentU, (float3x3)objectWorld.mat);
+    vout.NormalW = mul(DecodeNormal(vin.NormalL), (float3x3)objectWorld.mat);
+	vout.TangentW = mul(DecodeTangent(vin.TangentU), (float3x3)objectWorld.mat);
 
     // Transform to homogeneous clip space.
     vout.PosW = mul(float4(vin.PosL, 1.0f), objectWorld.mat);;
@@ -9,10 +9,9 @@ ConstantBuffer<Matrix> shadowVP : register(b1);
 struct VertexIn
 {
 	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+    float2 NormalL : NORMAL;
+	float4 TangentU : TANGENT;
 	float2 TexC    : UV;
-	float3 TangentU : TANGENT;
-    float3 BiTangentU : BITANGENT;
 };
 struct VertexOut
 {
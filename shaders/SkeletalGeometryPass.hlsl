@@ -1,3 +1,5 @@
+#include "VertexCompression.hlsli"
+
 struct WorldMatrix
 {
     matrix mat;
@@ -41,13 +43,12 @@ ConstantBuffer<MaterialData> materialDatas: register(b3);
 struct VertexIn
 {
 	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+    float2 NormalL : NORMAL;
+	float4 TangentU : TANGENT;
 	float2 TexC    : UV;
-	float3 TangentU : TANGENT;
-    float3 BiTangentU : BITANGENT;
     uint4 Bone_Indices : BONE_IDS;
+    // Unused influences have zero weight.
     float4 Weights : WEIGHTS;
-    uint Weight_num : WEIGHT_NUM;
 };
 
 struct VertexOut
@@ -74,18 +75,23 @@ VertexOut VS(VertexIn vin)
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
     float4x4 BoneTransform = cBoneTable[vin.Bone_Indices[0]] * vin.Weights[0];
-    for(uint i = 1; i < vin.Weight_num; ++i)
+    for(uint i = 1; i < 4; ++i)
     {
         BoneTransform += cBoneTable[vin.Bone_Indices[i]] * vin.Weights[i];
     }
+    // Vertices bound to no bone stay in the bind pose.
+    if (dot(vin.Weights, 1.f) == 0.f)
+    {
+        BoneTransform = float4x4(1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+    }
 
     // Transform to homogeneous clip space.
     float4 posBone = mul(float4(vin.PosL, 1.f), BoneTransform);
     //float4 posL = float4(vin.PosL, 1.f);
     vout.PosW = mul(posBone, objectWorld.mat);;
     vout.PosH = mul(vout.PosW, gViewProj);
-    vout.NormalW = mul(vin.NormalL, (float3x3)objectWorld.mat);
-    vout.TangentW = mul(vin.TangentU, (float3x3)objectWorld.mat);
+    vout.NormalW = mul(DecodeNormal(vin.NormalL), (float3x3)objectWorld.mat);
+    vout.TangentW = mul(DecodeTangent(vin.TangentU), (float3x3)objectWorld.mat);
 
     return vout;
 }
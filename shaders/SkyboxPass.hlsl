@@ -38,10 +38,9 @@ TextureCube gTable[] : register(t0, space0);
 struct VertexIn
 {
 	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+    float2 NormalL : NORMAL;
+	float4 TangentU : TANGENT;
 	float2 TexC    : UV;
-	float3 TangentU : TANGENT;
-    float3 BiTangentU : BITANGENT;
 };
 
 struct VertexOut
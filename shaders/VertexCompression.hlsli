@@ -0,0 +1,23 @@
+// Decode of the packed vertex attributes written by VertexCompression.cpp.
+
+// Octahedral encoded unit vector in [-1, 1]^2.
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.f - abs(e.x) - abs(e.y));
+    float fold = saturate(-n.z);
+    // Component wise, as the compiler is FXC.
+    n.xy += n.xy >= 0.f ? -fold : fold;
+    return normalize(n);
+}
+
+// R16G16_SNORM normal.
+float3 DecodeNormal(float2 packedNormal)
+{
+    return DecodeOctahedral(packedNormal);
+}
+
+// R10G10B10A2_UNORM tangent, octahedral in xy. w is 1 when the bitangent is cross(normal, tangent) and 0 when it is the negation.
+float3 DecodeTangent(float4 packedTangent)
+{
+    return DecodeOctahedral(packedTangent.xy * 2.f - 1.f);
+}